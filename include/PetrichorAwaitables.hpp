@@ -0,0 +1,46 @@
+#pragma once
+#ifndef PETRICHOR_AWAITABLES_HPP
+#define PETRICHOR_AWAITABLES_HPP
+#include "PetrichorResourceTypes.hpp"
+#include <coroutine>
+
+namespace petrichor
+{
+
+    // Lets user coroutines co_await replies instead of polling them. The coroutine always carries on on the thread that
+    // calls ResourceContext::Update(): straight away if it's already there and the operation is complete, otherwise once
+    // Update() sees it complete. Awaiting from any other thread hands the coroutine over even if nothing's left to wait on
+    // The reply has to outlive the suspension (awaiting a temporary is fine, it lives in the coroutine frame), and a
+    // suspended coroutine mustn't be destroyed before the context resumes it
+    struct ResourceReplyAwaiter
+    {
+        bool await_ready() const noexcept;
+        bool await_suspend(std::coroutine_handle<> continuation);
+        GpuResourceHandle await_resume() const noexcept;
+
+        const ResourceSystemReply& reply;
+    };
+
+    struct ResourceReadbackAwaiter
+    {
+        bool await_ready() const noexcept;
+        bool await_suspend(std::coroutine_handle<> continuation);
+        // Same as GetReadbackData(): nullptr if the readback failed
+        const void* await_resume() const noexcept;
+
+        const ResourceReadbackReply& reply;
+    };
+
+    inline ResourceReplyAwaiter operator co_await(const ResourceSystemReply& reply) noexcept
+    {
+        return ResourceReplyAwaiter{ reply };
+    }
+
+    inline ResourceReadbackAwaiter operator co_await(const ResourceReadbackReply& reply) noexcept
+    {
+        return ResourceReadbackAwaiter{ reply };
+    }
+
+}
+
+#endif //!PETRICHOR_AWAITABLES_HPP
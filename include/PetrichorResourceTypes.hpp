@@ -1,6 +1,7 @@
 #pragma once
 #ifndef PETRICHOR_RESOURCE_TYPES_HPP
 #define PETRICHOR_RESOURCE_TYPES_HPP
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 
@@ -47,7 +48,53 @@ namespace petrichor
         Sampler,
         CombinedImageSampler,
         BufferView,
-        ImageView
+        ImageView,
+        // Partially resident image backed by VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT. Info is a VkImageCreateInfo,
+        // and memory is committed per-tile with ResourceContext::RequestSparsePages()
+        SparseImage
+    };
+
+    // Initial contents read straight out of a file: the range is memory mapped rather than read into a buffer.
+    // Where VK_EXT_external_memory_host is available the mapping is imported and copied from directly
+    struct GpuResourceFileSource
+    {
+        const char* Path{ nullptr };
+        uint64_t Offset{ 0u };
+        // Zero reads to the end of the file
+        uint64_t Size{ 0u };
+    };
+
+    // Formats compressed initial contents can be stored in. LZ4 and Zstd only name the formats: their decoders are
+    // registered with ResourceContext::RegisterDecompressionCodec(), so we don't link either library ourselves
+    struct CompressionCodecs
+    {
+        enum : uint32_t
+        {
+            // Stored as-is, and just copied. Always available
+            Uncompressed = 0,
+            LZ4 = 1,
+            Zstd = 2,
+            // Anything from here up is free for custom formats
+            UserDefined = 0x100
+        };
+    };
+
+    using GpuCompressionCodec = uint32_t;
+
+    // Decodes src_size bytes at src into exactly dst_size bytes at dst, returning false if the stream is corrupt or
+    // doesn't decode to that size. Called from several threads at once, with dst pointing into staging memory
+    using DecompressionFn = bool(*)(const void* src, size_t src_size, void* dst, size_t dst_size, void* user_data);
+
+    // Compressed variant of GpuResourceData: decoded by the resource context's worker threads straight into staging
+    // memory, so the decompressed data never takes a trip through a buffer of its own
+    struct GpuCompressedResourceData
+    {
+        const void* Data{ nullptr };
+        size_t CompressedSize{ 0u };
+        size_t DecompressedSize{ 0u };
+        // Buffers only, as with GpuResourceData
+        size_t Alignment{ 0u };
+        GpuCompressionCodec Codec{ CompressionCodecs::Uncompressed };
     };
 
     // Describes memory "domain" or location it will be 
@@ -76,12 +123,27 @@ namespace petrichor
             // Don't allocate new memory objects to fit this resource, it must find room among others
             ResourceCreateNeverAllocate = 0x00000002,
             // This memory will be mapped throughout it's entire lifetime, meaning we don't need to
-            // map/unmap it to write to/from it. Will require a dedicated allocation, most likely
+            // map/unmap it to write to/from it. Host visible memory is preferred, and the resource is never evicted
+            // (so the pointer from ResourceContext::GetMappedPointer() stays put)
             ResourceCreatePersistentlyMapped = 0x00000004,
+            // This resource may be demoted to host memory (buffers) or released entirely (images) when
+            // device memory usage nears the budget. Check GetResourceResidency() before using it each frame
+            ResourceCreateEvictable = 0x00000008,
             // Passed in user data to creation function (unrelated to returned struct's UserData) 
             // will be interpreted as a \0 terminated C-string: this is then passed to debug info functions
             // if enabled, naming the resource in the API (and in graphics captures with tools like RenderDoc)
             ResourceCreateUserDataAsString = 0x00000020,
+            // Buffers only: adds VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, so the buffer's address can be fetched with
+            // ResourceContext::GetDeviceAddress(). Creation fails if the device wasn't created with the bufferDeviceAddress feature
+            ResourceCreateDeviceAddress = 0x00000040,
+            // Left for the next Update() to create, even when called from the thread calling it. The message is copied
+            // when queued (infos and their pNext chains, the debug name, the file source and the data arrays) so those can
+            // be freed as soon as CreateResource() returns. Created right away, on the calling thread, if a pNext chain
+            // holds a structure we can't copy
+            ResourceCreateDeferred = 0x00000080,
+            // With ResourceCreateDeferred: copies the initial (or compressed) data too. Otherwise it has to stay valid
+            // until the reply completes
+            ResourceCreateCopyInitialData = 0x00000100,
             // Use a memory allocation strategy that prioritizes overall memory footprint and consumption
             ResourceCreateMemoryStrategyMinMemory = 0x00010000,
             // This allocation strategy will prioritize time to allocate, but will result in waste
@@ -98,6 +160,95 @@ namespace petrichor
     using GpuResourceHandle = uint64_t;
     constexpr static GpuResourceHandle INVALID_GPU_RESOURCE_HANDLE = std::numeric_limits<uint64_t>::max();
 
+    // Where a resource's memory currently lives: only evictable resources ever leave the Resident state
+    enum class GpuResourceResidency : uint8_t
+    {
+        Invalid = 0,
+        Resident,
+        // Contents were copied into host memory, and the resource now refers to that copy
+        DemotedToHost,
+        // Resource was destroyed to make room: handle stays valid, but refers to no Vulkan object
+        Released,
+        // Created, but its initial contents are held back by the upload scheduler (see UploadBudget). Work queued
+        // against it (modifications, readbacks) is still ordered after the upload, but other queues have to wait
+        PendingUpload
+    };
+
+    // Snapshot of a single memory heap's consumption, as reported by VK_EXT_memory_budget (when available)
+    struct GpuMemoryHeapBudget
+    {
+        // Bytes allocated in VkDeviceMemory blocks by the context
+        uint64_t BlockBytes{ 0u };
+        // Bytes actually occupied by resources, within those blocks
+        uint64_t AllocationBytes{ 0u };
+        // Usage of the heap by the whole process (and possibly others): estimated if the extension is missing
+        uint64_t Usage{ 0u };
+        // How much we can use before things start failing or slowing down
+        uint64_t Budget{ 0u };
+        // VkMemoryHeapFlags of the heap
+        uint32_t HeapFlags{ 0u };
+    };
+
+    // Controls how the resource context reacts as device-local heaps approach their budget. Thresholds
+    // are fractions of the budget, and are checked once per frame in ResourceContext::Update()
+    struct MemoryBudgetPolicy
+    {
+        // Once usage passes this fraction of the budget, evictable resources start being evicted
+        float EvictionThreshold{ 0.90f };
+        // Past this fraction, creations using ResourceCreateNeverAllocate fail immediately
+        float NeverAllocateThreshold{ 0.95f };
+        // Evictable buffers are copied to host memory if set, otherwise they're released like images. Demoting waits for
+        // the context's frames still in flight, so Update() may block on the GPU in frames that demote anything
+        bool DemoteToHost{ true };
+        // Caps eviction work done in a single frame, so that we don't hitch trying to catch up
+        uint32_t MaxEvictionsPerFrame{ 8u };
+    };
+
+    // Caps the staged initial contents recorded by a single ResourceContext::Update(). Uploads over budget carry over to
+    // later frames, highest UploadPriority first, and are never split. All zero (the default) records everything at once
+    struct UploadBudget
+    {
+        // Zero for no limit. An upload bigger than the whole budget still goes, on its own
+        uint64_t MaxBytesPerFrame{ 0u };
+        // Uploads (one copy command each) per frame, or zero for no limit
+        uint32_t MaxUploadsPerFrame{ 0u };
+        // If non-zero, the byte budget also shrinks to what the transfer queue was measured to copy in this long.
+        // Measured with timestamp queries, which need a transfer queue family with graphics or compute support
+        float TargetMilliseconds{ 0.0f };
+    };
+
+    struct UploadSchedulerStats
+    {
+        // Waiting for budget as of the last Update()
+        uint32_t BacklogUploads{ 0u };
+        uint64_t BacklogBytes{ 0u };
+        // Frames the oldest waiting upload has been held back for
+        uint64_t OldestBacklogFrames{ 0u };
+        uint32_t LastFrameUploads{ 0u };
+        uint64_t LastFrameBytes{ 0u };
+        // Byte budget applied by the last Update(), zero if unlimited
+        uint64_t CurrentByteBudget{ 0u };
+        // Averaged over recent frames, zero until something's been measured
+        double MeasuredBytesPerSecond{ 0.0 };
+        // Over the life of the context
+        uint64_t TotalDeferredUploads{ 0u };
+    };
+
+    // Staging buffers uploads are copied through, pooled by power of two size class
+    struct StagingPoolStats
+    {
+        // Free, and waiting to be reused
+        uint32_t PooledBuffers{ 0u };
+        uint64_t PooledBytes{ 0u };
+        // Held by uploads whose frame hasn't retired yet
+        uint64_t InUseBytes{ 0u };
+        // Buffers created because no pooled one was free: flat once loading reaches a steady state
+        uint64_t Allocations{ 0u };
+        uint64_t Reuses{ 0u };
+        // Freed after sitting idle (see ResourceContext::SetStagingPoolIdleFrames())
+        uint64_t TrimmedBuffers{ 0u };
+    };
+
     /*
         Passed to our resource context to create a new resource, and contains all the requisite info
     */
@@ -107,27 +258,280 @@ namespace petrichor
         GpuResourceType Type;
         GpuResourceMemoryDomain MemoryDomain;
         GpuResourceCreationFlags Flags;
+        // Initial contents. Device buffers are written directly where device memory is host visible (UMA, ReBAR),
+        // everything else is staged. Images with contents are left in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
         union
         {
             struct
             {
-                uint32_t numData = 0u;
-                const GpuResourceData* data = nullptr;
+                uint32_t numData;
+                const GpuResourceData* data;
             } bufferData;
             struct
             {
-                uint32_t numData = 0u;
-                const GpuImageResourceData* data = nullptr;
+                uint32_t numData;
+                const GpuImageResourceData* data;
             } imageData;
-        } ResourceData;
+        } ResourceData{};
         // Set to the VkBuffer/Image/SamplerCreateInfo you are using
         const void* Info = nullptr;
         // Set to the VkBufferViewCreateInfo/VkImageViewCreateInfo you are using for this object, if applicable
         const void* ViewInfo = nullptr;
         // Used to hold debug names if relevant flags set, otherwise it's whatever you like and is copied to the resource
         const void* UserData = nullptr;
-        // If creating a view based on a pre-existing object, set this to the handle of the parent object
+        // If creating a view based on a pre-existing object, set this to the handle of the parent object. Views with identical
+        // infos of the same parent share a handle (each creation still needs a destroy), and all go when the parent does
         uint64_t ParentHandle = 0u;
+        // Takes the initial contents from a file instead of memory: buffers get the whole range at offset zero, images
+        // read imageData's regions back to back from it (ignoring their Data). Has to stay valid until CreateResource() returns.
+        // Buffers whose initial contents (from either) don't fit in them fail to create
+        const GpuResourceFileSource* FileSource = nullptr;
+        // Takes the initial contents from compressed data instead, with each entry decoded on its own worker thread: split
+        // big assets into several entries (per mip, or independently compressed chunks) to spread them out. Buffers get the
+        // entries packed like bufferData's, and images take entry i as the contents of imageData's region i (ignoring its
+        // Data and Size). Always staged, and can't be combined with FileSource. Has to stay valid until the reply completes
+        uint32_t NumCompressedData = 0u;
+        const GpuCompressedResourceData* CompressedData = nullptr;
+        // Only used when an UploadBudget is set: over budget, higher priorities are uploaded first. A non-zero deadline
+        // is the most Update() calls the upload may wait through, after which it goes regardless of the budget
+        uint32_t UploadPriority = 0u;
+        uint32_t UploadDeadline = 0u;
+    };
+
+    // Identifies a single tile of a sparse image, in units of the image's sparse block granularity
+    struct SparseImagePageRequest
+    {
+        uint32_t MipLevel{ 0u };
+        uint32_t ArrayLayer{ 0u };
+        uint32_t TileX{ 0u };
+        uint32_t TileY{ 0u };
+        uint32_t TileZ{ 0u };
+        // Commits memory to the tile if true, returns the tile's page to the pool if false
+        bool Commit{ true };
+    };
+
+    struct SparseResidencyStats
+    {
+        // Size of a single tile, in texels
+        uint32_t TileWidth{ 0u };
+        uint32_t TileHeight{ 0u };
+        uint32_t TileDepth{ 0u };
+        // Tiles outside of the mip tail, across all layers
+        uint64_t TotalTiles{ 0u };
+        uint64_t ResidentTiles{ 0u };
+        // Device memory bound to the image, including the (always resident) mip tail
+        uint64_t CommittedBytes{ 0u };
+        uint64_t PageSize{ 0u };
+        // Pages of this size sitting unused in the context's shared page pool
+        uint64_t PooledPages{ 0u };
+        // Set when the device lacked sparse residency support, and we created an ordinary image instead
+        bool IsFallback{ false };
+    };
+
+    // Describes a resource that's only alive for part of a frame. Use points are whatever the caller orders
+    // its frame by (usually pass indices): resources whose [FirstUse, LastUse] ranges don't overlap may share memory
+    struct TransientResourceDesc
+    {
+        // Buffer or Image: transient resources always live in device memory
+        GpuResourceType Type{ GpuResourceType::Invalid };
+        GpuResourceCreationFlags Flags{ 0u };
+        // Set to the VkBufferCreateInfo/VkImageCreateInfo you are using
+        const void* Info{ nullptr };
+        const void* UserData{ nullptr };
+        uint32_t FirstUse{ 0u };
+        uint32_t LastUse{ 0u };
+        // VkPipelineStageFlags and VkAccessFlags of the first and last accesses, used for the aliasing barriers
+        uint32_t FirstUseStages{ 0u };
+        uint32_t FirstUseAccess{ 0u };
+        uint32_t LastUseStages{ 0u };
+        uint32_t LastUseAccess{ 0u };
+        // VkImageLayout images are transitioned to (from undefined) before their first use
+        uint32_t FirstUseLayout{ 0u };
+    };
+
+    // Moves an image (or some of its mip levels and layers) into a new layout, for ResourceContext::TransitionResources()
+    struct ImageTransition
+    {
+        GpuResourceHandle Image{ INVALID_GPU_RESOURCE_HANDLE };
+        // VkImageLayout to move into
+        uint32_t NewLayout{ 0u };
+        // VkPipelineStageFlags2 and VkAccessFlags2 of the accesses that follow, which later transitions wait on
+        uint64_t DstStages{ 0u };
+        uint64_t DstAccess{ 0u };
+        // A count of zero covers the rest of the mip levels/array layers
+        uint32_t BaseMipLevel{ 0u };
+        uint32_t LevelCount{ 0u };
+        uint32_t BaseArrayLayer{ 0u };
+        uint32_t LayerCount{ 0u };
+        // The contents don't need to survive: transitions from VK_IMAGE_LAYOUT_UNDEFINED
+        bool Discard{ false };
+    };
+
+    // Describes a VkBuffer or VkImage created outside the context, for ResourceContext::ImportResource()
+    struct ImportedResourceDesc
+    {
+        // Buffer or Image
+        GpuResourceType Type{ GpuResourceType::Invalid };
+        // The VkBuffer or VkImage
+        uint64_t Handle{ 0u };
+        // Set to the VkBufferCreateInfo/VkImageCreateInfo it was created with: views, modifications and readbacks go by it
+        const void* Info{ nullptr };
+        // VmaAllocation it's bound to, if it came from the context's own allocator: it's then counted in memory stats like
+        // anything else. nullptr if its memory is managed elsewhere
+        void* Allocation{ nullptr };
+        // Only ResourceCreateUserDataAsString applies
+        GpuResourceCreationFlags Flags{ 0u };
+        const void* UserData{ nullptr };
+        // VkImageLayout the whole image is in when imported
+        uint32_t CurrentLayout{ 0u };
+        // If set, DestroyResource() destroys it (and Allocation) once frames using it retire. Otherwise it only drops
+        // the handle, and destroying the object is left to the caller
+        bool TakeOwnership{ false };
+    };
+
+    struct TransientMemoryStats
+    {
+        // What the resources would need with a separate allocation each
+        uint64_t UnaliasedBytes{ 0u };
+        // What was actually allocated, after packing
+        uint64_t AliasedBytes{ 0u };
+        // Most bytes alive at any one use point: the best any packing could do
+        uint64_t PeakLiveBytes{ 0u };
+        uint32_t NumResources{ 0u };
+        uint32_t NumHeaps{ 0u };
+    };
+
+    // Sampler deduplication over the life of the context
+    struct SamplerCacheStats
+    {
+        uint64_t Requests{ 0u };
+        uint64_t Hits{ 0u };
+        // Requests with a pNext structure the cache can't key, which always get a sampler of their own
+        uint64_t UncacheableRequests{ 0u };
+        // Distinct samplers currently shared through the cache
+        uint32_t UniqueSamplers{ 0u };
+        double HitRate{ 0.0 };
+    };
+
+    struct ViewCacheStats
+    {
+        // Only counts views the cache could key
+        uint64_t Requests{ 0u };
+        uint64_t Hits{ 0u };
+        uint32_t LiveViews{ 0u };
+        double HitRate{ 0.0 };
+    };
+
+    // Decompression of compressed initial contents, over the life of the context
+    struct DecompressionStats
+    {
+        uint64_t CompressedBytes{ 0u };
+        uint64_t DecompressedBytes{ 0u };
+        uint64_t Entries{ 0u };
+        // Creations that failed because an entry was corrupt, or used a codec nobody registered
+        uint64_t Failures{ 0u };
+        // Wall time spent decoding, summed over creations
+        double Seconds{ 0.0 };
+        // Decompressed bytes over Seconds, in units of 10^9 bytes
+        double GigabytesPerSecond{ 0.0 };
+        uint32_t WorkerThreads{ 0u };
+    };
+
+    // Stages a traced creation's latency is split into (see ResourceContext::EnableCreationTracing()). Each is the time
+    // taken to reach its state from the one reached before it: compressed contents are staged before allocation, for one
+    enum class ResourceCreationStage : uint8_t
+    {
+        // Waiting to start: off the thread calling Update(), that includes waiting for it to finish submitting
+        Queueing = 0,
+        Allocation,
+        // Writing initial contents into staging memory (or straight into the resource), decompression included
+        Staging,
+        // Includes any time spent waiting on the upload scheduler
+        Recording,
+        // Recorded, until the next Update() submitted it
+        SubmitWait,
+        // Submitted, until the batch was seen complete. Fences are checked once per Update(), so this rounds up to it
+        Gpu,
+        // Complete, until the frame was recycled and its staging memory freed
+        Retirement,
+        // From CreateResource() being called to the last state reached
+        Total,
+        Count
+    };
+
+    constexpr static uint32_t ResourceCreationStageCount = static_cast<uint32_t>(ResourceCreationStage::Count);
+    // Traced creations are grouped by size: under 64KiB, under 1MiB, under 16MiB, and anything bigger
+    constexpr static uint32_t CreationSizeClassCount = 4u;
+
+    struct ResourceCreationLatency
+    {
+        GpuResourceType Type{ GpuResourceType::Invalid };
+        uint32_t SizeClass{ 0u };
+        uint32_t NumSamples{ 0u };
+        // Microseconds, indexed by ResourceCreationStage. Only creations that went through a stage count towards it:
+        // samplers are never staged, and direct writes are never recorded or submitted
+        double P50[ResourceCreationStageCount]{};
+        double P90[ResourceCreationStageCount]{};
+        double P99[ResourceCreationStageCount]{};
+        double Max[ResourceCreationStageCount]{};
+    };
+
+    // Coroutine frames allocated for resource operations (CreateResource() replies)
+    struct CoroutineFrameStats
+    {
+        // Frames whose reply or coroutine hasn't been destroyed yet
+        uint64_t OutstandingFrames{ 0u };
+        uint64_t TotalFrames{ 0u };
+        // Frames too big for the pool (or allocated with pooling disabled), which went to the global heap
+        uint64_t HeapFrames{ 0u };
+        uint64_t PooledBytes{ 0u };
+    };
+
+    // Bindings of the bindless descriptor set (ResourceContext::GetBindlessSet()). Storage buffers, views of sampled
+    // images, and samplers created through the resource context are each written into their array at a stable index
+    constexpr static uint32_t BindlessSampledImageBinding = 0u;
+    constexpr static uint32_t BindlessStorageBufferBinding = 1u;
+    constexpr static uint32_t BindlessSamplerBinding = 2u;
+    constexpr static uint32_t BindlessIndexInvalid = std::numeric_limits<uint32_t>::max();
+
+    // VK_MAX_MEMORY_HEAPS, so samples don't need Vulkan headers to be read back
+    constexpr static uint32_t MemoryStatsMaxHeaps = 16u;
+    // One per GpuResourceMemoryDomain value
+    constexpr static uint32_t MemoryStatsDomainCount = 5u;
+
+    // Compact sample of memory consumption, taken every few frames once enabled with
+    // ResourceContext::EnableMemoryStatsSnapshots(). Plain data, so a ring of them can be written out as-is
+    struct MemoryStatsSample
+    {
+        uint64_t FrameIndex{ 0u };
+        // Nanoseconds, on the steady clock
+        uint64_t Timestamp{ 0u };
+        uint64_t HeapBlockBytes[MemoryStatsMaxHeaps]{};
+        uint64_t HeapAllocationBytes[MemoryStatsMaxHeaps]{};
+        uint64_t HeapUsage[MemoryStatsMaxHeaps]{};
+        uint64_t HeapBudget[MemoryStatsMaxHeaps]{};
+        // Resources that own an allocation, indexed by GpuResourceMemoryDomain. Sparse and transient
+        // resources are left out, as their memory isn't theirs alone (it's still in the heap totals)
+        uint64_t DomainBytes[MemoryStatsDomainCount]{};
+        uint32_t DomainResources[MemoryStatsDomainCount]{};
+        uint32_t HeapAllocationCount[MemoryStatsMaxHeaps]{};
+        uint32_t HeapCount{ 0u };
+        uint32_t LiveResources{ 0u };
+        // Demoted to host or released by the memory budget policy
+        uint32_t EvictedResources{ 0u };
+        uint32_t Reserved{ 0u };
+    };
+
+    constexpr static uint32_t MemoryStatsSnapshotMagic = 0x53534D50u; // "PMSS"
+    constexpr static uint32_t MemoryStatsSnapshotVersion = 1u;
+
+    // Start of the file written by ResourceContext::WriteMemoryStatsSnapshots(): followed by SampleCount samples, oldest first
+    struct MemoryStatsSnapshotFileHeader
+    {
+        uint32_t Magic{ MemoryStatsSnapshotMagic };
+        uint32_t Version{ MemoryStatsSnapshotVersion };
+        uint32_t SampleSize{ sizeof(MemoryStatsSample) };
+        uint32_t SampleCount{ 0u };
     };
 
     enum class ResourceModificationOpType : uint8_t
@@ -138,9 +542,44 @@ namespace petrichor
         CreateCopy,
     };
 
+    /*
+        Passed to our resource context to change the contents of an existing resource. Modifications are gathered
+        over a frame and recorded together in Update(): within a frame, clears are applied first, then writes, and
+        copies last. Overlapping writes to a buffer are merged, with later writes winning where they overlap.
+    */
     struct ResourceModificationMessage
     {
-
+        ResourceModificationOpType Type{ ResourceModificationOpType::Invalid };
+        // Resource being written to, cleared, or copied into
+        GpuResourceHandle DestinationHandle{ INVALID_GPU_RESOURCE_HANDLE };
+        // CreateCopy only: resource the contents are copied from. Images have to match in format and extent
+        GpuResourceHandle SourceHandle{ INVALID_GPU_RESOURCE_HANDLE };
+        // SetContents only: laid out as for creation, except buffer entries start at DestinationOffset.
+        // The data is copied when the message is queued, so it doesn't have to outlive the call. Image regions are
+        // checked as initial data is: if any lies outside the image, the whole message is dropped. So is a buffer write
+        // running past the end of the buffer
+        union
+        {
+            struct
+            {
+                uint32_t numData;
+                const GpuResourceData* data;
+            } bufferData;
+            struct
+            {
+                uint32_t numData;
+                const GpuImageResourceData* data;
+            } imageData;
+        } ResourceData{};
+        // Byte offset buffer writes and clears start at
+        uint64_t DestinationOffset{ 0u };
+        // Bytes of a buffer to clear, or zero to clear to the end. Offset and size must be multiples of 4, and lie within
+        // the buffer: clears that don't are dropped
+        uint64_t ClearSize{ 0u };
+        // Buffers are cleared to this word, repeated
+        uint32_t ClearValue{ 0u };
+        // Images are cleared to this color: depth formats use the first component
+        float ClearColor[4]{ 0.0f, 0.0f, 0.0f, 0.0f };
     };
 
     /*
@@ -150,15 +589,19 @@ namespace petrichor
     struct ResourceSystemReply
     {
         ResourceSystemReply() = default;
-        ~ResourceSystemReply() = default;
+        ~ResourceSystemReply();
         ResourceSystemReply(const ResourceSystemReply&) = delete;
         ResourceSystemReply& operator=(const ResourceSystemReply&) = delete;
+        ResourceSystemReply(ResourceSystemReply&& other) noexcept;
+        ResourceSystemReply& operator=(ResourceSystemReply&& other) noexcept;
 
     private:
+        ResourceSystemReply(void* _parent, void* coroutine_address) noexcept;
         // Handle to the coroutine created for this object
-        void* parent;
-        void* coroutineHandle;
+        void* parent{ nullptr };
+        void* coroutineHandle{ nullptr };
         friend struct ResourceCreationEvent;
+        friend struct ResourceReplyAwaiter;
         friend bool ResourceOperationComplete(const ResourceSystemReply&);
         friend GpuResourceHandle GetHandleFromOperation(const ResourceSystemReply&);
     };
@@ -166,6 +609,31 @@ namespace petrichor
     bool ResourceOperationComplete(const ResourceSystemReply& reply);
     GpuResourceHandle GetHandleFromOperation(const ResourceSystemReply& reply);
 
+    // Returned by ResourceContext::ReadbackResource(). The data stays mapped, and valid, until this is destroyed
+    struct ResourceReadbackReply
+    {
+        ResourceReadbackReply() = default;
+        ~ResourceReadbackReply();
+        ResourceReadbackReply(const ResourceReadbackReply&) = delete;
+        ResourceReadbackReply& operator=(const ResourceReadbackReply&) = delete;
+        ResourceReadbackReply(ResourceReadbackReply&& other) noexcept;
+        ResourceReadbackReply& operator=(ResourceReadbackReply&& other) noexcept;
+
+    private:
+        ResourceReadbackReply(void* _parent, void* readback_state) noexcept;
+        void* parent{ nullptr };
+        // ReadbackState shared with the context
+        void* readbackState{ nullptr };
+        friend struct ResourceContextImpl;
+        friend struct ResourceReadbackAwaiter;
+        friend bool ReadbackComplete(const ResourceReadbackReply&);
+        friend const void* GetReadbackData(const ResourceReadbackReply&, uint64_t*);
+    };
+
+    bool ReadbackComplete(const ResourceReadbackReply& reply);
+    // Pointer straight into the host cached readback buffer. nullptr until complete, or if the readback failed
+    const void* GetReadbackData(const ResourceReadbackReply& reply, uint64_t* size = nullptr);
+
 } // namespace petrichor
 
 #endif //!PETRICHOR_RESOURCE_TYPES_HPP
\ No newline at end of file
@@ -90,6 +90,32 @@ namespace petrichor
         uint32_t MaxSampledImages;
         uint32_t MaxStorageImages;
         uint32_t MaxInputAttachments;
+        // Limits for sets allocated from UPDATE_AFTER_BIND pools (descriptor indexing), which are usually far higher
+        // than the ones above. Only filled in for Vulkan 1.2 devices: zero otherwise
+        uint32_t MaxUpdateAfterBindSamplers;
+        uint32_t MaxUpdateAfterBindStorageBuffers;
+        uint32_t MaxUpdateAfterBindSampledImages;
+        uint32_t MaxPerStageUpdateAfterBindSamplers;
+        uint32_t MaxPerStageUpdateAfterBindStorageBuffers;
+        uint32_t MaxPerStageUpdateAfterBindSampledImages;
+        uint32_t MaxPerStageUpdateAfterBindResources;
+    };
+
+    // Features the logical device was created with, out of those ResourceContext can make use of. Being supported
+    // isn't enough: using a feature the device wasn't created with is invalid. Read from the features and pNext chain
+    // given to vkCreateDevice, which may hold VkPhysicalDeviceFeatures2 (replacing features), the Vulkan 1.2 and 1.3
+    // feature structures, or the individual structures they fold in
+    struct EnabledDeviceFeatures
+    {
+        EnabledDeviceFeatures() = default;
+        EnabledDeviceFeatures(const VkPhysicalDeviceFeatures* features, const void* next_chain);
+        VkPhysicalDeviceFeatures Core{};
+        bool BufferDeviceAddress{ false };
+        bool Synchronization2{ false };
+        bool RuntimeDescriptorArray{ false };
+        bool DescriptorBindingPartiallyBound{ false };
+        bool DescriptorBindingSampledImageUpdateAfterBind{ false };
+        bool DescriptorBindingStorageBufferUpdateAfterBind{ false };
     };
 
     class PETRICHOR_API RenderingContext
@@ -117,6 +143,8 @@ namespace petrichor
         GLFWwindow* glfwWindow() noexcept;
 
         static void AddSetupFunctions(post_physical_device_pre_logical_device_function_t fn0, post_logical_device_function_t fn1);
+        // What the setup functions had enabled on the device, read before the post logical device function runs
+        static const EnabledDeviceFeatures& GetEnabledDeviceFeatures() noexcept;
         static void AddSwapchainCallbacks(SwapchainCallbacks callbacks);
         static void GetWindowSize(int& w, int& h);
         static void GetFramebufferSize(int& w, int& h);
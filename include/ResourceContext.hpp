@@ -10,6 +10,10 @@ struct VkImageCreateInfo;
 struct VkImageViewCreateInfo;
 struct VkSamplerCreateInfo;
 struct VmaAllocationInfo;
+typedef struct VkCommandBuffer_T* VkCommandBuffer;
+typedef struct VkSemaphore_T* VkSemaphore;
+typedef struct VkDescriptorSetLayout_T* VkDescriptorSetLayout;
+typedef struct VkDescriptorSet_T* VkDescriptorSet;
 
 namespace vpr
 {
@@ -21,6 +25,7 @@ namespace petrichor
 {
 
     struct ResourceContextImpl;
+    struct EnabledDeviceFeatures;
 
     class PETRICHOR_API ResourceContext
     {
@@ -33,13 +38,104 @@ namespace petrichor
     public:
 
         static ResourceContext& Get(vpr::Device* device, vpr::PhysicalDevice* physicalDevice);
-        // Call at start of frame
+        // Call at start of frame. Also resumes coroutines awaiting replies that have completed (see PetrichorAwaitables.hpp)
         void Update();
         void Destroy();
-        void Construct(vpr::Device* device, vpr::PhysicalDevice* physicalDevice);
-
+        // Optional features (sparse residency, buffer device addresses, bindless, synchronization2) are only used if the
+        // device was created with them. Without enabledFeatures, those enabled through RenderingContext::AddSetupFunctions()
+        void Construct(vpr::Device* device, vpr::PhysicalDevice* physicalDevice, const EnabledDeviceFeatures* enabledFeatures = nullptr);
+
+        // Queued for the next Update(), unless called from the thread that calls it: there it's created right away.
+        // What the message points to has to stay valid until the reply completes. Update() spreads queued creations
+        // across its worker threads, each recording initial data into its own transfer command buffer, and submits
+        // them all together. With an UploadBudget set, staged data is left to the upload scheduler instead: the resource
+        // stays PendingUpload until an Update() records it. Messages flagged ResourceCreateDeferred are copied, and
+        // always left for the next Update(). Running out of device or host memory, staging for the initial data
+        // included, completes the reply with INVALID_GPU_RESOURCE_HANDLE
         ResourceSystemReply CreateResource(ResourceCreationMessage message);
+        // Samplers with identical create infos share one VkSampler and handle: each creation needs a matching destroy
         void DestroyResource(GpuResourceHandle handle);
+        // Gives a buffer or image created elsewhere an ordinary handle: it can have views made from it, be modified and read
+        // back, gets a bindless slot (storage buffers) and shows up in memory stats. The transfer queue has to be able to use
+        // it for the latter. Returns INVALID_GPU_RESOURCE_HANDLE if the desc is incomplete
+        GpuResourceHandle ImportResource(const ImportedResourceDesc& desc);
+        // Queues a SetContents/ClearContents/CreateCopy: everything queued in a frame is recorded in one transfer batch.
+        // If there's no memory to stage the batch in, it's left for the next Update()
+        void ModifyResource(const ResourceModificationMessage& message);
+
+        // Retrieves live per-heap usage and budget. Call with budgets == nullptr to get the heap count
+        void QueryMemoryBudget(uint32_t* num_heaps, GpuMemoryHeapBudget* budgets) const;
+        void SetMemoryBudgetPolicy(const MemoryBudgetPolicy& policy);
+        GpuResourceResidency GetResourceResidency(GpuResourceHandle handle) const;
+        // Address of a buffer created with ResourceCreateDeviceAddress, or zero. Takes no locks, so it's cheap enough to
+        // call per object while filling scene data. Demotion to host gives the buffer a new address
+        uint64_t GetDeviceAddress(GpuResourceHandle handle) const noexcept;
+        // VkBuffer, VkImage, VkSampler or view behind a handle, or zero for stale handles and released resources. Wait-free,
+        // for render threads resolving handles while recording. Demotion to host swaps the buffer, and destroyed resources
+        // are only kept alive until their frame retires, so don't hold onto it past the frame
+        uint64_t GetVulkanHandle(GpuResourceHandle handle) const noexcept;
+
+        // Mapping of a resource created with ResourceCreatePersistentlyMapped, valid until it's destroyed. nullptr if
+        // it isn't mapped, which happens if its memory type turned out not to be host visible
+        void* GetMappedPointer(GpuResourceHandle handle) const;
+        // Records a write through the mapping. Every range recorded in a frame is flushed by one vmaFlushAllocations()
+        // call at the start of the next Update(), skipping host coherent memory. Zero size runs to the end of the resource
+        void MarkMappedRangeDirty(GpuResourceHandle handle, uint64_t offset, uint64_t size);
+
+        // Set holding every storage buffer, view of a sampled image, and sampler made through the context, at the bindings
+        // given by BindlessSampledImageBinding and co. VK_NULL_HANDLE unless the device was created with runtimeDescriptorArray,
+        // descriptorBindingPartiallyBound and the sampled image and storage buffer update after bind features
+        VkDescriptorSetLayout GetBindlessSetLayout() const noexcept;
+        VkDescriptorSet GetBindlessSet() const noexcept;
+        // Stable for the life of the resource, but only written into the set by the next Update(). BindlessIndexInvalid
+        // for other resource types, or once an array is full. Released buffers keep their slot, which must not be read
+        uint32_t GetBindlessIndex(GpuResourceHandle handle) const;
+
+        // Queues tile commits/decommits for a sparse image: all of them are bound in one batch in Update()
+        void RequestSparsePages(GpuResourceHandle handle, uint32_t num_requests, const SparseImagePageRequest* requests);
+        SparseResidencyStats GetSparseResidencyStats(GpuResourceHandle handle) const;
+
+        // Creates resources that are each alive for only part of a frame, packing those with disjoint lifetimes into
+        // shared memory. The whole group is packed and bound at once.
+        // Returns false (and writes no handles) if any of them or the memory couldn't be created. Destroy each with DestroyResource()
+        bool CreateTransientResources(uint32_t num_resources, const TransientResourceDesc* descs, GpuResourceHandle* handles, TransientMemoryStats* stats = nullptr);
+        // Records the barriers needed before the resources whose FirstUse is use_point: the dependency on whatever
+        // previously occupied their memory (earlier this frame, or later in the last frame the group was used in, when
+        // both are recorded on the same queue), and for images the transition out of VK_IMAGE_LAYOUT_UNDEFINED
+        void RecordTransientAliasingBarriers(VkCommandBuffer cmd, uint32_t use_point, uint32_t num_handles, const GpuResourceHandle* handles) const;
+        // Totals across every transient resource currently alive
+        TransientMemoryStats GetTransientMemoryStats() const;
+
+        // Records the barriers moving each image from the layout and accesses the context last saw it in, tracked per mip level
+        // and array layer. Subresources changing layout (or with a write on either side) that were in the same layout share a
+        // barrier, and all of them go in one vkCmdPipelineBarrier2() call (vkCmdPipelineBarrier() unless the device enabled synchronization2).
+        // The new states are kept as soon as this returns, so record transitions in the order they'll execute, and name each
+        // image once per call. Transient images start out in their FirstUseLayout
+        void TransitionResources(VkCommandBuffer cmd, uint32_t num_transitions, const ImageTransition* transitions);
+
+        // Copies size bytes (zero for the rest of the buffer) from offset into pooled host cached memory. All readbacks
+        // queued in a frame are copied in one batch in Update(), and the reply completes once that batch has executed:
+        // nothing ever waits on the device for it. Writes from other queues need to be ordered before it with AddTransferWaitSemaphore().
+        // Only buffers can be read back: for images and other types (or stale handles) the reply completes right away, with no data
+        ResourceReadbackReply ReadbackResource(GpuResourceHandle handle, uint64_t offset, uint64_t size);
+        // The transfer batch submitted by the next Update() waits on semaphore at wait_stages (VkPipelineStageFlags)
+        void AddTransferWaitSemaphore(VkSemaphore semaphore, uint32_t wait_stages);
+
+        // Applies from the next creation on: uploads already waiting keep their place, and are drained under the new budget
+        void SetUploadBudget(const UploadBudget& budget);
+        UploadSchedulerStats GetUploadSchedulerStats() const;
+        // Pooled staging buffers unused for this many frames are freed (checked as frames retire). Zero keeps them forever
+        void SetStagingPoolIdleFrames(uint32_t frames);
+        StagingPoolStats GetStagingPoolStats() const;
+
+        // Decoder for entries of GpuCompressedResourceData using codec, replacing any earlier one (nullptr removes it). Register
+        // codecs before creating anything that uses them: creations naming an unregistered codec fail
+        void RegisterDecompressionCodec(GpuCompressionCodec codec, DecompressionFn fn, void* user_data = nullptr);
+        DecompressionStats GetDecompressionStats() const;
+
+        SamplerCacheStats GetSamplerCacheStats() const;
+        ViewCacheStats GetViewCacheStats() const;
+        CoroutineFrameStats GetCoroutineFrameStats() const;
 
         /*
         void SetBufferData(
@@ -67,7 +163,25 @@ namespace petrichor
         void UnmapResourceMemory(GpuResource* resource, size_t size, size_t offset);
         */
 
+        // Writes a JSON report: VMA's detailed statistics per heap and memory type, plus totals per memory domain and
+        // per creation flag, broken down by the names given with ResourceCreateUserDataAsString. Throws if the file can't be opened
         void WriteMemoryStatsFile(const char* output_file);
+        // Samples heap usage and per-domain totals every frame_interval frames in Update(), keeping the newest capacity
+        // samples. Zero for either disables sampling. Clears any samples already taken
+        void EnableMemoryStatsSnapshots(uint32_t frame_interval, uint32_t capacity = 256u);
+        // Copies the samples out oldest first. Call with samples == nullptr to get the count
+        void GetMemoryStatsSnapshots(uint32_t* num_samples, MemoryStatsSample* samples) const;
+        // Writes the samples in binary (see MemoryStatsSnapshotFileHeader), for tools/MemoryStatsDiff to compare
+        void WriteMemoryStatsSnapshots(const char* output_file) const;
+
+        // Timestamps every creation's trip through the states in ResourceCreationEvent, keeping the newest capacity traces
+        // (zero disables tracing). Creations with uploads are traced until the frame they were submitted in is recycled
+        void EnableCreationTracing(uint32_t capacity = 4096u);
+        // Percentiles of each ResourceCreationStage, per resource type and size class. Call with latencies == nullptr to
+        // get the count. Traces keep arriving, so the count can change between calls: at most *num_latencies are written
+        void GetCreationLatencies(uint32_t* num_latencies, ResourceCreationLatency* latencies) const;
+        // Writes the same as a JSON report. Throws if the file can't be opened
+        void WriteCreationLatencyFile(const char* output_file) const;
 
 
     private:
@@ -0,0 +1,202 @@
+#include "BindlessHeap.hpp"
+#include "RenderingContext.hpp"
+#include "vkAssert.hpp"
+#include <algorithm>
+
+namespace petrichor
+{
+
+    bool BindlessDescriptorHeap::create(VkDevice device, const DescriptorLimits& limits)
+    {
+        // Every array is visible to every stage, so the per-stage limits apply as well as the per-set ones
+        uint32_t sampledImages = std::min({ MaxSampledImages, limits.MaxUpdateAfterBindSampledImages, limits.MaxPerStageUpdateAfterBindSampledImages });
+        uint32_t storageBuffers = std::min({ MaxStorageBuffers, limits.MaxUpdateAfterBindStorageBuffers, limits.MaxPerStageUpdateAfterBindStorageBuffers });
+        const uint32_t samplers = std::min({ MaxSamplers, limits.MaxUpdateAfterBindSamplers, limits.MaxPerStageUpdateAfterBindSamplers });
+
+        // Images and buffers also share a per-stage total: split it evenly if we'd go over
+        if (static_cast<uint64_t>(sampledImages) + storageBuffers > limits.MaxPerStageUpdateAfterBindResources)
+        {
+            sampledImages = std::min(sampledImages, limits.MaxPerStageUpdateAfterBindResources / 2u);
+            storageBuffers = std::min(storageBuffers, limits.MaxPerStageUpdateAfterBindResources - sampledImages);
+        }
+
+        if ((sampledImages == 0u) || (storageBuffers == 0u) || (samplers == 0u))
+        {
+            return false;
+        }
+
+        bindings[BindlessSampledImageBinding].capacity = sampledImages;
+        bindings[BindlessStorageBufferBinding].capacity = storageBuffers;
+        bindings[BindlessSamplerBinding].capacity = samplers;
+
+        const VkDescriptorSetLayoutBinding layoutBindings[BindingCount]
+        {
+            { BindlessSampledImageBinding, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, sampledImages, VK_SHADER_STAGE_ALL, nullptr },
+            { BindlessStorageBufferBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBuffers, VK_SHADER_STAGE_ALL, nullptr },
+            { BindlessSamplerBinding, VK_DESCRIPTOR_TYPE_SAMPLER, samplers, VK_SHADER_STAGE_ALL, nullptr }
+        };
+
+        // Slots are only ever written while unused, so sets already bound by in-flight command buffers stay valid
+        constexpr static VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+        const VkDescriptorBindingFlags layoutBindingFlags[BindingCount]{ bindingFlags, bindingFlags, bindingFlags };
+        const VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo
+        {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+            nullptr,
+            BindingCount,
+            layoutBindingFlags
+        };
+
+        const VkDescriptorSetLayoutCreateInfo layoutInfo
+        {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            &bindingFlagsInfo,
+            VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+            BindingCount,
+            layoutBindings
+        };
+
+        VkResult result = vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &setLayout);
+        VkAssert(result);
+
+        const VkDescriptorPoolSize poolSizes[BindingCount]
+        {
+            { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, sampledImages },
+            { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBuffers },
+            { VK_DESCRIPTOR_TYPE_SAMPLER, samplers }
+        };
+
+        const VkDescriptorPoolCreateInfo poolInfo
+        {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            nullptr,
+            VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+            1u,
+            BindingCount,
+            poolSizes
+        };
+
+        result = vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool);
+        VkAssert(result);
+
+        const VkDescriptorSetAllocateInfo allocInfo
+        {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            nullptr,
+            pool,
+            1u,
+            &setLayout
+        };
+
+        result = vkAllocateDescriptorSets(device, &allocInfo, &set);
+        VkAssert(result);
+
+        return true;
+    }
+
+    void BindlessDescriptorHeap::destroy(VkDevice device)
+    {
+        if (pool != VK_NULL_HANDLE)
+        {
+            // Frees the set along with it
+            vkDestroyDescriptorPool(device, pool, nullptr);
+            pool = VK_NULL_HANDLE;
+            set = VK_NULL_HANDLE;
+        }
+
+        if (setLayout != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+            setLayout = VK_NULL_HANDLE;
+        }
+
+        bindings = {};
+        pendingWrites.clear();
+    }
+
+    bool BindlessDescriptorHeap::valid() const noexcept
+    {
+        return set != VK_NULL_HANDLE;
+    }
+
+    uint32_t BindlessDescriptorHeap::acquire(uint32_t binding)
+    {
+        BindingSlots& slots = bindings[binding];
+        if (!slots.freeIndices.empty())
+        {
+            const uint32_t index = slots.freeIndices.back();
+            slots.freeIndices.pop_back();
+            return index;
+        }
+
+        return slots.next < slots.capacity ? slots.next++ : BindlessIndexInvalid;
+    }
+
+    void BindlessDescriptorHeap::release(uint32_t binding, uint32_t index)
+    {
+        // Left as-is: partially bound slots can hold a dangling descriptor, as long as nothing reads them
+        bindings[binding].freeIndices.emplace_back(index);
+    }
+
+    void BindlessDescriptorHeap::write(uint32_t binding, uint32_t index, uint64_t vk_handle)
+    {
+        pendingWrites.emplace_back(PendingWrite{ binding, index, vk_handle });
+    }
+
+    void BindlessDescriptorHeap::flush(VkDevice device)
+    {
+        if (pendingWrites.empty())
+        {
+            return;
+        }
+
+        writes.clear();
+        imageInfos.clear();
+        bufferInfos.clear();
+        // Reserved up front, as the writes point into these
+        imageInfos.reserve(pendingWrites.size());
+        bufferInfos.reserve(pendingWrites.size());
+
+        for (const auto& pending : pendingWrites)
+        {
+            VkWriteDescriptorSet descriptorWrite
+            {
+                VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                nullptr,
+                set,
+                pending.binding,
+                pending.index,
+                1u,
+                VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                nullptr,
+                nullptr,
+                nullptr
+            };
+
+            switch (pending.binding)
+            {
+            case BindlessSampledImageBinding:
+                imageInfos.emplace_back(VkDescriptorImageInfo{ VK_NULL_HANDLE, (VkImageView)pending.vkHandle, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+                descriptorWrite.pImageInfo = &imageInfos.back();
+                break;
+            case BindlessStorageBufferBinding:
+                descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                bufferInfos.emplace_back(VkDescriptorBufferInfo{ (VkBuffer)pending.vkHandle, 0u, VK_WHOLE_SIZE });
+                descriptorWrite.pBufferInfo = &bufferInfos.back();
+                break;
+            default:
+                descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+                imageInfos.emplace_back(VkDescriptorImageInfo{ (VkSampler)pending.vkHandle, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED });
+                descriptorWrite.pImageInfo = &imageInfos.back();
+                break;
+            }
+
+            writes.emplace_back(descriptorWrite);
+        }
+
+        // Later writes to the same slot win, which is what we want when a buffer is demoted in the frame it was made
+        vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0u, nullptr);
+        pendingWrites.clear();
+    }
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+#ifndef PETRICHOR_BINDLESS_HEAP_HPP
+#define PETRICHOR_BINDLESS_HEAP_HPP
+#include "PetrichorResourceTypes.hpp"
+#include <array>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace petrichor
+{
+
+    struct DescriptorLimits;
+
+    // One update-after-bind descriptor set holding an array per binding (see BindlessSampledImageBinding and co.),
+    // with every slot partially bound. Indices are handed out on creation and written in one batch per frame
+    struct BindlessDescriptorHeap
+    {
+        // Most we'll ask for per array, before clamping to the device's limits
+        constexpr static uint32_t MaxSampledImages = 262144u;
+        constexpr static uint32_t MaxStorageBuffers = 262144u;
+        // Devices only guarantee 4000 live samplers, and the sampler cache keeps us far below that anyway
+        constexpr static uint32_t MaxSamplers = 4000u;
+
+        // Returns false, creating nothing, if the limits are too low to be of any use
+        bool create(VkDevice device, const DescriptorLimits& limits);
+        void destroy(VkDevice device);
+        bool valid() const noexcept;
+
+        // BindlessIndexInvalid if the array is full
+        uint32_t acquire(uint32_t binding);
+        // Only once nothing in flight can still be reading the slot: we release from the deferred destruction path
+        void release(uint32_t binding, uint32_t index);
+        // Queues a write of vk_handle (VkImageView, VkBuffer or VkSampler depending on binding) into the slot.
+        // Images are expected to be in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL whenever they're sampled
+        void write(uint32_t binding, uint32_t index, uint64_t vk_handle);
+        // Makes every queued write with one vkUpdateDescriptorSets call
+        void flush(VkDevice device);
+
+        VkDescriptorSetLayout setLayout{ VK_NULL_HANDLE };
+        VkDescriptorPool pool{ VK_NULL_HANDLE };
+        VkDescriptorSet set{ VK_NULL_HANDLE };
+
+    private:
+        constexpr static uint32_t BindingCount = 3u;
+
+        struct BindingSlots
+        {
+            uint32_t capacity{ 0u };
+            // Indices below this have been handed out at least once
+            uint32_t next{ 0u };
+            std::vector<uint32_t> freeIndices;
+        };
+
+        struct PendingWrite
+        {
+            uint32_t binding{ 0u };
+            uint32_t index{ 0u };
+            uint64_t vkHandle{ 0u };
+        };
+
+        std::array<BindingSlots, BindingCount> bindings{};
+        std::vector<PendingWrite> pendingWrites;
+        // Kept around between flushes, so batching doesn't allocate every frame
+        std::vector<VkWriteDescriptorSet> writes;
+        std::vector<VkDescriptorImageInfo> imageInfos;
+        std::vector<VkDescriptorBufferInfo> bufferInfos;
+    };
+
+}
+
+#endif //!PETRICHOR_BINDLESS_HEAP_HPP
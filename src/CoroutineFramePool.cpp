@@ -0,0 +1,102 @@
+#include "CoroutineFramePool.hpp"
+#include <functional>
+#include <new>
+#include <thread>
+
+namespace petrichor
+{
+
+    CoroutineFramePool::~CoroutineFramePool()
+    {
+        // Frames still out there (replies that outlived the context) would be left pointing into freed slabs
+        if (outstandingFrames.load(std::memory_order_acquire) != 0u)
+        {
+            return;
+        }
+
+        for (auto* slab : slabs)
+        {
+            ::operator delete(slab);
+        }
+    }
+
+    void* CoroutineFramePool::allocate(size_t size)
+    {
+        totalFrames.fetch_add(1u, std::memory_order_relaxed);
+        outstandingFrames.fetch_add(1u, std::memory_order_relaxed);
+
+        const size_t blockSize = size + sizeof(FrameHeader);
+        std::byte* block = nullptr;
+        bool pooled = PETRICHOR_COROUTINE_FRAME_POOL_ENABLED && (blockSize <= BlockSize);
+
+        if (pooled)
+        {
+            Shard& shard = callingThreadShard();
+            std::lock_guard shardLock(shard.mutex);
+            if (shard.freeBlocks.empty())
+            {
+                addSlab(shard);
+            }
+            block = shard.freeBlocks.back();
+            shard.freeBlocks.pop_back();
+        }
+        else
+        {
+            heapFrames.fetch_add(1u, std::memory_order_relaxed);
+            block = static_cast<std::byte*>(::operator new(blockSize));
+        }
+
+        FrameHeader* header = new (block) FrameHeader{ this, pooled };
+        return header + 1;
+    }
+
+    void CoroutineFramePool::deallocate(void* frame, size_t) noexcept
+    {
+        FrameHeader* header = static_cast<FrameHeader*>(frame) - 1;
+        CoroutineFramePool* pool = header->pool;
+        pool->outstandingFrames.fetch_sub(1u, std::memory_order_relaxed);
+
+        if (!header->pooled)
+        {
+            ::operator delete(header);
+            return;
+        }
+
+        // Goes back to the freeing thread's shard: threads that destroy replies end up with blocks to create with
+        Shard& shard = pool->callingThreadShard();
+        std::lock_guard shardLock(shard.mutex);
+        shard.freeBlocks.emplace_back(reinterpret_cast<std::byte*>(header));
+    }
+
+    CoroutineFrameStats CoroutineFramePool::stats() const noexcept
+    {
+        CoroutineFrameStats result;
+        result.OutstandingFrames = outstandingFrames.load(std::memory_order_relaxed);
+        result.TotalFrames = totalFrames.load(std::memory_order_relaxed);
+        result.HeapFrames = heapFrames.load(std::memory_order_relaxed);
+        std::lock_guard slabLock(slabMutex);
+        result.PooledBytes = static_cast<uint64_t>(slabs.size()) * BlockSize * BlocksPerSlab;
+        return result;
+    }
+
+    CoroutineFramePool::Shard& CoroutineFramePool::callingThreadShard() noexcept
+    {
+        return shards[std::hash<std::thread::id>{}(std::this_thread::get_id()) % NumShards];
+    }
+
+    void CoroutineFramePool::addSlab(Shard& shard)
+    {
+        std::byte* slab = static_cast<std::byte*>(::operator new(BlockSize * BlocksPerSlab));
+        {
+            std::lock_guard slabLock(slabMutex);
+            slabs.emplace_back(slab);
+        }
+
+        shard.freeBlocks.reserve(shard.freeBlocks.size() + BlocksPerSlab);
+        for (size_t i = 0u; i < BlocksPerSlab; ++i)
+        {
+            shard.freeBlocks.emplace_back(slab + (i * BlockSize));
+        }
+    }
+
+}
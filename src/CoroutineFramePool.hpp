@@ -0,0 +1,68 @@
+#pragma once
+#ifndef PETRICHOR_COROUTINE_FRAME_POOL_HPP
+#define PETRICHOR_COROUTINE_FRAME_POOL_HPP
+#include "RenderingContextConfig.hpp"
+#include "PetrichorResourceTypes.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#ifdef PETRICHOR_COROUTINE_FRAME_POOL_ENABLED_CONF
+constexpr static bool PETRICHOR_COROUTINE_FRAME_POOL_ENABLED = true;
+#else
+constexpr static bool PETRICHOR_COROUTINE_FRAME_POOL_ENABLED = false;
+#endif
+
+namespace petrichor
+{
+
+    // Fixed size blocks for coroutine frames, carved out of larger slabs. Free blocks are spread over a few shards
+    // picked by thread, so producers creating resources in parallel rarely contend on the same lock
+    class CoroutineFramePool
+    {
+    public:
+        CoroutineFramePool() = default;
+        ~CoroutineFramePool();
+        CoroutineFramePool(const CoroutineFramePool&) = delete;
+        CoroutineFramePool& operator=(const CoroutineFramePool&) = delete;
+
+        void* allocate(size_t size);
+        // Static, since the frame has to find its way back to the pool it came from on its own
+        static void deallocate(void* frame, size_t size) noexcept;
+        CoroutineFrameStats stats() const noexcept;
+
+        // Frames bigger than this go to the global heap
+        constexpr static size_t BlockSize = 1024u;
+        constexpr static size_t BlocksPerSlab = 64u;
+        constexpr static size_t NumShards = 8u;
+
+    private:
+        // Sits in front of every frame, so deallocate() knows where it came from. Keeps the frame 16 byte aligned
+        struct alignas(16) FrameHeader
+        {
+            CoroutineFramePool* pool;
+            bool pooled;
+        };
+
+        struct alignas(64) Shard
+        {
+            std::mutex mutex;
+            std::vector<std::byte*> freeBlocks;
+        };
+
+        Shard& callingThreadShard() noexcept;
+        void addSlab(Shard& shard);
+
+        std::array<Shard, NumShards> shards;
+        mutable std::mutex slabMutex;
+        std::vector<std::byte*> slabs;
+        std::atomic<uint64_t> outstandingFrames{ 0u };
+        std::atomic<uint64_t> totalFrames{ 0u };
+        std::atomic<uint64_t> heapFrames{ 0u };
+    };
+
+}
+
+#endif //!PETRICHOR_COROUTINE_FRAME_POOL_HPP
@@ -0,0 +1,165 @@
+#include "CreationTrace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <utility>
+
+namespace petrichor
+{
+
+    void CreationTrace::mark(ResourceCreationEvent::State state) noexcept
+    {
+        uint64_t& timestamp = timestamps[static_cast<size_t>(state)];
+        if (timestamp == 0u)
+        {
+            timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+    }
+
+    bool CreationTrace::reached(ResourceCreationEvent::State state) const noexcept
+    {
+        return timestamps[static_cast<size_t>(state)] != 0u;
+    }
+
+    CreationTraceBuffer::CreationTraceBuffer(uint32_t _capacity) : slots(std::make_unique<Slot[]>(std::max(_capacity, 1u))),
+        capacity(std::max(_capacity, 1u)) {}
+
+    void CreationTraceBuffer::push(const CreationTrace& trace) noexcept
+    {
+        const uint64_t ticket = nextTicket.fetch_add(1u, std::memory_order_relaxed);
+        Slot& slot = slots[ticket % capacity];
+
+        uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        if ((sequence & 1u) || !slot.sequence.compare_exchange_strong(sequence, (ticket * 2u) + 1u, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            dropped.fetch_add(1u, std::memory_order_relaxed);
+            return;
+        }
+
+        // Keeps the field stores below from moving ahead of the odd sequence number
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.size.store(trace.size, std::memory_order_relaxed);
+        slot.type.store(trace.type, std::memory_order_relaxed);
+        for (size_t i = 0u; i < CreationStateCount; ++i)
+        {
+            slot.timestamps[i].store(trace.timestamps[i], std::memory_order_relaxed);
+        }
+        slot.sequence.store((ticket * 2u) + 2u, std::memory_order_release);
+    }
+
+    void CreationTraceBuffer::copyTraces(std::vector<CreationTrace>& traces) const
+    {
+        for (uint32_t i = 0u; i < capacity; ++i)
+        {
+            const Slot& slot = slots[i];
+            const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if ((sequence == 0u) || (sequence & 1u))
+            {
+                continue;
+            }
+
+            CreationTrace trace;
+            trace.size = slot.size.load(std::memory_order_relaxed);
+            trace.type = slot.type.load(std::memory_order_relaxed);
+            for (size_t j = 0u; j < CreationStateCount; ++j)
+            {
+                trace.timestamps[j] = slot.timestamps[j].load(std::memory_order_relaxed);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == sequence)
+            {
+                traces.emplace_back(trace);
+            }
+        }
+    }
+
+    uint64_t CreationTraceBuffer::droppedTraces() const noexcept
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+    uint32_t CreationSizeClass(uint64_t size) noexcept
+    {
+        constexpr static uint64_t SizeClassLimits[CreationSizeClassCount - 1u] = { 64u * 1024u, 1024u * 1024u, 16u * 1024u * 1024u };
+        uint32_t sizeClass = 0u;
+        while ((sizeClass < CreationSizeClassCount - 1u) && (size >= SizeClassLimits[sizeClass]))
+        {
+            ++sizeClass;
+        }
+        return sizeClass;
+    }
+
+    void ComputeCreationLatencies(const std::vector<CreationTrace>& traces, std::vector<ResourceCreationLatency>& latencies)
+    {
+        using StageSamples = std::array<std::vector<double>, ResourceCreationStageCount>;
+        std::map<std::pair<GpuResourceType, uint32_t>, std::pair<uint32_t, StageSamples>> groups;
+
+        std::vector<std::pair<uint64_t, size_t>> reachedStates;
+        for (const auto& trace : traces)
+        {
+            if (!trace.reached(ResourceCreationEvent::State::Queued))
+            {
+                continue;
+            }
+
+            reachedStates.clear();
+            for (size_t i = 0u; i < CreationStateCount; ++i)
+            {
+                if (trace.timestamps[i] != 0u)
+                {
+                    reachedStates.emplace_back(trace.timestamps[i], i);
+                }
+            }
+            // Time order rather than state order: each gap goes to the stage of the state it ended with
+            std::sort(reachedStates.begin(), reachedStates.end());
+
+            auto& [numSamples, samples] = groups[std::make_pair(trace.type, CreationSizeClass(trace.size))];
+            ++numSamples;
+            for (size_t i = 1u; i < reachedStates.size(); ++i)
+            {
+                // Stages line up with the states after Queued
+                const size_t stage = reachedStates[i].second - 1u;
+                samples[stage].emplace_back(static_cast<double>(reachedStates[i].first - reachedStates[i - 1u].first) / 1.0e3);
+            }
+
+            const size_t totalStage = static_cast<size_t>(ResourceCreationStage::Total);
+            samples[totalStage].emplace_back(static_cast<double>(reachedStates.back().first - reachedStates.front().first) / 1.0e3);
+        }
+
+        for (auto& [key, group] : groups)
+        {
+            ResourceCreationLatency latency;
+            latency.Type = key.first;
+            latency.SizeClass = key.second;
+            latency.NumSamples = group.first;
+
+            for (uint32_t stage = 0u; stage < ResourceCreationStageCount; ++stage)
+            {
+                std::vector<double>& samples = group.second[stage];
+                if (samples.empty())
+                {
+                    continue;
+                }
+
+                std::sort(samples.begin(), samples.end());
+                // Nearest rank
+                auto percentile = [&samples](const double fraction)
+                {
+                    const size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(samples.size())));
+                    return samples[std::max(rank, size_t(1u)) - 1u];
+                };
+
+                latency.P50[stage] = percentile(0.5);
+                latency.P90[stage] = percentile(0.9);
+                latency.P99[stage] = percentile(0.99);
+                latency.Max[stage] = samples.back();
+            }
+
+            latencies.emplace_back(latency);
+        }
+    }
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+#ifndef PETRICHOR_CREATION_TRACE_HPP
+#define PETRICHOR_CREATION_TRACE_HPP
+#include "ResourceCreationCoro.hpp"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace petrichor
+{
+
+    constexpr static size_t CreationStateCount = static_cast<size_t>(ResourceCreationEvent::State::Count);
+
+    // One creation's trip through ResourceCreationEvent::State, in steady clock nanoseconds. Zero for states it never reached
+    struct CreationTrace
+    {
+        GpuResourceType type{ GpuResourceType::Invalid };
+        uint64_t size{ 0u };
+        std::array<uint64_t, CreationStateCount> timestamps{};
+
+        // Only the first time a state is reached counts
+        void mark(ResourceCreationEvent::State state) noexcept;
+        bool reached(ResourceCreationEvent::State state) const noexcept;
+    };
+
+    // Ring of finished traces: once full, new ones overwrite the oldest. Pushing claims a slot with one atomic add
+    // and never blocks. A push finding its slot still being written (the ring wrapped around onto a slow writer) is dropped
+    struct CreationTraceBuffer
+    {
+        explicit CreationTraceBuffer(uint32_t capacity);
+        CreationTraceBuffer(const CreationTraceBuffer&) = delete;
+        CreationTraceBuffer& operator=(const CreationTraceBuffer&) = delete;
+
+        void push(const CreationTrace& trace) noexcept;
+        // Appends every trace in the ring that isn't mid-write
+        void copyTraces(std::vector<CreationTrace>& traces) const;
+        uint64_t droppedTraces() const noexcept;
+
+    private:
+        // Odd sequence numbers mark a slot being written, like DeviceAddressTable's handles: readers only keep
+        // what they read between two loads of the same even number
+        struct Slot
+        {
+            std::atomic<uint64_t> sequence{ 0u };
+            std::atomic<uint64_t> size{ 0u };
+            std::atomic<GpuResourceType> type{ GpuResourceType::Invalid };
+            std::array<std::atomic<uint64_t>, CreationStateCount> timestamps{};
+        };
+
+        std::unique_ptr<Slot[]> slots;
+        uint32_t capacity{ 0u };
+        std::atomic<uint64_t> nextTicket{ 0u };
+        std::atomic<uint64_t> dropped{ 0u };
+    };
+
+    uint32_t CreationSizeClass(uint64_t size) noexcept;
+    // Groups traces by type and size class, ordered by both, and works out the percentiles of each stage
+    void ComputeCreationLatencies(const std::vector<CreationTrace>& traces, std::vector<ResourceCreationLatency>& latencies);
+
+}
+
+#endif //!PETRICHOR_CREATION_TRACE_HPP
@@ -0,0 +1,84 @@
+#include "DeviceAddressTable.hpp"
+
+namespace petrichor
+{
+
+    DeviceAddressTable::~DeviceAddressTable()
+    {
+        clear();
+    }
+
+    void DeviceAddressTable::publish(GpuResourceHandle handle, uint64_t address)
+    {
+        const uint32_t slot = static_cast<uint32_t>(handle & 0xFFFFFFFFu);
+        const uint32_t chunkIdx = slot / ChunkSize;
+        if (chunkIdx >= MaxChunks)
+        {
+            // Past the end of the table: find() reports no address, as for any buffer without one
+            return;
+        }
+
+        Entry* chunk = chunks[chunkIdx].load(std::memory_order_acquire);
+        if (chunk == nullptr)
+        {
+            chunk = new Entry[ChunkSize];
+            chunks[chunkIdx].store(chunk, std::memory_order_release);
+        }
+
+        Entry& dest = chunk[slot % ChunkSize];
+        dest.handle.store(INVALID_GPU_RESOURCE_HANDLE, std::memory_order_release);
+        dest.address.store(address, std::memory_order_release);
+        dest.handle.store(handle, std::memory_order_release);
+    }
+
+    void DeviceAddressTable::retract(GpuResourceHandle handle) noexcept
+    {
+        Entry* found = entry(static_cast<uint32_t>(handle & 0xFFFFFFFFu));
+        if ((found == nullptr) || (found->handle.load(std::memory_order_acquire) != handle))
+        {
+            return;
+        }
+
+        found->handle.store(INVALID_GPU_RESOURCE_HANDLE, std::memory_order_release);
+        found->address.store(0u, std::memory_order_release);
+    }
+
+    uint64_t DeviceAddressTable::find(GpuResourceHandle handle) const noexcept
+    {
+        if (handle == INVALID_GPU_RESOURCE_HANDLE)
+        {
+            return 0u;
+        }
+
+        const Entry* found = entry(static_cast<uint32_t>(handle & 0xFFFFFFFFu));
+        if ((found == nullptr) || (found->handle.load(std::memory_order_acquire) != handle))
+        {
+            return 0u;
+        }
+
+        const uint64_t address = found->address.load(std::memory_order_acquire);
+        // Changed while we were reading it: the address may belong to whatever replaced it
+        return found->handle.load(std::memory_order_acquire) == handle ? address : 0u;
+    }
+
+    void DeviceAddressTable::clear() noexcept
+    {
+        for (auto& chunk : chunks)
+        {
+            delete[] chunk.exchange(nullptr, std::memory_order_acq_rel);
+        }
+    }
+
+    DeviceAddressTable::Entry* DeviceAddressTable::entry(uint32_t slot) const noexcept
+    {
+        const uint32_t chunkIdx = slot / ChunkSize;
+        if (chunkIdx >= MaxChunks)
+        {
+            return nullptr;
+        }
+
+        Entry* chunk = chunks[chunkIdx].load(std::memory_order_acquire);
+        return chunk != nullptr ? &chunk[slot % ChunkSize] : nullptr;
+    }
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+#ifndef PETRICHOR_DEVICE_ADDRESS_TABLE_HPP
+#define PETRICHOR_DEVICE_ADDRESS_TABLE_HPP
+#include "PetrichorResourceTypes.hpp"
+#include <array>
+#include <atomic>
+
+namespace petrichor
+{
+
+    // Device addresses of buffers, indexed by handle slot and readable without taking any lock. Chunks are
+    // allocated as slots are first used and never move or get freed until clear(), so readers can always
+    // dereference what they load. Writers have to be serialized by the caller (we hold recordMutex exclusively)
+    struct DeviceAddressTable
+    {
+        DeviceAddressTable() noexcept = default;
+        ~DeviceAddressTable();
+        DeviceAddressTable(const DeviceAddressTable&) = delete;
+        DeviceAddressTable& operator=(const DeviceAddressTable&) = delete;
+
+        // Replaces whatever the slot held, including an earlier address for the same handle
+        void publish(GpuResourceHandle handle, uint64_t address);
+        void retract(GpuResourceHandle handle) noexcept;
+        // Zero for stale handles, and handles without an address
+        uint64_t find(GpuResourceHandle handle) const noexcept;
+        // Not safe against concurrent readers: only for when the context is destroyed
+        void clear() noexcept;
+
+    private:
+        // The handle doubles as a sequence number: it's invalidated before the address changes, and set again after,
+        // so a reader seeing the same handle on both sides of its address load knows the address belongs to it
+        struct Entry
+        {
+            std::atomic<GpuResourceHandle> handle{ INVALID_GPU_RESOURCE_HANDLE };
+            std::atomic<uint64_t> address{ 0u };
+        };
+
+        constexpr static uint32_t ChunkSize = 4096u;
+        constexpr static uint32_t MaxChunks = 1024u;
+
+        Entry* entry(uint32_t slot) const noexcept;
+        std::array<std::atomic<Entry*>, MaxChunks> chunks{};
+    };
+
+}
+
+#endif //!PETRICHOR_DEVICE_ADDRESS_TABLE_HPP
@@ -0,0 +1,199 @@
+#include "FormatCapabilities.hpp"
+
+namespace petrichor
+{
+
+    void FormatCapabilityTable::build(VkPhysicalDevice device, const VkPhysicalDeviceFeatures& features, bool transfer_features_reported)
+    {
+        for (uint32_t i = 0u; i < CoreFormatCount; ++i)
+        {
+            VkFormatProperties properties{};
+            vkGetPhysicalDeviceFormatProperties(device, static_cast<VkFormat>(i), &properties);
+            formats[i] = FormatEntry{ properties.optimalTilingFeatures, properties.linearTilingFeatures, properties.bufferFeatures };
+        }
+
+        transferFeaturesReported = transfer_features_reported;
+        bcSupported = features.textureCompressionBC == VK_TRUE;
+        etc2Supported = features.textureCompressionETC2 == VK_TRUE;
+        astcLdrSupported = features.textureCompressionASTC_LDR == VK_TRUE;
+    }
+
+    bool FormatCapabilityTable::covers(VkFormat format) const noexcept
+    {
+        return static_cast<uint32_t>(format) < CoreFormatCount;
+    }
+
+    VkFormatFeatureFlags FormatCapabilityTable::features(VkFormat format, VkImageTiling tiling) const noexcept
+    {
+        if (!covers(format))
+        {
+            return 0u;
+        }
+
+        const FormatEntry& entry = formats[static_cast<uint32_t>(format)];
+        return tiling == VK_IMAGE_TILING_LINEAR ? entry.linearFeatures : entry.optimalFeatures;
+    }
+
+    VkFormatFeatureFlags FormatCapabilityTable::bufferFeatures(VkFormat format) const noexcept
+    {
+        return covers(format) ? formats[static_cast<uint32_t>(format)].bufferFeatures : 0u;
+    }
+
+    VkFormatFeatureFlags FormatCapabilityTable::featureFlagsFromUsage(VkImageUsageFlags usage) const noexcept
+    {
+        VkFormatFeatureFlags result = 0u;
+        if (usage & VK_IMAGE_USAGE_SAMPLED_BIT)
+        {
+            result |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+        }
+        if (usage & VK_IMAGE_USAGE_STORAGE_BIT)
+        {
+            result |= VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+        }
+        if (usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)
+        {
+            result |= VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT;
+        }
+        if (usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)
+        {
+            result |= VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        }
+        if (transferFeaturesReported)
+        {
+            if (usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+            {
+                result |= VK_FORMAT_FEATURE_TRANSFER_SRC_BIT;
+            }
+            if (usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+            {
+                result |= VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+            }
+        }
+        return result;
+    }
+
+    bool FormatCapabilityTable::supportsImage(const VkImageCreateInfo& info) const noexcept
+    {
+        if (!covers(info.format))
+        {
+            return true;
+        }
+
+        const VkFormatFeatureFlags required = featureFlagsFromUsage(info.usage);
+        const VkFormatFeatureFlags available = features(info.format, info.tiling);
+        // A format with no features at all isn't supported for this tiling, even if usage asked for nothing we check
+        return (available != 0u) && ((available & required) == required);
+    }
+
+    bool FormatCapabilityTable::compressionFamilySupported(VkFormat format) const noexcept
+    {
+        if ((format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK) && (format <= VK_FORMAT_BC7_SRGB_BLOCK))
+        {
+            return bcSupported;
+        }
+        if ((format >= VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK) && (format <= VK_FORMAT_EAC_R11G11_SNORM_BLOCK))
+        {
+            return etc2Supported;
+        }
+        if ((format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK) && (format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK))
+        {
+            return astcLdrSupported;
+        }
+        return false;
+    }
+
+    bool FormatCapabilityTable::isBlockCompressed(VkFormat format) noexcept
+    {
+        return (format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK) && (format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK);
+    }
+
+    FormatBlockInfo FormatCapabilityTable::blockInfo(VkFormat format) noexcept
+    {
+        switch (format)
+        {
+        // 64 bit blocks: BC1, BC4, ETC2 without alpha (or with punchthrough alpha), and single channel EAC
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+        case VK_FORMAT_BC4_SNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+        case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+        case VK_FORMAT_EAC_R11_SNORM_BLOCK:
+            return FormatBlockInfo{ 4u, 4u, 8u };
+        case VK_FORMAT_BC2_UNORM_BLOCK:
+        case VK_FORMAT_BC2_SRGB_BLOCK:
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+        case VK_FORMAT_BC5_SNORM_BLOCK:
+        case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+        case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+        case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+        case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+        case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+            return FormatBlockInfo{ 4u, 4u, 16u };
+        // Every ASTC block is 128 bits, whatever its footprint
+        case VK_FORMAT_ASTC_5x4_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_5x4_SRGB_BLOCK:
+            return FormatBlockInfo{ 5u, 4u, 16u };
+        case VK_FORMAT_ASTC_5x5_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_5x5_SRGB_BLOCK:
+            return FormatBlockInfo{ 5u, 5u, 16u };
+        case VK_FORMAT_ASTC_6x5_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_6x5_SRGB_BLOCK:
+            return FormatBlockInfo{ 6u, 5u, 16u };
+        case VK_FORMAT_ASTC_6x6_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_6x6_SRGB_BLOCK:
+            return FormatBlockInfo{ 6u, 6u, 16u };
+        case VK_FORMAT_ASTC_8x5_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_8x5_SRGB_BLOCK:
+            return FormatBlockInfo{ 8u, 5u, 16u };
+        case VK_FORMAT_ASTC_8x6_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_8x6_SRGB_BLOCK:
+            return FormatBlockInfo{ 8u, 6u, 16u };
+        case VK_FORMAT_ASTC_8x8_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_8x8_SRGB_BLOCK:
+            return FormatBlockInfo{ 8u, 8u, 16u };
+        case VK_FORMAT_ASTC_10x5_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_10x5_SRGB_BLOCK:
+            return FormatBlockInfo{ 10u, 5u, 16u };
+        case VK_FORMAT_ASTC_10x6_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_10x6_SRGB_BLOCK:
+            return FormatBlockInfo{ 10u, 6u, 16u };
+        case VK_FORMAT_ASTC_10x8_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_10x8_SRGB_BLOCK:
+            return FormatBlockInfo{ 10u, 8u, 16u };
+        case VK_FORMAT_ASTC_10x10_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_10x10_SRGB_BLOCK:
+            return FormatBlockInfo{ 10u, 10u, 16u };
+        case VK_FORMAT_ASTC_12x10_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_12x10_SRGB_BLOCK:
+            return FormatBlockInfo{ 12u, 10u, 16u };
+        case VK_FORMAT_ASTC_12x12_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_12x12_SRGB_BLOCK:
+            return FormatBlockInfo{ 12u, 12u, 16u };
+        default:
+            return FormatBlockInfo{};
+        }
+    }
+
+    VkDeviceSize FormatCapabilityTable::blockCompressedSize(VkFormat format, uint32_t width, uint32_t height, uint32_t depth) noexcept
+    {
+        const FormatBlockInfo block = blockInfo(format);
+        // Partial blocks at the right and bottom edges are stored whole
+        const VkDeviceSize blocksWide = (width + block.width - 1u) / block.width;
+        const VkDeviceSize blocksHigh = (height + block.height - 1u) / block.height;
+        return blocksWide * blocksHigh * depth * block.bytes;
+    }
+
+}
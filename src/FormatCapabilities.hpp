@@ -0,0 +1,60 @@
+#pragma once
+#ifndef PETRICHOR_FORMAT_CAPABILITIES_HPP
+#define PETRICHOR_FORMAT_CAPABILITIES_HPP
+#include <vulkan/vulkan_core.h>
+#include <array>
+#include <cstdint>
+
+namespace petrichor
+{
+
+    // Texel block of a format. Uncompressed formats are single texel blocks, with bytes left at zero (we don't track them)
+    struct FormatBlockInfo
+    {
+        uint32_t width{ 1u };
+        uint32_t height{ 1u };
+        uint32_t bytes{ 0u };
+    };
+
+    // Features of every core format, queried once up front so image creation doesn't go back to the driver each time.
+    // Formats from extensions aren't covered, and are taken on trust
+    struct FormatCapabilityTable
+    {
+        // transfer_features_reported is set when the device reports VK_FORMAT_FEATURE_TRANSFER_SRC/DST_BIT (1.1, or maintenance1)
+        void build(VkPhysicalDevice device, const VkPhysicalDeviceFeatures& features, bool transfer_features_reported);
+        bool covers(VkFormat format) const noexcept;
+        VkFormatFeatureFlags features(VkFormat format, VkImageTiling tiling) const noexcept;
+        VkFormatFeatureFlags bufferFeatures(VkFormat format) const noexcept;
+        // Features an image needs for usage: the transfer bits only where the device reports them
+        VkFormatFeatureFlags featureFlagsFromUsage(VkImageUsageFlags usage) const noexcept;
+        bool supportsImage(const VkImageCreateInfo& info) const noexcept;
+        // Whether the compression family (BCn, ETC2/EAC or ASTC LDR) is enabled on the device as a whole. Individual formats
+        // may still be supported without it, which features() says
+        bool compressionFamilySupported(VkFormat format) const noexcept;
+
+        static bool isBlockCompressed(VkFormat format) noexcept;
+        static FormatBlockInfo blockInfo(VkFormat format) noexcept;
+        // Bytes of a tightly packed width x height x depth region of a block compressed format, in whole blocks. Zero for other formats
+        static VkDeviceSize blockCompressedSize(VkFormat format, uint32_t width, uint32_t height, uint32_t depth) noexcept;
+
+    private:
+        // Core formats run contiguously from VK_FORMAT_UNDEFINED to the last ASTC format
+        constexpr static uint32_t CoreFormatCount = static_cast<uint32_t>(VK_FORMAT_ASTC_12x12_SRGB_BLOCK) + 1u;
+
+        struct FormatEntry
+        {
+            VkFormatFeatureFlags optimalFeatures{ 0u };
+            VkFormatFeatureFlags linearFeatures{ 0u };
+            VkFormatFeatureFlags bufferFeatures{ 0u };
+        };
+
+        std::array<FormatEntry, CoreFormatCount> formats{};
+        bool transferFeaturesReported{ false };
+        bool bcSupported{ false };
+        bool etc2Supported{ false };
+        bool astcLdrSupported{ false };
+    };
+
+}
+
+#endif //!PETRICHOR_FORMAT_CAPABILITIES_HPP
@@ -0,0 +1,162 @@
+#include "ImageLayoutTracker.hpp"
+#include <algorithm>
+
+namespace petrichor
+{
+
+    namespace
+    {
+
+        constexpr VkAccessFlags2 WriteAccess = VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT |
+            VK_ACCESS_2_MEMORY_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+
+        bool SameState(const SubresourceState& lhs, const SubresourceState& rhs) noexcept
+        {
+            return (lhs.layout == rhs.layout) && (lhs.stages == rhs.stages) && (lhs.access == rhs.access);
+        }
+
+    }
+
+    void ImageLayoutTracker::reset(const SubresourceState& state)
+    {
+        states.clear();
+        uniformState = state;
+    }
+
+    void ImageLayoutTracker::transition(uint32_t mip_levels, uint32_t array_layers, const VkImageSubresourceRange& range, const SubresourceState& next,
+        std::vector<SubresourceTransition>& transitions)
+    {
+        const uint32_t levelCount = range.levelCount == VK_REMAINING_MIP_LEVELS ? mip_levels - range.baseMipLevel : range.levelCount;
+        const uint32_t layerCount = range.layerCount == VK_REMAINING_ARRAY_LAYERS ? array_layers - range.baseArrayLayer : range.layerCount;
+        const uint32_t levelEnd = std::min(range.baseMipLevel + levelCount, mip_levels);
+        const uint32_t layerEnd = std::min(range.baseArrayLayer + layerCount, array_layers);
+        if ((range.baseMipLevel >= levelEnd) || (range.baseArrayLayer >= layerEnd))
+        {
+            return;
+        }
+
+        auto needsBarrier = [&next](const SubresourceState& previous) noexcept
+        {
+            return (previous.layout != next.layout) || (((previous.access | next.access) & WriteAccess) != 0u);
+        };
+
+        auto advance = [&next, &needsBarrier](SubresourceState& state) noexcept
+        {
+            if (needsBarrier(state))
+            {
+                state = next;
+            }
+            else
+            {
+                state.stages |= next.stages;
+                state.access |= next.access;
+            }
+        };
+
+        const bool wholeImage = (range.baseMipLevel == 0u) && (levelEnd == mip_levels) && (range.baseArrayLayer == 0u) && (layerEnd == array_layers);
+        if (states.empty())
+        {
+            if (wholeImage)
+            {
+                if (needsBarrier(uniformState))
+                {
+                    transitions.emplace_back(SubresourceTransition{ VkImageSubresourceRange{ range.aspectMask, 0u, mip_levels, 0u, array_layers }, uniformState });
+                }
+                advance(uniformState);
+                return;
+            }
+            states.assign(static_cast<size_t>(mip_levels) * array_layers, uniformState);
+        }
+
+        const size_t firstTransition = transitions.size();
+        for (uint32_t mip = range.baseMipLevel; mip < levelEnd; ++mip)
+        {
+            uint32_t layer = range.baseArrayLayer;
+            while (layer < layerEnd)
+            {
+                SubresourceState& state = states[static_cast<size_t>(layer) * mip_levels + mip];
+                if (!needsBarrier(state))
+                {
+                    advance(state);
+                    ++layer;
+                    continue;
+                }
+
+                // Layers after this one in the same layout go in the same barrier, waiting on all of their accesses
+                SubresourceState previous = state;
+                uint32_t runEnd = layer + 1u;
+                for (; (runEnd < layerEnd) && (states[static_cast<size_t>(runEnd) * mip_levels + mip].layout == previous.layout); ++runEnd)
+                {
+                    previous.stages |= states[static_cast<size_t>(runEnd) * mip_levels + mip].stages;
+                    previous.access |= states[static_cast<size_t>(runEnd) * mip_levels + mip].access;
+                }
+                for (uint32_t runLayer = layer; runLayer < runEnd; ++runLayer)
+                {
+                    states[static_cast<size_t>(runLayer) * mip_levels + mip] = next;
+                }
+
+                // Extends the barrier of the level above, if it covered the same layers from the same layout
+                auto extended = std::find_if(transitions.begin() + firstTransition, transitions.end(), [&](const SubresourceTransition& transition)
+                {
+                    return (transition.range.baseMipLevel + transition.range.levelCount == mip) && (transition.range.baseArrayLayer == layer) &&
+                        (transition.range.layerCount == runEnd - layer) && (transition.previous.layout == previous.layout);
+                });
+
+                if (extended != transitions.end())
+                {
+                    ++extended->range.levelCount;
+                    extended->previous.stages |= previous.stages;
+                    extended->previous.access |= previous.access;
+                }
+                else
+                {
+                    transitions.emplace_back(SubresourceTransition{ VkImageSubresourceRange{ range.aspectMask, mip, 1u, layer, runEnd - layer }, previous });
+                }
+                layer = runEnd;
+            }
+        }
+
+        collapse();
+    }
+
+    void ImageLayoutTracker::merge(uint32_t mip_levels, uint32_t array_layers, const ImageLayoutTracker& base, const ImageLayoutTracker& planned)
+    {
+        // Nothing else moved it, which is almost always the case
+        if (states.empty() && base.states.empty() && SameState(uniformState, base.uniformState))
+        {
+            *this = planned;
+            return;
+        }
+
+        auto stateOf = [](const ImageLayoutTracker& tracker, size_t idx) -> const SubresourceState&
+        {
+            return tracker.states.empty() ? tracker.uniformState : tracker.states[idx];
+        };
+
+        std::vector<SubresourceState> merged(static_cast<size_t>(mip_levels) * array_layers);
+        for (size_t i = 0u; i < merged.size(); ++i)
+        {
+            const SubresourceState& current = stateOf(*this, i);
+            merged[i] = SameState(current, stateOf(base, i)) ? stateOf(planned, i) : current;
+        }
+        states = std::move(merged);
+        collapse();
+    }
+
+    void ImageLayoutTracker::collapse()
+    {
+        if (states.empty())
+        {
+            return;
+        }
+
+        const SubresourceState& first = states.front();
+        if (std::all_of(states.begin() + 1, states.end(), [&first](const SubresourceState& state) { return SameState(state, first); }))
+        {
+            uniformState = first;
+            states.clear();
+        }
+    }
+
+}
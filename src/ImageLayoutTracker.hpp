@@ -0,0 +1,52 @@
+#pragma once
+#ifndef PETRICHOR_IMAGE_LAYOUT_TRACKER_HPP
+#define PETRICHOR_IMAGE_LAYOUT_TRACKER_HPP
+#include <vulkan/vulkan_core.h>
+#include <vector>
+
+namespace petrichor
+{
+
+    // Layout a subresource is in, and the accesses made to it since its last barrier
+    struct SubresourceState
+    {
+        VkImageLayout layout{ VK_IMAGE_LAYOUT_UNDEFINED };
+        VkPipelineStageFlags2 stages{ VK_PIPELINE_STAGE_2_NONE };
+        VkAccessFlags2 access{ VK_ACCESS_2_NONE };
+    };
+
+    // Subresources that need a barrier, and were in the same layout before it: one barrier covers the whole range,
+    // waiting on the accesses made to any of them
+    struct SubresourceTransition
+    {
+        VkImageSubresourceRange range;
+        SubresourceState previous;
+    };
+
+    // Current state of each mip level and array layer of an image. Kept as a single state while the whole image
+    // agrees, which is most of the time, and split per subresource once only part of it is transitioned
+    struct ImageLayoutTracker
+    {
+        // Puts the whole image in state
+        void reset(const SubresourceState& state);
+        // Moves range into next, appending the barriers it needs: subresources changing layout, or with a write on either
+        // side. Reads in the same layout just add to the state, so a later write waits on all of them. Transitions merge
+        // neighbouring layers, then neighbouring mip levels, that were in the same layout
+        void transition(uint32_t mip_levels, uint32_t array_layers, const VkImageSubresourceRange& range, const SubresourceState& next,
+            std::vector<SubresourceTransition>& transitions);
+        // For transitions planned on a copy (planned) of this tracker as it was (base): takes planned's state for each
+        // subresource still in its base state, and keeps the newer state of any transitioned here in the meantime
+        void merge(uint32_t mip_levels, uint32_t array_layers, const ImageLayoutTracker& base, const ImageLayoutTracker& planned);
+
+    private:
+        // Back to a single state once the image agrees again
+        void collapse();
+
+        // Empty while every subresource is in uniformState, otherwise indexed by layer * mip levels + mip level
+        std::vector<SubresourceState> states;
+        SubresourceState uniformState;
+    };
+
+}
+
+#endif //!PETRICHOR_IMAGE_LAYOUT_TRACKER_HPP
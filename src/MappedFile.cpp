@@ -0,0 +1,216 @@
+#include "MappedFile.hpp"
+#include <utility>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace petrichor
+{
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept :
+        mapping(std::exchange(other.mapping, nullptr)),
+        mappedBytes(std::exchange(other.mappedBytes, 0u)),
+        offsetInMapping(std::exchange(other.offsetInMapping, 0u)),
+        rangeSize(std::exchange(other.rangeSize, 0u))
+#ifdef _WIN32
+        , fileHandle(std::exchange(other.fileHandle, nullptr))
+        , mappingHandle(std::exchange(other.mappingHandle, nullptr))
+#endif
+    {}
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            mapping = std::exchange(other.mapping, nullptr);
+            mappedBytes = std::exchange(other.mappedBytes, 0u);
+            offsetInMapping = std::exchange(other.offsetInMapping, 0u);
+            rangeSize = std::exchange(other.rangeSize, 0u);
+#ifdef _WIN32
+            fileHandle = std::exchange(other.fileHandle, nullptr);
+            mappingHandle = std::exchange(other.mappingHandle, nullptr);
+#endif
+        }
+        return *this;
+    }
+
+#ifdef _WIN32
+
+    bool MappedFile::open(const char* path, uint64_t offset, uint64_t size)
+    {
+        close();
+
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        fileHandle = file;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || (offset >= static_cast<uint64_t>(fileSize.QuadPart)))
+        {
+            close();
+            return false;
+        }
+
+        const uint64_t available = static_cast<uint64_t>(fileSize.QuadPart) - offset;
+        rangeSize = size != 0u ? size : available;
+        if (rangeSize > available)
+        {
+            close();
+            return false;
+        }
+
+        mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle == nullptr)
+        {
+            close();
+            return false;
+        }
+
+        // Views have to start on an allocation granule, not just a page
+        SYSTEM_INFO systemInfo;
+        GetSystemInfo(&systemInfo);
+        const uint64_t granularity = systemInfo.dwAllocationGranularity;
+        const uint64_t mappingOffset = (offset / granularity) * granularity;
+        offsetInMapping = offset - mappingOffset;
+        mappedBytes = offsetInMapping + rangeSize;
+
+        mapping = MapViewOfFile(mappingHandle, FILE_MAP_READ, static_cast<DWORD>(mappingOffset >> 32u), static_cast<DWORD>(mappingOffset & 0xFFFFFFFFu), static_cast<SIZE_T>(mappedBytes));
+        if (mapping == nullptr)
+        {
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void MappedFile::close() noexcept
+    {
+        if (mapping != nullptr)
+        {
+            UnmapViewOfFile(mapping);
+        }
+        if (mappingHandle != nullptr)
+        {
+            CloseHandle(mappingHandle);
+        }
+        if (fileHandle != nullptr)
+        {
+            CloseHandle(fileHandle);
+        }
+        mapping = nullptr;
+        mappingHandle = nullptr;
+        fileHandle = nullptr;
+        mappedBytes = 0u;
+        offsetInMapping = 0u;
+        rangeSize = 0u;
+    }
+
+#else
+
+    bool MappedFile::open(const char* path, uint64_t offset, uint64_t size)
+    {
+        close();
+
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat fileStat;
+        if ((fstat(fd, &fileStat) != 0) || (offset >= static_cast<uint64_t>(fileStat.st_size)))
+        {
+            ::close(fd);
+            return false;
+        }
+
+        const uint64_t available = static_cast<uint64_t>(fileStat.st_size) - offset;
+        rangeSize = size != 0u ? size : available;
+        if (rangeSize > available)
+        {
+            ::close(fd);
+            rangeSize = 0u;
+            return false;
+        }
+
+        const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        const uint64_t mappingOffset = (offset / pageSize) * pageSize;
+        offsetInMapping = offset - mappingOffset;
+        mappedBytes = offsetInMapping + rangeSize;
+
+        void* result = mmap(nullptr, static_cast<size_t>(mappedBytes), PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(mappingOffset));
+        // The mapping keeps its own reference to the file
+        ::close(fd);
+        if (result == MAP_FAILED)
+        {
+            mappedBytes = 0u;
+            offsetInMapping = 0u;
+            rangeSize = 0u;
+            return false;
+        }
+
+        // We read it front to back exactly once: let the kernel start reading ahead now
+        madvise(result, static_cast<size_t>(mappedBytes), MADV_SEQUENTIAL);
+        madvise(result, static_cast<size_t>(mappedBytes), MADV_WILLNEED);
+        mapping = result;
+        return true;
+    }
+
+    void MappedFile::close() noexcept
+    {
+        if (mapping != nullptr)
+        {
+            munmap(mapping, static_cast<size_t>(mappedBytes));
+        }
+        mapping = nullptr;
+        mappedBytes = 0u;
+        offsetInMapping = 0u;
+        rangeSize = 0u;
+    }
+
+#endif
+
+    const std::byte* MappedFile::data() const noexcept
+    {
+        return mapping != nullptr ? reinterpret_cast<const std::byte*>(mapping) + offsetInMapping : nullptr;
+    }
+
+    uint64_t MappedFile::size() const noexcept
+    {
+        return rangeSize;
+    }
+
+    const std::byte* MappedFile::mappingBase() const noexcept
+    {
+        return reinterpret_cast<const std::byte*>(mapping);
+    }
+
+    uint64_t MappedFile::mappingSize() const noexcept
+    {
+        return mappedBytes;
+    }
+
+    uint64_t MappedFile::rangeOffset() const noexcept
+    {
+        return offsetInMapping;
+    }
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+#ifndef PETRICHOR_MAPPED_FILE_HPP
+#define PETRICHOR_MAPPED_FILE_HPP
+#include <cstddef>
+#include <cstdint>
+
+namespace petrichor
+{
+
+    // Read-only mapping of a range of a file. The mapping itself starts at the page (or allocation granule)
+    // containing the range, which is what makes it importable as host memory. Unmapped on destruction
+    class MappedFile
+    {
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+    public:
+
+        MappedFile() noexcept = default;
+        ~MappedFile();
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        // size == 0 maps to the end of the file. Returns false if the file can't be opened, or the range is out of bounds
+        bool open(const char* path, uint64_t offset, uint64_t size);
+        void close() noexcept;
+
+        const std::byte* data() const noexcept;
+        uint64_t size() const noexcept;
+        // Whole mapping, and where the requested range starts within it
+        const std::byte* mappingBase() const noexcept;
+        uint64_t mappingSize() const noexcept;
+        uint64_t rangeOffset() const noexcept;
+
+    private:
+        void* mapping{ nullptr };
+        uint64_t mappedBytes{ 0u };
+        uint64_t offsetInMapping{ 0u };
+        uint64_t rangeSize{ 0u };
+#ifdef _WIN32
+        void* fileHandle{ nullptr };
+        void* mappingHandle{ nullptr };
+#endif
+    };
+
+}
+
+#endif //!PETRICHOR_MAPPED_FILE_HPP
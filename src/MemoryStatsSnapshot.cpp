@@ -0,0 +1,79 @@
+#include "MemoryStatsSnapshot.hpp"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+namespace petrichor
+{
+
+    void MemoryStatsSnapshotRing::reset(uint32_t frame_interval, uint32_t capacity)
+    {
+        frameInterval = capacity != 0u ? frame_interval : 0u;
+        samples.assign(frameInterval != 0u ? capacity : 0u, MemoryStatsSample{});
+        samples.shrink_to_fit();
+        next = 0u;
+        count = 0u;
+    }
+
+    bool MemoryStatsSnapshotRing::sampleDue(uint64_t frame_index) const noexcept
+    {
+        return (frameInterval != 0u) && ((frame_index % frameInterval) == 0u);
+    }
+
+    void MemoryStatsSnapshotRing::push(const MemoryStatsSample& sample)
+    {
+        if (samples.empty())
+        {
+            return;
+        }
+
+        samples[next] = sample;
+        next = (next + 1u) % static_cast<uint32_t>(samples.size());
+        count = std::min(count + 1u, static_cast<uint32_t>(samples.size()));
+    }
+
+    uint32_t MemoryStatsSnapshotRing::size() const noexcept
+    {
+        return count;
+    }
+
+    uint32_t MemoryStatsSnapshotRing::copySamples(uint32_t max_samples, MemoryStatsSample* dest) const
+    {
+        const uint32_t numCopied = std::min(max_samples, count);
+        const uint32_t capacity = static_cast<uint32_t>(samples.size());
+        // next is one past the newest sample, so the oldest one we want is numCopied behind it
+        uint32_t idx = (next + capacity - numCopied) % std::max(capacity, 1u);
+        for (uint32_t i = 0u; i < numCopied; ++i)
+        {
+            dest[i] = samples[idx];
+            idx = (idx + 1u) % capacity;
+        }
+        return numCopied;
+    }
+
+    void MemoryStatsSnapshotRing::writeFile(const char* output_file) const
+    {
+        std::ofstream output(output_file, std::ios::binary | std::ios::trunc);
+        if (!output.is_open())
+        {
+            throw std::runtime_error("Couldn't open memory stats snapshot output file.");
+        }
+
+        MemoryStatsSnapshotFileHeader header;
+        header.SampleCount = count;
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        // At most two contiguous runs: from the oldest sample to the end of the ring, then from the start up to next
+        const uint32_t capacity = static_cast<uint32_t>(samples.size());
+        const uint32_t oldest = (next + capacity - count) % std::max(capacity, 1u);
+        const uint32_t firstRun = std::min(count, capacity - oldest);
+        output.write(reinterpret_cast<const char*>(samples.data() + oldest), sizeof(MemoryStatsSample) * firstRun);
+        output.write(reinterpret_cast<const char*>(samples.data()), sizeof(MemoryStatsSample) * (count - firstRun));
+
+        if (!output.good())
+        {
+            throw std::runtime_error("Failed to write memory stats snapshots.");
+        }
+    }
+
+}
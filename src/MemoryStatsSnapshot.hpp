@@ -0,0 +1,33 @@
+#pragma once
+#ifndef PETRICHOR_MEMORY_STATS_SNAPSHOT_HPP
+#define PETRICHOR_MEMORY_STATS_SNAPSHOT_HPP
+#include "PetrichorResourceTypes.hpp"
+#include <vector>
+
+namespace petrichor
+{
+
+    // Fixed size ring of periodic memory samples: once full, each new sample overwrites the oldest
+    struct MemoryStatsSnapshotRing
+    {
+        // Clears the ring. A zero interval or capacity disables sampling
+        void reset(uint32_t frame_interval, uint32_t capacity);
+        bool sampleDue(uint64_t frame_index) const noexcept;
+        void push(const MemoryStatsSample& sample);
+        uint32_t size() const noexcept;
+        // Copies up to max_samples of the newest samples, oldest first. Returns the number copied
+        uint32_t copySamples(uint32_t max_samples, MemoryStatsSample* dest) const;
+        // Throws if the file can't be written
+        void writeFile(const char* output_file) const;
+
+    private:
+        std::vector<MemoryStatsSample> samples;
+        uint32_t frameInterval{ 0u };
+        // Slot the next sample goes in
+        uint32_t next{ 0u };
+        uint32_t count{ 0u };
+    };
+
+}
+
+#endif //!PETRICHOR_MEMORY_STATS_SNAPSHOT_HPP
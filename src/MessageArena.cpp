@@ -0,0 +1,250 @@
+#include "MessageArena.hpp"
+#include <vulkan/vulkan_core.h>
+#include <algorithm>
+#include <cstdint>
+
+namespace petrichor
+{
+
+    namespace
+    {
+
+        template<typename T>
+        T* CopyStructure(MessageArena& arena, const VkBaseInStructure* structure)
+        {
+            return arena.copy(reinterpret_cast<const T*>(structure), 1u);
+        }
+
+        // Structures that can go in the pNext chain of the infos we take. Anything else could hold pointers
+        // we'd miss, so the whole chain is refused
+        bool CopyNextChain(MessageArena& arena, const void* chain, const void*& result)
+        {
+            VkBaseOutStructure* head = nullptr;
+            VkBaseOutStructure* tail = nullptr;
+            for (auto* next = reinterpret_cast<const VkBaseInStructure*>(chain); next != nullptr; next = next->pNext)
+            {
+                void* copied = nullptr;
+                switch (next->sType)
+                {
+                case VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO:
+                    copied = CopyStructure<VkExternalMemoryBufferCreateInfo>(arena, next);
+                    break;
+                case VK_STRUCTURE_TYPE_BUFFER_OPAQUE_CAPTURE_ADDRESS_CREATE_INFO:
+                    copied = CopyStructure<VkBufferOpaqueCaptureAddressCreateInfo>(arena, next);
+                    break;
+                case VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_CREATE_INFO_EXT:
+                    copied = CopyStructure<VkBufferDeviceAddressCreateInfoEXT>(arena, next);
+                    break;
+                case VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO:
+                    copied = CopyStructure<VkExternalMemoryImageCreateInfo>(arena, next);
+                    break;
+                case VK_STRUCTURE_TYPE_IMAGE_STENCIL_USAGE_CREATE_INFO:
+                    copied = CopyStructure<VkImageStencilUsageCreateInfo>(arena, next);
+                    break;
+                case VK_STRUCTURE_TYPE_IMAGE_FORMAT_LIST_CREATE_INFO:
+                {
+                    auto* formatList = CopyStructure<VkImageFormatListCreateInfo>(arena, next);
+                    formatList->pViewFormats = arena.copy(formatList->pViewFormats, formatList->viewFormatCount);
+                    copied = formatList;
+                    break;
+                }
+                case VK_STRUCTURE_TYPE_IMAGE_DRM_FORMAT_MODIFIER_LIST_CREATE_INFO_EXT:
+                {
+                    auto* modifierList = CopyStructure<VkImageDrmFormatModifierListCreateInfoEXT>(arena, next);
+                    modifierList->pDrmFormatModifiers = arena.copy(modifierList->pDrmFormatModifiers, modifierList->drmFormatModifierCount);
+                    copied = modifierList;
+                    break;
+                }
+                case VK_STRUCTURE_TYPE_IMAGE_DRM_FORMAT_MODIFIER_EXPLICIT_CREATE_INFO_EXT:
+                {
+                    auto* explicitModifier = CopyStructure<VkImageDrmFormatModifierExplicitCreateInfoEXT>(arena, next);
+                    explicitModifier->pPlaneLayouts = arena.copy(explicitModifier->pPlaneLayouts, explicitModifier->drmFormatModifierPlaneCount);
+                    copied = explicitModifier;
+                    break;
+                }
+                case VK_STRUCTURE_TYPE_SAMPLER_REDUCTION_MODE_CREATE_INFO:
+                    copied = CopyStructure<VkSamplerReductionModeCreateInfo>(arena, next);
+                    break;
+                case VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_INFO:
+                    copied = CopyStructure<VkSamplerYcbcrConversionInfo>(arena, next);
+                    break;
+                case VK_STRUCTURE_TYPE_SAMPLER_CUSTOM_BORDER_COLOR_CREATE_INFO_EXT:
+                    copied = CopyStructure<VkSamplerCustomBorderColorCreateInfoEXT>(arena, next);
+                    break;
+                case VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO:
+                    copied = CopyStructure<VkImageViewUsageCreateInfo>(arena, next);
+                    break;
+                case VK_STRUCTURE_TYPE_IMAGE_VIEW_ASTC_DECODE_MODE_EXT:
+                    copied = CopyStructure<VkImageViewASTCDecodeModeEXT>(arena, next);
+                    break;
+                default:
+                    return false;
+                }
+
+                auto* structure = static_cast<VkBaseOutStructure*>(copied);
+                structure->pNext = nullptr;
+                if (tail != nullptr)
+                {
+                    tail->pNext = structure;
+                }
+                else
+                {
+                    head = structure;
+                }
+                tail = structure;
+            }
+
+            result = head;
+            return true;
+        }
+
+        // Copies the info, and repoints its pNext at a copy of the chain
+        template<typename T>
+        T* CopyCreateInfo(MessageArena& arena, const void* info)
+        {
+            T* copied = arena.copy(reinterpret_cast<const T*>(info), 1u);
+            if ((copied != nullptr) && !CopyNextChain(arena, copied->pNext, copied->pNext))
+            {
+                return nullptr;
+            }
+            return copied;
+        }
+
+        template<typename DataType>
+        const DataType* CopyDataArray(MessageArena& arena, const DataType* data, uint32_t count, bool copy_payloads)
+        {
+            DataType* copied = arena.copy(data, count);
+            for (uint32_t i = 0u; copy_payloads && (copied != nullptr) && (i < count); ++i)
+            {
+                copied[i].Data = arena.copy(static_cast<const std::byte*>(copied[i].Data), copied[i].Size);
+            }
+            return copied;
+        }
+
+    }
+
+    void* MessageArena::allocate(size_t size, size_t alignment)
+    {
+        for (; currentBlock < blocks.size(); ++currentBlock, offset = 0u)
+        {
+            Block& block = blocks[currentBlock];
+            const uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+            const size_t alignedOffset = static_cast<size_t>(((base + offset + alignment - 1u) & ~static_cast<uintptr_t>(alignment - 1u)) - base);
+            if (alignedOffset + size <= block.size)
+            {
+                offset = alignedOffset + size;
+                return block.data.get() + alignedOffset;
+            }
+        }
+
+        // Payloads bigger than a block get one of their own
+        const size_t blockSize = std::max(BlockSize, size + alignment);
+        blocks.emplace_back(Block{ std::unique_ptr<std::byte[]>(new std::byte[blockSize]), blockSize });
+        currentBlock = blocks.size() - 1u;
+        offset = 0u;
+        return allocate(size, alignment);
+    }
+
+    const char* MessageArena::copyString(const char* string)
+    {
+        return string != nullptr ? copy(string, std::strlen(string) + 1u) : nullptr;
+    }
+
+    void MessageArena::reset()
+    {
+        blocks.erase(std::remove_if(blocks.begin(), blocks.end(), [](const Block& block) { return block.size != BlockSize; }), blocks.end());
+        currentBlock = 0u;
+        offset = 0u;
+    }
+
+    bool CopyCreationMessage(MessageArena& arena, ResourceCreationMessage& message, bool copy_payloads)
+    {
+        ResourceCreationMessage copied = message;
+
+        switch (message.Type)
+        {
+        case GpuResourceType::Buffer:
+        {
+            VkBufferCreateInfo* bufferInfo = CopyCreateInfo<VkBufferCreateInfo>(arena, message.Info);
+            if ((message.Info != nullptr) && (bufferInfo == nullptr))
+            {
+                return false;
+            }
+            if (bufferInfo != nullptr)
+            {
+                bufferInfo->pQueueFamilyIndices = arena.copy(bufferInfo->pQueueFamilyIndices, bufferInfo->queueFamilyIndexCount);
+            }
+            copied.Info = bufferInfo;
+            copied.ResourceData.bufferData.data = CopyDataArray(arena, message.ResourceData.bufferData.data, message.ResourceData.bufferData.numData, copy_payloads);
+            break;
+        }
+        case GpuResourceType::Image:
+        case GpuResourceType::SparseImage:
+        {
+            VkImageCreateInfo* imageInfo = CopyCreateInfo<VkImageCreateInfo>(arena, message.Info);
+            if ((message.Info != nullptr) && (imageInfo == nullptr))
+            {
+                return false;
+            }
+            if (imageInfo != nullptr)
+            {
+                imageInfo->pQueueFamilyIndices = arena.copy(imageInfo->pQueueFamilyIndices, imageInfo->queueFamilyIndexCount);
+            }
+            copied.Info = imageInfo;
+            copied.ResourceData.imageData.data = CopyDataArray(arena, message.ResourceData.imageData.data, message.ResourceData.imageData.numData, copy_payloads);
+            break;
+        }
+        case GpuResourceType::Sampler:
+            copied.Info = CopyCreateInfo<VkSamplerCreateInfo>(arena, message.Info);
+            if ((message.Info != nullptr) && (copied.Info == nullptr))
+            {
+                return false;
+            }
+            break;
+        case GpuResourceType::ImageView:
+            copied.ViewInfo = CopyCreateInfo<VkImageViewCreateInfo>(arena, message.ViewInfo);
+            if ((message.ViewInfo != nullptr) && (copied.ViewInfo == nullptr))
+            {
+                return false;
+            }
+            break;
+        case GpuResourceType::BufferView:
+            copied.ViewInfo = CopyCreateInfo<VkBufferViewCreateInfo>(arena, message.ViewInfo);
+            if ((message.ViewInfo != nullptr) && (copied.ViewInfo == nullptr))
+            {
+                return false;
+            }
+            break;
+        default:
+            // Fails when it's created anyways
+            break;
+        }
+
+        // Anything else in UserData is the caller's own value, handed back as-is
+        if (message.Flags & CreationFlagBits::ResourceCreateUserDataAsString)
+        {
+            copied.UserData = arena.copyString(reinterpret_cast<const char*>(message.UserData));
+        }
+
+        if (message.FileSource != nullptr)
+        {
+            GpuResourceFileSource* fileSource = arena.copy(message.FileSource, 1u);
+            fileSource->Path = arena.copyString(fileSource->Path);
+            copied.FileSource = fileSource;
+        }
+
+        if (message.CompressedData != nullptr)
+        {
+            GpuCompressedResourceData* compressedData = arena.copy(message.CompressedData, message.NumCompressedData);
+            for (uint32_t i = 0u; copy_payloads && (compressedData != nullptr) && (i < message.NumCompressedData); ++i)
+            {
+                compressedData[i].Data = arena.copy(static_cast<const std::byte*>(compressedData[i].Data), compressedData[i].CompressedSize);
+            }
+            copied.CompressedData = compressedData;
+        }
+
+        message = copied;
+        return true;
+    }
+
+}
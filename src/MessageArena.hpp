@@ -0,0 +1,56 @@
+#pragma once
+#ifndef PETRICHOR_MESSAGE_ARENA_HPP
+#define PETRICHOR_MESSAGE_ARENA_HPP
+#include "PetrichorResourceTypes.hpp"
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace petrichor
+{
+
+    // Bump allocator for copies of queued creation messages. Nothing is freed on its own: the whole arena is
+    // reset once the frame the messages were queued in retires
+    struct MessageArena
+    {
+        void* allocate(size_t size, size_t alignment);
+
+        template<typename T>
+        T* copy(const T* source, size_t count)
+        {
+            if ((source == nullptr) || (count == 0u))
+            {
+                return nullptr;
+            }
+            void* result = allocate(sizeof(T) * count, alignof(T));
+            std::memcpy(result, source, sizeof(T) * count);
+            return static_cast<T*>(result);
+        }
+
+        const char* copyString(const char* string);
+        // Keeps regular blocks around for the next frame, but frees ones sized for a single big payload
+        void reset();
+
+        constexpr static size_t BlockSize = 64u * 1024u;
+
+    private:
+        struct Block
+        {
+            std::unique_ptr<std::byte[]> data;
+            size_t size{ 0u };
+        };
+
+        std::vector<Block> blocks;
+        size_t currentBlock{ 0u };
+        size_t offset{ 0u };
+    };
+
+    // Copies everything message points at into the arena and repoints it there: the create infos and their pNext chains,
+    // queue family lists, the debug name, the file source and the data arrays. The data itself is only copied if
+    // copy_payloads is set. Returns false, leaving message as it was, if a pNext chain holds a structure we don't know
+    bool CopyCreationMessage(MessageArena& arena, ResourceCreationMessage& message, bool copy_payloads);
+
+}
+
+#endif //!PETRICHOR_MESSAGE_ARENA_HPP
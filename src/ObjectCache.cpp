@@ -0,0 +1,348 @@
+#include "ObjectCache.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace petrichor
+{
+
+    void CreateInfoKey::push(uint32_t word) noexcept
+    {
+        // Keys are built from fixed size structs, so this only trips if MaxWords is out of date
+        if (count < MaxWords)
+        {
+            words[count++] = word;
+        }
+    }
+
+    void CreateInfoKey::push64(uint64_t value) noexcept
+    {
+        push(static_cast<uint32_t>(value & 0xFFFFFFFFu));
+        push(static_cast<uint32_t>(value >> 32u));
+    }
+
+    void CreateInfoKey::pushFloat(float value) noexcept
+    {
+        push(std::bit_cast<uint32_t>(value));
+    }
+
+    bool CreateInfoKey::operator==(const CreateInfoKey& other) const noexcept
+    {
+        if (count != other.count)
+        {
+            return false;
+        }
+
+        for (uint32_t i = 0u; i < count; ++i)
+        {
+            if (words[i] != other.words[i])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    size_t CreateInfoKeyHash::operator()(const CreateInfoKey& key) const noexcept
+    {
+        // FNV-1a, a word at a time: keys are a couple dozen words, so there's no need for anything fancier
+        uint64_t hash = 14695981039346656037ull;
+        for (uint32_t i = 0u; i < key.count; ++i)
+        {
+            hash ^= key.words[i];
+            hash *= 1099511628211ull;
+        }
+        return static_cast<size_t>(hash);
+    }
+
+    bool MakeSamplerKey(const VkSamplerCreateInfo& info, CreateInfoKey& key) noexcept
+    {
+        const VkSamplerReductionModeCreateInfo* reductionInfo = nullptr;
+        const VkSamplerYcbcrConversionInfo* ycbcrInfo = nullptr;
+        const VkSamplerCustomBorderColorCreateInfoEXT* borderColorInfo = nullptr;
+
+        for (auto* next = reinterpret_cast<const VkBaseInStructure*>(info.pNext); next != nullptr; next = next->pNext)
+        {
+            switch (next->sType)
+            {
+            case VK_STRUCTURE_TYPE_SAMPLER_REDUCTION_MODE_CREATE_INFO:
+                reductionInfo = reinterpret_cast<const VkSamplerReductionModeCreateInfo*>(next);
+                break;
+            case VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_INFO:
+                ycbcrInfo = reinterpret_cast<const VkSamplerYcbcrConversionInfo*>(next);
+                break;
+            case VK_STRUCTURE_TYPE_SAMPLER_CUSTOM_BORDER_COLOR_CREATE_INFO_EXT:
+                borderColorInfo = reinterpret_cast<const VkSamplerCustomBorderColorCreateInfoEXT*>(next);
+                break;
+            default:
+                return false;
+            }
+        }
+
+        key = CreateInfoKey{};
+        key.push(info.flags);
+        key.push(info.magFilter);
+        key.push(info.minFilter);
+        key.push(info.mipmapMode);
+        key.push(info.addressModeU);
+        key.push(info.addressModeV);
+        key.push(info.addressModeW);
+        key.pushFloat(info.mipLodBias);
+        key.push(info.anisotropyEnable);
+        key.pushFloat(info.anisotropyEnable ? info.maxAnisotropy : 0.0f);
+        key.push(info.compareEnable);
+        key.push(info.compareEnable ? static_cast<uint32_t>(info.compareOp) : 0u);
+        key.pushFloat(info.minLod);
+        key.pushFloat(info.maxLod);
+        key.push(info.borderColor);
+        key.push(info.unnormalizedCoordinates);
+
+        // In a fixed order, so the same chain in a different order still finds the same sampler
+        if (reductionInfo != nullptr)
+        {
+            key.push(VK_STRUCTURE_TYPE_SAMPLER_REDUCTION_MODE_CREATE_INFO);
+            key.push(reductionInfo->reductionMode);
+        }
+
+        if (ycbcrInfo != nullptr)
+        {
+            key.push(VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_INFO);
+            key.push64((uint64_t)ycbcrInfo->conversion);
+        }
+
+        if (borderColorInfo != nullptr)
+        {
+            key.push(VK_STRUCTURE_TYPE_SAMPLER_CUSTOM_BORDER_COLOR_CREATE_INFO_EXT);
+            for (uint32_t i = 0u; i < 4u; ++i)
+            {
+                key.push(borderColorInfo->customBorderColor.uint32[i]);
+            }
+            key.push(borderColorInfo->format);
+        }
+
+        return true;
+    }
+
+    bool MakeImageViewKey(GpuResourceHandle parent, const VkImageViewCreateInfo& info, CreateInfoKey& key) noexcept
+    {
+        const VkImageViewUsageCreateInfo* usageInfo = nullptr;
+        const VkSamplerYcbcrConversionInfo* ycbcrInfo = nullptr;
+
+        for (auto* next = reinterpret_cast<const VkBaseInStructure*>(info.pNext); next != nullptr; next = next->pNext)
+        {
+            switch (next->sType)
+            {
+            case VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO:
+                usageInfo = reinterpret_cast<const VkImageViewUsageCreateInfo*>(next);
+                break;
+            case VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_INFO:
+                ycbcrInfo = reinterpret_cast<const VkSamplerYcbcrConversionInfo*>(next);
+                break;
+            default:
+                return false;
+            }
+        }
+
+        // info.image is ignored: the parent handle decides what the view is of
+        key = CreateInfoKey{};
+        key.push(static_cast<uint32_t>(GpuResourceType::ImageView));
+        key.push64(parent);
+        key.push(info.flags);
+        key.push(info.viewType);
+        key.push(info.format);
+        key.push(info.components.r);
+        key.push(info.components.g);
+        key.push(info.components.b);
+        key.push(info.components.a);
+        key.push(info.subresourceRange.aspectMask);
+        key.push(info.subresourceRange.baseMipLevel);
+        key.push(info.subresourceRange.levelCount);
+        key.push(info.subresourceRange.baseArrayLayer);
+        key.push(info.subresourceRange.layerCount);
+
+        if (usageInfo != nullptr)
+        {
+            key.push(VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO);
+            key.push(usageInfo->usage);
+        }
+
+        if (ycbcrInfo != nullptr)
+        {
+            key.push(VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_INFO);
+            key.push64((uint64_t)ycbcrInfo->conversion);
+        }
+
+        return true;
+    }
+
+    bool MakeBufferViewKey(GpuResourceHandle parent, const VkBufferViewCreateInfo& info, CreateInfoKey& key) noexcept
+    {
+        if (info.pNext != nullptr)
+        {
+            return false;
+        }
+
+        key = CreateInfoKey{};
+        key.push(static_cast<uint32_t>(GpuResourceType::BufferView));
+        key.push64(parent);
+        key.push(info.flags);
+        key.push(info.format);
+        key.push64(info.offset);
+        key.push64(info.range);
+        return true;
+    }
+
+    GpuResourceHandle SamplerCache::acquire(const CreateInfoKey& key) noexcept
+    {
+        ++requests;
+        auto iter = entries.find(key);
+        if (iter == entries.end())
+        {
+            return INVALID_GPU_RESOURCE_HANDLE;
+        }
+
+        ++hits;
+        ++iter->second.refCount;
+        return iter->second.handle;
+    }
+
+    void SamplerCache::insert(const CreateInfoKey& key, GpuResourceHandle handle)
+    {
+        entries[key] = Entry{ handle, 1u };
+        handleKeys[handle] = key;
+    }
+
+    bool SamplerCache::release(GpuResourceHandle handle)
+    {
+        auto keyIter = handleKeys.find(handle);
+        if (keyIter == handleKeys.end())
+        {
+            return true;
+        }
+
+        auto entryIter = entries.find(keyIter->second);
+        if ((entryIter != entries.end()) && (--entryIter->second.refCount != 0u))
+        {
+            return false;
+        }
+
+        if (entryIter != entries.end())
+        {
+            entries.erase(entryIter);
+        }
+        handleKeys.erase(keyIter);
+        return true;
+    }
+
+    void SamplerCache::countUncacheable() noexcept
+    {
+        ++requests;
+        ++uncacheable;
+    }
+
+    SamplerCacheStats SamplerCache::stats() const noexcept
+    {
+        SamplerCacheStats result;
+        result.Requests = requests;
+        result.Hits = hits;
+        result.UncacheableRequests = uncacheable;
+        result.UniqueSamplers = static_cast<uint32_t>(entries.size());
+        result.HitRate = requests != 0u ? static_cast<double>(hits) / static_cast<double>(requests) : 0.0;
+        return result;
+    }
+
+    GpuResourceHandle ViewCache::acquire(const CreateInfoKey& key) noexcept
+    {
+        ++requests;
+        auto iter = cachedViews.find(key);
+        if (iter == cachedViews.end())
+        {
+            return INVALID_GPU_RESOURCE_HANDLE;
+        }
+
+        ++hits;
+        ++entries[iter->second].refCount;
+        return iter->second;
+    }
+
+    void ViewCache::insert(const CreateInfoKey* key, GpuResourceHandle parent, GpuResourceHandle view)
+    {
+        Entry& entry = entries[view];
+        entry.parent = parent;
+        entry.refCount = 1u;
+        entry.cached = (key != nullptr);
+        if (entry.cached)
+        {
+            entry.key = *key;
+            cachedViews[*key] = view;
+        }
+        parentViews[parent].emplace_back(view);
+    }
+
+    bool ViewCache::release(GpuResourceHandle view)
+    {
+        auto iter = entries.find(view);
+        if (iter == entries.end())
+        {
+            return true;
+        }
+
+        if (--iter->second.refCount != 0u)
+        {
+            return false;
+        }
+
+        auto& siblings = parentViews[iter->second.parent];
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), view), siblings.end());
+        if (siblings.empty())
+        {
+            parentViews.erase(iter->second.parent);
+        }
+
+        forget(view, iter->second);
+        return true;
+    }
+
+    std::vector<GpuResourceHandle> ViewCache::releaseParent(GpuResourceHandle parent)
+    {
+        auto iter = parentViews.find(parent);
+        if (iter == parentViews.end())
+        {
+            return {};
+        }
+
+        std::vector<GpuResourceHandle> result = std::move(iter->second);
+        parentViews.erase(iter);
+        for (const auto& view : result)
+        {
+            auto entryIter = entries.find(view);
+            if (entryIter != entries.end())
+            {
+                forget(view, entryIter->second);
+            }
+        }
+
+        return result;
+    }
+
+    ViewCacheStats ViewCache::stats() const noexcept
+    {
+        ViewCacheStats result;
+        result.Requests = requests;
+        result.Hits = hits;
+        result.LiveViews = static_cast<uint32_t>(entries.size());
+        result.HitRate = requests != 0u ? static_cast<double>(hits) / static_cast<double>(requests) : 0.0;
+        return result;
+    }
+
+    void ViewCache::forget(GpuResourceHandle view, const Entry& entry)
+    {
+        if (entry.cached)
+        {
+            cachedViews.erase(entry.key);
+        }
+        // Invalidates entry, so it has to go last
+        entries.erase(view);
+    }
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+#ifndef PETRICHOR_OBJECT_CACHE_HPP
+#define PETRICHOR_OBJECT_CACHE_HPP
+#include "PetrichorResourceTypes.hpp"
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace petrichor
+{
+
+    // Create info flattened into words, so it can be hashed and compared without tripping over padding or pNext pointers
+    struct CreateInfoKey
+    {
+        void push(uint32_t word) noexcept;
+        void push64(uint64_t value) noexcept;
+        void pushFloat(float value) noexcept;
+        bool operator==(const CreateInfoKey& other) const noexcept;
+
+        constexpr static uint32_t MaxWords = 32u;
+        std::array<uint32_t, MaxWords> words{};
+        uint32_t count{ 0u };
+    };
+
+    struct CreateInfoKeyHash
+    {
+        size_t operator()(const CreateInfoKey& key) const noexcept;
+    };
+
+    // Returns false if info has a pNext structure we don't know how to key, in which case the sampler can't be shared
+    bool MakeSamplerKey(const VkSamplerCreateInfo& info, CreateInfoKey& key) noexcept;
+
+    // Keys include the parent's handle, generation and all, so a view can never be matched to a later occupant of the slot
+    bool MakeImageViewKey(GpuResourceHandle parent, const VkImageViewCreateInfo& info, CreateInfoKey& key) noexcept;
+    bool MakeBufferViewKey(GpuResourceHandle parent, const VkBufferViewCreateInfo& info, CreateInfoKey& key) noexcept;
+
+    // Samplers shared between every request with an identical create info, destroyed with their last reference
+    struct SamplerCache
+    {
+        // Adds a reference to the matching sampler, returning INVALID_GPU_RESOURCE_HANDLE on a miss
+        GpuResourceHandle acquire(const CreateInfoKey& key) noexcept;
+        void insert(const CreateInfoKey& key, GpuResourceHandle handle);
+        // Drops a reference. True if the handle isn't a cached sampler, or that was the last reference to it
+        bool release(GpuResourceHandle handle);
+        void countUncacheable() noexcept;
+        SamplerCacheStats stats() const noexcept;
+
+    private:
+        struct Entry
+        {
+            GpuResourceHandle handle{ INVALID_GPU_RESOURCE_HANDLE };
+            uint32_t refCount{ 0u };
+        };
+
+        std::unordered_map<CreateInfoKey, Entry, CreateInfoKeyHash> entries;
+        std::unordered_map<GpuResourceHandle, CreateInfoKey> handleKeys;
+        uint64_t requests{ 0u };
+        uint64_t hits{ 0u };
+        uint64_t uncacheable{ 0u };
+    };
+
+    // Image and buffer views, shared like samplers. Every view is tracked by parent (cached or not), so they
+    // can all be destroyed along with it
+    struct ViewCache
+    {
+        GpuResourceHandle acquire(const CreateInfoKey& key) noexcept;
+        // Views that couldn't be keyed are passed in with a null key, and are only tracked for their parent's sake
+        void insert(const CreateInfoKey* key, GpuResourceHandle parent, GpuResourceHandle view);
+        // Drops a reference. True if the handle isn't a view, or that was the last reference to it
+        bool release(GpuResourceHandle view);
+        // Forgets every view of parent, whatever their reference counts, returning them for destruction
+        std::vector<GpuResourceHandle> releaseParent(GpuResourceHandle parent);
+        ViewCacheStats stats() const noexcept;
+
+    private:
+        struct Entry
+        {
+            GpuResourceHandle parent{ INVALID_GPU_RESOURCE_HANDLE };
+            uint32_t refCount{ 0u };
+            bool cached{ false };
+            CreateInfoKey key;
+        };
+
+        void forget(GpuResourceHandle view, const Entry& entry);
+
+        std::unordered_map<CreateInfoKey, GpuResourceHandle, CreateInfoKeyHash> cachedViews;
+        std::unordered_map<GpuResourceHandle, Entry> entries;
+        std::unordered_map<GpuResourceHandle, std::vector<GpuResourceHandle>> parentViews;
+        uint64_t requests{ 0u };
+        uint64_t hits{ 0u };
+    };
+
+}
+
+#endif //!PETRICHOR_OBJECT_CACHE_HPP
@@ -0,0 +1,45 @@
+#include "PetrichorAwaitables.hpp"
+#include "ResourceContextImpl.hpp"
+#include "ReadbackPool.hpp"
+
+namespace petrichor
+{
+
+    bool ResourceReplyAwaiter::await_ready() const noexcept
+    {
+        // Empty replies have nothing to wait for: they resume straight away with an invalid handle. Complete ones
+        // still go through await_suspend, as only the work queue thread may carry on without waiting for Update()
+        return reply.coroutineHandle == nullptr;
+    }
+
+    bool ResourceReplyAwaiter::await_suspend(std::coroutine_handle<> continuation)
+    {
+        using coroHandle = std::coroutine_handle<ResourceCreationEvent::promise_type>;
+        coroHandle handle = coroHandle::from_address(reply.coroutineHandle);
+        ResourceContextImpl* impl = reinterpret_cast<ResourceContextImpl*>(reply.parent);
+        return impl->resumeWhenComplete(continuation, &handle.promise().complete);
+    }
+
+    GpuResourceHandle ResourceReplyAwaiter::await_resume() const noexcept
+    {
+        return GetHandleFromOperation(reply);
+    }
+
+    bool ResourceReadbackAwaiter::await_ready() const noexcept
+    {
+        return reply.readbackState == nullptr;
+    }
+
+    bool ResourceReadbackAwaiter::await_suspend(std::coroutine_handle<> continuation)
+    {
+        ReadbackState* state = reinterpret_cast<ReadbackState*>(reply.readbackState);
+        ResourceContextImpl* impl = reinterpret_cast<ResourceContextImpl*>(reply.parent);
+        return impl->resumeWhenComplete(continuation, &state->complete);
+    }
+
+    const void* ResourceReadbackAwaiter::await_resume() const noexcept
+    {
+        return GetReadbackData(reply);
+    }
+
+}
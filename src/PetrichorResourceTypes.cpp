@@ -1,25 +1,59 @@
 #include "PetrichorResourceTypes.hpp"
 #include "ResourceCreationCoro.hpp"
+#include "ReadbackPool.hpp"
+#include <utility>
 
 namespace petrichor
 {
 
+    ResourceSystemReply::ResourceSystemReply(void* _parent, void* coroutine_address) noexcept : parent(_parent), coroutineHandle(coroutine_address) {}
+
+    ResourceSystemReply::~ResourceSystemReply()
+    {
+        using coroHandle = std::coroutine_handle<ResourceCreationEvent::promise_type>;
+        coroHandle handle = coroHandle::from_address(coroutineHandle);
+        // If the coroutine already finished it's waiting on us to clean up: otherwise, it'll clean itself up
+        if (handle && handle.promise().released.exchange(true, std::memory_order_acq_rel))
+        {
+            handle.destroy();
+        }
+    }
+
+    ResourceSystemReply::ResourceSystemReply(ResourceSystemReply&& other) noexcept : parent(std::move(other.parent)), coroutineHandle(std::move(other.coroutineHandle))
+    {
+        other.parent = nullptr;
+        other.coroutineHandle = nullptr;
+    }
+
+    ResourceSystemReply& ResourceSystemReply::operator=(ResourceSystemReply&& other) noexcept
+    {
+        if (this != &other)
+        {
+            this->~ResourceSystemReply();
+            parent = std::move(other.parent);
+            other.parent = nullptr;
+            coroutineHandle = std::move(other.coroutineHandle);
+            other.coroutineHandle = nullptr;
+        }
+        return *this;
+    }
+
     bool ResourceOperationComplete(const ResourceSystemReply& reply)
     {
         using coroHandle = std::coroutine_handle<ResourceCreationEvent::promise_type>;
         coroHandle handle = coroHandle::from_address(reply.coroutineHandle);
         // bool conversion first lets us know this is actually referring to a valid handle, so we don't crash
-        return handle ? handle.done() : false;
+        return handle ? handle.promise().complete.load(std::memory_order_acquire) : false;
     }
 
     GpuResourceHandle GetHandleFromOperation(const ResourceSystemReply& reply)
     {
         using coroHandle = std::coroutine_handle<ResourceCreationEvent::promise_type>;
         coroHandle handle = coroHandle::from_address(reply.coroutineHandle);
-        if (handle && handle.done())
+        if (handle && handle.promise().complete.load(std::memory_order_acquire))
         {
             auto& handlePromise = handle.promise();
-
+            return handlePromise.resourceHandle;
         }
         else
         {
@@ -27,4 +61,56 @@ namespace petrichor
         }
     }
 
+    ResourceReadbackReply::ResourceReadbackReply(void* _parent, void* readback_state) noexcept : parent(_parent), readbackState(readback_state) {}
+
+    ResourceReadbackReply::~ResourceReadbackReply()
+    {
+        ReadbackState* state = reinterpret_cast<ReadbackState*>(readbackState);
+        // The context frees it once it sees we're gone, unless it was destroyed first and left it to us
+        if (state && state->released.exchange(true, std::memory_order_acq_rel))
+        {
+            delete state;
+        }
+    }
+
+    ResourceReadbackReply::ResourceReadbackReply(ResourceReadbackReply&& other) noexcept : parent(std::move(other.parent)), readbackState(std::move(other.readbackState))
+    {
+        other.parent = nullptr;
+        other.readbackState = nullptr;
+    }
+
+    ResourceReadbackReply& ResourceReadbackReply::operator=(ResourceReadbackReply&& other) noexcept
+    {
+        if (this != &other)
+        {
+            this->~ResourceReadbackReply();
+            parent = std::move(other.parent);
+            other.parent = nullptr;
+            readbackState = std::move(other.readbackState);
+            other.readbackState = nullptr;
+        }
+        return *this;
+    }
+
+    bool ReadbackComplete(const ResourceReadbackReply& reply)
+    {
+        const ReadbackState* state = reinterpret_cast<const ReadbackState*>(reply.readbackState);
+        return state ? state->complete.load(std::memory_order_acquire) : false;
+    }
+
+    const void* GetReadbackData(const ResourceReadbackReply& reply, uint64_t* size)
+    {
+        const ReadbackState* state = reinterpret_cast<const ReadbackState*>(reply.readbackState);
+        if (!state || !state->complete.load(std::memory_order_acquire) || (state->buffer.mappedData == nullptr))
+        {
+            return nullptr;
+        }
+
+        if (size != nullptr)
+        {
+            *size = state->size;
+        }
+        return state->buffer.mappedData;
+    }
+
 }
@@ -0,0 +1,76 @@
+#include "ReadbackPool.hpp"
+#include <bit>
+
+namespace petrichor
+{
+
+    ReadbackBuffer ReadbackBufferPool::acquire(VmaAllocator allocator, VkDeviceSize size, const VmaAllocationCreateInfo& alloc_create_info)
+    {
+        const VkDeviceSize capacity = sizeClass(size);
+        auto& buffers = freeBuffers[capacity];
+        if (!buffers.empty())
+        {
+            ReadbackBuffer result = buffers.back();
+            buffers.pop_back();
+            return result;
+        }
+
+        // Only ever written by the transfer queue, and read by the host
+        const VkBufferCreateInfo createInfo
+        {
+            VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            nullptr,
+            0,
+            capacity,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_SHARING_MODE_EXCLUSIVE,
+            0u,
+            nullptr
+        };
+
+        ReadbackBuffer result{};
+        VmaAllocationInfo allocationInfo{};
+        if (vmaCreateBuffer(allocator, &createInfo, &alloc_create_info, &result.buffer, &result.allocation, &allocationInfo) != VK_SUCCESS)
+        {
+            return ReadbackBuffer{};
+        }
+
+        result.capacity = capacity;
+        result.mappedData = allocationInfo.pMappedData;
+        return result;
+    }
+
+    void ReadbackBufferPool::release(VmaAllocator allocator, ReadbackBuffer buffer)
+    {
+        if (buffer.buffer == VK_NULL_HANDLE)
+        {
+            return;
+        }
+
+        auto& buffers = freeBuffers[buffer.capacity];
+        if (buffers.size() >= MaxPooledPerClass)
+        {
+            vmaDestroyBuffer(allocator, buffer.buffer, buffer.allocation);
+            return;
+        }
+        buffers.emplace_back(buffer);
+    }
+
+    void ReadbackBufferPool::destroy(VmaAllocator allocator)
+    {
+        for (auto& [capacity, buffers] : freeBuffers)
+        {
+            for (auto& buffer : buffers)
+            {
+                vmaDestroyBuffer(allocator, buffer.buffer, buffer.allocation);
+            }
+        }
+        freeBuffers.clear();
+    }
+
+    VkDeviceSize ReadbackBufferPool::sizeClass(VkDeviceSize size) noexcept
+    {
+        return size <= MinSizeClass ? MinSizeClass : std::bit_ceil(size);
+    }
+
+}
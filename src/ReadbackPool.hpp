@@ -0,0 +1,55 @@
+#pragma once
+#ifndef PETRICHOR_READBACK_POOL_HPP
+#define PETRICHOR_READBACK_POOL_HPP
+#include "PetrichorResourceTypes.hpp"
+#include <atomic>
+#include <vector>
+#include <unordered_map>
+#include <vulkan/vulkan_core.h>
+#include "vk_mem_alloc.h"
+
+namespace petrichor
+{
+
+    // Host cached buffer that readback copies land in, mapped for its whole life
+    struct ReadbackBuffer
+    {
+        VkBuffer buffer{ VK_NULL_HANDLE };
+        VmaAllocation allocation{ VK_NULL_HANDLE };
+        VkDeviceSize capacity{ 0u };
+        void* mappedData{ nullptr };
+    };
+
+    // Readback buffers bucketed by power of two size class, so the buffers released by one frame's
+    // replies can take the next frame's copies without going back to VMA
+    struct ReadbackBufferPool
+    {
+        ReadbackBuffer acquire(VmaAllocator allocator, VkDeviceSize size, const VmaAllocationCreateInfo& alloc_create_info);
+        void release(VmaAllocator allocator, ReadbackBuffer buffer);
+        void destroy(VmaAllocator allocator);
+
+        constexpr static VkDeviceSize MinSizeClass = 4096u;
+        // Free buffers kept per size class: anything past this is returned to VMA
+        constexpr static size_t MaxPooledPerClass = 8u;
+        static VkDeviceSize sizeClass(VkDeviceSize size) noexcept;
+
+    private:
+        std::unordered_map<VkDeviceSize, std::vector<ReadbackBuffer>> freeBuffers;
+    };
+
+    // Shared by a ResourceReadbackReply and the context. Whichever of the two lets go of it last frees it:
+    // normally that's the context, once the copy has completed and the reply has been destroyed
+    struct ReadbackState
+    {
+        GpuResourceHandle handle{ INVALID_GPU_RESOURCE_HANDLE };
+        VkDeviceSize offset{ 0u };
+        VkDeviceSize size{ 0u };
+        // Left empty if the readback failed
+        ReadbackBuffer buffer{};
+        std::atomic<bool> complete{ false };
+        std::atomic<bool> released{ false };
+    };
+
+}
+
+#endif //!PETRICHOR_READBACK_POOL_HPP
@@ -33,6 +33,8 @@ namespace
     static petrichor::post_logical_device_function_t postLogicalDeviceFunction = nullptr;
     static void* usedNextPtr = nullptr;
     static VkPhysicalDeviceFeatures* enabledDeviceFeatures = nullptr;
+    // Copied out as the device is created, since the post logical device function is free to release the chain
+    static petrichor::EnabledDeviceFeatures enabledFeatureSet;
     static std::vector<std::string> extensionsBuffer;
     static std::string windowingModeBuffer;
     static bool validationEnabled{ false };
@@ -103,6 +105,74 @@ namespace petrichor
         MaxSampledImages = limits.maxDescriptorSetSampledImages;
         MaxStorageImages = limits.maxDescriptorSetStorageImages;
         MaxInputAttachments = limits.maxDescriptorSetInputAttachments;
+
+        VkPhysicalDeviceDescriptorIndexingProperties indexingProperties{};
+        indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+        if (hostDevice->GetProperties().apiVersion >= VK_API_VERSION_1_2)
+        {
+            VkPhysicalDeviceProperties2 properties2
+            {
+                VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+                &indexingProperties,
+                {}
+            };
+            vkGetPhysicalDeviceProperties2(hostDevice->vkHandle(), &properties2);
+        }
+        MaxUpdateAfterBindSamplers = indexingProperties.maxDescriptorSetUpdateAfterBindSamplers;
+        MaxUpdateAfterBindStorageBuffers = indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers;
+        MaxUpdateAfterBindSampledImages = indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages;
+        MaxPerStageUpdateAfterBindSamplers = indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers;
+        MaxPerStageUpdateAfterBindStorageBuffers = indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers;
+        MaxPerStageUpdateAfterBindSampledImages = indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages;
+        MaxPerStageUpdateAfterBindResources = indexingProperties.maxPerStageUpdateAfterBindResources;
+    }
+
+    EnabledDeviceFeatures::EnabledDeviceFeatures(const VkPhysicalDeviceFeatures* features, const void* next_chain)
+    {
+        if (features != nullptr)
+        {
+            Core = *features;
+        }
+
+        for (const VkBaseInStructure* next = reinterpret_cast<const VkBaseInStructure*>(next_chain); next != nullptr; next = next->pNext)
+        {
+            switch (next->sType)
+            {
+            case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2:
+                Core = reinterpret_cast<const VkPhysicalDeviceFeatures2*>(next)->features;
+                break;
+            case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES:
+            {
+                const auto* features12 = reinterpret_cast<const VkPhysicalDeviceVulkan12Features*>(next);
+                BufferDeviceAddress |= features12->bufferDeviceAddress == VK_TRUE;
+                RuntimeDescriptorArray |= features12->runtimeDescriptorArray == VK_TRUE;
+                DescriptorBindingPartiallyBound |= features12->descriptorBindingPartiallyBound == VK_TRUE;
+                DescriptorBindingSampledImageUpdateAfterBind |= features12->descriptorBindingSampledImageUpdateAfterBind == VK_TRUE;
+                DescriptorBindingStorageBufferUpdateAfterBind |= features12->descriptorBindingStorageBufferUpdateAfterBind == VK_TRUE;
+                break;
+            }
+            case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES:
+                Synchronization2 |= reinterpret_cast<const VkPhysicalDeviceVulkan13Features*>(next)->synchronization2 == VK_TRUE;
+                break;
+            case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES:
+                BufferDeviceAddress |= reinterpret_cast<const VkPhysicalDeviceBufferDeviceAddressFeatures*>(next)->bufferDeviceAddress == VK_TRUE;
+                break;
+            case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES:
+            {
+                const auto* indexingFeatures = reinterpret_cast<const VkPhysicalDeviceDescriptorIndexingFeatures*>(next);
+                RuntimeDescriptorArray |= indexingFeatures->runtimeDescriptorArray == VK_TRUE;
+                DescriptorBindingPartiallyBound |= indexingFeatures->descriptorBindingPartiallyBound == VK_TRUE;
+                DescriptorBindingSampledImageUpdateAfterBind |= indexingFeatures->descriptorBindingSampledImageUpdateAfterBind == VK_TRUE;
+                DescriptorBindingStorageBufferUpdateAfterBind |= indexingFeatures->descriptorBindingStorageBufferUpdateAfterBind == VK_TRUE;
+                break;
+            }
+            case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES:
+                Synchronization2 |= reinterpret_cast<const VkPhysicalDeviceSynchronization2Features*>(next)->synchronization2 == VK_TRUE;
+                break;
+            default:
+                break;
+            }
+        }
     }
 
     RenderingContext::RenderingContext() : impl(new RenderingContextImpl())
@@ -222,6 +292,11 @@ namespace petrichor
         postLogicalDeviceFunction = fn1;
     }
 
+    const EnabledDeviceFeatures& RenderingContext::GetEnabledDeviceFeatures() noexcept
+    {
+        return enabledFeatureSet;
+    }
+
     void RenderingContext::AddSwapchainCallbacks(SwapchainCallbacks callbacks)
     {
         SwapchainCallbacksStorage.BeginFns.emplace_front(callbacks.BeginResize);
@@ -884,6 +959,7 @@ namespace
         }
 
         *device = std::make_unique<vpr::Device>(instance, physical_device, surface, &pack, nullptr, 0);
+        enabledFeatureSet = petrichor::EnabledDeviceFeatures(enabledDeviceFeatures, usedNextPtr);
 
         if (postLogicalDeviceFunction != nullptr)
         {
@@ -1,5 +1,6 @@
 #include "ResourceContext.hpp"
 #include "ResourceContextImpl.hpp"
+#include "RenderingContext.hpp"
 
 namespace petrichor
 {
@@ -10,8 +11,231 @@ namespace petrichor
     {
         if (impl)
         {
+            impl->destroy();
             delete impl;
         }
     }
 
+    ResourceContext& ResourceContext::Get(vpr::Device*, vpr::PhysicalDevice*)
+    {
+        // Construct() is what sets the context up for a device: this only hands out the instance
+        static ResourceContext ctxt;
+        return ctxt;
+    }
+
+    void ResourceContext::Update()
+    {
+        impl->update();
+    }
+
+    void ResourceContext::Destroy()
+    {
+        if (impl)
+        {
+            impl->destroy();
+            delete impl;
+            impl = nullptr;
+        }
+    }
+
+    void ResourceContext::Construct(vpr::Device* device, vpr::PhysicalDevice* physicalDevice, const EnabledDeviceFeatures* enabledFeatures)
+    {
+        if (!impl)
+        {
+            impl = new ResourceContextImpl();
+        }
+        impl->construct(device, physicalDevice, enabledFeatures != nullptr ? *enabledFeatures : RenderingContext::GetEnabledDeviceFeatures(),
+            PETRICHOR_VALIDATION_ENABLED);
+    }
+
+    ResourceSystemReply ResourceContext::CreateResource(ResourceCreationMessage message)
+    {
+        return impl->createResource(message);
+    }
+
+    void ResourceContext::DestroyResource(GpuResourceHandle handle)
+    {
+        impl->destroyResource(handle);
+    }
+
+    GpuResourceHandle ResourceContext::ImportResource(const ImportedResourceDesc& desc)
+    {
+        return impl->importResource(desc);
+    }
+
+    void ResourceContext::ModifyResource(const ResourceModificationMessage& message)
+    {
+        impl->modifyResource(message);
+    }
+
+    void ResourceContext::QueryMemoryBudget(uint32_t* num_heaps, GpuMemoryHeapBudget* budgets) const
+    {
+        impl->queryMemoryBudget(num_heaps, budgets);
+    }
+
+    void ResourceContext::SetMemoryBudgetPolicy(const MemoryBudgetPolicy& policy)
+    {
+        impl->setMemoryBudgetPolicy(policy);
+    }
+
+    GpuResourceResidency ResourceContext::GetResourceResidency(GpuResourceHandle handle) const
+    {
+        return impl->resourceResidency(handle);
+    }
+
+    uint64_t ResourceContext::GetDeviceAddress(GpuResourceHandle handle) const noexcept
+    {
+        return impl->deviceAddress(handle);
+    }
+
+    uint64_t ResourceContext::GetVulkanHandle(GpuResourceHandle handle) const noexcept
+    {
+        return impl->vulkanHandle(handle);
+    }
+
+    void* ResourceContext::GetMappedPointer(GpuResourceHandle handle) const
+    {
+        return impl->mappedPointer(handle);
+    }
+
+    void ResourceContext::MarkMappedRangeDirty(GpuResourceHandle handle, uint64_t offset, uint64_t size)
+    {
+        impl->markMappedRangeDirty(handle, offset, size);
+    }
+
+    VkDescriptorSetLayout ResourceContext::GetBindlessSetLayout() const noexcept
+    {
+        return impl->bindlessSetLayout();
+    }
+
+    VkDescriptorSet ResourceContext::GetBindlessSet() const noexcept
+    {
+        return impl->bindlessSet();
+    }
+
+    uint32_t ResourceContext::GetBindlessIndex(GpuResourceHandle handle) const
+    {
+        return impl->bindlessIndex(handle);
+    }
+
+    void ResourceContext::RequestSparsePages(GpuResourceHandle handle, uint32_t num_requests, const SparseImagePageRequest* requests)
+    {
+        impl->requestSparsePages(handle, num_requests, requests);
+    }
+
+    SparseResidencyStats ResourceContext::GetSparseResidencyStats(GpuResourceHandle handle) const
+    {
+        return impl->sparseResidencyStats(handle);
+    }
+
+    bool ResourceContext::CreateTransientResources(uint32_t num_resources, const TransientResourceDesc* descs, GpuResourceHandle* handles, TransientMemoryStats* stats)
+    {
+        return impl->createTransientResources(num_resources, descs, handles, stats);
+    }
+
+    void ResourceContext::TransitionResources(VkCommandBuffer cmd, uint32_t num_transitions, const ImageTransition* transitions)
+    {
+        impl->transitionResources(cmd, num_transitions, transitions);
+    }
+
+    void ResourceContext::RecordTransientAliasingBarriers(VkCommandBuffer cmd, uint32_t use_point, uint32_t num_handles, const GpuResourceHandle* handles) const
+    {
+        impl->recordTransientAliasingBarriers(cmd, use_point, num_handles, handles);
+    }
+
+    TransientMemoryStats ResourceContext::GetTransientMemoryStats() const
+    {
+        return impl->transientMemoryStats();
+    }
+
+    ResourceReadbackReply ResourceContext::ReadbackResource(GpuResourceHandle handle, uint64_t offset, uint64_t size)
+    {
+        return impl->readbackResource(handle, offset, size);
+    }
+
+    void ResourceContext::AddTransferWaitSemaphore(VkSemaphore semaphore, uint32_t wait_stages)
+    {
+        impl->addTransferWaitSemaphore(semaphore, wait_stages);
+    }
+
+    void ResourceContext::SetUploadBudget(const UploadBudget& budget)
+    {
+        impl->setUploadBudget(budget);
+    }
+
+    UploadSchedulerStats ResourceContext::GetUploadSchedulerStats() const
+    {
+        return impl->uploadSchedulerStats();
+    }
+
+    void ResourceContext::SetStagingPoolIdleFrames(uint32_t frames)
+    {
+        impl->setStagingPoolIdleFrames(frames);
+    }
+
+    StagingPoolStats ResourceContext::GetStagingPoolStats() const
+    {
+        return impl->stagingPoolStats();
+    }
+
+    void ResourceContext::RegisterDecompressionCodec(GpuCompressionCodec codec, DecompressionFn fn, void* user_data)
+    {
+        impl->registerDecompressionCodec(codec, fn, user_data);
+    }
+
+    DecompressionStats ResourceContext::GetDecompressionStats() const
+    {
+        return impl->decompressionStats();
+    }
+
+    SamplerCacheStats ResourceContext::GetSamplerCacheStats() const
+    {
+        return impl->samplerCacheStats();
+    }
+
+    ViewCacheStats ResourceContext::GetViewCacheStats() const
+    {
+        return impl->viewCacheStats();
+    }
+
+    CoroutineFrameStats ResourceContext::GetCoroutineFrameStats() const
+    {
+        return impl->coroutineFrameStats();
+    }
+
+    void ResourceContext::WriteMemoryStatsFile(const char* output_file)
+    {
+        impl->writeMemoryStatsFile(output_file);
+    }
+
+    void ResourceContext::EnableMemoryStatsSnapshots(uint32_t frame_interval, uint32_t capacity)
+    {
+        impl->enableMemoryStatsSnapshots(frame_interval, capacity);
+    }
+
+    void ResourceContext::GetMemoryStatsSnapshots(uint32_t* num_samples, MemoryStatsSample* samples) const
+    {
+        impl->memoryStatsSnapshots(num_samples, samples);
+    }
+
+    void ResourceContext::WriteMemoryStatsSnapshots(const char* output_file) const
+    {
+        impl->writeMemoryStatsSnapshots(output_file);
+    }
+
+    void ResourceContext::EnableCreationTracing(uint32_t capacity)
+    {
+        impl->enableCreationTracing(capacity);
+    }
+
+    void ResourceContext::GetCreationLatencies(uint32_t* num_latencies, ResourceCreationLatency* latencies) const
+    {
+        impl->creationLatencies(num_latencies, latencies);
+    }
+
+    void ResourceContext::WriteCreationLatencyFile(const char* output_file) const
+    {
+        impl->writeCreationLatencyFile(output_file);
+    }
+
 }
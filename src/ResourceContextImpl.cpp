@@ -2,13 +2,378 @@
 #include "Instance.hpp"
 #include "LogicalDevice.hpp"
 #include "PhysicalDevice.hpp"
+#include "RenderingContext.hpp"
 #include "vkAssert.hpp"
+#include "nlohmann/json.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+
+    bool deviceExtensionEnabled(const vpr::Device* device, const char* extension_name)
+    {
+        size_t num_device_extensions = 0;
+        device->GetEnabledExtensions(&num_device_extensions, nullptr);
+        if (num_device_extensions == 0)
+        {
+            return false;
+        }
+
+        bool found = false;
+        std::vector<char*> extensions_buffer(num_device_extensions);
+        device->GetEnabledExtensions(&num_device_extensions, extensions_buffer.data());
+        for (auto& str : extensions_buffer)
+        {
+            found |= (strcmp(str, extension_name) == 0);
+            free(str);
+        }
+
+        return found;
+    }
+
+    // Old style BAR window: host visible VRAM no bigger than this is too scarce to upload everything through
+    constexpr static VkDeviceSize LegacyBarWindowSize = 256u * 1024u * 1024u;
+    // Satisfies the bufferOffset requirements of vkCmdCopyBufferToImage for every format we upload: including block
+    // compressed ones, which need a multiple of their 8 or 16 byte block
+    constexpr static VkDeviceSize ImageCopyAlignment = 16u;
+
+    constexpr inline VkDeviceSize alignUp(const VkDeviceSize value, const VkDeviceSize alignment) noexcept
+    {
+        return alignment > 1u ? ((value + alignment - 1u) / alignment) * alignment : value;
+    }
+
+    // Running out of memory is something callers can recover from, so creations hand it back as an invalid handle
+    // instead of asserting. Anything else is still a bug
+    constexpr inline bool outOfMemory(const VkResult result) noexcept
+    {
+        return (result == VK_ERROR_OUT_OF_DEVICE_MEMORY) || (result == VK_ERROR_OUT_OF_HOST_MEMORY);
+    }
+
+    // Pools the calling thread last recorded with, so recording doesn't take threadPoolsMutex every time
+    struct ThreadPoolsCache
+    {
+        uint64_t instanceID{ std::numeric_limits<uint64_t>::max() };
+        void* pools{ nullptr };
+    };
+
+    thread_local ThreadPoolsCache cachedThreadPools;
+    std::atomic<uint64_t> nextContextInstanceID{ 0u };
+
+    // Trace of the creation running on this thread, if it's being traced
+    thread_local petrichor::CreationTrace* activeCreationTrace{ nullptr };
+
+    void markCreationState(const petrichor::ResourceCreationEvent::State state) noexcept
+    {
+        if (activeCreationTrace != nullptr)
+        {
+            activeCreationTrace->mark(state);
+        }
+    }
+
+    // Copies of the creation running on this thread, when they're left to the upload scheduler instead of recorded
+    struct DeferredUploads
+    {
+        std::vector<petrichor::ScheduledUpload> uploads;
+        // Acquired by the creation: handed over to its uploads, or freed with the frame if it fails
+        std::vector<petrichor::StagingBuffer> staging;
+    };
+
+    thread_local DeferredUploads* activeDeferredUploads{ nullptr };
+
+    bool uploadsDeferred() noexcept
+    {
+        return (activeDeferredUploads != nullptr) && !activeDeferredUploads->uploads.empty();
+    }
+
+    // Queues the copies for the scheduler if the creation on this thread is being scheduled. Returns false (leaving the regions
+    // alone) if they should be recorded now
+    bool deferUpload(const petrichor::ResourceRecord& record, VkBuffer source, const VkDeviceSize bytes, std::vector<VkBufferCopy>&& buffer_regions,
+        std::vector<VkBufferImageCopy>&& image_regions)
+    {
+        if (activeDeferredUploads == nullptr)
+        {
+            return false;
+        }
+
+        petrichor::ScheduledUpload& upload = activeDeferredUploads->uploads.emplace_back();
+        upload.vkHandle = record.vkHandle;
+        upload.type = record.type;
+        upload.source = source;
+        upload.bufferRegions = std::move(buffer_regions);
+        upload.imageRegions = std::move(image_regions);
+        upload.bytes = bytes;
+        return true;
+    }
+
+    VkImageAspectFlags aspectMaskFromFormat(const VkFormat format) noexcept
+    {
+        switch (format)
+        {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT;
+        case VK_FORMAT_S8_UINT:
+            return VK_IMAGE_ASPECT_STENCIL_BIT;
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        default:
+            return VK_IMAGE_ASPECT_COLOR_BIT;
+        }
+    }
+
+    // Synchronization2 flags share their bits with the originals below 32. The ones above have no equivalent short of everything
+    VkPipelineStageFlags legacyStageMask(const VkPipelineStageFlags2 stages) noexcept
+    {
+        return (stages >> 32u) != 0u ? static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT) : static_cast<VkPipelineStageFlags>(stages);
+    }
+
+    VkAccessFlags legacyAccessMask(const VkAccessFlags2 access) noexcept
+    {
+        return (access >> 32u) != 0u ? static_cast<VkAccessFlags>(access) | VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT :
+            static_cast<VkAccessFlags>(access);
+    }
+
+    // Regions have to lie within the image. Block compressed ones are copied as-is, so they have to cover whole blocks
+    // (or run to the edge of the mip), and hold at least that many blocks
+    bool validUploadRegion(const VkImageCreateInfo& info, const petrichor::GpuImageResourceData& region, const size_t size) noexcept
+    {
+        using petrichor::FormatCapabilityTable;
+        const uint32_t numLayers = std::max(region.ArrayLayerCount, 1u);
+        if ((region.MipLevel >= info.mipLevels) || (region.ArrayLayer + numLayers > info.arrayLayers))
+        {
+            return false;
+        }
+
+        const uint32_t mipWidth = std::max(info.extent.width >> region.MipLevel, 1u);
+        const uint32_t mipHeight = std::max(info.extent.height >> region.MipLevel, 1u);
+        if ((region.Width > mipWidth) || (region.Height > mipHeight))
+        {
+            return false;
+        }
+
+        if (!FormatCapabilityTable::isBlockCompressed(info.format))
+        {
+            return true;
+        }
+
+        const petrichor::FormatBlockInfo block = FormatCapabilityTable::blockInfo(info.format);
+        if ((((region.Width % block.width) != 0u) && (region.Width != mipWidth)) ||
+            (((region.Height % block.height) != 0u) && (region.Height != mipHeight)))
+        {
+            return false;
+        }
+
+        const uint32_t mipDepth = std::max(info.extent.depth >> region.MipLevel, 1u);
+        return size >= FormatCapabilityTable::blockCompressedSize(info.format, region.Width, region.Height, mipDepth) * numLayers;
+    }
+
+    // Entries packed one after another from offset, each at its own alignment as buffer uploads lay them out, all have
+    // to end within the buffer
+    bool validBufferWrite(const VkDeviceSize buffer_size, VkDeviceSize offset, const petrichor::GpuResourceData* data, const uint32_t num_data) noexcept
+    {
+        for (uint32_t i = 0u; i < num_data; ++i)
+        {
+            if (offset > buffer_size)
+            {
+                return false;
+            }
+            offset = alignUp(offset, data[i].Alignment);
+            if ((offset > buffer_size) || (data[i].Size > buffer_size - offset))
+            {
+                return false;
+            }
+            offset += data[i].Size;
+        }
+        return true;
+    }
+
+    // Same for compressed entries, by the size they decode to
+    bool validBufferWrite(const VkDeviceSize buffer_size, const petrichor::GpuCompressedResourceData* data, const uint32_t num_data) noexcept
+    {
+        VkDeviceSize offset = 0u;
+        for (uint32_t i = 0u; i < num_data; ++i)
+        {
+            offset = alignUp(offset, data[i].Alignment);
+            if ((offset > buffer_size) || (data[i].DecompressedSize > buffer_size - offset))
+            {
+                return false;
+            }
+            offset += data[i].DecompressedSize;
+        }
+        return true;
+    }
+
+    // vkCmdFillBuffer works in whole words, and has to stay within the buffer
+    bool validBufferFill(const VkDeviceSize buffer_size, const VkDeviceSize offset, const VkDeviceSize size) noexcept
+    {
+        return ((offset % 4u) == 0u) && ((size % 4u) == 0u) && (size != 0u) && (offset < buffer_size) && (size <= buffer_size - offset);
+    }
+
+    // Rows are tightly packed, which for block compressed formats means in whole blocks
+    VkBufferImageCopy imageUploadRegion(const VkImageCreateInfo& info, const petrichor::GpuImageResourceData& region, const VkDeviceSize buffer_offset) noexcept
+    {
+        return VkBufferImageCopy
+        {
+            buffer_offset,
+            0u,
+            0u,
+            VkImageSubresourceLayers{ aspectMaskFromFormat(info.format), region.MipLevel, region.ArrayLayer, std::max(region.ArrayLayerCount, 1u) },
+            VkOffset3D{ 0, 0, 0 },
+            VkExtent3D{ region.Width, region.Height, std::max(info.extent.depth >> region.MipLevel, 1u) }
+        };
+    }
+
+    const char* resourceTypeName(const petrichor::GpuResourceType type) noexcept
+    {
+        using petrichor::GpuResourceType;
+        switch (type)
+        {
+        case GpuResourceType::Buffer:
+            return "Buffer";
+        case GpuResourceType::Image:
+            return "Image";
+        case GpuResourceType::Sampler:
+            return "Sampler";
+        case GpuResourceType::CombinedImageSampler:
+            return "CombinedImageSampler";
+        case GpuResourceType::BufferView:
+            return "BufferView";
+        case GpuResourceType::ImageView:
+            return "ImageView";
+        case GpuResourceType::SparseImage:
+            return "SparseImage";
+        default:
+            return "Invalid";
+        }
+    }
+
+    const char* memoryDomainName(const petrichor::GpuResourceMemoryDomain domain) noexcept
+    {
+        using petrichor::GpuResourceMemoryDomain;
+        switch (domain)
+        {
+        case GpuResourceMemoryDomain::Device:
+            return "Device";
+        case GpuResourceMemoryDomain::Host:
+            return "Host";
+        case GpuResourceMemoryDomain::HostCached:
+            return "HostCached";
+        case GpuResourceMemoryDomain::LinkedDeviceHost:
+            return "LinkedDeviceHost";
+        default:
+            return "Invalid";
+        }
+    }
+
+    const char* residencyName(const petrichor::GpuResourceResidency residency) noexcept
+    {
+        using petrichor::GpuResourceResidency;
+        switch (residency)
+        {
+        case GpuResourceResidency::Resident:
+            return "Resident";
+        case GpuResourceResidency::DemotedToHost:
+            return "DemotedToHost";
+        case GpuResourceResidency::Released:
+            return "Released";
+        case GpuResourceResidency::PendingUpload:
+            return "PendingUpload";
+        default:
+            return "Invalid";
+        }
+    }
+
+    struct CreationFlagName
+    {
+        uint32_t flag;
+        const char* name;
+    };
+
+    // Flags that affect where or how resources are allocated, which memory stats are broken down by
+    constexpr static CreationFlagName CreationFlagNames[]
+    {
+        { petrichor::CreationFlagBits::ResourceCreateDedicatedMemory, "DedicatedMemory" },
+        { petrichor::CreationFlagBits::ResourceCreateNeverAllocate, "NeverAllocate" },
+        { petrichor::CreationFlagBits::ResourceCreatePersistentlyMapped, "PersistentlyMapped" },
+        { petrichor::CreationFlagBits::ResourceCreateEvictable, "Evictable" },
+        { petrichor::CreationFlagBits::ResourceCreateDeviceAddress, "DeviceAddress" },
+        { petrichor::CreationFlagBits::ResourceCreateMemoryStrategyMinMemory, "MemoryStrategyMinMemory" },
+        { petrichor::CreationFlagBits::ResourceCreateMemoryStrategyMinTime, "MemoryStrategyMinTime" },
+        { petrichor::CreationFlagBits::ResourceCreateMemoryStrategyMinFragmentation, "MemoryStrategyMinFragmentation" }
+    };
+
+    nlohmann::json detailedStatsJson(const VmaDetailedStatistics& stats)
+    {
+        const bool anyAllocations = stats.statistics.allocationCount != 0u;
+        const bool anyUnusedRanges = stats.unusedRangeCount != 0u;
+        return nlohmann::json
+        {
+            { "blockCount", stats.statistics.blockCount },
+            { "allocationCount", stats.statistics.allocationCount },
+            { "blockBytes", stats.statistics.blockBytes },
+            { "allocationBytes", stats.statistics.allocationBytes },
+            { "unusedBytes", stats.statistics.blockBytes - stats.statistics.allocationBytes },
+            { "unusedRangeCount", stats.unusedRangeCount },
+            // VMA reports VK_WHOLE_SIZE as the minimum of an empty set
+            { "allocationSizeMin", anyAllocations ? stats.allocationSizeMin : 0u },
+            { "allocationSizeMax", stats.allocationSizeMax },
+            { "unusedRangeSizeMin", anyUnusedRanges ? stats.unusedRangeSizeMin : 0u },
+            { "unusedRangeSizeMax", stats.unusedRangeSizeMax }
+        };
+    }
+
+    // Adds a resource to a breakdown entry, attributing its bytes to its debug name
+    void addToBreakdown(nlohmann::json& entry, const std::string& debug_name, const VkDeviceSize bytes)
+    {
+        if (entry.is_null())
+        {
+            entry = nlohmann::json{ { "resources", 0u }, { "bytes", 0u }, { "byName", nlohmann::json::object() } };
+        }
+
+        entry["resources"] = entry["resources"].get<uint64_t>() + 1u;
+        entry["bytes"] = entry["bytes"].get<uint64_t>() + bytes;
+        nlohmann::json& named = entry["byName"][debug_name.empty() ? "<unnamed>" : debug_name];
+        named = (named.is_null() ? 0u : named.get<uint64_t>()) + bytes;
+    }
+
+    // Moves the queue families of a concurrently shared resource into its record, as the info's pointer won't outlive
+    // the message. Anything else is left exclusive, without families
+    template<typename CreateInfo>
+    void keepQueueFamilies(CreateInfo& info, std::vector<uint32_t>& queue_families)
+    {
+        if ((info.sharingMode == VK_SHARING_MODE_CONCURRENT) && (info.pQueueFamilyIndices != nullptr))
+        {
+            queue_families.assign(info.pQueueFamilyIndices, info.pQueueFamilyIndices + info.queueFamilyIndexCount);
+        }
+        else
+        {
+            queue_families.clear();
+            info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            info.queueFamilyIndexCount = 0u;
+        }
+        info.pQueueFamilyIndices = nullptr;
+    }
+
+}
 
 namespace petrichor
 {
-    void ResourceContextImpl::construct(vpr::Device* _device, vpr::PhysicalDevice* _physical_device, bool validation_enabled)
+
+    void ResourceContextImpl::construct(vpr::Device* _device, vpr::PhysicalDevice* _physical_device, const EnabledDeviceFeatures& enabled_features, bool validation_enabled)
     {
         workQueueThreadID = std::this_thread::get_id();
+        instanceID = nextContextInstanceID.fetch_add(1u, std::memory_order_relaxed);
         logicalDevice = _device;
         physicalDevice = _physical_device;
 
@@ -18,10 +383,43 @@ namespace petrichor
         }
 
         const VkApplicationInfo& applicationInfo = logicalDevice->ParentInstance()->ApplicationInfo();
+        // VMA needs vkGetPhysicalDeviceMemoryProperties2 to read the budget, so 1.0 devices don't get it
+        memoryBudgetExtEnabled = (applicationInfo.apiVersion >= VK_API_VERSION_1_1) &&
+            deviceExtensionEnabled(logicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+        // Only if the device was created with bufferDeviceAddress: the allocator flag and SHADER_DEVICE_ADDRESS usage
+        // are invalid otherwise, however much the hardware supports it
+        if (enabled_features.BufferDeviceAddress && ((applicationInfo.apiVersion >= VK_API_VERSION_1_2) || ((applicationInfo.apiVersion >= VK_API_VERSION_1_1) &&
+            deviceExtensionEnabled(logicalDevice, VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME))))
+        {
+            const char* addressFnName = applicationInfo.apiVersion >= VK_API_VERSION_1_2 ? "vkGetBufferDeviceAddress" : "vkGetBufferDeviceAddressKHR";
+            vkGetBufferDeviceAddressFn = reinterpret_cast<PFN_vkGetBufferDeviceAddress>(vkGetDeviceProcAddr(logicalDevice->vkHandle(), addressFnName));
+            bufferDeviceAddressSupported = vkGetBufferDeviceAddressFn != nullptr;
+        }
+
+        // Used by TransitionResources() when the device was created with synchronization2: vkCmdPipelineBarrier otherwise
+        if (enabled_features.Synchronization2 && ((applicationInfo.apiVersion >= VK_API_VERSION_1_3) || ((applicationInfo.apiVersion >= VK_API_VERSION_1_1) &&
+            deviceExtensionEnabled(logicalDevice, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME))))
+        {
+            const char* barrierFnName = applicationInfo.apiVersion >= VK_API_VERSION_1_3 ? "vkCmdPipelineBarrier2" : "vkCmdPipelineBarrier2KHR";
+            vkCmdPipelineBarrier2Fn = reinterpret_cast<PFN_vkCmdPipelineBarrier2>(vkGetDeviceProcAddr(logicalDevice->vkHandle(), barrierFnName));
+        }
 
         VmaAllocatorCreateInfo allocatorCreateInfo;
         memset(&allocatorCreateInfo, 0, sizeof(VmaAllocatorCreateInfo));
-        allocatorCreateInfo.flags = applicationInfo.apiVersion >= VK_API_VERSION_1_1 ? VMA_ALLOCATOR_CREATE_KHR_DEDICATED_ALLOCATION_BIT : 0u;
+        if (applicationInfo.apiVersion >= VK_API_VERSION_1_1)
+        {
+            allocatorCreateInfo.flags |= VMA_ALLOCATOR_CREATE_KHR_DEDICATED_ALLOCATION_BIT;
+        }
+        if (memoryBudgetExtEnabled)
+        {
+            allocatorCreateInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+        }
+        if (bufferDeviceAddressSupported)
+        {
+            // Memory for any buffer may be allocated with VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT: VMA can't tell which will need it
+            allocatorCreateInfo.flags |= VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+        }
         allocatorCreateInfo.device = logicalDevice->vkHandle();
         allocatorCreateInfo.physicalDevice = physicalDevice->vkHandle();
         allocatorCreateInfo.instance = logicalDevice->ParentInstance()->vkHandle();
@@ -30,12 +428,4415 @@ namespace petrichor
         VkResult result = vmaCreateAllocator(&allocatorCreateInfo, &vmaAllocatorHandle);
         VkAssert(result);
 
+        const VkPhysicalDeviceMemoryProperties* allocatorMemoryProperties = nullptr;
+        vmaGetMemoryProperties(vmaAllocatorHandle, &allocatorMemoryProperties);
+        memoryProperties = *allocatorMemoryProperties;
+
+        for (uint32_t i = 0u; i < memoryProperties.memoryTypeCount; ++i)
+        {
+            if (!(memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+            {
+                hostOnlyMemoryTypeBits |= (1u << i);
+            }
+        }
+
+        bool allHeapsDeviceLocal = true;
+        for (uint32_t i = 0u; i < memoryProperties.memoryHeapCount; ++i)
+        {
+            allHeapsDeviceLocal &= (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0u;
+        }
+
+        VkDeviceSize largestDirectWriteHeap = 0u;
+        constexpr VkMemoryPropertyFlags directWriteFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+        for (uint32_t i = 0u; i < memoryProperties.memoryTypeCount; ++i)
+        {
+            if ((memoryProperties.memoryTypes[i].propertyFlags & directWriteFlags) == directWriteFlags)
+            {
+                directWriteMemoryTypeBits |= (1u << i);
+                largestDirectWriteHeap = std::max(largestDirectWriteHeap, memoryProperties.memoryHeaps[memoryProperties.memoryTypes[i].heapIndex].size);
+            }
+        }
+
+        hostMemoryImportSupported = (applicationInfo.apiVersion >= VK_API_VERSION_1_1) &&
+            deviceExtensionEnabled(logicalDevice, VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME);
+        if (hostMemoryImportSupported)
+        {
+            vkGetMemoryHostPointerPropertiesEXT = reinterpret_cast<PFN_vkGetMemoryHostPointerPropertiesEXT>(
+                vkGetDeviceProcAddr(logicalDevice->vkHandle(), "vkGetMemoryHostPointerPropertiesEXT"));
+
+            VkPhysicalDeviceExternalMemoryHostPropertiesEXT hostMemoryProperties
+            {
+                VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT,
+                nullptr,
+                0u
+            };
+            VkPhysicalDeviceProperties2 properties2
+            {
+                VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+                &hostMemoryProperties,
+                {}
+            };
+            vkGetPhysicalDeviceProperties2(physicalDevice->vkHandle(), &properties2);
+            minImportedHostPointerAlignment = hostMemoryProperties.minImportedHostPointerAlignment;
+            hostMemoryImportSupported = (vkGetMemoryHostPointerPropertiesEXT != nullptr) && (minImportedHostPointerAlignment != 0u);
+        }
+
+        // UMA devices (integrated GPUs, lavapipe) only have device local heaps, and with ReBAR the host visible
+        // heap covers all of VRAM: in both cases, staging copies are just overhead
+        directDeviceWrites = (directWriteMemoryTypeBits != 0u) && (allHeapsDeviceLocal || (largestDirectWriteHeap > LegacyBarWindowSize));
+
+        uploadQueueFamilies[0] = logicalDevice->QueueFamilyIndices().Transfer;
+        uploadQueueFamilies[1] = logicalDevice->QueueFamilyIndices().Graphics;
+        uploadQueueFamilyCount = (uploadQueueFamilies[0] != uploadQueueFamilies[1]) ? 2u : 1u;
+
+        // What the device was created with, rather than what it supports: texture compression and sparse residency
+        // can't be used otherwise
+        deviceFeatures = enabled_features.Core;
+        // VK_FORMAT_FEATURE_TRANSFER_SRC/DST_BIT came with 1.1 (and maintenance1): 1.0 devices don't report them
+        formatCapabilities.build(physicalDevice->vkHandle(), deviceFeatures, (applicationInfo.apiVersion >= VK_API_VERSION_1_1) ||
+            deviceExtensionEnabled(logicalDevice, VK_KHR_MAINTENANCE1_EXTENSION_NAME));
+
+        {
+            uint32_t queueFamilyCount = 0u;
+            vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice->vkHandle(), &queueFamilyCount, nullptr);
+            std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+            vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice->vkHandle(), &queueFamilyCount, queueFamilies.data());
+
+            auto supportsSparseBinding = [&queueFamilies](const uint32_t family_idx)
+            {
+                return (family_idx < queueFamilies.size()) && (queueFamilies[family_idx].queueFlags & VK_QUEUE_SPARSE_BINDING_BIT);
+            };
+
+            // Prefer the transfer queue, since we already submit to it from this thread
+            const auto& queueFamilyIndices = logicalDevice->QueueFamilyIndices();
+            if (queueFamilyIndices.Transfer < queueFamilies.size())
+            {
+                transferQueueFlags = queueFamilies[queueFamilyIndices.Transfer].queueFlags;
+                // Query pools have to be reset in a command buffer (without hostQueryReset), which transfer-only queues can't do
+                const uint32_t validBits = queueFamilies[queueFamilyIndices.Transfer].timestampValidBits;
+                if ((validBits != 0u) && (transferQueueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+                {
+                    timestampMask = validBits >= 64u ? std::numeric_limits<uint64_t>::max() : ((uint64_t{ 1u } << validBits) - 1u);
+                    timestampPeriod = physicalDevice->GetProperties().limits.timestampPeriod;
+                }
+            }
+            if (supportsSparseBinding(queueFamilyIndices.Transfer))
+            {
+                sparseBindingQueue = logicalDevice->TransferQueue();
+            }
+            else if (supportsSparseBinding(queueFamilyIndices.Graphics))
+            {
+                sparseBindingQueue = logicalDevice->GraphicsQueue();
+            }
+        }
+
+        // Descriptor indexing is core in 1.2. The heap's bindings are partially bound and updated after bind, so each of
+        // those has to be enabled on the device, not just supported
+        const bool bindlessEnabled = enabled_features.RuntimeDescriptorArray && enabled_features.DescriptorBindingPartiallyBound &&
+            enabled_features.DescriptorBindingSampledImageUpdateAfterBind && enabled_features.DescriptorBindingStorageBufferUpdateAfterBind;
+        if (bindlessEnabled && ((applicationInfo.apiVersion >= VK_API_VERSION_1_2) || ((applicationInfo.apiVersion >= VK_API_VERSION_1_1) &&
+            deviceExtensionEnabled(logicalDevice, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))))
+        {
+            bindlessHeap.create(logicalDevice->vkHandle(), DescriptorLimits(physicalDevice));
+        }
+
+        sparseResidencySupported = deviceFeatures.sparseBinding && (deviceFeatures.sparseResidencyImage2D || deviceFeatures.sparseResidencyImage3D) &&
+            (sparseBindingQueue != VK_NULL_HANDLE);
+
+        commandPoolInfo = VkCommandPoolCreateInfo
+        {
+            VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            nullptr,
+            VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+            logicalDevice->QueueFamilyIndices().Transfer
+        };
+
+        constexpr static VkFenceCreateInfo fenceInfo
+        {
+            VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+            nullptr,
+            0
+        };
+
+        constexpr static VkSemaphoreCreateInfo semaphoreInfo
+        {
+            VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            nullptr,
+            0
+        };
+
+        for (auto& frame : frames)
+        {
+            result = vkCreateCommandPool(logicalDevice->vkHandle(), &commandPoolInfo, nullptr, &frame.commandPool);
+            VkAssert(result);
+
+            const VkCommandBufferAllocateInfo allocInfo
+            {
+                VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                nullptr,
+                frame.commandPool,
+                VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                1u
+            };
+
+            result = vkAllocateCommandBuffers(logicalDevice->vkHandle(), &allocInfo, &frame.transferCmd);
+            VkAssert(result);
+            result = vkAllocateCommandBuffers(logicalDevice->vkHandle(), &allocInfo, &frame.uploadCmd);
+            VkAssert(result);
+            result = vkCreateFence(logicalDevice->vkHandle(), &fenceInfo, nullptr, &frame.fence);
+            VkAssert(result);
+            result = vkCreateFence(logicalDevice->vkHandle(), &fenceInfo, nullptr, &frame.sparseFence);
+            VkAssert(result);
+            result = vkCreateSemaphore(logicalDevice->vkHandle(), &semaphoreInfo, nullptr, &frame.sparseSemaphore);
+            VkAssert(result);
+        }
+
+        if (timestampMask != 0u)
+        {
+            const VkQueryPoolCreateInfo queryPoolInfo
+            {
+                VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                nullptr,
+                0,
+                VK_QUERY_TYPE_TIMESTAMP,
+                static_cast<uint32_t>(MaxFramesInFlight * 2u),
+                0
+            };
+
+            result = vkCreateQueryPool(logicalDevice->vkHandle(), &queryPoolInfo, nullptr, &uploadQueryPool);
+            VkAssert(result);
+        }
+
+        // Whoever is creating the resource decodes alongside the workers, so leave a core for them
+        decompressionPool.start(std::max(std::thread::hardware_concurrency(), 2u) - 1u);
+
+        beginFrame();
+    }
+
+    void ResourceContextImpl::destroy()
+    {
+        if (vmaAllocatorHandle == VK_NULL_HANDLE)
+        {
+            return;
+        }
+
+        // Queued creations still hold their reply's coroutine. What they create is freed along with everything else
+        ProcessMessages();
+
+        // Teardown is the one place we're allowed to stall: everything has to be idle before we free it
+        vkDeviceWaitIdle(logicalDevice->vkHandle());
+        decompressionPool.stop();
+
+        for (auto& frame : frames)
+        {
+            retireFrame(frame);
+            vkDestroyFence(logicalDevice->vkHandle(), frame.fence, nullptr);
+            vkDestroyFence(logicalDevice->vkHandle(), frame.sparseFence, nullptr);
+            vkDestroySemaphore(logicalDevice->vkHandle(), frame.sparseSemaphore, nullptr);
+            vkDestroyCommandPool(logicalDevice->vkHandle(), frame.commandPool, nullptr);
+            frame = FrameData{};
+        }
+
+        // Never recorded, so their staging can go straight back
+        std::vector<ScheduledUpload> unscheduled;
+        uploadScheduler.drain(unscheduled);
+        for (auto& upload : unscheduled)
+        {
+            for (const auto& staging : upload.staging)
+            {
+                stagingPool.release(staging, frameCounter);
+            }
+        }
+        stagingPool.destroy(vmaAllocatorHandle);
+
+        if (uploadQueryPool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(logicalDevice->vkHandle(), uploadQueryPool, nullptr);
+            uploadQueryPool = VK_NULL_HANDLE;
+        }
+
+        for (auto& [threadID, pools] : threadPools)
+        {
+            for (auto& pool : pools->pools)
+            {
+                vkDestroyCommandPool(logicalDevice->vkHandle(), pool, nullptr);
+            }
+        }
+        threadPools.clear();
+
+        // Views before the resources they view
+        for (auto& record : resourceRecords)
+        {
+            if (record.parentHandle != INVALID_GPU_RESOURCE_HANDLE)
+            {
+                destroyRecord(record);
+            }
+        }
+        for (auto& record : resourceRecords)
+        {
+            destroyRecord(record);
+        }
+        resourceRecords.clear();
+        freeRecordSlots.clear();
+        deviceAddresses.clear();
+        vulkanHandles.clear();
+        bindlessHeap.destroy(logicalDevice->vkHandle());
+
+        // Only safe once every sparse image has handed its pages back
+        sparsePagePool.destroy(vmaAllocatorHandle);
+        pendingPageRequests.clear();
+        pendingMipTailBinds.clear();
+
+        // Replies that outlive us get their state handed over, with no data left in it
+        {
+            std::lock_guard readbackLock(readbackMutex);
+            for (auto& readback : pendingReadbacks)
+            {
+                readback->complete.store(true, std::memory_order_release);
+                completedReadbacks.emplace_back(std::move(readback));
+            }
+            pendingReadbacks.clear();
+            pendingTransferWaits.clear();
+        }
+        for (auto& readback : completedReadbacks)
+        {
+            if (readback->buffer.buffer != VK_NULL_HANDLE)
+            {
+                vmaDestroyBuffer(vmaAllocatorHandle, readback->buffer.buffer, readback->buffer.allocation);
+                readback->buffer = ReadbackBuffer{};
+            }
+            if (!readback->released.exchange(true, std::memory_order_acq_rel))
+            {
+                readback.release();
+            }
+        }
+        completedReadbacks.clear();
+        readbackPool.destroy(vmaAllocatorHandle);
+
+        {
+            std::lock_guard traceBuffersLock(traceBuffersMutex);
+            creationTraceBuffer.store(nullptr, std::memory_order_release);
+            creationTraceBuffers.clear();
+        }
+
+        vmaDestroyAllocator(vmaAllocatorHandle);
+        vmaAllocatorHandle = VK_NULL_HANDLE;
+    }
+
+    void ResourceContextImpl::update()
+    {
+        // First, so transfers recorded below see the host's writes too
+        flushMappedRanges();
+        pollCreationTraces();
+        ProcessMessages();
+        processModifications();
+        processReadbacks();
+        // After both, so it knows which of the resources they touch can't wait. Its command buffer goes ahead of theirs
+        scheduleUploads();
+        enforceMemoryBudget();
+        processSparseBindings();
+        flushBindlessWrites();
+
+        // Waits for other threads to finish recording into this frame, and keeps them out until the next one has begun
+        std::unique_lock frameLock(frameMutex);
+        submitFrame();
+
+        {
+            std::lock_guard destructionLock(destructionMutex);
+            ++frameCounter;
+        }
+
+        // Lets VMA refresh the budget it fetched from the driver
+        vmaSetCurrentFrameIndex(vmaAllocatorHandle, static_cast<uint32_t>(frameCounter));
+        beginFrame();
+        frameLock.unlock();
+        sampleMemoryStats();
+        // Directories replaced as the handle table grew, once the threads reading them have moved on
+        vulkanHandles.reclaim();
+
+        // Last, so readbacks retired by beginFrame() are picked up this frame. Continuations are free to
+        // create more resources, so other threads have to be let back in first
+        resumeContinuations();
     }
 
     ResourceSystemReply ResourceContextImpl::createResource(ResourceCreationMessage message)
     {
+        using State = ResourceCreationEvent::State;
+        // Queued creations get here once ProcessMessages() resumes them
+        const ResourceCreationEvent::Promise& promise = co_await ResourceCreationEvent::PromiseAwaitable{};
+        CreationTrace trace;
+        const bool traced = creationTraceBuffer.load(std::memory_order_acquire) != nullptr;
+        if (traced)
+        {
+            trace.type = message.Type;
+            trace.timestamps[static_cast<size_t>(State::Queued)] = promise.queuedTimestamp;
+            trace.mark(State::Queued);
+        }
+
+        // Off the work queue thread (pool workers resuming queued creations, or deferred ones we couldn't copy)
+        // uploads go into that thread's own command buffer, so the frame can't be submitted under it. The work
+        // queue thread is the one that submits frames, so it doesn't need to keep itself out
+        std::shared_lock frameLock(frameMutex, std::defer_lock);
+        if (std::this_thread::get_id() != workQueueThreadID)
+        {
+            frameLock.lock();
+        }
+
+        if (traced)
+        {
+            trace.mark(State::Dequeued);
+            activeCreationTrace = &trace;
+        }
+
+        DeferredUploads deferred;
+        if (uploadScheduler.enabled())
+        {
+            activeDeferredUploads = &deferred;
+        }
+
+        const GpuResourceHandle handle = createResourceImmediate(message);
+        activeCreationTrace = nullptr;
+        activeDeferredUploads = nullptr;
+
+        const bool uploadsScheduled = (handle != INVALID_GPU_RESOURCE_HANDLE) && !deferred.uploads.empty();
+        if (uploadsScheduled)
+        {
+            // They go in order, so the staging lives until every copy reading from it has been recorded
+            deferred.uploads.back().staging.swap(deferred.staging);
+            const uint64_t deadlineFrame = message.UploadDeadline != 0u ? frameCounter + message.UploadDeadline - 1u : std::numeric_limits<uint64_t>::max();
+            for (auto& upload : deferred.uploads)
+            {
+                upload.handle = handle;
+                upload.priority = message.UploadPriority;
+                upload.deadlineFrame = deadlineFrame;
+            }
+
+            // Finished once it's been recorded and retired, like any other
+            deferred.uploads.back().trace = trace;
+            deferred.uploads.back().traced = traced;
+
+            uploadScheduler.push(frameCounter, deferred.uploads);
+        }
+        releaseStaging(deferred.staging);
+
+        // Failures would only skew the numbers
+        if (traced && !uploadsScheduled && (handle != INVALID_GPU_RESOURCE_HANDLE))
+        {
+            finishCreationTrace(trace);
+        }
+
+        co_return handle;
+    }
+
+    GpuResourceHandle ResourceContextImpl::importResource(const ImportedResourceDesc& desc)
+    {
+        if ((desc.Handle == 0u) || (desc.Info == nullptr) || ((desc.Type != GpuResourceType::Buffer) && (desc.Type != GpuResourceType::Image)))
+        {
+            return INVALID_GPU_RESOURCE_HANDLE;
+        }
+
+        ResourceRecord record;
+        record.type = desc.Type;
+        record.memoryDomain = GpuResourceMemoryDomain::Device;
+        record.residency = GpuResourceResidency::Resident;
+        // Nothing else means anything for memory we didn't allocate
+        record.flags = desc.Flags & CreationFlagBits::ResourceCreateUserDataAsString;
+        record.vkHandle = desc.Handle;
+        record.allocation = reinterpret_cast<VmaAllocation>(desc.Allocation);
+        record.imported = true;
+        record.ownsHandle = desc.TakeOwnership;
+
+        if (record.allocation != VK_NULL_HANDLE)
+        {
+            VkMemoryPropertyFlags memoryFlags = 0u;
+            vmaGetAllocationMemoryProperties(vmaAllocatorHandle, record.allocation, &memoryFlags);
+            if (!(memoryFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+            {
+                record.memoryDomain = (memoryFlags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT) ? GpuResourceMemoryDomain::HostCached : GpuResourceMemoryDomain::Host;
+            }
+        }
+
+        VkObjectType objectType = VK_OBJECT_TYPE_IMAGE;
+        if (desc.Type == GpuResourceType::Buffer)
+        {
+            objectType = VK_OBJECT_TYPE_BUFFER;
+            record.bufferInfo = *reinterpret_cast<const VkBufferCreateInfo*>(desc.Info);
+            record.bufferInfo.pNext = nullptr;
+            keepQueueFamilies(record.bufferInfo, record.queueFamilies);
+            record.size = record.bufferInfo.size;
+            if ((record.bufferInfo.usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) && bufferDeviceAddressSupported)
+            {
+                record.deviceAddress = bufferDeviceAddress((VkBuffer)record.vkHandle);
+            }
+            if (record.bufferInfo.usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+            {
+                record.bindlessIndex = registerBindless(BindlessStorageBufferBinding, record.vkHandle);
+            }
+        }
+        else
+        {
+            record.imageInfo = *reinterpret_cast<const VkImageCreateInfo*>(desc.Info);
+            record.imageInfo.pNext = nullptr;
+            keepQueueFamilies(record.imageInfo, record.queueFamilies);
+            // Whatever last used it is assumed to be finished with it
+            record.layouts.reset(SubresourceState{ static_cast<VkImageLayout>(desc.CurrentLayout), VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE });
+            VkMemoryRequirements requirements{};
+            vkGetImageMemoryRequirements(logicalDevice->vkHandle(), (VkImage)record.vkHandle, &requirements);
+            record.size = requirements.size;
+        }
+
+        if ((desc.Flags & CreationFlagBits::ResourceCreateUserDataAsString) && (desc.UserData != nullptr))
+        {
+            nameRecord(record, objectType, reinterpret_cast<const char*>(desc.UserData));
+        }
 
-        return ResourceSystemReply();
+        return allocateRecord(std::move(record));
+    }
+
+    void ResourceContextImpl::destroyResource(GpuResourceHandle handle)
+    {
+        ResourceRecord record;
+
+        // Shared samplers and views stay alive until their last user lets go
+        std::unique_lock samplerLock(samplerMutex);
+        if (!samplerCache.release(handle))
+        {
+            return;
+        }
+
+        std::unique_lock viewLock(viewMutex);
+        if (!viewCache.release(handle))
+        {
+            return;
+        }
+
+        // Views go first, so they're destroyed before what they view
+        std::vector<ResourceRecord> records;
+        {
+            std::unique_lock recordLock(recordMutex);
+            auto takeRecord = [this, &records](GpuResourceHandle record_handle)
+            {
+                ResourceRecord* found = lookupRecord(record_handle);
+                if (found == nullptr)
+                {
+                    return;
+                }
+
+                if (found->deviceAddress != 0u)
+                {
+                    deviceAddresses.retract(record_handle);
+                }
+                vulkanHandles.retract(record_handle);
+
+                records.emplace_back(*found);
+                *found = ResourceRecord{};
+                found->generation = records.back().generation + 1u;
+                freeRecordSlots.emplace_back(HandleSlot(record_handle));
+            };
+
+            for (const auto& view : viewCache.releaseParent(handle))
+            {
+                takeRecord(view);
+            }
+            takeRecord(handle);
+
+            if (!records.empty() && (records.back().parentHandle != INVALID_GPU_RESOURCE_HANDLE))
+            {
+                ResourceRecord* parent = lookupRecord(records.back().parentHandle);
+                if ((parent != nullptr) && (parent->viewCount != 0u))
+                {
+                    --parent->viewCount;
+                }
+            }
+        }
+        viewLock.unlock();
+        samplerLock.unlock();
+
+        // Previous frames may still be using these, so they're not destroyed until our frame slot comes back around
+        std::lock_guard destructionLock(destructionMutex);
+        for (auto& record : records)
+        {
+            currentFrame().pendingDestruction.emplace_back(std::move(record));
+        }
+    }
+
+    void ResourceContextImpl::modifyResource(const ResourceModificationMessage& message)
+    {
+        GpuResourceType destinationType = GpuResourceType::Invalid;
+        VkDeviceSize destinationSize = 0u;
+        VkImageCreateInfo destinationInfo{};
+        {
+            std::shared_lock recordLock(recordMutex);
+            const ResourceRecord* record = lookupRecord(message.DestinationHandle);
+            if (record == nullptr)
+            {
+                return;
+            }
+            destinationType = record->type;
+            destinationSize = record->size;
+            destinationInfo = record->imageInfo;
+        }
+
+        // Same checks as initial data gets. A bad region drops the whole message, rather than leaving the image half written
+        if ((message.Type == ResourceModificationOpType::SetContents) && (destinationType == GpuResourceType::Image))
+        {
+            for (uint32_t i = 0u; i < message.ResourceData.imageData.numData; ++i)
+            {
+                const GpuImageResourceData& region = message.ResourceData.imageData.data[i];
+                if (!validUploadRegion(destinationInfo, region, region.Size))
+                {
+                    return;
+                }
+            }
+        }
+        else if ((message.Type == ResourceModificationOpType::SetContents) && (destinationType == GpuResourceType::Buffer) &&
+            !validBufferWrite(destinationSize, message.DestinationOffset, message.ResourceData.bufferData.data, message.ResourceData.bufferData.numData))
+        {
+            return;
+        }
+
+        // Fills are in whole words: clearing to the end rounds down, as VK_WHOLE_SIZE would
+        VkDeviceSize clearSize = message.ClearSize;
+        if ((message.Type == ResourceModificationOpType::ClearContents) && (destinationType == GpuResourceType::Buffer))
+        {
+            if ((clearSize == 0u) && (message.DestinationOffset < destinationSize))
+            {
+                clearSize = (destinationSize - message.DestinationOffset) & ~VkDeviceSize(3u);
+            }
+            if (!validBufferFill(destinationSize, message.DestinationOffset, clearSize))
+            {
+                return;
+            }
+        }
+
+        std::lock_guard modificationLock(modificationMutex);
+        switch (message.Type)
+        {
+        case ResourceModificationOpType::SetContents:
+            if (destinationType == GpuResourceType::Buffer)
+            {
+                BufferModificationBatch& batch = pendingBufferModifications[message.DestinationHandle];
+                VkDeviceSize offset = message.DestinationOffset;
+                for (uint32_t i = 0u; i < message.ResourceData.bufferData.numData; ++i)
+                {
+                    const GpuResourceData& data = message.ResourceData.bufferData.data[i];
+                    offset = alignUp(offset, data.Alignment);
+                    batch.write(offset, data.Data, data.Size);
+                    offset += data.Size;
+                }
+            }
+            else if (destinationType == GpuResourceType::Image)
+            {
+                ImageModificationBatch& batch = pendingImageModifications[message.DestinationHandle];
+                for (uint32_t i = 0u; i < message.ResourceData.imageData.numData; ++i)
+                {
+                    batch.write(message.ResourceData.imageData.data[i]);
+                }
+            }
+            break;
+        case ResourceModificationOpType::ClearContents:
+            if (destinationType == GpuResourceType::Buffer)
+            {
+                pendingBufferModifications[message.DestinationHandle].fill(message.DestinationOffset, clearSize, message.ClearValue);
+            }
+            else if (destinationType == GpuResourceType::Image)
+            {
+                pendingImageModifications[message.DestinationHandle].clear(message.ClearColor);
+            }
+            break;
+        case ResourceModificationOpType::CreateCopy:
+            pendingCopies.emplace_back(message.SourceHandle, message.DestinationHandle);
+            break;
+        default:
+            break;
+        }
+    }
+
+    ResourceReadbackReply ResourceContextImpl::readbackResource(GpuResourceHandle handle, uint64_t offset, uint64_t size)
+    {
+        auto state = std::make_unique<ReadbackState>();
+        state->handle = handle;
+        state->offset = offset;
+        state->size = size;
+        ResourceReadbackReply reply(this, state.get());
+
+        {
+            // Only buffers can be read back: anything else fails straight away, instead of once the batch is processed
+            std::shared_lock recordLock(recordMutex);
+            const ResourceRecord* record = lookupRecord(handle);
+            if ((record == nullptr) || (record->type != GpuResourceType::Buffer))
+            {
+                state->complete.store(true, std::memory_order_release);
+            }
+        }
+
+        std::lock_guard readbackLock(readbackMutex);
+        pendingReadbacks.emplace_back(std::move(state));
+        return reply;
+    }
+
+    void ResourceContextImpl::addTransferWaitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags wait_stages)
+    {
+        std::lock_guard readbackLock(readbackMutex);
+        pendingTransferWaits.emplace_back(semaphore, wait_stages);
+    }
+
+    void ResourceContextImpl::setUploadBudget(const UploadBudget& budget)
+    {
+        uploadScheduler.setBudget(budget);
+    }
+
+    UploadSchedulerStats ResourceContextImpl::uploadSchedulerStats() const
+    {
+        return uploadScheduler.stats();
+    }
+
+    void ResourceContextImpl::setStagingPoolIdleFrames(uint32_t frames)
+    {
+        stagingPool.setIdleFrames(frames);
+    }
+
+    StagingPoolStats ResourceContextImpl::stagingPoolStats() const
+    {
+        return stagingPool.stats();
+    }
+
+    void ResourceContextImpl::registerDecompressionCodec(GpuCompressionCodec codec, DecompressionFn fn, void* user_data)
+    {
+        // Uncompressed data is copied without asking anyone
+        if (codec == CompressionCodecs::Uncompressed)
+        {
+            return;
+        }
+
+        std::unique_lock codecLock(codecMutex);
+        if (fn == nullptr)
+        {
+            decompressionCodecs.erase(codec);
+        }
+        else
+        {
+            decompressionCodecs[codec] = DecompressionCodec{ fn, user_data };
+        }
+    }
+
+    DecompressionStats ResourceContextImpl::decompressionStats() const
+    {
+        DecompressionStats result;
+        result.CompressedBytes = decompressionInputBytes.load(std::memory_order_relaxed);
+        result.DecompressedBytes = decompressedBytes.load(std::memory_order_relaxed);
+        result.Entries = decompressedEntries.load(std::memory_order_relaxed);
+        result.Failures = decompressionFailures.load(std::memory_order_relaxed);
+        result.Seconds = static_cast<double>(decompressionNanoseconds.load(std::memory_order_relaxed)) / 1.0e9;
+        result.GigabytesPerSecond = result.Seconds > 0.0 ? (static_cast<double>(result.DecompressedBytes) / 1.0e9) / result.Seconds : 0.0;
+        result.WorkerThreads = decompressionPool.workerCount();
+        return result;
+    }
+
+    SamplerCacheStats ResourceContextImpl::samplerCacheStats() const
+    {
+        std::lock_guard samplerLock(samplerMutex);
+        return samplerCache.stats();
+    }
+
+    ViewCacheStats ResourceContextImpl::viewCacheStats() const
+    {
+        std::lock_guard viewLock(viewMutex);
+        return viewCache.stats();
+    }
+
+    CoroutineFrameStats ResourceContextImpl::coroutineFrameStats() const noexcept
+    {
+        return coroutineFramePool.stats();
+    }
+
+    void ResourceContextImpl::writeMemoryStatsFile(const char* output_file) const
+    {
+        VmaTotalStatistics totalStats{};
+        vmaCalculateStatistics(vmaAllocatorHandle, &totalStats);
+        std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> heapBudgets{};
+        vmaGetHeapBudgets(vmaAllocatorHandle, heapBudgets.data());
+
+        nlohmann::json stats;
+        stats["total"] = detailedStatsJson(totalStats.total);
+
+        nlohmann::json& heaps = stats["heaps"] = nlohmann::json::array();
+        for (uint32_t i = 0u; i < memoryProperties.memoryHeapCount; ++i)
+        {
+            nlohmann::json heap = detailedStatsJson(totalStats.memoryHeap[i]);
+            heap["index"] = i;
+            heap["flags"] = memoryProperties.memoryHeaps[i].flags;
+            heap["size"] = memoryProperties.memoryHeaps[i].size;
+            heap["usage"] = heapBudgets[i].usage;
+            heap["budget"] = heapBudgets[i].budget;
+            heaps.emplace_back(std::move(heap));
+        }
+
+        nlohmann::json& memoryTypes = stats["memoryTypes"] = nlohmann::json::array();
+        for (uint32_t i = 0u; i < memoryProperties.memoryTypeCount; ++i)
+        {
+            if (totalStats.memoryType[i].statistics.blockCount == 0u)
+            {
+                continue;
+            }
+
+            nlohmann::json memoryType = detailedStatsJson(totalStats.memoryType[i]);
+            memoryType["index"] = i;
+            memoryType["heapIndex"] = memoryProperties.memoryTypes[i].heapIndex;
+            memoryType["propertyFlags"] = memoryProperties.memoryTypes[i].propertyFlags;
+            memoryTypes.emplace_back(std::move(memoryType));
+        }
+
+        nlohmann::json& domains = stats["domains"] = nlohmann::json::object();
+        nlohmann::json& creationFlags = stats["creationFlags"] = nlohmann::json::object();
+        nlohmann::json& resources = stats["resources"] = nlohmann::json::array();
+        {
+            std::shared_lock recordLock(recordMutex);
+            for (uint32_t slot = 0u; slot < static_cast<uint32_t>(resourceRecords.size()); ++slot)
+            {
+                const ResourceRecord& record = resourceRecords[slot];
+                if (record.type == GpuResourceType::Invalid)
+                {
+                    continue;
+                }
+
+                nlohmann::json resource
+                {
+                    { "handle", MakeHandle(slot, record.generation) },
+                    { "name", record.debugName },
+                    { "type", resourceTypeName(record.type) },
+                    { "residency", residencyName(record.residency) },
+                    { "flags", record.flags }
+                };
+
+                if (record.parentHandle != INVALID_GPU_RESOURCE_HANDLE)
+                {
+                    resource["parent"] = record.parentHandle;
+                }
+
+                if (record.imported)
+                {
+                    resource["imported"] = true;
+                    resource["owned"] = record.ownsHandle;
+                }
+
+                if (record.transientGroup != std::numeric_limits<uint32_t>::max())
+                {
+                    // Bound into memory shared with the rest of its group, so it's only counted there
+                    resource["transientGroup"] = record.transientGroup;
+                    resource["size"] = record.size;
+                }
+                else if (record.allocation != VK_NULL_HANDLE)
+                {
+                    VmaAllocationInfo allocInfo{};
+                    vmaGetAllocationInfo(vmaAllocatorHandle, record.allocation, &allocInfo);
+                    resource["domain"] = memoryDomainName(record.memoryDomain);
+                    resource["size"] = allocInfo.size;
+                    resource["memoryType"] = allocInfo.memoryType;
+                    resource["offset"] = allocInfo.offset;
+
+                    addToBreakdown(domains[memoryDomainName(record.memoryDomain)], record.debugName, allocInfo.size);
+                    for (const auto& flagName : CreationFlagNames)
+                    {
+                        if (record.flags & flagName.flag)
+                        {
+                            addToBreakdown(creationFlags[flagName.name], record.debugName, allocInfo.size);
+                        }
+                    }
+                }
+                else if (record.imported)
+                {
+                    // Memory we know nothing about, beyond what it needs
+                    resource["size"] = record.size;
+                }
+
+                resources.emplace_back(std::move(resource));
+            }
+        }
+
+        // VMA's own dump, which lists every block and allocation (including staging and pooled memory we don't track as resources)
+        char* vmaStatsString = nullptr;
+        vmaBuildStatsString(vmaAllocatorHandle, &vmaStatsString, VK_TRUE);
+        stats["vma"] = nlohmann::json::parse(vmaStatsString);
+        vmaFreeStatsString(vmaAllocatorHandle, vmaStatsString);
+
+        std::ofstream output(output_file, std::ios::trunc);
+        if (!output.is_open())
+        {
+            throw std::runtime_error("Couldn't open memory stats output file.");
+        }
+        output << stats.dump(4);
+    }
+
+    void ResourceContextImpl::enableMemoryStatsSnapshots(uint32_t frame_interval, uint32_t capacity)
+    {
+        std::lock_guard snapshotLock(snapshotMutex);
+        snapshotRing.reset(frame_interval, capacity);
+    }
+
+    void ResourceContextImpl::memoryStatsSnapshots(uint32_t* num_samples, MemoryStatsSample* samples) const
+    {
+        std::lock_guard snapshotLock(snapshotMutex);
+        if (samples == nullptr)
+        {
+            *num_samples = snapshotRing.size();
+            return;
+        }
+
+        *num_samples = snapshotRing.copySamples(*num_samples, samples);
+    }
+
+    void ResourceContextImpl::writeMemoryStatsSnapshots(const char* output_file) const
+    {
+        std::lock_guard snapshotLock(snapshotMutex);
+        snapshotRing.writeFile(output_file);
+    }
+
+    void ResourceContextImpl::enableCreationTracing(uint32_t capacity)
+    {
+        std::lock_guard traceBuffersLock(traceBuffersMutex);
+        CreationTraceBuffer* traceBuffer = nullptr;
+        if (capacity != 0u)
+        {
+            traceBuffer = creationTraceBuffers.emplace_back(std::make_unique<CreationTraceBuffer>(capacity)).get();
+        }
+        creationTraceBuffer.store(traceBuffer, std::memory_order_release);
+    }
+
+    void ResourceContextImpl::creationLatencies(uint32_t* num_latencies, ResourceCreationLatency* latencies) const
+    {
+        std::vector<ResourceCreationLatency> computed;
+        const CreationTraceBuffer* traceBuffer = creationTraceBuffer.load(std::memory_order_acquire);
+        if (traceBuffer != nullptr)
+        {
+            std::vector<CreationTrace> traces;
+            traceBuffer->copyTraces(traces);
+            ComputeCreationLatencies(traces, computed);
+        }
+
+        if (latencies == nullptr)
+        {
+            *num_latencies = static_cast<uint32_t>(computed.size());
+            return;
+        }
+
+        *num_latencies = std::min(*num_latencies, static_cast<uint32_t>(computed.size()));
+        std::copy_n(computed.begin(), *num_latencies, latencies);
+    }
+
+    void ResourceContextImpl::writeCreationLatencyFile(const char* output_file) const
+    {
+        constexpr static const char* StageNames[ResourceCreationStageCount] =
+        {
+            "queueing", "allocation", "staging", "recording", "submitWait", "gpu", "retirement", "total"
+        };
+        constexpr static const char* SizeClassNames[CreationSizeClassCount] = { "<64KiB", "<1MiB", "<16MiB", ">=16MiB" };
+
+        std::vector<ResourceCreationLatency> latencies;
+        uint64_t droppedTraces = 0u;
+        const CreationTraceBuffer* traceBuffer = creationTraceBuffer.load(std::memory_order_acquire);
+        if (traceBuffer != nullptr)
+        {
+            std::vector<CreationTrace> traces;
+            traceBuffer->copyTraces(traces);
+            ComputeCreationLatencies(traces, latencies);
+            droppedTraces = traceBuffer->droppedTraces();
+        }
+
+        nlohmann::json report;
+        report["droppedTraces"] = droppedTraces;
+        nlohmann::json& groups = report["groups"] = nlohmann::json::array();
+        for (const auto& latency : latencies)
+        {
+            nlohmann::json group
+            {
+                { "type", resourceTypeName(latency.Type) },
+                { "sizeClass", SizeClassNames[latency.SizeClass] },
+                { "samples", latency.NumSamples }
+            };
+
+            // Microseconds, as in ResourceCreationLatency
+            for (uint32_t stage = 0u; stage < ResourceCreationStageCount; ++stage)
+            {
+                group["stages"][StageNames[stage]] = nlohmann::json
+                {
+                    { "p50", latency.P50[stage] },
+                    { "p90", latency.P90[stage] },
+                    { "p99", latency.P99[stage] },
+                    { "max", latency.Max[stage] }
+                };
+            }
+
+            groups.emplace_back(std::move(group));
+        }
+
+        std::ofstream output(output_file, std::ios::trunc);
+        if (!output.is_open())
+        {
+            throw std::runtime_error("Couldn't open creation latency output file.");
+        }
+        output << report.dump(4);
+    }
+
+    void ResourceContextImpl::finishCreationTrace(CreationTrace& trace)
+    {
+        if (trace.reached(ResourceCreationEvent::State::Recorded))
+        {
+            // Either frameMutex is held or this is the work queue thread, so the frame can't move on under us
+            std::lock_guard destructionLock(destructionMutex);
+            currentFrame().creationTraces.emplace_back(trace);
+            return;
+        }
+
+        CreationTraceBuffer* traceBuffer = creationTraceBuffer.load(std::memory_order_acquire);
+        if (traceBuffer != nullptr)
+        {
+            traceBuffer->push(trace);
+        }
+    }
+
+    void ResourceContextImpl::pollCreationTraces()
+    {
+        std::lock_guard destructionLock(destructionMutex);
+        for (auto& frame : frames)
+        {
+            if (!frame.submitted || frame.tracesGpuComplete || frame.creationTraces.empty())
+            {
+                continue;
+            }
+
+            // Doesn't wait: if it's not done now, the next update() will look again
+            if (vkGetFenceStatus(logicalDevice->vkHandle(), frame.fence) == VK_SUCCESS)
+            {
+                for (auto& trace : frame.creationTraces)
+                {
+                    trace.mark(ResourceCreationEvent::State::GpuComplete);
+                }
+                frame.tracesGpuComplete = true;
+            }
+        }
+    }
+
+    void ResourceContextImpl::ProcessMessages()
+    {
+        // Creations record into per-thread command buffers, so they're resumed across the pool rather than one
+        // after another here. Ones queued while these run are left for the next frame
+        std::vector<ResourceCreationEvent::CoroutineHandle> handles;
+        ResourceCreationEvent::CoroutineHandle handle;
+        while (eventQueue.try_pop(handle))
+        {
+            handles.emplace_back(handle);
+        }
+
+        decompressionPool.parallelFor(static_cast<uint32_t>(handles.size()), [&handles](uint32_t i)
+        {
+            handles[i].resume();
+        });
+    }
+
+    void ResourceContextImpl::queryMemoryBudget(uint32_t* num_heaps, GpuMemoryHeapBudget* budgets) const
+    {
+        if (budgets == nullptr)
+        {
+            *num_heaps = memoryProperties.memoryHeapCount;
+            return;
+        }
+
+        std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> heapBudgets{};
+        vmaGetHeapBudgets(vmaAllocatorHandle, heapBudgets.data());
+
+        const uint32_t count = std::min(*num_heaps, memoryProperties.memoryHeapCount);
+        for (uint32_t i = 0u; i < count; ++i)
+        {
+            budgets[i].BlockBytes = heapBudgets[i].statistics.blockBytes;
+            budgets[i].AllocationBytes = heapBudgets[i].statistics.allocationBytes;
+            budgets[i].Usage = heapBudgets[i].usage;
+            budgets[i].Budget = heapBudgets[i].budget;
+            budgets[i].HeapFlags = memoryProperties.memoryHeaps[i].flags;
+        }
+        *num_heaps = count;
+    }
+
+    void ResourceContextImpl::setMemoryBudgetPolicy(const MemoryBudgetPolicy& policy)
+    {
+        std::lock_guard policyLock(budgetPolicyMutex);
+        budgetPolicy = policy;
+    }
+
+    GpuResourceResidency ResourceContextImpl::resourceResidency(GpuResourceHandle handle) const
+    {
+        std::shared_lock recordLock(recordMutex);
+        const ResourceRecord* found = lookupRecord(handle);
+        return found != nullptr ? found->residency : GpuResourceResidency::Invalid;
+    }
+
+    uint64_t ResourceContextImpl::deviceAddress(GpuResourceHandle handle) const noexcept
+    {
+        return deviceAddresses.find(handle);
+    }
+
+    uint64_t ResourceContextImpl::vulkanHandle(GpuResourceHandle handle) const noexcept
+    {
+        return vulkanHandles.find(handle);
+    }
+
+    void* ResourceContextImpl::mappedPointer(GpuResourceHandle handle) const
+    {
+        std::shared_lock recordLock(recordMutex);
+        const ResourceRecord* found = lookupRecord(handle);
+        return found != nullptr ? found->mappedData : nullptr;
+    }
+
+    void ResourceContextImpl::markMappedRangeDirty(GpuResourceHandle handle, VkDeviceSize offset, VkDeviceSize size)
+    {
+        // Resolved and filtered when flushed, so marking costs no more than a push
+        std::lock_guard dirtyRangeLock(dirtyRangeMutex);
+        dirtyRanges.emplace_back(DirtyMappedRange{ handle, VK_NULL_HANDLE, offset, size });
+    }
+
+    VkDescriptorSetLayout ResourceContextImpl::bindlessSetLayout() const noexcept
+    {
+        return bindlessHeap.setLayout;
+    }
+
+    VkDescriptorSet ResourceContextImpl::bindlessSet() const noexcept
+    {
+        return bindlessHeap.set;
+    }
+
+    uint32_t ResourceContextImpl::bindlessIndex(GpuResourceHandle handle) const
+    {
+        std::shared_lock recordLock(recordMutex);
+        const ResourceRecord* found = lookupRecord(handle);
+        return found != nullptr ? found->bindlessIndex : BindlessIndexInvalid;
+    }
+
+    bool ResourceContextImpl::withinNeverAllocateBudget(const ResourceCreationMessage& message) const
+    {
+        if (!(message.Flags & CreationFlagBits::ResourceCreateNeverAllocate) || (message.Info == nullptr))
+        {
+            return true;
+        }
+
+        const VmaAllocationCreateInfo allocCreateInfo = allocationCreateInfo(message.MemoryDomain, message.Flags);
+        uint32_t memoryTypeIdx = 0u;
+        VkDeviceSize requestedSize = 0u;
+        VkResult result = VK_SUCCESS;
+
+        if (message.Type == GpuResourceType::Buffer)
+        {
+            const VkBufferCreateInfo* bufferInfo = reinterpret_cast<const VkBufferCreateInfo*>(message.Info);
+            requestedSize = bufferInfo->size;
+            result = vmaFindMemoryTypeIndexForBufferInfo(vmaAllocatorHandle, bufferInfo, &allocCreateInfo, &memoryTypeIdx);
+        }
+        else if (message.Type == GpuResourceType::Image)
+        {
+            const VkImageCreateInfo* imageInfo = reinterpret_cast<const VkImageCreateInfo*>(message.Info);
+            result = vmaFindMemoryTypeIndexForImageInfo(vmaAllocatorHandle, imageInfo, &allocCreateInfo, &memoryTypeIdx);
+        }
+        else
+        {
+            return true;
+        }
+
+        if (result != VK_SUCCESS)
+        {
+            return false;
+        }
+
+        const uint32_t heapIdx = memoryProperties.memoryTypes[memoryTypeIdx].heapIndex;
+        std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> heapBudgets{};
+        vmaGetHeapBudgets(vmaAllocatorHandle, heapBudgets.data());
+
+        const MemoryBudgetPolicy policy = currentBudgetPolicy();
+        const double limit = static_cast<double>(heapBudgets[heapIdx].budget) * static_cast<double>(policy.NeverAllocateThreshold);
+        return static_cast<double>(heapBudgets[heapIdx].usage + requestedSize) < limit;
+    }
+
+    GpuResourceHandle ResourceContextImpl::createResourceImmediate(const ResourceCreationMessage& message)
+    {
+        if (!withinNeverAllocateBudget(message))
+        {
+            return INVALID_GPU_RESOURCE_HANDLE;
+        }
+
+        switch (message.Type)
+        {
+        case GpuResourceType::Buffer:
+            return createBuffer(message);
+        case GpuResourceType::Image:
+            return createImage(message);
+        case GpuResourceType::Sampler:
+            return createSampler(message);
+        case GpuResourceType::ImageView:
+        case GpuResourceType::BufferView:
+            return createView(message);
+        case GpuResourceType::SparseImage:
+            return createSparseImage(message);
+        default:
+            // Combined image samplers aren't supported by the creation path yet
+            return INVALID_GPU_RESOURCE_HANDLE;
+        }
+    }
+
+    GpuResourceHandle ResourceContextImpl::createBuffer(const ResourceCreationMessage& message)
+    {
+        // Staged uploads, modifications, copies and demotion all need these: for buffers they cost nothing
+        VkBufferCreateInfo createInfo = *reinterpret_cast<const VkBufferCreateInfo*>(message.Info);
+        createInfo.usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+        const bool needsDeviceAddress = (message.Flags & CreationFlagBits::ResourceCreateDeviceAddress) != 0u;
+        if (needsDeviceAddress)
+        {
+            if (!bufferDeviceAddressSupported)
+            {
+                return INVALID_GPU_RESOURCE_HANDLE;
+            }
+            createInfo.usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+        }
+
+        uint32_t numData = message.ResourceData.bufferData.numData;
+        const GpuResourceData* initialData = message.ResourceData.bufferData.data;
+
+        // Opened before anything is created, so a bad path fails the creation cleanly
+        MappedFile sourceFile;
+        GpuResourceData fileData{};
+        if (message.FileSource != nullptr)
+        {
+            if (!sourceFile.open(message.FileSource->Path, message.FileSource->Offset, message.FileSource->Size))
+            {
+                return INVALID_GPU_RESOURCE_HANDLE;
+            }
+            fileData.Data = sourceFile.data();
+            fileData.Size = static_cast<size_t>(sourceFile.size());
+            numData = 1u;
+            initialData = &fileData;
+        }
+
+        const bool hasInitialData = (numData != 0u) && (initialData != nullptr);
+        if (hasInitialData && !validBufferWrite(createInfo.size, 0u, initialData, numData))
+        {
+            return INVALID_GPU_RESOURCE_HANDLE;
+        }
+
+        // Decoded up front as well, so a corrupt stream, unregistered codec or data too big for the buffer fails cleanly
+        const bool hasCompressedData = (message.NumCompressedData != 0u) && (message.CompressedData != nullptr);
+        DecompressedUpload compressedUpload;
+        if (hasCompressedData && ((message.FileSource != nullptr) || !validBufferWrite(createInfo.size, message.CompressedData, message.NumCompressedData) ||
+            !decompressToStaging(message.NumCompressedData, message.CompressedData, 1u, compressedUpload)))
+        {
+            return INVALID_GPU_RESOURCE_HANDLE;
+        }
+
+        const VmaAllocationCreateInfo allocCreateInfo = allocationCreateInfo(message.MemoryDomain, message.Flags);
+        VkBuffer buffer{ VK_NULL_HANDLE };
+        VmaAllocation allocation{ VK_NULL_HANDLE };
+        VkResult result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+
+        if (hasInitialData && directWriteEligible(message.MemoryDomain))
+        {
+            VmaAllocationCreateInfo directCreateInfo = allocCreateInfo;
+            directCreateInfo.requiredFlags |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+            directCreateInfo.memoryTypeBits = directWriteMemoryTypeBits;
+            result = vmaCreateBuffer(vmaAllocatorHandle, &createInfo, &directCreateInfo, &buffer, &allocation, nullptr);
+        }
+
+        if (result != VK_SUCCESS)
+        {
+            if ((hasInitialData || hasCompressedData) && (message.MemoryDomain == GpuResourceMemoryDomain::Device))
+            {
+                shareWithTransferQueue(createInfo.sharingMode, createInfo.queueFamilyIndexCount, createInfo.pQueueFamilyIndices);
+            }
+            result = vmaCreateBuffer(vmaAllocatorHandle, &createInfo, &allocCreateInfo, &buffer, &allocation, nullptr);
+        }
+
+        if (outOfMemory(result))
+        {
+            // Expected with ResourceCreateNeverAllocate, when VMA refuses to allocate a new block or go over budget
+            return INVALID_GPU_RESOURCE_HANDLE;
+        }
+        VkAssert(result);
+        markCreationState(ResourceCreationEvent::State::Allocated);
+
+        ResourceRecord record;
+        record.type = GpuResourceType::Buffer;
+        record.memoryDomain = message.MemoryDomain;
+        record.residency = GpuResourceResidency::Resident;
+        record.flags = message.Flags;
+        record.vkHandle = (uint64_t)buffer;
+        record.allocation = allocation;
+        record.size = createInfo.size;
+        record.deviceAddress = needsDeviceAddress ? bufferDeviceAddress(buffer) : 0u;
+        setPersistentMapping(record);
+        if (createInfo.usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+        {
+            record.bindlessIndex = registerBindless(BindlessStorageBufferBinding, record.vkHandle);
+        }
+        record.bufferInfo = createInfo;
+        record.bufferInfo.pNext = nullptr;
+        keepQueueFamilies(record.bufferInfo, record.queueFamilies);
+
+        if ((message.Flags & CreationFlagBits::ResourceCreateUserDataAsString) && (message.UserData != nullptr))
+        {
+            nameRecord(record, VK_OBJECT_TYPE_BUFFER, reinterpret_cast<const char*>(message.UserData));
+        }
+
+        if (hasCompressedData)
+        {
+            // Entries are already laid out in staging as they are in the buffer
+            const VkBufferCopy copyRegion{ compressedUpload.staging.offset, 0u, compressedUpload.totalSize };
+            if (!deferUpload(record, compressedUpload.staging.buffer, compressedUpload.totalSize, { copyRegion }, {}))
+            {
+                vkCmdCopyBuffer(transferCommandBuffer(), compressedUpload.staging.buffer, buffer, 1u, &copyRegion);
+                markCreationState(ResourceCreationEvent::State::Recorded);
+            }
+        }
+        else if (hasInitialData && ((message.FileSource == nullptr) || !uploadBufferFromFile(record, sourceFile)) &&
+            !uploadBufferData(record, numData, initialData))
+        {
+            discardRecord(std::move(record));
+            return INVALID_GPU_RESOURCE_HANDLE;
+        }
+
+        if (uploadsDeferred())
+        {
+            // Becomes Resident once the scheduler records the copy
+            record.residency = GpuResourceResidency::PendingUpload;
+        }
+
+        return allocateRecord(std::move(record));
+    }
+
+    GpuResourceHandle ResourceContextImpl::createImage(const ResourceCreationMessage& message)
+    {
+        VkImageCreateInfo createInfo = *reinterpret_cast<const VkImageCreateInfo*>(message.Info);
+
+        // Optimally tiled images have an opaque layout, so their contents always go through a copy
+        const uint32_t numData = message.ResourceData.imageData.numData;
+        const GpuImageResourceData* initialData = message.ResourceData.imageData.data;
+
+        MappedFile sourceFile;
+        std::vector<GpuImageResourceData> fileRegions;
+        if (message.FileSource != nullptr)
+        {
+            // The regions still have to say what goes where
+            if ((initialData == nullptr) || !sourceFile.open(message.FileSource->Path, message.FileSource->Offset, message.FileSource->Size))
+            {
+                return INVALID_GPU_RESOURCE_HANDLE;
+            }
+
+            // Regions are packed back to back in the file, in the order given
+            fileRegions.assign(initialData, initialData + numData);
+            uint64_t regionOffset = 0u;
+            for (auto& region : fileRegions)
+            {
+                if (regionOffset + region.Size > sourceFile.size())
+                {
+                    return INVALID_GPU_RESOURCE_HANDLE;
+                }
+                region.Data = sourceFile.data() + regionOffset;
+                regionOffset += region.Size;
+            }
+            initialData = fileRegions.data();
+        }
+
+        const bool hasInitialData = (numData != 0u) && (initialData != nullptr);
+        if (hasInitialData)
+        {
+            createInfo.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+            shareWithTransferQueue(createInfo.sharingMode, createInfo.queueFamilyIndexCount, createInfo.pQueueFamilyIndices);
+        }
+
+        // Checked against the table rather than the driver, and before anything is created. Block compressed formats
+        // are uploaded as-is, so this is also where we find out if the device can take them
+        if (!formatCapabilities.supportsImage(createInfo))
+        {
+            return INVALID_GPU_RESOURCE_HANDLE;
+        }
+
+        // The regions still say what goes where, one per compressed entry
+        const bool hasCompressedData = (message.NumCompressedData != 0u) && (message.CompressedData != nullptr);
+        if (hasCompressedData && ((message.FileSource != nullptr) || !hasInitialData || (numData != message.NumCompressedData)))
+        {
+            return INVALID_GPU_RESOURCE_HANDLE;
+        }
+
+        for (uint32_t i = 0u; hasInitialData && (i < numData); ++i)
+        {
+            const size_t regionSize = hasCompressedData ? message.CompressedData[i].DecompressedSize : initialData[i].Size;
+            if (!validUploadRegion(createInfo, initialData[i], regionSize))
+            {
+                return INVALID_GPU_RESOURCE_HANDLE;
+            }
+        }
+
+        DecompressedUpload compressedUpload;
+        if (hasCompressedData && !decompressToStaging(numData, message.CompressedData, ImageCopyAlignment, compressedUpload))
+        {
+            return INVALID_GPU_RESOURCE_HANDLE;
+        }
+
+        const VmaAllocationCreateInfo allocCreateInfo = allocationCreateInfo(message.MemoryDomain, message.Flags);
+        VkImage image{ VK_NULL_HANDLE };
+        VmaAllocation allocation{ VK_NULL_HANDLE };
+        VmaAllocationInfo allocationInfo{};
+        VkResult result = vmaCreateImage(vmaAllocatorHandle, &createInfo, &allocCreateInfo, &image, &allocation, &allocationInfo);
+        if (outOfMemory(result))
+        {
+            return INVALID_GPU_RESOURCE_HANDLE;
+        }
+        VkAssert(result);
+        markCreationState(ResourceCreationEvent::State::Allocated);
+
+        ResourceRecord record;
+        record.type = GpuResourceType::Image;
+        record.memoryDomain = message.MemoryDomain;
+        record.residency = GpuResourceResidency::Resident;
+        record.flags = message.Flags;
+        record.vkHandle = (uint64_t)image;
+        record.allocation = allocation;
+        record.size = allocationInfo.size;
+        setPersistentMapping(record);
+        record.imageInfo = createInfo;
+        record.imageInfo.pNext = nullptr;
+        keepQueueFamilies(record.imageInfo, record.queueFamilies);
+
+        if ((message.Flags & CreationFlagBits::ResourceCreateUserDataAsString) && (message.UserData != nullptr))
+        {
+            nameRecord(record, VK_OBJECT_TYPE_IMAGE, reinterpret_cast<const char*>(message.UserData));
+        }
+
+        if (hasInitialData)
+        {
+            if (hasCompressedData)
+            {
+                recordStagedImageUpload(record, compressedUpload.staging, compressedUpload.offsets.data(), compressedUpload.totalSize, numData, initialData);
+            }
+            else if (((message.FileSource == nullptr) || !uploadImageFromFile(record, sourceFile, numData, initialData)) &&
+                !uploadImageData(record, numData, initialData))
+            {
+                discardRecord(std::move(record));
+                return INVALID_GPU_RESOURCE_HANDLE;
+            }
+            // Even if the upload is deferred: the scheduler records it ahead of anything else queued against the image
+            record.layouts.reset(SubresourceState{ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE });
+        }
+
+        if (uploadsDeferred())
+        {
+            record.residency = GpuResourceResidency::PendingUpload;
+        }
+
+        return allocateRecord(std::move(record));
+    }
+
+    GpuResourceHandle ResourceContextImpl::createSampler(const ResourceCreationMessage& message)
+    {
+        const VkSamplerCreateInfo* createInfo = reinterpret_cast<const VkSamplerCreateInfo*>(message.Info);
+
+        // Held through creation, so concurrent requests for the same sampler can't both miss
+        std::lock_guard samplerLock(samplerMutex);
+        CreateInfoKey key;
+        const bool cacheable = MakeSamplerKey(*createInfo, key);
+        if (cacheable)
+        {
+            const GpuResourceHandle cached = samplerCache.acquire(key);
+            if (cached != INVALID_GPU_RESOURCE_HANDLE)
+            {
+                return cached;
+            }
+        }
+        else
+        {
+            samplerCache.countUncacheable();
+        }
+
+        VkSampler sampler{ VK_NULL_HANDLE };
+        VkResult result = vkCreateSampler(logicalDevice->vkHandle(), createInfo, nullptr, &sampler);
+        if (outOfMemory(result))
+        {
+            return INVALID_GPU_RESOURCE_HANDLE;
+        }
+        VkAssert(result);
+
+        ResourceRecord record;
+        record.type = GpuResourceType::Sampler;
+        record.residency = GpuResourceResidency::Resident;
+        record.flags = message.Flags;
+        record.vkHandle = (uint64_t)sampler;
+        // Cache hits return above, so samplers shared through the cache share a slot too
+        record.bindlessIndex = registerBindless(BindlessSamplerBinding, record.vkHandle);
+
+        if ((message.Flags & CreationFlagBits::ResourceCreateUserDataAsString) && (message.UserData != nullptr))
+        {
+            nameRecord(record, VK_OBJECT_TYPE_SAMPLER, reinterpret_cast<const char*>(message.UserData));
+        }
+
+        const GpuResourceHandle handle = allocateRecord(std::move(record));
+        if (cacheable)
+        {
+            samplerCache.insert(key, handle);
+        }
+        return handle;
+    }
+
+    GpuResourceHandle ResourceContextImpl::createView(const ResourceCreationMessage& message)
+    {
+        if (message.ViewInfo == nullptr)
+        {
+            return INVALID_GPU_RESOURCE_HANDLE;
+        }
+
+        const bool isImageView = (message.Type == GpuResourceType::ImageView);
+        bool sampledImageView = false;
+        VkImageViewCreateInfo imageViewInfo{};
+        VkBufferViewCreateInfo bufferViewInfo{};
+        if (isImageView)
+        {
+            imageViewInfo = *reinterpret_cast<const VkImageViewCreateInfo*>(message.ViewInfo);
+        }
+        else
+        {
+            bufferViewInfo = *reinterpret_cast<const VkBufferViewCreateInfo*>(message.ViewInfo);
+        }
+
+        // Held through creation, like samplers: it also keeps the parent from being destroyed underneath us
+        std::lock_guard viewLock(viewMutex);
+        CreateInfoKey key;
+        const bool cacheable = isImageView ? MakeImageViewKey(message.ParentHandle, imageViewInfo, key) :
+            MakeBufferViewKey(message.ParentHandle, bufferViewInfo, key);
+        if (cacheable)
+        {
+            const GpuResourceHandle cached = viewCache.acquire(key);
+            if (cached != INVALID_GPU_RESOURCE_HANDLE)
+            {
+                return cached;
+            }
+        }
+
+        {
+            std::shared_lock recordLock(recordMutex);
+            const ResourceRecord* parent = lookupRecord(message.ParentHandle);
+            if ((parent == nullptr) || (parent->vkHandle == 0u))
+            {
+                return INVALID_GPU_RESOURCE_HANDLE;
+            }
+
+            const bool parentIsImage = (parent->type == GpuResourceType::Image) || (parent->type == GpuResourceType::SparseImage);
+            if (isImageView ? !parentIsImage : (parent->type != GpuResourceType::Buffer))
+            {
+                return INVALID_GPU_RESOURCE_HANDLE;
+            }
+
+            imageViewInfo.image = (VkImage)parent->vkHandle;
+            bufferViewInfo.buffer = (VkBuffer)parent->vkHandle;
+            sampledImageView = isImageView && (parent->imageInfo.usage & VK_IMAGE_USAGE_SAMPLED_BIT);
+        }
+
+        uint64_t view = 0u;
+        if (isImageView)
+        {
+            VkImageView imageView{ VK_NULL_HANDLE };
+            VkResult result = vkCreateImageView(logicalDevice->vkHandle(), &imageViewInfo, nullptr, &imageView);
+            if (outOfMemory(result))
+            {
+                return INVALID_GPU_RESOURCE_HANDLE;
+            }
+            VkAssert(result);
+            view = (uint64_t)imageView;
+        }
+        else
+        {
+            VkBufferView bufferView{ VK_NULL_HANDLE };
+            VkResult result = vkCreateBufferView(logicalDevice->vkHandle(), &bufferViewInfo, nullptr, &bufferView);
+            if (outOfMemory(result))
+            {
+                return INVALID_GPU_RESOURCE_HANDLE;
+            }
+            VkAssert(result);
+            view = (uint64_t)bufferView;
+        }
+
+        ResourceRecord record;
+        record.type = message.Type;
+        record.residency = GpuResourceResidency::Resident;
+        record.flags = message.Flags;
+        record.vkHandle = view;
+        record.parentHandle = message.ParentHandle;
+        if (sampledImageView)
+        {
+            record.bindlessIndex = registerBindless(BindlessSampledImageBinding, record.vkHandle);
+        }
+
+        if ((message.Flags & CreationFlagBits::ResourceCreateUserDataAsString) && (message.UserData != nullptr))
+        {
+            nameRecord(record, isImageView ? VK_OBJECT_TYPE_IMAGE_VIEW : VK_OBJECT_TYPE_BUFFER_VIEW, reinterpret_cast<const char*>(message.UserData));
+        }
+
+        const GpuResourceHandle handle = allocateRecord(std::move(record));
+        {
+            std::unique_lock recordLock(recordMutex);
+            ResourceRecord* parent = lookupRecord(message.ParentHandle);
+            if (parent != nullptr)
+            {
+                ++parent->viewCount;
+            }
+        }
+
+        viewCache.insert(cacheable ? &key : nullptr, message.ParentHandle, handle);
+        return handle;
+    }
+
+    bool ResourceContextImpl::uploadBufferData(const ResourceRecord& record, uint32_t num_data, const GpuResourceData* data)
+    {
+        // Entries are packed one after another, each at its own alignment
+        std::vector<VkDeviceSize> offsets(num_data);
+        VkDeviceSize totalSize = 0u;
+        for (uint32_t i = 0u; i < num_data; ++i)
+        {
+            offsets[i] = alignUp(totalSize, data[i].Alignment);
+            totalSize = offsets[i] + data[i].Size;
+        }
+
+        VkMemoryPropertyFlags memoryFlags = 0u;
+        vmaGetAllocationMemoryProperties(vmaAllocatorHandle, record.allocation, &memoryFlags);
+
+        if (memoryFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            void* mappedData = nullptr;
+            VkResult result = vmaMapMemory(vmaAllocatorHandle, record.allocation, &mappedData);
+            VkAssert(result);
+
+            for (uint32_t i = 0u; i < num_data; ++i)
+            {
+                memcpy(reinterpret_cast<std::byte*>(mappedData) + offsets[i], data[i].Data, data[i].Size);
+            }
+            markCreationState(ResourceCreationEvent::State::Staged);
+
+            // VMA rounds the range out to nonCoherentAtomSize for us
+            if (!(memoryFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+            {
+                result = vmaFlushAllocation(vmaAllocatorHandle, record.allocation, 0u, totalSize);
+                VkAssert(result);
+            }
+
+            vmaUnmapMemory(vmaAllocatorHandle, record.allocation);
+            return true;
+        }
+
+        const StagingAllocation staging = acquireStagingMemory(totalSize);
+        if (staging.buffer == VK_NULL_HANDLE)
+        {
+            return false;
+        }
+
+        std::vector<VkBufferCopy> copyRegions(num_data);
+        for (uint32_t i = 0u; i < num_data; ++i)
+        {
+            memcpy(reinterpret_cast<std::byte*>(staging.mappedData) + offsets[i], data[i].Data, data[i].Size);
+            copyRegions[i] = VkBufferCopy{ staging.offset + offsets[i], offsets[i], data[i].Size };
+        }
+        markCreationState(ResourceCreationEvent::State::Staged);
+
+        if (!deferUpload(record, staging.buffer, totalSize, std::move(copyRegions), {}))
+        {
+            vkCmdCopyBuffer(transferCommandBuffer(), staging.buffer, (VkBuffer)record.vkHandle, num_data, copyRegions.data());
+            markCreationState(ResourceCreationEvent::State::Recorded);
+        }
+        return true;
+    }
+
+    bool ResourceContextImpl::uploadImageData(const ResourceRecord& record, uint32_t num_data, const GpuImageResourceData* data)
+    {
+        std::vector<VkDeviceSize> offsets(num_data);
+        VkDeviceSize totalSize = 0u;
+        for (uint32_t i = 0u; i < num_data; ++i)
+        {
+            offsets[i] = alignUp(totalSize, ImageCopyAlignment);
+            totalSize = offsets[i] + data[i].Size;
+        }
+
+        const StagingAllocation staging = acquireStagingMemory(totalSize);
+        if (staging.buffer == VK_NULL_HANDLE)
+        {
+            return false;
+        }
+
+        for (uint32_t i = 0u; i < num_data; ++i)
+        {
+            memcpy(reinterpret_cast<std::byte*>(staging.mappedData) + offsets[i], data[i].Data, data[i].Size);
+        }
+        markCreationState(ResourceCreationEvent::State::Staged);
+
+        recordStagedImageUpload(record, staging, offsets.data(), totalSize, num_data, data);
+        return true;
+    }
+
+    void ResourceContextImpl::recordStagedImageUpload(const ResourceRecord& record, const StagingAllocation& staging, const VkDeviceSize* offsets, VkDeviceSize total_size,
+        uint32_t num_data, const GpuImageResourceData* data)
+    {
+        std::vector<VkBufferImageCopy> copyRegions(num_data);
+        for (uint32_t i = 0u; i < num_data; ++i)
+        {
+            copyRegions[i] = imageUploadRegion(record.imageInfo, data[i], staging.offset + offsets[i]);
+        }
+
+        if (!deferUpload(record, staging.buffer, total_size, {}, std::move(copyRegions)))
+        {
+            recordImageUpload(record, transferCommandBuffer(), staging.buffer, num_data, copyRegions.data());
+        }
+    }
+
+    void ResourceContextImpl::recordImageUpload(const ResourceRecord& record, VkCommandBuffer cmd, VkBuffer source, uint32_t num_regions, const VkBufferImageCopy* regions)
+    {
+        const VkImageSubresourceRange subresourceRange{ aspectMaskFromFormat(record.imageInfo.format), 0u, record.imageInfo.mipLevels, 0u, record.imageInfo.arrayLayers };
+        const VkImageMemoryBarrier toTransferDst
+        {
+            VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            nullptr,
+            0u,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED,
+            (VkImage)record.vkHandle,
+            subresourceRange
+        };
+
+        // Readers are on other queues (or later submissions), and synchronize with the frame's submission instead
+        const VkImageMemoryBarrier toShaderRead
+        {
+            VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            nullptr,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            0u,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED,
+            (VkImage)record.vkHandle,
+            subresourceRange
+        };
+
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0u, nullptr, 0u, nullptr, 1u, &toTransferDst);
+        vkCmdCopyBufferToImage(cmd, source, (VkImage)record.vkHandle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, num_regions, regions);
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0u, nullptr, 0u, nullptr, 1u, &toShaderRead);
+        markCreationState(ResourceCreationEvent::State::Recorded);
+    }
+
+    bool ResourceContextImpl::uploadBufferFromFile(const ResourceRecord& record, MappedFile& file)
+    {
+        // Host visible destinations are better off with a single memcpy straight out of the mapping. Scheduled uploads are
+        // staged too, as the mapping only lives as long as the frame it's imported in
+        VkMemoryPropertyFlags memoryFlags = 0u;
+        vmaGetAllocationMemoryProperties(vmaAllocatorHandle, record.allocation, &memoryFlags);
+        if ((memoryFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) || (activeDeferredUploads != nullptr))
+        {
+            return false;
+        }
+
+        const VkDeviceSize rangeOffset = file.rangeOffset();
+        const VkDeviceSize rangeSize = file.size();
+        VkBuffer source = importMappedFile(file);
+        if (source == VK_NULL_HANDLE)
+        {
+            return false;
+        }
+
+        // Imported in place: the mapping is the staging memory
+        markCreationState(ResourceCreationEvent::State::Staged);
+        const VkBufferCopy copyRegion{ rangeOffset, 0u, rangeSize };
+        vkCmdCopyBuffer(transferCommandBuffer(), source, (VkBuffer)record.vkHandle, 1u, &copyRegion);
+        markCreationState(ResourceCreationEvent::State::Recorded);
+        return true;
+    }
+
+    bool ResourceContextImpl::uploadImageFromFile(const ResourceRecord& record, MappedFile& file, uint32_t num_data, const GpuImageResourceData* data)
+    {
+        if (activeDeferredUploads != nullptr)
+        {
+            return false;
+        }
+
+        std::vector<VkBufferImageCopy> copyRegions(num_data);
+        for (uint32_t i = 0u; i < num_data; ++i)
+        {
+            // We can't realign data that's already sitting in the file, so misaligned regions have to be staged
+            const VkDeviceSize bufferOffset = static_cast<VkDeviceSize>(reinterpret_cast<const std::byte*>(data[i].Data) - file.mappingBase());
+            if ((bufferOffset % ImageCopyAlignment) != 0u)
+            {
+                return false;
+            }
+
+            copyRegions[i] = imageUploadRegion(record.imageInfo, data[i], bufferOffset);
+        }
+
+        VkBuffer source = importMappedFile(file);
+        if (source == VK_NULL_HANDLE)
+        {
+            return false;
+        }
+        markCreationState(ResourceCreationEvent::State::Staged);
+
+        recordImageUpload(record, transferCommandBuffer(), source, num_data, copyRegions.data());
+        return true;
+    }
+
+    VkBuffer ResourceContextImpl::importMappedFile(MappedFile& file)
+    {
+        if (!hostMemoryImportSupported || ((reinterpret_cast<uintptr_t>(file.mappingBase()) % minImportedHostPointerAlignment) != 0u))
+        {
+            return VK_NULL_HANDLE;
+        }
+
+        // Mappings cover whole pages, so rounding up to the (page sized) import alignment stays within it
+        const VkDeviceSize importSize = alignUp(file.mappingSize(), minImportedHostPointerAlignment);
+        void* hostPointer = const_cast<std::byte*>(file.mappingBase());
+
+        VkMemoryHostPointerPropertiesEXT pointerProperties
+        {
+            VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT,
+            nullptr,
+            0u
+        };
+        VkResult result = vkGetMemoryHostPointerPropertiesEXT(logicalDevice->vkHandle(), VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT, hostPointer, &pointerProperties);
+        if ((result != VK_SUCCESS) || (pointerProperties.memoryTypeBits == 0u))
+        {
+            return VK_NULL_HANDLE;
+        }
+
+        constexpr static VkExternalMemoryBufferCreateInfo externalBufferInfo
+        {
+            VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO,
+            nullptr,
+            VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT
+        };
+
+        const VkBufferCreateInfo bufferInfo
+        {
+            VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            &externalBufferInfo,
+            0,
+            importSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_SHARING_MODE_EXCLUSIVE,
+            0u,
+            nullptr
+        };
+
+        VkBuffer buffer{ VK_NULL_HANDLE };
+        result = vkCreateBuffer(logicalDevice->vkHandle(), &bufferInfo, nullptr, &buffer);
+        if (result != VK_SUCCESS)
+        {
+            return VK_NULL_HANDLE;
+        }
+
+        VkMemoryRequirements requirements{};
+        vkGetBufferMemoryRequirements(logicalDevice->vkHandle(), buffer, &requirements);
+        const uint32_t memoryTypeBits = requirements.memoryTypeBits & pointerProperties.memoryTypeBits;
+        uint32_t memoryTypeIdx = 0u;
+        while ((memoryTypeIdx < memoryProperties.memoryTypeCount) && !(memoryTypeBits & (1u << memoryTypeIdx)))
+        {
+            ++memoryTypeIdx;
+        }
+
+        if (memoryTypeIdx == memoryProperties.memoryTypeCount)
+        {
+            vkDestroyBuffer(logicalDevice->vkHandle(), buffer, nullptr);
+            return VK_NULL_HANDLE;
+        }
+
+        const VkImportMemoryHostPointerInfoEXT importInfo
+        {
+            VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT,
+            nullptr,
+            VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT,
+            hostPointer
+        };
+
+        const VkMemoryAllocateInfo allocInfo
+        {
+            VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            &importInfo,
+            importSize,
+            memoryTypeIdx
+        };
+
+        // Some drivers refuse file backed (or read-only) mappings: callers fall back to staging
+        VkDeviceMemory memory{ VK_NULL_HANDLE };
+        result = vkAllocateMemory(logicalDevice->vkHandle(), &allocInfo, nullptr, &memory);
+        if (result != VK_SUCCESS)
+        {
+            vkDestroyBuffer(logicalDevice->vkHandle(), buffer, nullptr);
+            return VK_NULL_HANDLE;
+        }
+
+        result = vkBindBufferMemory(logicalDevice->vkHandle(), buffer, memory, 0u);
+        VkAssert(result);
+
+        std::lock_guard destructionLock(destructionMutex);
+        currentFrame().importedUploads.emplace_back(ImportedFileUpload{ std::move(file), buffer, memory });
+        return buffer;
+    }
+
+    void ResourceContextImpl::processModifications()
+    {
+        std::unordered_map<GpuResourceHandle, BufferModificationBatch> bufferBatches;
+        std::unordered_map<GpuResourceHandle, ImageModificationBatch> imageBatches;
+        std::vector<std::pair<GpuResourceHandle, GpuResourceHandle>> copies;
+        {
+            std::lock_guard modificationLock(modificationMutex);
+            bufferBatches.swap(pendingBufferModifications);
+            imageBatches.swap(pendingImageModifications);
+            copies.swap(pendingCopies);
+        }
+
+        if (bufferBatches.empty() && imageBatches.empty() && copies.empty())
+        {
+            return;
+        }
+
+        {
+            // Recorded after the uploads, so anything still waiting on one has to have it this frame
+            std::vector<GpuResourceHandle> targets;
+            targets.reserve(bufferBatches.size() + imageBatches.size() + copies.size() * 2u);
+            for (const auto& [handle, batch] : bufferBatches)
+            {
+                targets.emplace_back(handle);
+            }
+            for (const auto& [handle, batch] : imageBatches)
+            {
+                targets.emplace_back(handle);
+            }
+            for (const auto& [src, dst] : copies)
+            {
+                targets.emplace_back(src);
+                targets.emplace_back(dst);
+            }
+            uploadScheduler.expedite(targets);
+        }
+
+        struct BufferTarget
+        {
+            VkBuffer buffer;
+            const BufferModificationBatch* batch;
+            std::vector<VkBufferCopy> ranges;
+        };
+
+        struct ImageTarget
+        {
+            GpuResourceHandle handle;
+            VkImage image;
+            VkImageCreateInfo info;
+            VkImageSubresourceRange range;
+            const ImageModificationBatch* batch;
+            // Set if the device can't clear on the transfer queue, and we copy this texel over the image instead
+            std::byte clearTexel[16];
+            size_t clearTexelSize;
+        };
+
+        struct CopyTarget
+        {
+            GpuResourceType type;
+            GpuResourceHandle srcHandle;
+            GpuResourceHandle dstHandle;
+            uint64_t src;
+            uint64_t dst;
+            VkDeviceSize size;
+            VkImageCreateInfo info;
+            VkImageSubresourceRange range;
+        };
+
+        // Layouts images are in as we record: starts as whatever the context last left them in. Render threads can
+        // transition them while we record, so only what we change is written back, against the state we started from
+        struct ImageLayoutState
+        {
+            VkImage image;
+            VkImageSubresourceRange range;
+            ImageLayoutTracker base;
+            ImageLayoutTracker layouts;
+        };
+
+        std::vector<BufferTarget> bufferTargets;
+        std::vector<ImageTarget> imageTargets;
+        std::vector<CopyTarget> copyTargets;
+        std::unordered_map<GpuResourceHandle, ImageLayoutState> imageLayouts;
+        const bool canClearColor = (transferQueueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) != 0u;
+        const bool canClearDepth = (transferQueueFlags & VK_QUEUE_GRAPHICS_BIT) != 0u;
+
+        {
+            std::shared_lock recordLock(recordMutex);
+
+            auto trackImage = [&imageLayouts](GpuResourceHandle handle, const ResourceRecord& record)
+            {
+                const VkImageSubresourceRange range{ aspectMaskFromFormat(record.imageInfo.format), 0u, record.imageInfo.mipLevels, 0u, record.imageInfo.arrayLayers };
+                imageLayouts.emplace(handle, ImageLayoutState{ (VkImage)record.vkHandle, range, record.layouts, record.layouts });
+                return range;
+            };
+
+            for (const auto& [handle, batch] : bufferBatches)
+            {
+                const ResourceRecord* record = lookupRecord(handle);
+                if ((record == nullptr) || (record->type != GpuResourceType::Buffer) || (record->vkHandle == 0u))
+                {
+                    continue;
+                }
+                bufferTargets.emplace_back(BufferTarget{ (VkBuffer)record->vkHandle, &batch, batch.mergedRanges() });
+            }
+
+            for (const auto& [handle, batch] : imageBatches)
+            {
+                const ResourceRecord* record = lookupRecord(handle);
+                if ((record == nullptr) || (record->type != GpuResourceType::Image) || (record->vkHandle == 0u) ||
+                    !(record->imageInfo.usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT))
+                {
+                    continue;
+                }
+
+                ImageTarget target{ handle, (VkImage)record->vkHandle, record->imageInfo, trackImage(handle, *record), &batch, {}, 0u };
+                const bool isDepth = (target.range.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT) == 0u;
+                if (batch.hasClear && !(isDepth ? canClearDepth : canClearColor))
+                {
+                    // Depth aspects can't be copied to without graphics support either, so those clears are dropped
+                    target.clearTexelSize = isDepth ? 0u : EncodeClearTexel(record->imageInfo.format, batch.clearColor, target.clearTexel);
+                    if ((target.clearTexelSize == 0u) && batch.writes.empty())
+                    {
+                        imageLayouts.erase(handle);
+                        continue;
+                    }
+                }
+                imageTargets.emplace_back(target);
+            }
+
+            for (const auto& [srcHandle, dstHandle] : copies)
+            {
+                const ResourceRecord* src = lookupRecord(srcHandle);
+                const ResourceRecord* dst = lookupRecord(dstHandle);
+                if ((src == nullptr) || (dst == nullptr) || (src->type != dst->type) || (src->vkHandle == 0u) || (dst->vkHandle == 0u))
+                {
+                    continue;
+                }
+
+                if (src->type == GpuResourceType::Buffer)
+                {
+                    copyTargets.emplace_back(CopyTarget{ src->type, srcHandle, dstHandle, src->vkHandle, dst->vkHandle, std::min(src->size, dst->size), {}, {} });
+                }
+                else if ((src->type == GpuResourceType::Image) && (src->imageInfo.format == dst->imageInfo.format) &&
+                    (memcmp(&src->imageInfo.extent, &dst->imageInfo.extent, sizeof(VkExtent3D)) == 0) &&
+                    (src->imageInfo.usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) && (dst->imageInfo.usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT))
+                {
+                    VkImageSubresourceRange range = trackImage(srcHandle, *src);
+                    trackImage(dstHandle, *dst);
+                    range.levelCount = std::min(src->imageInfo.mipLevels, dst->imageInfo.mipLevels);
+                    range.layerCount = std::min(src->imageInfo.arrayLayers, dst->imageInfo.arrayLayers);
+                    copyTargets.emplace_back(CopyTarget{ src->type, srcHandle, dstHandle, src->vkHandle, dst->vkHandle, 0u, src->imageInfo, range });
+                }
+            }
+        }
+
+        // Clear fallbacks copy a tile of the clear color over the image, rather than staging a whole image of it
+        constexpr static uint32_t ClearTileSize = 128u;
+        auto clearTileExtent = [](const VkImageCreateInfo& info)
+        {
+            return VkExtent2D{ std::min(info.extent.width, ClearTileSize), std::min(info.extent.height, ClearTileSize) };
+        };
+
+        VkDeviceSize stagingSize = 0u;
+        for (const auto& target : bufferTargets)
+        {
+            for (const auto& range : target.ranges)
+            {
+                stagingSize += range.size;
+            }
+        }
+
+        for (const auto& target : imageTargets)
+        {
+            if (target.clearTexelSize != 0u)
+            {
+                const VkExtent2D tile = clearTileExtent(target.info);
+                stagingSize = alignUp(stagingSize, ImageCopyAlignment) + (target.clearTexelSize * tile.width * tile.height);
+            }
+            for (const auto& pendingWrite : target.batch->writes)
+            {
+                stagingSize = alignUp(stagingSize, ImageCopyAlignment) + pendingWrite.data.size();
+            }
+        }
+
+        StagingAllocation staging;
+        if (stagingSize != 0u)
+        {
+            staging = acquireStagingMemory(stagingSize);
+            if (staging.buffer == VK_NULL_HANDLE)
+            {
+                // Nothing is recorded yet: try again next frame, ahead of anything queued since
+                requeueModifications(std::move(bufferBatches), std::move(imageBatches), std::move(copies));
+                return;
+            }
+        }
+        std::byte* stagingData = reinterpret_cast<std::byte*>(staging.mappedData);
+
+        FrameData& frame = currentFrame();
+        VkCommandBuffer cmd = frame.transferCmd;
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+
+        std::vector<SubresourceTransition> subresourceTransitions;
+        auto transitionImage = [&imageLayouts, &imageBarriers, &subresourceTransitions](GpuResourceHandle handle, VkImageLayout new_layout, bool discard_contents)
+        {
+            ImageLayoutState& state = imageLayouts.at(handle);
+            // Other queues are ordered against the transfer batch by semaphores, so there are no accesses for later barriers to wait on
+            subresourceTransitions.clear();
+            state.layouts.transition(state.range.levelCount, state.range.layerCount, state.range,
+                SubresourceState{ new_layout, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE }, subresourceTransitions);
+
+            for (const auto& transition : subresourceTransitions)
+            {
+                // Writes from other queues that stay in our layout are covered by the same semaphores
+                if (transition.previous.layout == new_layout)
+                {
+                    continue;
+                }
+
+                imageBarriers.emplace_back(VkImageMemoryBarrier
+                {
+                    VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                    nullptr,
+                    VK_ACCESS_TRANSFER_WRITE_BIT,
+                    VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+                    discard_contents ? VK_IMAGE_LAYOUT_UNDEFINED : transition.previous.layout,
+                    new_layout,
+                    VK_QUEUE_FAMILY_IGNORED,
+                    VK_QUEUE_FAMILY_IGNORED,
+                    state.image,
+                    transition.range
+                });
+            }
+        };
+
+        // Between each phase: everything written so far is visible to the next round of transfers
+        auto transferBarrier = [&cmd, &imageBarriers]()
+        {
+            constexpr static VkMemoryBarrier memoryBarrier
+            {
+                VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                nullptr,
+                VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT
+            };
+            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1u, &memoryBarrier, 0u, nullptr,
+                static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+            imageBarriers.clear();
+        };
+
+        for (const auto& target : imageTargets)
+        {
+            // A clear covers the whole image, so there's nothing worth preserving through the transition
+            transitionImage(target.handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, target.batch->hasClear);
+        }
+        for (const auto& copy : copyTargets)
+        {
+            if (copy.type == GpuResourceType::Image)
+            {
+                transitionImage(copy.dstHandle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, false);
+            }
+        }
+        transferBarrier();
+
+        // Clears
+        VkDeviceSize stagingOffset = 0u;
+        for (const auto& target : bufferTargets)
+        {
+            for (const auto& fill : target.batch->fills)
+            {
+                vkCmdFillBuffer(cmd, target.buffer, fill.offset, fill.size, fill.value);
+            }
+        }
+
+        for (auto& target : imageTargets)
+        {
+            if (!target.batch->hasClear)
+            {
+                continue;
+            }
+
+            if (target.clearTexelSize != 0u)
+            {
+                const VkExtent2D tile = clearTileExtent(target.info);
+                stagingOffset = alignUp(stagingOffset, ImageCopyAlignment);
+                for (uint32_t i = 0u; i < tile.width * tile.height; ++i)
+                {
+                    memcpy(stagingData + stagingOffset + (i * target.clearTexelSize), target.clearTexel, target.clearTexelSize);
+                }
+
+                // One layer per region: a region spanning several would read a tile per layer, and only one is staged
+                std::vector<VkBufferImageCopy> regions;
+                for (uint32_t mip = 0u; mip < target.info.mipLevels; ++mip)
+                {
+                    const uint32_t mipWidth = std::max(target.info.extent.width >> mip, 1u);
+                    const uint32_t mipHeight = std::max(target.info.extent.height >> mip, 1u);
+                    const uint32_t mipDepth = std::max(target.info.extent.depth >> mip, 1u);
+                    for (uint32_t layer = 0u; layer < target.info.arrayLayers; ++layer)
+                    {
+                        for (uint32_t z = 0u; z < mipDepth; ++z)
+                        {
+                            for (uint32_t y = 0u; y < mipHeight; y += tile.height)
+                            {
+                                for (uint32_t x = 0u; x < mipWidth; x += tile.width)
+                                {
+                                    regions.emplace_back(VkBufferImageCopy
+                                    {
+                                        staging.offset + stagingOffset,
+                                        tile.width,
+                                        tile.height,
+                                        VkImageSubresourceLayers{ target.range.aspectMask, mip, layer, 1u },
+                                        VkOffset3D{ static_cast<int32_t>(x), static_cast<int32_t>(y), static_cast<int32_t>(z) },
+                                        VkExtent3D{ std::min(tile.width, mipWidth - x), std::min(tile.height, mipHeight - y), 1u }
+                                    });
+                                }
+                            }
+                        }
+                    }
+                }
+
+                vkCmdCopyBufferToImage(cmd, staging.buffer, target.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+                stagingOffset += target.clearTexelSize * tile.width * tile.height;
+            }
+            else if (target.range.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT)
+            {
+                VkClearColorValue clearValue;
+                std::copy(target.batch->clearColor, target.batch->clearColor + 4, clearValue.float32);
+                vkCmdClearColorImage(cmd, target.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearValue, 1u, &target.range);
+            }
+            else if (canClearDepth)
+            {
+                const VkClearDepthStencilValue clearValue{ target.batch->clearColor[0], 0u };
+                vkCmdClearDepthStencilImage(cmd, target.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearValue, 1u, &target.range);
+            }
+        }
+        transferBarrier();
+
+        // Writes
+        for (auto& target : bufferTargets)
+        {
+            if (target.ranges.empty())
+            {
+                continue;
+            }
+
+            target.batch->stage(target.ranges, stagingData + stagingOffset, staging.offset + stagingOffset);
+            for (const auto& range : target.ranges)
+            {
+                stagingOffset += range.size;
+            }
+            vkCmdCopyBuffer(cmd, staging.buffer, target.buffer, static_cast<uint32_t>(target.ranges.size()), target.ranges.data());
+        }
+
+        for (const auto& target : imageTargets)
+        {
+            std::vector<VkBufferImageCopy> regions;
+            for (const auto& pendingWrite : target.batch->writes)
+            {
+                stagingOffset = alignUp(stagingOffset, ImageCopyAlignment);
+                memcpy(stagingData + stagingOffset, pendingWrite.data.data(), pendingWrite.data.size());
+                const GpuImageResourceData& region = pendingWrite.region;
+                regions.emplace_back(VkBufferImageCopy
+                {
+                    staging.offset + stagingOffset,
+                    0u,
+                    0u,
+                    VkImageSubresourceLayers{ target.range.aspectMask, region.MipLevel, region.ArrayLayer, std::max(region.ArrayLayerCount, 1u) },
+                    VkOffset3D{ 0, 0, 0 },
+                    VkExtent3D{ region.Width, region.Height, std::max(target.info.extent.depth >> region.MipLevel, 1u) }
+                });
+                stagingOffset += pendingWrite.data.size();
+            }
+
+            if (!regions.empty())
+            {
+                vkCmdCopyBufferToImage(cmd, staging.buffer, target.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+            }
+        }
+
+        // Copies see everything written to their sources this frame
+        for (const auto& copy : copyTargets)
+        {
+            if (copy.type == GpuResourceType::Image)
+            {
+                transitionImage(copy.srcHandle, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false);
+            }
+        }
+        transferBarrier();
+
+        for (const auto& copy : copyTargets)
+        {
+            if (copy.type == GpuResourceType::Buffer)
+            {
+                const VkBufferCopy region{ 0u, 0u, copy.size };
+                vkCmdCopyBuffer(cmd, (VkBuffer)copy.src, (VkBuffer)copy.dst, 1u, &region);
+                continue;
+            }
+
+            std::vector<VkImageCopy> regions;
+            for (uint32_t mip = 0u; mip < copy.range.levelCount; ++mip)
+            {
+                const VkImageSubresourceLayers subresource{ copy.range.aspectMask, mip, 0u, copy.range.layerCount };
+                const VkExtent3D mipExtent
+                {
+                    std::max(copy.info.extent.width >> mip, 1u),
+                    std::max(copy.info.extent.height >> mip, 1u),
+                    std::max(copy.info.extent.depth >> mip, 1u)
+                };
+                regions.emplace_back(VkImageCopy{ subresource, VkOffset3D{ 0, 0, 0 }, subresource, VkOffset3D{ 0, 0, 0 }, mipExtent });
+            }
+            vkCmdCopyImage(cmd, (VkImage)copy.src, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, (VkImage)copy.dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                static_cast<uint32_t>(regions.size()), regions.data());
+        }
+
+        // Back to where sampling expects them. Readers synchronize with the frame's submission, not this barrier
+        for (auto& [handle, state] : imageLayouts)
+        {
+            transitionImage(handle, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false);
+        }
+        if (!imageBarriers.empty())
+        {
+            for (auto& barrier : imageBarriers)
+            {
+                barrier.dstAccessMask = 0u;
+            }
+            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0u, nullptr, 0u, nullptr,
+                static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+        }
+        frame.hasCommands = true;
+
+        std::unique_lock recordLock(recordMutex);
+        for (const auto& [handle, state] : imageLayouts)
+        {
+            ResourceRecord* record = lookupRecord(handle);
+            if (record != nullptr)
+            {
+                record->layouts.merge(state.range.levelCount, state.range.layerCount, state.base, state.layouts);
+            }
+        }
+    }
+
+    void ResourceContextImpl::requeueModifications(std::unordered_map<GpuResourceHandle, BufferModificationBatch>&& buffer_batches,
+        std::unordered_map<GpuResourceHandle, ImageModificationBatch>&& image_batches, std::vector<std::pair<GpuResourceHandle, GpuResourceHandle>>&& copies)
+    {
+        std::lock_guard modificationLock(modificationMutex);
+        for (auto& [handle, batch] : buffer_batches)
+        {
+            // Replayed onto ours in the order they were queued, so later fills still paint into earlier writes
+            auto [iter, inserted] = pendingBufferModifications.try_emplace(handle, std::move(batch));
+            if (!inserted)
+            {
+                std::swap(iter->second, batch);
+                for (const auto& fill : batch.fills)
+                {
+                    iter->second.fill(fill.offset, fill.size, fill.value);
+                }
+                for (const auto& pendingWrite : batch.writes)
+                {
+                    iter->second.write(pendingWrite.offset, pendingWrite.data.data(), pendingWrite.data.size());
+                }
+            }
+        }
+
+        for (auto& [handle, batch] : image_batches)
+        {
+            auto [iter, inserted] = pendingImageModifications.try_emplace(handle, std::move(batch));
+            if (!inserted)
+            {
+                std::swap(iter->second, batch);
+                if (batch.hasClear)
+                {
+                    iter->second.clear(batch.clearColor);
+                }
+                for (const auto& pendingWrite : batch.writes)
+                {
+                    iter->second.write(pendingWrite.region);
+                }
+            }
+        }
+
+        copies.insert(copies.end(), pendingCopies.begin(), pendingCopies.end());
+        pendingCopies.swap(copies);
+    }
+
+    void ResourceContextImpl::processReadbacks()
+    {
+        // Frames that have already finished don't need to wait for their slot to come back around
+        for (auto& frame : frames)
+        {
+            if (frame.submitted && !frame.readbacks.empty() && (vkGetFenceStatus(logicalDevice->vkHandle(), frame.fence) == VK_SUCCESS))
+            {
+                completeReadbacks(frame);
+            }
+        }
+
+        for (auto& readback : completedReadbacks)
+        {
+            if (readback->released.load(std::memory_order_acquire))
+            {
+                readbackPool.release(vmaAllocatorHandle, readback->buffer);
+                readback.reset();
+            }
+        }
+        std::erase(completedReadbacks, nullptr);
+
+        std::vector<std::unique_ptr<ReadbackState>> requests;
+        {
+            std::lock_guard readbackLock(readbackMutex);
+            requests.swap(pendingReadbacks);
+        }
+
+        if (requests.empty())
+        {
+            return;
+        }
+
+        {
+            std::vector<GpuResourceHandle> sourceHandles(requests.size());
+            for (size_t i = 0u; i < requests.size(); ++i)
+            {
+                sourceHandles[i] = requests[i]->handle;
+            }
+            uploadScheduler.expedite(sourceHandles);
+        }
+
+        // Source buffer of each request, or VK_NULL_HANDLE if it can't be read back (destroyed since, or never a buffer).
+        // Destruction is deferred past this frame, so the buffers stay valid after we drop the lock
+        std::vector<VkBuffer> sources(requests.size(), VK_NULL_HANDLE);
+        {
+            std::shared_lock recordLock(recordMutex);
+            for (size_t i = 0u; i < requests.size(); ++i)
+            {
+                ReadbackState& request = *requests[i];
+                const ResourceRecord* record = lookupRecord(request.handle);
+                if ((record == nullptr) || (record->type != GpuResourceType::Buffer) || (record->vkHandle == 0u) || (request.offset >= record->size))
+                {
+                    continue;
+                }
+
+                const VkDeviceSize available = record->size - request.offset;
+                request.size = request.size != 0u ? std::min(request.size, available) : available;
+                sources[i] = (VkBuffer)record->vkHandle;
+            }
+        }
+
+        FrameData& frame = currentFrame();
+        VkCommandBuffer cmd = frame.transferCmd;
+        const VmaAllocationCreateInfo allocCreateInfo = allocationCreateInfo(GpuResourceMemoryDomain::HostCached, CreationFlagBits::ResourceCreatePersistentlyMapped);
+        bool barrierRecorded = false;
+
+        for (size_t i = 0u; i < requests.size(); ++i)
+        {
+            ReadbackState& request = *requests[i];
+            if (sources[i] != VK_NULL_HANDLE)
+            {
+                request.buffer = readbackPool.acquire(vmaAllocatorHandle, request.size, allocCreateInfo);
+            }
+
+            if (request.buffer.buffer == VK_NULL_HANDLE)
+            {
+                request.complete.store(true, std::memory_order_release);
+                completedReadbacks.emplace_back(std::move(requests[i]));
+                continue;
+            }
+
+            if (!barrierRecorded)
+            {
+                // Reads see whatever processModifications() wrote earlier in the batch
+                constexpr static VkMemoryBarrier transferBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT };
+                vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1u, &transferBarrier, 0u, nullptr, 0u, nullptr);
+                barrierRecorded = true;
+            }
+
+            const VkBufferCopy region{ request.offset, 0u, request.size };
+            vkCmdCopyBuffer(cmd, sources[i], request.buffer.buffer, 1u, &region);
+            frame.readbacks.emplace_back(std::move(requests[i]));
+        }
+
+        if (barrierRecorded)
+        {
+            constexpr static VkMemoryBarrier hostBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT };
+            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1u, &hostBarrier, 0u, nullptr, 0u, nullptr);
+            frame.hasCommands = true;
+        }
+    }
+
+    void ResourceContextImpl::completeReadbacks(FrameData& frame)
+    {
+        for (auto& readback : frame.readbacks)
+        {
+            // Host cached memory usually isn't coherent too
+            vmaInvalidateAllocation(vmaAllocatorHandle, readback->buffer.allocation, 0u, VK_WHOLE_SIZE);
+            readback->complete.store(true, std::memory_order_release);
+            completedReadbacks.emplace_back(std::move(readback));
+        }
+        frame.readbacks.clear();
+    }
+
+    void ResourceContextImpl::scheduleUploads()
+    {
+        std::vector<ScheduledUpload> uploads;
+        uploadScheduler.take(frameCounter, uploads);
+        if (uploads.empty())
+        {
+            return;
+        }
+
+        // Copied out so we can record without the lock. Left empty for resources destroyed while their upload waited
+        std::vector<ResourceRecord> targets(uploads.size());
+        {
+            std::unique_lock recordLock(recordMutex);
+            for (size_t i = 0u; i < uploads.size(); ++i)
+            {
+                ResourceRecord* record = lookupRecord(uploads[i].handle);
+                // Pending uploads pin the resource in place, so the Vulkan handle only changes if it was destroyed and the slot reused
+                if ((record == nullptr) || (record->vkHandle != uploads[i].vkHandle))
+                {
+                    continue;
+                }
+
+                // Anything recorded against it from here on is ordered after the copy
+                record->residency = GpuResourceResidency::Resident;
+                targets[i] = *record;
+            }
+        }
+
+        FrameData& frame = currentFrame();
+        constexpr static VkCommandBufferBeginInfo beginInfo
+        {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            nullptr,
+            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            nullptr
+        };
+
+        VkResult result = vkBeginCommandBuffer(frame.uploadCmd, &beginInfo);
+        VkAssert(result);
+        frame.uploadsRecorded = true;
+
+        const uint32_t firstQuery = static_cast<uint32_t>((frameCounter % MaxFramesInFlight) * 2u);
+        frame.uploadsTimestamped = uploadQueryPool != VK_NULL_HANDLE;
+        if (frame.uploadsTimestamped)
+        {
+            vkCmdResetQueryPool(frame.uploadCmd, uploadQueryPool, firstQuery, 2u);
+            vkCmdWriteTimestamp(frame.uploadCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, uploadQueryPool, firstQuery);
+        }
+
+        std::vector<StagingBuffer> staging;
+        std::vector<CreationTrace> traces;
+        for (size_t i = 0u; i < uploads.size(); ++i)
+        {
+            ScheduledUpload& upload = uploads[i];
+            const ResourceRecord& target = targets[i];
+            if (target.vkHandle != 0u)
+            {
+                if (target.type == GpuResourceType::Buffer)
+                {
+                    vkCmdCopyBuffer(frame.uploadCmd, upload.source, (VkBuffer)target.vkHandle, static_cast<uint32_t>(upload.bufferRegions.size()), upload.bufferRegions.data());
+                }
+                else
+                {
+                    recordImageUpload(target, frame.uploadCmd, upload.source, static_cast<uint32_t>(upload.imageRegions.size()), upload.imageRegions.data());
+                }
+                frame.uploadBytes += upload.bytes;
+
+                if (upload.traced)
+                {
+                    upload.trace.mark(ResourceCreationEvent::State::Recorded);
+                    traces.emplace_back(upload.trace);
+                }
+            }
+
+            staging.insert(staging.end(), upload.staging.begin(), upload.staging.end());
+        }
+
+        if (frame.uploadsTimestamped)
+        {
+            vkCmdWriteTimestamp(frame.uploadCmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, uploadQueryPool, firstQuery + 1u);
+        }
+
+        // The copies reading from it are in this frame's batch now
+        releaseStaging(staging);
+
+        std::lock_guard destructionLock(destructionMutex);
+        frame.creationTraces.insert(frame.creationTraces.end(), traces.begin(), traces.end());
+    }
+
+    bool ResourceContextImpl::decompressToStaging(uint32_t num_data, const GpuCompressedResourceData* data, VkDeviceSize min_alignment, DecompressedUpload& upload)
+    {
+        // Resolved before anything is decoded, so the workers never need the lock
+        std::vector<DecompressionCodec> codecs(num_data);
+        {
+            std::shared_lock codecLock(codecMutex);
+            for (uint32_t i = 0u; i < num_data; ++i)
+            {
+                if (data[i].Codec == CompressionCodecs::Uncompressed)
+                {
+                    if (data[i].CompressedSize != data[i].DecompressedSize)
+                    {
+                        decompressionFailures.fetch_add(1u, std::memory_order_relaxed);
+                        return false;
+                    }
+                    continue;
+                }
+
+                auto iter = decompressionCodecs.find(data[i].Codec);
+                if (iter == decompressionCodecs.end())
+                {
+                    decompressionFailures.fetch_add(1u, std::memory_order_relaxed);
+                    return false;
+                }
+                codecs[i] = iter->second;
+            }
+        }
+
+        upload.offsets.resize(num_data);
+        upload.totalSize = 0u;
+        uint64_t compressedSize = 0u;
+        for (uint32_t i = 0u; i < num_data; ++i)
+        {
+            upload.offsets[i] = alignUp(upload.totalSize, std::max<VkDeviceSize>(data[i].Alignment, min_alignment));
+            upload.totalSize = upload.offsets[i] + data[i].DecompressedSize;
+            compressedSize += data[i].CompressedSize;
+        }
+
+        upload.staging = acquireStagingMemory(upload.totalSize, true);
+        if (upload.staging.buffer == VK_NULL_HANDLE)
+        {
+            return false;
+        }
+        std::byte* destination = reinterpret_cast<std::byte*>(upload.staging.mappedData);
+
+        // One entry per job: entries are independent streams, which is as finely as they can be split
+        std::atomic<bool> failed{ false };
+        const auto decodeStart = std::chrono::steady_clock::now();
+        decompressionPool.parallelFor(num_data, [&](uint32_t i)
+        {
+            if (failed.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+
+            bool decoded = true;
+            if (codecs[i].fn == nullptr)
+            {
+                memcpy(destination + upload.offsets[i], data[i].Data, data[i].DecompressedSize);
+            }
+            else
+            {
+                decoded = codecs[i].fn(data[i].Data, data[i].CompressedSize, destination + upload.offsets[i], data[i].DecompressedSize, codecs[i].userData);
+            }
+
+            if (!decoded)
+            {
+                failed.store(true, std::memory_order_relaxed);
+            }
+        });
+        const auto decodeTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - decodeStart);
+
+        if (failed.load(std::memory_order_relaxed))
+        {
+            // The staging allocation goes with the frame, like any other
+            decompressionFailures.fetch_add(1u, std::memory_order_relaxed);
+            return false;
+        }
+
+        // VMA skips this if the memory turned out to be coherent
+        VkResult result = vmaFlushAllocation(vmaAllocatorHandle, upload.staging.allocation, upload.staging.offset, upload.totalSize);
+        VkAssert(result);
+
+        decompressedBytes.fetch_add(upload.totalSize, std::memory_order_relaxed);
+        decompressionInputBytes.fetch_add(compressedSize, std::memory_order_relaxed);
+        decompressedEntries.fetch_add(num_data, std::memory_order_relaxed);
+        decompressionNanoseconds.fetch_add(static_cast<uint64_t>(decodeTime.count()), std::memory_order_relaxed);
+        markCreationState(ResourceCreationEvent::State::Staged);
+        return true;
+    }
+
+    ResourceContextImpl::StagingAllocation ResourceContextImpl::acquireStagingMemory(VkDeviceSize size, bool host_cached)
+    {
+        const GpuResourceMemoryDomain domain = host_cached ? GpuResourceMemoryDomain::HostCached : GpuResourceMemoryDomain::Host;
+        const VmaAllocationCreateInfo allocCreateInfo = allocationCreateInfo(domain, CreationFlagBits::ResourceCreatePersistentlyMapped);
+        StagingBuffer staging{};
+        VkResult result = stagingPool.acquire(vmaAllocatorHandle, size, host_cached, allocCreateInfo, staging);
+        if (outOfMemory(result))
+        {
+            // Left to the caller to fail whatever needed it
+            return StagingAllocation{};
+        }
+        VkAssert(result);
+
+        if (activeDeferredUploads != nullptr)
+        {
+            // Belongs to the creation's uploads, until the scheduler gets around to them
+            activeDeferredUploads->staging.emplace_back(staging);
+        }
+        else
+        {
+            // The copies reading from it are in this frame's batch, so it can be reused once the frame retires
+            std::lock_guard destructionLock(destructionMutex);
+            currentFrame().releasedStaging.emplace_back(staging);
+        }
+
+        return StagingAllocation{ staging.buffer, staging.allocation, 0u, staging.mappedData };
+    }
+
+    void ResourceContextImpl::releaseStaging(std::vector<StagingBuffer>& staging)
+    {
+        if (staging.empty())
+        {
+            return;
+        }
+
+        std::lock_guard destructionLock(destructionMutex);
+        std::vector<StagingBuffer>& released = currentFrame().releasedStaging;
+        released.insert(released.end(), staging.begin(), staging.end());
+        staging.clear();
+    }
+
+    VkCommandBuffer ResourceContextImpl::transferCommandBuffer()
+    {
+        FrameData& frame = currentFrame();
+        if (std::this_thread::get_id() == workQueueThreadID)
+        {
+            frame.hasCommands = true;
+            return frame.transferCmd;
+        }
+
+        ThreadCommandPools& pools = callingThreadPools();
+        const size_t frameIdx = frameCounter % MaxFramesInFlight;
+        if (pools.recordingFrame[frameIdx] != frameCounter)
+        {
+            // The pool was reset when this frame slot retired, so the command buffer is ready to begin again
+            constexpr static VkCommandBufferBeginInfo beginInfo
+            {
+                VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                nullptr,
+                VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+                nullptr
+            };
+
+            VkResult result = vkBeginCommandBuffer(pools.commandBuffers[frameIdx], &beginInfo);
+            VkAssert(result);
+            pools.recordingFrame[frameIdx] = frameCounter;
+
+            std::lock_guard poolsLock(threadPoolsMutex);
+            frame.threadCommandBuffers.emplace_back(pools.commandBuffers[frameIdx]);
+        }
+
+        return pools.commandBuffers[frameIdx];
+    }
+
+    ResourceContextImpl::ThreadCommandPools& ResourceContextImpl::callingThreadPools()
+    {
+        if (cachedThreadPools.instanceID == instanceID)
+        {
+            return *reinterpret_cast<ThreadCommandPools*>(cachedThreadPools.pools);
+        }
+
+        std::lock_guard poolsLock(threadPoolsMutex);
+        auto& pools = threadPools[std::this_thread::get_id()];
+        if (!pools)
+        {
+            pools = std::make_unique<ThreadCommandPools>();
+            pools->recordingFrame.fill(std::numeric_limits<uint64_t>::max());
+            for (size_t i = 0u; i < MaxFramesInFlight; ++i)
+            {
+                VkResult result = vkCreateCommandPool(logicalDevice->vkHandle(), &commandPoolInfo, nullptr, &pools->pools[i]);
+                VkAssert(result);
+
+                const VkCommandBufferAllocateInfo allocInfo
+                {
+                    VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                    nullptr,
+                    pools->pools[i],
+                    VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                    1u
+                };
+
+                result = vkAllocateCommandBuffers(logicalDevice->vkHandle(), &allocInfo, &pools->commandBuffers[i]);
+                VkAssert(result);
+            }
+        }
+
+        cachedThreadPools = ThreadPoolsCache{ instanceID, pools.get() };
+        return *pools;
+    }
+
+    bool ResourceContextImpl::directWriteEligible(GpuResourceMemoryDomain domain) const noexcept
+    {
+        // Host domains are already host visible, and LinkedDeviceHost already requires exactly these types
+        return directDeviceWrites && (domain == GpuResourceMemoryDomain::Device);
+    }
+
+    void ResourceContextImpl::shareWithTransferQueue(VkSharingMode& sharing_mode, uint32_t& num_families, const uint32_t*& families) const noexcept
+    {
+        // Cheaper than a release/acquire pair per upload, and we have no way to record the acquire on the graphics queue
+        if ((uploadQueueFamilyCount < 2u) || (sharing_mode == VK_SHARING_MODE_CONCURRENT))
+        {
+            return;
+        }
+
+        sharing_mode = VK_SHARING_MODE_CONCURRENT;
+        num_families = uploadQueueFamilyCount;
+        families = uploadQueueFamilies.data();
+    }
+
+    VmaAllocationCreateInfo ResourceContextImpl::allocationCreateInfo(GpuResourceMemoryDomain domain, GpuResourceCreationFlags flags) const noexcept
+    {
+        VmaAllocationCreateInfo result{};
+
+        switch (domain)
+        {
+        case GpuResourceMemoryDomain::Device:
+            result.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+            break;
+        case GpuResourceMemoryDomain::Host:
+            result.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+            break;
+        case GpuResourceMemoryDomain::HostCached:
+            result.usage = VMA_MEMORY_USAGE_GPU_TO_CPU;
+            result.preferredFlags = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+            break;
+        case GpuResourceMemoryDomain::LinkedDeviceHost:
+            result.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+            result.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+            break;
+        default:
+            result.usage = VMA_MEMORY_USAGE_UNKNOWN;
+            break;
+        }
+
+        if (flags & CreationFlagBits::ResourceCreateDedicatedMemory)
+        {
+            result.flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+        }
+
+        if (flags & CreationFlagBits::ResourceCreateNeverAllocate)
+        {
+            // Within budget makes VMA refuse instead of silently over-committing the heap
+            result.flags |= VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT | VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT;
+        }
+
+        if (flags & CreationFlagBits::ResourceCreatePersistentlyMapped)
+        {
+            // Device domain resources only end up mappable on UMA and ReBAR devices
+            result.flags |= VMA_ALLOCATION_CREATE_MAPPED_BIT;
+            result.preferredFlags |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+        }
+
+        if (flags & CreationFlagBits::ResourceCreateMemoryStrategyMinMemory)
+        {
+            result.flags |= VMA_ALLOCATION_CREATE_STRATEGY_MIN_MEMORY_BIT;
+        }
+        else if (flags & CreationFlagBits::ResourceCreateMemoryStrategyMinTime)
+        {
+            result.flags |= VMA_ALLOCATION_CREATE_STRATEGY_MIN_TIME_BIT;
+        }
+        else if (flags & CreationFlagBits::ResourceCreateMemoryStrategyMinFragmentation)
+        {
+            // VMA folded its fragmentation strategy into best-fit, which is the min memory strategy
+            result.flags |= VMA_ALLOCATION_CREATE_STRATEGY_MIN_MEMORY_BIT;
+        }
+
+        return result;
+    }
+
+    GpuResourceHandle ResourceContextImpl::allocateRecord(ResourceRecord&& record)
+    {
+        // Buffers and images mark this themselves, ahead of their uploads
+        markCreationState(ResourceCreationEvent::State::Allocated);
+        if (activeCreationTrace != nullptr)
+        {
+            activeCreationTrace->size = record.size;
+        }
+
+        std::unique_lock recordLock(recordMutex);
+
+        uint32_t slot = 0u;
+        if (!freeRecordSlots.empty())
+        {
+            slot = freeRecordSlots.back();
+            freeRecordSlots.pop_back();
+        }
+        else
+        {
+            slot = static_cast<uint32_t>(resourceRecords.size());
+            resourceRecords.emplace_back();
+        }
+
+        record.generation = resourceRecords[slot].generation;
+        resourceRecords[slot] = std::move(record);
+        const GpuResourceHandle handle = MakeHandle(slot, resourceRecords[slot].generation);
+        if (resourceRecords[slot].deviceAddress != 0u)
+        {
+            deviceAddresses.publish(handle, resourceRecords[slot].deviceAddress);
+        }
+        vulkanHandles.publish(handle, resourceRecords[slot].vkHandle);
+        return handle;
+    }
+
+    void ResourceContextImpl::discardRecord(ResourceRecord&& record)
+    {
+        // Its bindless slot may already have a write queued, so it can't be released until the frame retires either
+        std::lock_guard destructionLock(destructionMutex);
+        currentFrame().pendingDestruction.emplace_back(std::move(record));
+    }
+
+    ResourceRecord* ResourceContextImpl::lookupRecord(GpuResourceHandle handle)
+    {
+        const uint32_t slot = HandleSlot(handle);
+        if ((handle == INVALID_GPU_RESOURCE_HANDLE) || (slot >= resourceRecords.size()))
+        {
+            return nullptr;
+        }
+
+        ResourceRecord& record = resourceRecords[slot];
+        if ((record.generation != HandleGeneration(handle)) || (record.type == GpuResourceType::Invalid))
+        {
+            return nullptr;
+        }
+
+        return &record;
+    }
+
+    const ResourceRecord* ResourceContextImpl::lookupRecord(GpuResourceHandle handle) const
+    {
+        return const_cast<ResourceContextImpl*>(this)->lookupRecord(handle);
+    }
+
+    void ResourceContextImpl::destroyRecord(ResourceRecord& record)
+    {
+        // Only the record goes: the bindless slot is still ours to release
+        const GpuResourceType destroyedType = record.ownsHandle ? record.type : GpuResourceType::Invalid;
+        switch (destroyedType)
+        {
+        case GpuResourceType::Buffer:
+            if (record.vkHandle != 0u)
+            {
+                // Transient resources have no allocation of their own, so this only destroys the buffer
+                vmaDestroyBuffer(vmaAllocatorHandle, (VkBuffer)record.vkHandle, record.allocation);
+                releaseTransientResource(record);
+            }
+            break;
+        case GpuResourceType::Image:
+            if (record.vkHandle != 0u)
+            {
+                // Fallbacks for unsupported sparse images have some state to clean up too
+                destroySparseImageState((VkImage)record.vkHandle);
+                vmaDestroyImage(vmaAllocatorHandle, (VkImage)record.vkHandle, record.allocation);
+                releaseTransientResource(record);
+            }
+            break;
+        case GpuResourceType::SparseImage:
+            if (record.vkHandle != 0u)
+            {
+                destroySparseImageState((VkImage)record.vkHandle);
+                vkDestroyImage(logicalDevice->vkHandle(), (VkImage)record.vkHandle, nullptr);
+            }
+            break;
+        case GpuResourceType::Sampler:
+            vkDestroySampler(logicalDevice->vkHandle(), (VkSampler)record.vkHandle, nullptr);
+            break;
+        case GpuResourceType::ImageView:
+            vkDestroyImageView(logicalDevice->vkHandle(), (VkImageView)record.vkHandle, nullptr);
+            break;
+        case GpuResourceType::BufferView:
+            vkDestroyBufferView(logicalDevice->vkHandle(), (VkBufferView)record.vkHandle, nullptr);
+            break;
+        default:
+            break;
+        }
+
+        if (record.bindlessIndex != BindlessIndexInvalid)
+        {
+            // Deferred destruction got us here, so nothing in flight can still be reading the slot
+            std::lock_guard bindlessLock(bindlessMutex);
+            const uint32_t binding = record.type == GpuResourceType::Buffer ? BindlessStorageBufferBinding :
+                (record.type == GpuResourceType::Sampler ? BindlessSamplerBinding : BindlessSampledImageBinding);
+            bindlessHeap.release(binding, record.bindlessIndex);
+            record.bindlessIndex = BindlessIndexInvalid;
+        }
+
+        record.vkHandle = 0u;
+        record.allocation = VK_NULL_HANDLE;
+    }
+
+    void ResourceContextImpl::setObjectName(VkObjectType object_type, uint64_t handle, const char* name)
+    {
+        if (vkDebugFns.vkSetDebugUtilsObjectName == nullptr)
+        {
+            return;
+        }
+
+        const VkDebugUtilsObjectNameInfoEXT nameInfo
+        {
+            VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT,
+            nullptr,
+            object_type,
+            handle,
+            name
+        };
+
+        vkDebugFns.vkSetDebugUtilsObjectName(logicalDevice->vkHandle(), &nameInfo);
+    }
+
+    VkDeviceAddress ResourceContextImpl::bufferDeviceAddress(VkBuffer buffer) const noexcept
+    {
+        const VkBufferDeviceAddressInfo addressInfo
+        {
+            VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+            nullptr,
+            buffer
+        };
+
+        return vkGetBufferDeviceAddressFn(logicalDevice->vkHandle(), &addressInfo);
+    }
+
+    uint32_t ResourceContextImpl::registerBindless(uint32_t binding, uint64_t vk_handle)
+    {
+        std::lock_guard bindlessLock(bindlessMutex);
+        if (!bindlessHeap.valid())
+        {
+            return BindlessIndexInvalid;
+        }
+
+        const uint32_t index = bindlessHeap.acquire(binding);
+        if (index != BindlessIndexInvalid)
+        {
+            bindlessHeap.write(binding, index, vk_handle);
+        }
+        return index;
+    }
+
+    void ResourceContextImpl::flushBindlessWrites()
+    {
+        std::lock_guard bindlessLock(bindlessMutex);
+        bindlessHeap.flush(logicalDevice->vkHandle());
+    }
+
+    void ResourceContextImpl::setPersistentMapping(ResourceRecord& record)
+    {
+        if (!(record.flags & CreationFlagBits::ResourceCreatePersistentlyMapped))
+        {
+            return;
+        }
+
+        VmaAllocationInfo allocInfo{};
+        vmaGetAllocationInfo(vmaAllocatorHandle, record.allocation, &allocInfo);
+        VkMemoryPropertyFlags memoryFlags = 0u;
+        vmaGetAllocationMemoryProperties(vmaAllocatorHandle, record.allocation, &memoryFlags);
+        // VMA leaves pMappedData null if the memory type couldn't be mapped
+        record.mappedData = allocInfo.pMappedData;
+        record.hostCoherent = (memoryFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0u;
+    }
+
+    void ResourceContextImpl::flushMappedRanges()
+    {
+        {
+            std::lock_guard dirtyRangeLock(dirtyRangeMutex);
+            flushingRanges.swap(dirtyRanges);
+        }
+
+        if (flushingRanges.empty())
+        {
+            return;
+        }
+
+        {
+            // Destroyed resources are dropped: their memory sticks around until the frame retires, but nobody reads it
+            std::shared_lock recordLock(recordMutex);
+            for (auto& range : flushingRanges)
+            {
+                const ResourceRecord* record = lookupRecord(range.handle);
+                if ((record == nullptr) || (record->mappedData == nullptr) || record->hostCoherent || (range.offset >= record->size))
+                {
+                    range.allocation = VK_NULL_HANDLE;
+                    continue;
+                }
+
+                range.allocation = record->allocation;
+                range.size = (range.size == 0u) ? (record->size - range.offset) : std::min(range.size, record->size - range.offset);
+            }
+        }
+
+        // Overlapping and adjacent ranges of each allocation are merged, so each is flushed once
+        std::sort(flushingRanges.begin(), flushingRanges.end(), [](const DirtyMappedRange& lhs, const DirtyMappedRange& rhs)
+        {
+            return (lhs.allocation != rhs.allocation) ? std::less<VmaAllocation>{}(lhs.allocation, rhs.allocation) : (lhs.offset < rhs.offset);
+        });
+
+        flushAllocations.clear();
+        flushOffsets.clear();
+        flushSizes.clear();
+        for (const auto& range : flushingRanges)
+        {
+            if (range.allocation == VK_NULL_HANDLE)
+            {
+                continue;
+            }
+
+            if (!flushAllocations.empty() && (flushAllocations.back() == range.allocation) &&
+                (range.offset <= flushOffsets.back() + flushSizes.back()))
+            {
+                const VkDeviceSize end = std::max(flushOffsets.back() + flushSizes.back(), range.offset + range.size);
+                flushSizes.back() = end - flushOffsets.back();
+                continue;
+            }
+
+            flushAllocations.emplace_back(range.allocation);
+            flushOffsets.emplace_back(range.offset);
+            flushSizes.emplace_back(range.size);
+        }
+        flushingRanges.clear();
+
+        if (!flushAllocations.empty())
+        {
+            // VMA rounds each range out to nonCoherentAtomSize
+            VkResult result = vmaFlushAllocations(vmaAllocatorHandle, static_cast<uint32_t>(flushAllocations.size()), flushAllocations.data(),
+                flushOffsets.data(), flushSizes.data());
+            VkAssert(result);
+        }
+    }
+
+    void ResourceContextImpl::nameRecord(ResourceRecord& record, VkObjectType object_type, const char* name)
+    {
+        record.debugName = name;
+        setObjectName(object_type, record.vkHandle, name);
+        if (record.allocation != VK_NULL_HANDLE)
+        {
+            // Shows up in vmaBuildStatsString(), and so in WriteMemoryStatsFile()
+            vmaSetAllocationName(vmaAllocatorHandle, record.allocation, name);
+        }
+    }
+
+    void ResourceContextImpl::beginFrame()
+    {
+        FrameData& frame = currentFrame();
+
+        if (frame.submitted)
+        {
+            // Submitted MaxFramesInFlight - 1 frames ago, so this is almost always already signaled
+            VkResult result = vkWaitForFences(logicalDevice->vkHandle(), 1u, &frame.fence, VK_TRUE, UINT64_MAX);
+            VkAssert(result);
+            result = vkResetFences(logicalDevice->vkHandle(), 1u, &frame.fence);
+            VkAssert(result);
+            frame.submitted = false;
+        }
+
+        if (frame.sparseSubmitted)
+        {
+            VkResult result = vkWaitForFences(logicalDevice->vkHandle(), 1u, &frame.sparseFence, VK_TRUE, UINT64_MAX);
+            VkAssert(result);
+            result = vkResetFences(logicalDevice->vkHandle(), 1u, &frame.sparseFence);
+            VkAssert(result);
+            frame.sparseSubmitted = false;
+        }
+
+        retireFrame(frame);
+
+        VkResult result = vkResetCommandPool(logicalDevice->vkHandle(), frame.commandPool, 0);
+        VkAssert(result);
+
+        {
+            // Every thread's pool for this slot goes at once: none of them can be recording, since we hold frameMutex
+            const size_t frameIdx = frameCounter % MaxFramesInFlight;
+            std::lock_guard poolsLock(threadPoolsMutex);
+            for (auto& [threadID, pools] : threadPools)
+            {
+                if (pools->recordingFrame[frameIdx] != std::numeric_limits<uint64_t>::max())
+                {
+                    result = vkResetCommandPool(logicalDevice->vkHandle(), pools->pools[frameIdx], 0);
+                    VkAssert(result);
+                }
+            }
+            frame.threadCommandBuffers.clear();
+        }
+
+        constexpr static VkCommandBufferBeginInfo beginInfo
+        {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            nullptr,
+            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            nullptr
+        };
+
+        result = vkBeginCommandBuffer(frame.transferCmd, &beginInfo);
+        VkAssert(result);
+        frame.hasCommands = false;
+    }
+
+    void ResourceContextImpl::submitFrame()
+    {
+        FrameData& frame = currentFrame();
+        VkResult result = vkEndCommandBuffer(frame.transferCmd);
+        VkAssert(result);
+
+        // Other threads' uploads go first, so this frame's modifications and readbacks see them
+        std::vector<VkCommandBuffer> commandBuffers;
+        {
+            std::lock_guard poolsLock(threadPoolsMutex);
+            commandBuffers = frame.threadCommandBuffers;
+        }
+        // Scheduled uploads go ahead of even those, as they're for resources created in earlier frames
+        if (frame.uploadsRecorded)
+        {
+            commandBuffers.insert(commandBuffers.begin(), frame.uploadCmd);
+        }
+        for (auto& cmd : commandBuffers)
+        {
+            result = vkEndCommandBuffer(cmd);
+            VkAssert(result);
+        }
+        commandBuffers.emplace_back(frame.transferCmd);
+
+        std::vector<VkSemaphore> waitSemaphores;
+        std::vector<VkPipelineStageFlags> waitStages;
+        if (frame.sparseSubmitted)
+        {
+            waitSemaphores.emplace_back(frame.sparseSemaphore);
+            waitStages.emplace_back(VK_PIPELINE_STAGE_TRANSFER_BIT);
+        }
+
+        {
+            std::lock_guard readbackLock(readbackMutex);
+            for (const auto& [semaphore, stages] : pendingTransferWaits)
+            {
+                waitSemaphores.emplace_back(semaphore);
+                waitStages.emplace_back(stages);
+            }
+            pendingTransferWaits.clear();
+        }
+
+        // Even without any commands, pending semaphores have to be waited on before they're signaled again
+        if (!frame.hasCommands && (commandBuffers.size() == 1u) && waitSemaphores.empty())
+        {
+            return;
+        }
+
+        const VkSubmitInfo submitInfo
+        {
+            VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            nullptr,
+            static_cast<uint32_t>(waitSemaphores.size()),
+            waitSemaphores.data(),
+            waitStages.data(),
+            static_cast<uint32_t>(commandBuffers.size()),
+            commandBuffers.data(),
+            0u,
+            nullptr
+        };
+
+        result = vkQueueSubmit(logicalDevice->TransferQueue(), 1u, &submitInfo, frame.fence);
+        VkAssert(result);
+        frame.submitted = true;
+
+        std::lock_guard destructionLock(destructionMutex);
+        for (auto& trace : frame.creationTraces)
+        {
+            trace.mark(ResourceCreationEvent::State::Submitted);
+        }
+    }
+
+    void ResourceContextImpl::retireFrame(FrameData& frame)
+    {
+        if (frame.uploadsTimestamped)
+        {
+            // The fence has signaled, so these are available without waiting
+            const uint32_t firstQuery = static_cast<uint32_t>((&frame - frames.data()) * 2u);
+            uint64_t timestamps[2]{};
+            const VkResult result = vkGetQueryPoolResults(logicalDevice->vkHandle(), uploadQueryPool, firstQuery, 2u, sizeof(timestamps), timestamps,
+                sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+            if (result == VK_SUCCESS)
+            {
+                // Masked, in case the counter wrapped between the two
+                const uint64_t ticks = (timestamps[1] - timestamps[0]) & timestampMask;
+                uploadScheduler.recordThroughput(frame.uploadBytes, static_cast<uint64_t>(static_cast<double>(ticks) * timestampPeriod));
+            }
+        }
+        frame.uploadsRecorded = false;
+        frame.uploadsTimestamped = false;
+        frame.uploadBytes = 0u;
+
+        {
+            std::lock_guard arenaLock(arenaMutex);
+            frame.messageArena.reset();
+        }
+
+        std::vector<ResourceRecord> toDestroy;
+        std::vector<StagingBuffer> staging;
+        {
+            std::lock_guard destructionLock(destructionMutex);
+            toDestroy.swap(frame.pendingDestruction);
+            staging.swap(frame.releasedStaging);
+        }
+
+        for (const auto& buffer : staging)
+        {
+            stagingPool.release(buffer, frameCounter);
+        }
+
+        // Freed outside the pool's lock, so acquires on other threads don't wait on VMA
+        staging.clear();
+        stagingPool.trim(frameCounter, staging);
+        for (const auto& buffer : staging)
+        {
+            vmaDestroyBuffer(vmaAllocatorHandle, buffer.buffer, buffer.allocation);
+        }
+
+        for (auto& record : toDestroy)
+        {
+            destroyRecord(record);
+        }
+
+        for (auto& upload : frame.importedUploads)
+        {
+            vkDestroyBuffer(logicalDevice->vkHandle(), upload.buffer, nullptr);
+            vkFreeMemory(logicalDevice->vkHandle(), upload.memory, nullptr);
+        }
+        // Unmaps the files too
+        frame.importedUploads.clear();
+        completeReadbacks(frame);
+
+        std::vector<CreationTrace> traces;
+        {
+            std::lock_guard destructionLock(destructionMutex);
+            traces.swap(frame.creationTraces);
+            frame.tracesGpuComplete = false;
+        }
+        CreationTraceBuffer* traceBuffer = creationTraceBuffer.load(std::memory_order_acquire);
+        for (auto& trace : traces)
+        {
+            // Still set if the fence signaled after the last poll: we only know it's done now
+            trace.mark(ResourceCreationEvent::State::GpuComplete);
+            trace.mark(ResourceCreationEvent::State::Retired);
+            if (traceBuffer != nullptr)
+            {
+                traceBuffer->push(trace);
+            }
+        }
+
+        std::lock_guard sparseLock(sparseMutex);
+        for (auto& page : frame.releasedPages)
+        {
+            sparsePagePool.release(vmaAllocatorHandle, page);
+        }
+        frame.releasedPages.clear();
+    }
+
+    ResourceContextImpl::FrameData& ResourceContextImpl::currentFrame() noexcept
+    {
+        return frames[frameCounter % MaxFramesInFlight];
+    }
+
+    MemoryBudgetPolicy ResourceContextImpl::currentBudgetPolicy() const
+    {
+        std::lock_guard policyLock(budgetPolicyMutex);
+        return budgetPolicy;
+    }
+
+    void ResourceContextImpl::enforceMemoryBudget()
+    {
+        const MemoryBudgetPolicy policy = currentBudgetPolicy();
+        std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> heapBudgets{};
+        vmaGetHeapBudgets(vmaAllocatorHandle, heapBudgets.data());
+
+        // How far over the eviction threshold each device-local heap is: zero if it's fine
+        std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> excessBytes{};
+        bool anyOverBudget = false;
+        for (uint32_t i = 0u; i < memoryProperties.memoryHeapCount; ++i)
+        {
+            if (!(memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT))
+            {
+                continue;
+            }
+
+            const VkDeviceSize threshold = static_cast<VkDeviceSize>(static_cast<double>(heapBudgets[i].budget) * static_cast<double>(policy.EvictionThreshold));
+            if (heapBudgets[i].usage > threshold)
+            {
+                excessBytes[i] = heapBudgets[i].usage - threshold;
+                anyOverBudget = true;
+            }
+        }
+
+        if (!anyOverBudget || (policy.MaxEvictionsPerFrame == 0u))
+        {
+            return;
+        }
+
+        struct EvictionCandidate
+        {
+            GpuResourceHandle handle;
+            uint32_t heapIdx;
+            VkDeviceSize size;
+        };
+
+        std::vector<EvictionCandidate> candidates;
+        {
+            std::shared_lock recordLock(recordMutex);
+            for (uint32_t slot = 0u; slot < static_cast<uint32_t>(resourceRecords.size()); ++slot)
+            {
+                const ResourceRecord& record = resourceRecords[slot];
+                // Sparse images manage their own residency, and have no single allocation to evict
+                if ((record.residency != GpuResourceResidency::Resident) || !(record.flags & CreationFlagBits::ResourceCreateEvictable) ||
+                    (record.allocation == VK_NULL_HANDLE) || (record.viewCount != 0u) || (record.mappedData != nullptr))
+                {
+                    continue;
+                }
+
+                VmaAllocationInfo allocInfo{};
+                vmaGetAllocationInfo(vmaAllocatorHandle, record.allocation, &allocInfo);
+                const uint32_t heapIdx = memoryProperties.memoryTypes[allocInfo.memoryType].heapIndex;
+                if (excessBytes[heapIdx] != 0u)
+                {
+                    candidates.emplace_back(EvictionCandidate{ MakeHandle(slot, record.generation), heapIdx, allocInfo.size });
+                }
+            }
+        }
+
+        // Largest first: frees the most memory for the fewest copies
+        std::sort(candidates.begin(), candidates.end(), [](const EvictionCandidate& lhs, const EvictionCandidate& rhs)
+        {
+            return lhs.size > rhs.size;
+        });
+
+        if (policy.DemoteToHost && !candidates.empty())
+        {
+            // Demotions copy out of the device buffers, so whatever earlier frames still in flight do to them has to finish
+            // first. Waited on before taking the lock, so lookups aren't held up by it
+            for (FrameData& frame : frames)
+            {
+                if (frame.submitted)
+                {
+                    VkResult result = vkWaitForFences(logicalDevice->vkHandle(), 1u, &frame.fence, VK_TRUE, UINT64_MAX);
+                    VkAssert(result);
+                }
+            }
+        }
+
+        uint32_t numEvicted = 0u;
+        std::unique_lock recordLock(recordMutex);
+        for (const auto& candidate : candidates)
+        {
+            if (numEvicted >= policy.MaxEvictionsPerFrame)
+            {
+                break;
+            }
+
+            if (excessBytes[candidate.heapIdx] == 0u)
+            {
+                continue;
+            }
+
+            // Could've been destroyed or evicted while we weren't holding the lock
+            ResourceRecord* record = lookupRecord(candidate.handle);
+            if ((record == nullptr) || (record->residency != GpuResourceResidency::Resident))
+            {
+                continue;
+            }
+
+            const bool demoted = policy.DemoteToHost && (record->type == GpuResourceType::Buffer) && demoteBufferToHost(*record);
+            if (demoted)
+            {
+                vulkanHandles.publish(candidate.handle, record->vkHandle);
+            }
+            else
+            {
+                releaseRecord(*record);
+                vulkanHandles.retract(candidate.handle);
+            }
+
+            if (record->deviceAddress != 0u)
+            {
+                record->deviceAddress = demoted ? bufferDeviceAddress((VkBuffer)record->vkHandle) : 0u;
+                if (demoted)
+                {
+                    deviceAddresses.publish(candidate.handle, record->deviceAddress);
+                }
+                else
+                {
+                    deviceAddresses.retract(candidate.handle);
+                }
+            }
+
+            excessBytes[candidate.heapIdx] -= std::min(excessBytes[candidate.heapIdx], candidate.size);
+            ++numEvicted;
+        }
+    }
+
+    bool ResourceContextImpl::demoteBufferToHost(ResourceRecord& record)
+    {
+        if (hostOnlyMemoryTypeBits == 0u)
+        {
+            // Everything is device local (integrated GPUs): nowhere to demote to
+            return false;
+        }
+
+        VmaAllocationCreateInfo allocCreateInfo{};
+        allocCreateInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+        allocCreateInfo.memoryTypeBits = hostOnlyMemoryTypeBits;
+
+        VkBuffer hostBuffer{ VK_NULL_HANDLE };
+        VmaAllocation hostAllocation{ VK_NULL_HANDLE };
+        // Shared with the same queues as the buffer it replaces
+        VkBufferCreateInfo hostInfo = record.bufferInfo;
+        hostInfo.pQueueFamilyIndices = record.queueFamilies.data();
+        VkResult result = vmaCreateBuffer(vmaAllocatorHandle, &hostInfo, &allocCreateInfo, &hostBuffer, &hostAllocation, nullptr);
+        if (result != VK_SUCCESS)
+        {
+            return false;
+        }
+
+        // Earlier frames were waited on by enforceMemoryBudget(), and this barrier covers transfers recorded ahead of us in
+        // this one. Evictable resources are expected to be read-mostly: writes from other queues may not make it into the copy
+        FrameData& frame = currentFrame();
+        constexpr static VkMemoryBarrier transferBarrier
+        {
+            VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            nullptr,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_TRANSFER_READ_BIT
+        };
+        vkCmdPipelineBarrier(frame.transferCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1u, &transferBarrier, 0u, nullptr, 0u, nullptr);
+        const VkBufferCopy copyRegion{ 0u, 0u, record.size };
+        vkCmdCopyBuffer(frame.transferCmd, (VkBuffer)record.vkHandle, hostBuffer, 1u, &copyRegion);
+        frame.hasCommands = true;
+
+        ResourceRecord deviceCopy = record;
+        deviceCopy.bindlessIndex = BindlessIndexInvalid;
+        record.vkHandle = (uint64_t)hostBuffer;
+        record.allocation = hostAllocation;
+        record.memoryDomain = GpuResourceMemoryDomain::Host;
+        record.residency = GpuResourceResidency::DemotedToHost;
+        if (!record.debugName.empty())
+        {
+            setObjectName(VK_OBJECT_TYPE_BUFFER, record.vkHandle, record.debugName.c_str());
+            vmaSetAllocationName(vmaAllocatorHandle, hostAllocation, record.debugName.c_str());
+        }
+
+        if (record.bindlessIndex != BindlessIndexInvalid)
+        {
+            // Same slot, now pointing at the host copy
+            std::lock_guard bindlessLock(bindlessMutex);
+            bindlessHeap.write(BindlessStorageBufferBinding, record.bindlessIndex, record.vkHandle);
+        }
+
+        std::lock_guard destructionLock(destructionMutex);
+        frame.pendingDestruction.emplace_back(std::move(deviceCopy));
+        return true;
+    }
+
+    void ResourceContextImpl::releaseRecord(ResourceRecord& record)
+    {
+        ResourceRecord released = record;
+        // The slot stays with the handle
+        released.bindlessIndex = BindlessIndexInvalid;
+        record.vkHandle = 0u;
+        record.allocation = VK_NULL_HANDLE;
+        record.residency = GpuResourceResidency::Released;
+
+        std::lock_guard destructionLock(destructionMutex);
+        currentFrame().pendingDestruction.emplace_back(std::move(released));
+    }
+
+    void ResourceContextImpl::sampleMemoryStats()
+    {
+        {
+            std::lock_guard snapshotLock(snapshotMutex);
+            if (!snapshotRing.sampleDue(frameCounter))
+            {
+                return;
+            }
+        }
+
+        // Only what's cheap to gather: VMA keeps the heap totals as it goes, unlike vmaCalculateStatistics()
+        MemoryStatsSample sample;
+        sample.FrameIndex = frameCounter;
+        sample.Timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+
+        std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> heapBudgets{};
+        vmaGetHeapBudgets(vmaAllocatorHandle, heapBudgets.data());
+        sample.HeapCount = std::min(memoryProperties.memoryHeapCount, MemoryStatsMaxHeaps);
+        for (uint32_t i = 0u; i < sample.HeapCount; ++i)
+        {
+            sample.HeapBlockBytes[i] = heapBudgets[i].statistics.blockBytes;
+            sample.HeapAllocationBytes[i] = heapBudgets[i].statistics.allocationBytes;
+            sample.HeapUsage[i] = heapBudgets[i].usage;
+            sample.HeapBudget[i] = heapBudgets[i].budget;
+            sample.HeapAllocationCount[i] = heapBudgets[i].statistics.allocationCount;
+        }
+
+        {
+            std::shared_lock recordLock(recordMutex);
+            for (const auto& record : resourceRecords)
+            {
+                if (record.type == GpuResourceType::Invalid)
+                {
+                    continue;
+                }
+
+                ++sample.LiveResources;
+                if ((record.residency == GpuResourceResidency::DemotedToHost) || (record.residency == GpuResourceResidency::Released))
+                {
+                    ++sample.EvictedResources;
+                }
+
+                const uint32_t domainIdx = static_cast<uint32_t>(record.memoryDomain);
+                if ((record.allocation != VK_NULL_HANDLE) && (record.transientGroup == std::numeric_limits<uint32_t>::max()) &&
+                    (domainIdx < MemoryStatsDomainCount))
+                {
+                    sample.DomainBytes[domainIdx] += record.size;
+                    ++sample.DomainResources[domainIdx];
+                }
+            }
+        }
+
+        std::lock_guard snapshotLock(snapshotMutex);
+        snapshotRing.push(sample);
+    }
+
+    void ResourceContextImpl::requestSparsePages(GpuResourceHandle handle, uint32_t num_requests, const SparseImagePageRequest* requests)
+    {
+        std::lock_guard sparseLock(sparseMutex);
+        for (uint32_t i = 0u; i < num_requests; ++i)
+        {
+            pendingPageRequests.emplace_back(handle, requests[i]);
+        }
+    }
+
+    SparseResidencyStats ResourceContextImpl::sparseResidencyStats(GpuResourceHandle handle) const
+    {
+        SparseResidencyStats result;
+
+        std::shared_lock recordLock(recordMutex);
+        const ResourceRecord* record = lookupRecord(handle);
+        if (record == nullptr)
+        {
+            return result;
+        }
+
+        std::lock_guard sparseLock(sparseMutex);
+        auto iter = sparseImages.find(record->vkHandle);
+        if (iter == sparseImages.cend())
+        {
+            return result;
+        }
+
+        const SparseImageState& state = iter->second;
+        if (state.isFallback)
+        {
+            // Fallbacks are a single, always resident "tile"
+            result.TotalTiles = 1u;
+            result.ResidentTiles = 1u;
+            result.CommittedBytes = record->size;
+            result.IsFallback = true;
+            return result;
+        }
+
+        result.TileWidth = state.granularity.width;
+        result.TileHeight = state.granularity.height;
+        result.TileDepth = state.granularity.depth;
+        result.TotalTiles = state.tilesPerLayer * state.arrayLayers;
+        result.ResidentTiles = state.residentTiles;
+        result.PageSize = state.pageRequirements.size;
+        result.CommittedBytes = (state.residentTiles * state.pageRequirements.size) + (state.mipTailCount() * state.mipTailSize);
+        result.PooledPages = sparsePagePool.pooledPageCount(vmaAllocatorHandle, state.pageRequirements);
+        return result;
+    }
+
+    GpuResourceHandle ResourceContextImpl::createSparseImage(const ResourceCreationMessage& message)
+    {
+        const VkImageCreateInfo& requestedInfo = *reinterpret_cast<const VkImageCreateInfo*>(message.Info);
+        if (!sparseImageSupported(requestedInfo))
+        {
+            return createSparseFallbackImage(message);
+        }
+
+        VkImageCreateInfo createInfo = requestedInfo;
+        createInfo.flags |= VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT;
+
+        VkImage image{ VK_NULL_HANDLE };
+        VkResult result = vkCreateImage(logicalDevice->vkHandle(), &createInfo, nullptr, &image);
+        if (outOfMemory(result))
+        {
+            return INVALID_GPU_RESOURCE_HANDLE;
+        }
+        VkAssert(result);
+
+        SparseImageState state;
+        if (!state.initialize(logicalDevice->vkHandle(), image, createInfo))
+        {
+            vkDestroyImage(logicalDevice->vkHandle(), image, nullptr);
+            return createSparseFallbackImage(message);
+        }
+
+        // Mip tails are small and needed for any sampling at a distance, so they're committed up front
+        VkMemoryRequirements mipTailRequirements = state.pageRequirements;
+        mipTailRequirements.size = state.mipTailSize;
+        VmaAllocationCreateInfo mipTailCreateInfo{};
+        mipTailCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+        std::vector<std::pair<VkImage, VkSparseMemoryBind>> mipTailBinds;
+        for (uint32_t i = 0u; i < state.mipTailCount(); ++i)
+        {
+            result = vmaAllocateMemory(vmaAllocatorHandle, &mipTailRequirements, &mipTailCreateInfo, &state.mipTailPages[i], nullptr);
+            if (result != VK_SUCCESS)
+            {
+                for (auto& page : state.mipTailPages)
+                {
+                    if (page != VK_NULL_HANDLE)
+                    {
+                        vmaFreeMemory(vmaAllocatorHandle, page);
+                    }
+                }
+                vkDestroyImage(logicalDevice->vkHandle(), image, nullptr);
+                return INVALID_GPU_RESOURCE_HANDLE;
+            }
+
+            VmaAllocationInfo allocInfo{};
+            vmaGetAllocationInfo(vmaAllocatorHandle, state.mipTailPages[i], &allocInfo);
+            mipTailBinds.emplace_back(image, VkSparseMemoryBind{ state.mipTailResourceOffset(i), state.mipTailSize, allocInfo.deviceMemory, allocInfo.offset, 0 });
+        }
+
+        ResourceRecord record;
+        record.type = GpuResourceType::SparseImage;
+        record.memoryDomain = GpuResourceMemoryDomain::Device;
+        record.residency = GpuResourceResidency::Resident;
+        record.flags = message.Flags;
+        record.vkHandle = (uint64_t)image;
+        record.imageInfo = createInfo;
+        record.imageInfo.pNext = nullptr;
+        keepQueueFamilies(record.imageInfo, record.queueFamilies);
+
+        {
+            std::lock_guard sparseLock(sparseMutex);
+            sparseImages.emplace(record.vkHandle, std::move(state));
+            pendingMipTailBinds.insert(pendingMipTailBinds.end(), mipTailBinds.begin(), mipTailBinds.end());
+        }
+
+        if ((message.Flags & CreationFlagBits::ResourceCreateUserDataAsString) && (message.UserData != nullptr))
+        {
+            nameRecord(record, VK_OBJECT_TYPE_IMAGE, reinterpret_cast<const char*>(message.UserData));
+        }
+
+        return allocateRecord(std::move(record));
+    }
+
+    GpuResourceHandle ResourceContextImpl::createSparseFallbackImage(const ResourceCreationMessage& message)
+    {
+        ResourceCreationMessage fallbackMessage = message;
+        fallbackMessage.Type = GpuResourceType::Image;
+        const GpuResourceHandle handle = createImage(fallbackMessage);
+        if (handle == INVALID_GPU_RESOURCE_HANDLE)
+        {
+            return handle;
+        }
+
+        std::shared_lock recordLock(recordMutex);
+        const ResourceRecord* record = lookupRecord(handle);
+
+        // Page requests against this are ignored, and stats report it as fully resident
+        SparseImageState state;
+        state.image = (VkImage)record->vkHandle;
+        state.extent = record->imageInfo.extent;
+        state.isFallback = true;
+
+        std::lock_guard sparseLock(sparseMutex);
+        sparseImages.emplace(record->vkHandle, std::move(state));
+        return handle;
+    }
+
+    bool ResourceContextImpl::sparseImageSupported(const VkImageCreateInfo& info) const
+    {
+        if (!sparseResidencySupported || (info.samples != VK_SAMPLE_COUNT_1_BIT))
+        {
+            return false;
+        }
+
+        if (((info.imageType == VK_IMAGE_TYPE_2D) && !deviceFeatures.sparseResidencyImage2D) ||
+            ((info.imageType == VK_IMAGE_TYPE_3D) && !deviceFeatures.sparseResidencyImage3D) ||
+            (info.imageType == VK_IMAGE_TYPE_1D))
+        {
+            return false;
+        }
+
+        uint32_t propertyCount = 0u;
+        vkGetPhysicalDeviceSparseImageFormatProperties(physicalDevice->vkHandle(), info.format, info.imageType, info.samples, info.usage, info.tiling, &propertyCount, nullptr);
+        return propertyCount != 0u;
+    }
+
+    void ResourceContextImpl::processSparseBindings()
+    {
+        std::vector<std::pair<GpuResourceHandle, SparseImagePageRequest>> requests;
+        std::vector<std::pair<VkImage, VkSparseMemoryBind>> mipTailBinds;
+        {
+            std::lock_guard sparseLock(sparseMutex);
+            requests.swap(pendingPageRequests);
+            mipTailBinds.swap(pendingMipTailBinds);
+        }
+
+        if (requests.empty() && mipTailBinds.empty())
+        {
+            return;
+        }
+
+        FrameData& frame = currentFrame();
+        std::unordered_map<VkImage, std::vector<VkSparseImageMemoryBind>> imageBinds;
+        std::unordered_map<VkImage, std::vector<VkSparseMemoryBind>> opaqueBinds;
+
+        for (const auto& [image, bind] : mipTailBinds)
+        {
+            opaqueBinds[image].emplace_back(bind);
+        }
+
+        {
+            std::shared_lock recordLock(recordMutex);
+            std::lock_guard sparseLock(sparseMutex);
+
+            for (const auto& [handle, request] : requests)
+            {
+                const ResourceRecord* record = lookupRecord(handle);
+                if ((record == nullptr) || (record->type != GpuResourceType::SparseImage))
+                {
+                    continue;
+                }
+
+                auto iter = sparseImages.find(record->vkHandle);
+                if ((iter == sparseImages.end()) || iter->second.isFallback)
+                {
+                    continue;
+                }
+
+                SparseImageState& state = iter->second;
+                const uint64_t tileIdx = state.tileIndex(request);
+                if (tileIdx == SparseImageState::TileIndexInvalid)
+                {
+                    continue;
+                }
+
+                VmaAllocation& page = state.tilePages[tileIdx];
+                if (request.Commit && (page == VK_NULL_HANDLE))
+                {
+                    page = sparsePagePool.acquire(vmaAllocatorHandle, state.pageRequirements);
+                    if (page == VK_NULL_HANDLE)
+                    {
+                        continue;
+                    }
+
+                    VmaAllocationInfo allocInfo{};
+                    vmaGetAllocationInfo(vmaAllocatorHandle, page, &allocInfo);
+                    imageBinds[state.image].emplace_back(state.tileBind(request, allocInfo.deviceMemory, allocInfo.offset));
+                    ++state.residentTiles;
+                }
+                else if (!request.Commit && (page != VK_NULL_HANDLE))
+                {
+                    // Previous frames may still be sampling the tile, so the page isn't reusable until we retire
+                    imageBinds[state.image].emplace_back(state.tileBind(request, VK_NULL_HANDLE, 0u));
+                    frame.releasedPages.emplace_back(page);
+                    page = VK_NULL_HANDLE;
+                    --state.residentTiles;
+                }
+            }
+        }
+
+        if (imageBinds.empty() && opaqueBinds.empty())
+        {
+            return;
+        }
+
+        std::vector<VkSparseImageMemoryBindInfo> imageBindInfos;
+        imageBindInfos.reserve(imageBinds.size());
+        for (const auto& [image, binds] : imageBinds)
+        {
+            imageBindInfos.emplace_back(VkSparseImageMemoryBindInfo{ image, static_cast<uint32_t>(binds.size()), binds.data() });
+        }
+
+        std::vector<VkSparseImageOpaqueMemoryBindInfo> opaqueBindInfos;
+        opaqueBindInfos.reserve(opaqueBinds.size());
+        for (const auto& [image, binds] : opaqueBinds)
+        {
+            opaqueBindInfos.emplace_back(VkSparseImageOpaqueMemoryBindInfo{ image, static_cast<uint32_t>(binds.size()), binds.data() });
+        }
+
+        const VkBindSparseInfo bindSparseInfo
+        {
+            VK_STRUCTURE_TYPE_BIND_SPARSE_INFO,
+            nullptr,
+            0u,
+            nullptr,
+            0u,
+            nullptr,
+            static_cast<uint32_t>(opaqueBindInfos.size()),
+            opaqueBindInfos.data(),
+            static_cast<uint32_t>(imageBindInfos.size()),
+            imageBindInfos.data(),
+            1u,
+            &frame.sparseSemaphore
+        };
+
+        VkResult result = vkQueueBindSparse(sparseBindingQueue, 1u, &bindSparseInfo, frame.sparseFence);
+        VkAssert(result);
+        frame.sparseSubmitted = true;
+    }
+
+    void ResourceContextImpl::destroySparseImageState(VkImage image)
+    {
+        std::lock_guard sparseLock(sparseMutex);
+        auto iter = sparseImages.find((uint64_t)image);
+        if (iter == sparseImages.end())
+        {
+            return;
+        }
+
+        // Called once the image's last frame has retired, so its pages can go straight back into the pool
+        for (auto& page : iter->second.tilePages)
+        {
+            if (page != VK_NULL_HANDLE)
+            {
+                sparsePagePool.release(vmaAllocatorHandle, page);
+            }
+        }
+
+        for (auto& page : iter->second.mipTailPages)
+        {
+            if (page != VK_NULL_HANDLE)
+            {
+                vmaFreeMemory(vmaAllocatorHandle, page);
+            }
+        }
+
+        sparseImages.erase(iter);
+    }
+
+    bool ResourceContextImpl::createTransientResources(uint32_t num_resources, const TransientResourceDesc* descs, GpuResourceHandle* handles, TransientMemoryStats* stats)
+    {
+        std::vector<uint64_t> vkHandles(num_resources, 0u);
+        std::vector<TransientAllocationRequest> requests(num_resources);
+        std::vector<VmaAllocation> heaps;
+
+        auto destroyCreated = [&]()
+        {
+            for (uint32_t i = 0u; i < num_resources; ++i)
+            {
+                if (vkHandles[i] == 0u)
+                {
+                    continue;
+                }
+
+                if (descs[i].Type == GpuResourceType::Buffer)
+                {
+                    vkDestroyBuffer(logicalDevice->vkHandle(), (VkBuffer)vkHandles[i], nullptr);
+                }
+                else
+                {
+                    vkDestroyImage(logicalDevice->vkHandle(), (VkImage)vkHandles[i], nullptr);
+                }
+            }
+
+            for (auto& heap : heaps)
+            {
+                vmaFreeMemory(vmaAllocatorHandle, heap);
+            }
+        };
+
+        bool hasBuffers = false;
+        bool hasImages = false;
+        for (uint32_t i = 0u; i < num_resources; ++i)
+        {
+            const TransientResourceDesc& desc = descs[i];
+            VkMemoryRequirements requirements{};
+            VkResult result = VK_SUCCESS;
+
+            if (desc.Type == GpuResourceType::Buffer)
+            {
+                VkBufferCreateInfo bufferInfo = *reinterpret_cast<const VkBufferCreateInfo*>(desc.Info);
+                if (desc.Flags & CreationFlagBits::ResourceCreateDeviceAddress)
+                {
+                    if (!bufferDeviceAddressSupported)
+                    {
+                        destroyCreated();
+                        return false;
+                    }
+                    bufferInfo.usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+                }
+
+                VkBuffer buffer{ VK_NULL_HANDLE };
+                result = vkCreateBuffer(logicalDevice->vkHandle(), &bufferInfo, nullptr, &buffer);
+                if (result != VK_SUCCESS)
+                {
+                    destroyCreated();
+                    return false;
+                }
+                vkGetBufferMemoryRequirements(logicalDevice->vkHandle(), buffer, &requirements);
+                vkHandles[i] = (uint64_t)buffer;
+                hasBuffers = true;
+            }
+            else if (desc.Type == GpuResourceType::Image)
+            {
+                VkImage image{ VK_NULL_HANDLE };
+                result = vkCreateImage(logicalDevice->vkHandle(), reinterpret_cast<const VkImageCreateInfo*>(desc.Info), nullptr, &image);
+                if (result != VK_SUCCESS)
+                {
+                    destroyCreated();
+                    return false;
+                }
+                vkGetImageMemoryRequirements(logicalDevice->vkHandle(), image, &requirements);
+                vkHandles[i] = (uint64_t)image;
+                hasImages = true;
+            }
+            else
+            {
+                destroyCreated();
+                return false;
+            }
+
+            requests[i] = TransientAllocationRequest{ requirements, desc.FirstUse, desc.LastUse };
+        }
+
+        if (hasBuffers && hasImages)
+        {
+            // Buffers and optimally tiled images sharing memory have to be kept a page of this size apart
+            const VkDeviceSize granularity = physicalDevice->GetProperties().limits.bufferImageGranularity;
+            for (auto& request : requests)
+            {
+                request.requirements.alignment = std::max(request.requirements.alignment, granularity);
+                request.requirements.size = ((request.requirements.size + granularity - 1u) / granularity) * granularity;
+            }
+        }
+
+        const TransientPackResult packing = PackTransientResources(requests);
+
+        // Every heap is shared by resources bound at the offsets we packed them at, which VMA has to be told about
+        VmaAllocationCreateInfo allocCreateInfo = allocationCreateInfo(GpuResourceMemoryDomain::Device, 0u);
+        allocCreateInfo.flags |= VMA_ALLOCATION_CREATE_CAN_ALIAS_BIT;
+        for (const auto& layout : packing.heaps)
+        {
+            const VkMemoryRequirements heapRequirements{ layout.size, layout.alignment, layout.memoryTypeBits };
+            VmaAllocation heap{ VK_NULL_HANDLE };
+            VkResult result = vmaAllocateMemory(vmaAllocatorHandle, &heapRequirements, &allocCreateInfo, &heap, nullptr);
+            if (result != VK_SUCCESS)
+            {
+                destroyCreated();
+                return false;
+            }
+            heaps.emplace_back(heap);
+        }
+
+        for (uint32_t i = 0u; i < num_resources; ++i)
+        {
+            const TransientPlacement& placement = packing.placements[i];
+            VkResult result = VK_SUCCESS;
+            if (descs[i].Type == GpuResourceType::Buffer)
+            {
+                result = vmaBindBufferMemory2(vmaAllocatorHandle, heaps[placement.heapIdx], placement.offset, (VkBuffer)vkHandles[i], nullptr);
+            }
+            else
+            {
+                result = vmaBindImageMemory2(vmaAllocatorHandle, heaps[placement.heapIdx], placement.offset, (VkImage)vkHandles[i], nullptr);
+            }
+
+            if (result != VK_SUCCESS)
+            {
+                destroyCreated();
+                return false;
+            }
+        }
+
+        // The group is used again every frame, and the next frame's first users of some memory overwrite what the last
+        // users left in it this frame. Nothing else orders the two on the queue, so their first use waits on those too
+        std::vector<std::vector<uint32_t>> aliasedSuccessors(num_resources);
+        for (uint32_t i = 0u; i < num_resources; ++i)
+        {
+            for (const uint32_t predecessorIdx : packing.aliasedPredecessors[i])
+            {
+                aliasedSuccessors[predecessorIdx].emplace_back(i);
+            }
+        }
+
+        uint32_t groupID = 0u;
+        {
+            std::lock_guard transientLock(transientMutex);
+            groupID = nextTransientGroupID++;
+
+            TransientGroup& group = transientGroups[groupID];
+            group.liveResources = num_resources;
+            group.unaliasedBytes = packing.unaliasedBytes;
+            group.peakLiveBytes = packing.peakLiveBytes;
+            for (const auto& layout : packing.heaps)
+            {
+                group.aliasedBytes += layout.size;
+            }
+            group.heaps = std::move(heaps);
+
+            for (uint32_t i = 0u; i < num_resources; ++i)
+            {
+                const TransientResourceDesc& desc = descs[i];
+                TransientAliasBarrier barrier;
+                barrier.firstUse = desc.FirstUse;
+                barrier.dstStages = desc.FirstUseStages;
+                barrier.dstAccess = desc.FirstUseAccess;
+                barrier.newLayout = static_cast<VkImageLayout>(desc.FirstUseLayout);
+                for (const uint32_t predecessorIdx : packing.aliasedPredecessors[i])
+                {
+                    barrier.srcStages |= descs[predecessorIdx].LastUseStages;
+                    barrier.srcAccess |= descs[predecessorIdx].LastUseAccess;
+                    barrier.aliased = true;
+                }
+                for (const uint32_t successorIdx : aliasedSuccessors[i])
+                {
+                    barrier.srcStages |= descs[successorIdx].LastUseStages;
+                    barrier.srcAccess |= descs[successorIdx].LastUseAccess;
+                    barrier.aliased = true;
+                }
+                transientBarriers.emplace(vkHandles[i], barrier);
+            }
+        }
+
+        for (uint32_t i = 0u; i < num_resources; ++i)
+        {
+            const TransientResourceDesc& desc = descs[i];
+
+            ResourceRecord record;
+            record.type = desc.Type;
+            record.memoryDomain = GpuResourceMemoryDomain::Device;
+            record.residency = GpuResourceResidency::Resident;
+            record.flags = desc.Flags;
+            record.vkHandle = vkHandles[i];
+            record.size = requests[i].requirements.size;
+            record.transientGroup = groupID;
+
+            VkObjectType objectType = VK_OBJECT_TYPE_IMAGE;
+            if (desc.Type == GpuResourceType::Buffer)
+            {
+                objectType = VK_OBJECT_TYPE_BUFFER;
+                record.bufferInfo = *reinterpret_cast<const VkBufferCreateInfo*>(desc.Info);
+                record.bufferInfo.pNext = nullptr;
+                if (desc.Flags & CreationFlagBits::ResourceCreateDeviceAddress)
+                {
+                    // Heaps come from the same allocator as everything else, so they were allocated with the address bit too
+                    record.bufferInfo.usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+                    record.deviceAddress = bufferDeviceAddress((VkBuffer)record.vkHandle);
+                }
+                keepQueueFamilies(record.bufferInfo, record.queueFamilies);
+            }
+            else
+            {
+                record.imageInfo = *reinterpret_cast<const VkImageCreateInfo*>(desc.Info);
+                record.imageInfo.pNext = nullptr;
+                keepQueueFamilies(record.imageInfo, record.queueFamilies);
+                // Where the aliasing barrier leaves it
+                record.layouts.reset(SubresourceState{ static_cast<VkImageLayout>(desc.FirstUseLayout), VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE });
+            }
+
+            if ((desc.Flags & CreationFlagBits::ResourceCreateUserDataAsString) && (desc.UserData != nullptr))
+            {
+                nameRecord(record, objectType, reinterpret_cast<const char*>(desc.UserData));
+            }
+
+            handles[i] = allocateRecord(std::move(record));
+        }
+
+        if (stats != nullptr)
+        {
+            stats->UnaliasedBytes = packing.unaliasedBytes;
+            stats->PeakLiveBytes = packing.peakLiveBytes;
+            stats->AliasedBytes = 0u;
+            for (const auto& layout : packing.heaps)
+            {
+                stats->AliasedBytes += layout.size;
+            }
+            stats->NumResources = num_resources;
+            stats->NumHeaps = static_cast<uint32_t>(packing.heaps.size());
+        }
+
+        return true;
+    }
+
+    void ResourceContextImpl::recordTransientAliasingBarriers(VkCommandBuffer cmd, uint32_t use_point, uint32_t num_handles, const GpuResourceHandle* handles) const
+    {
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+        std::vector<VkBufferMemoryBarrier> bufferBarriers;
+        VkPipelineStageFlags srcStages = 0u;
+        VkPipelineStageFlags dstStages = 0u;
+
+        {
+            std::shared_lock recordLock(recordMutex);
+            std::lock_guard transientLock(transientMutex);
+
+            for (uint32_t i = 0u; i < num_handles; ++i)
+            {
+                const ResourceRecord* record = lookupRecord(handles[i]);
+                if ((record == nullptr) || (record->transientGroup == std::numeric_limits<uint32_t>::max()))
+                {
+                    continue;
+                }
+
+                auto iter = transientBarriers.find(record->vkHandle);
+                if ((iter == transientBarriers.cend()) || (iter->second.firstUse != use_point))
+                {
+                    continue;
+                }
+
+                const TransientAliasBarrier& barrier = iter->second;
+                if (record->type == GpuResourceType::Image)
+                {
+                    // Whatever was in the memory before is garbage to this image, so the old layout is always undefined
+                    imageBarriers.emplace_back(VkImageMemoryBarrier
+                    {
+                        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                        nullptr,
+                        barrier.srcAccess,
+                        barrier.dstAccess,
+                        VK_IMAGE_LAYOUT_UNDEFINED,
+                        barrier.newLayout,
+                        VK_QUEUE_FAMILY_IGNORED,
+                        VK_QUEUE_FAMILY_IGNORED,
+                        (VkImage)record->vkHandle,
+                        VkImageSubresourceRange{ aspectMaskFromFormat(record->imageInfo.format), 0u, record->imageInfo.mipLevels, 0u, record->imageInfo.arrayLayers }
+                    });
+                }
+                else if (barrier.aliased)
+                {
+                    bufferBarriers.emplace_back(VkBufferMemoryBarrier
+                    {
+                        VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                        nullptr,
+                        barrier.srcAccess,
+                        barrier.dstAccess,
+                        VK_QUEUE_FAMILY_IGNORED,
+                        VK_QUEUE_FAMILY_IGNORED,
+                        (VkBuffer)record->vkHandle,
+                        0u,
+                        VK_WHOLE_SIZE
+                    });
+                }
+                else
+                {
+                    continue;
+                }
+
+                srcStages |= barrier.srcStages;
+                dstStages |= barrier.dstStages;
+            }
+        }
+
+        if (imageBarriers.empty() && bufferBarriers.empty())
+        {
+            return;
+        }
+
+        // Zero stage masks aren't valid: nothing to wait on is top of pipe, and unknown consumers are everything
+        srcStages = srcStages != 0u ? srcStages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+        dstStages = dstStages != 0u ? dstStages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+        vkCmdPipelineBarrier(cmd, srcStages, dstStages, 0, 0u, nullptr,
+            static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+            static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+    }
+
+    TransientMemoryStats ResourceContextImpl::transientMemoryStats() const
+    {
+        TransientMemoryStats result;
+
+        std::lock_guard transientLock(transientMutex);
+        for (const auto& [groupID, group] : transientGroups)
+        {
+            result.UnaliasedBytes += group.unaliasedBytes;
+            result.AliasedBytes += group.aliasedBytes;
+            result.PeakLiveBytes += group.peakLiveBytes;
+            result.NumResources += group.liveResources;
+            result.NumHeaps += static_cast<uint32_t>(group.heaps.size());
+        }
+
+        return result;
+    }
+
+    void ResourceContextImpl::transitionResources(VkCommandBuffer cmd, uint32_t num_transitions, const ImageTransition* transitions)
+    {
+        std::vector<VkImageMemoryBarrier2> barriers;
+        std::vector<SubresourceTransition> subresourceTransitions;
+        {
+            // Exclusive, as the new states are kept as we go
+            std::unique_lock recordLock(recordMutex);
+            for (uint32_t i = 0u; i < num_transitions; ++i)
+            {
+                const ImageTransition& transition = transitions[i];
+                ResourceRecord* record = lookupRecord(transition.Image);
+                if ((record == nullptr) || ((record->type != GpuResourceType::Image) && (record->type != GpuResourceType::SparseImage)) ||
+                    (record->vkHandle == 0u))
+                {
+                    continue;
+                }
+
+                const VkImageSubresourceRange range
+                {
+                    aspectMaskFromFormat(record->imageInfo.format),
+                    transition.BaseMipLevel,
+                    transition.LevelCount != 0u ? transition.LevelCount : VK_REMAINING_MIP_LEVELS,
+                    transition.BaseArrayLayer,
+                    transition.LayerCount != 0u ? transition.LayerCount : VK_REMAINING_ARRAY_LAYERS
+                };
+                const SubresourceState next{ static_cast<VkImageLayout>(transition.NewLayout), transition.DstStages, transition.DstAccess };
+
+                subresourceTransitions.clear();
+                record->layouts.transition(record->imageInfo.mipLevels, record->imageInfo.arrayLayers, range, next, subresourceTransitions);
+                for (const auto& subresource : subresourceTransitions)
+                {
+                    barriers.emplace_back(VkImageMemoryBarrier2
+                    {
+                        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                        nullptr,
+                        subresource.previous.stages,
+                        subresource.previous.access,
+                        next.stages,
+                        next.access,
+                        transition.Discard ? VK_IMAGE_LAYOUT_UNDEFINED : subresource.previous.layout,
+                        next.layout,
+                        VK_QUEUE_FAMILY_IGNORED,
+                        VK_QUEUE_FAMILY_IGNORED,
+                        (VkImage)record->vkHandle,
+                        subresource.range
+                    });
+                }
+            }
+        }
+
+        if (barriers.empty())
+        {
+            return;
+        }
+
+        if (vkCmdPipelineBarrier2Fn != nullptr)
+        {
+            const VkDependencyInfo dependencyInfo
+            {
+                VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                nullptr,
+                0u,
+                0u,
+                nullptr,
+                0u,
+                nullptr,
+                static_cast<uint32_t>(barriers.size()),
+                barriers.data()
+            };
+            vkCmdPipelineBarrier2Fn(cmd, &dependencyInfo);
+            return;
+        }
+
+        // The same barriers, with their stages merged into the one pair of masks the call takes
+        std::vector<VkImageMemoryBarrier> legacyBarriers;
+        legacyBarriers.reserve(barriers.size());
+        VkPipelineStageFlags srcStages = 0u;
+        VkPipelineStageFlags dstStages = 0u;
+        for (const auto& barrier : barriers)
+        {
+            srcStages |= legacyStageMask(barrier.srcStageMask);
+            dstStages |= legacyStageMask(barrier.dstStageMask);
+            legacyBarriers.emplace_back(VkImageMemoryBarrier
+            {
+                VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                nullptr,
+                legacyAccessMask(barrier.srcAccessMask),
+                legacyAccessMask(barrier.dstAccessMask),
+                barrier.oldLayout,
+                barrier.newLayout,
+                VK_QUEUE_FAMILY_IGNORED,
+                VK_QUEUE_FAMILY_IGNORED,
+                barrier.image,
+                barrier.subresourceRange
+            });
+        }
+
+        // Zero masks aren't allowed here: nothing to wait on, or nothing waiting
+        vkCmdPipelineBarrier(cmd, srcStages != 0u ? srcStages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT),
+            dstStages != 0u ? dstStages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT), 0, 0u, nullptr, 0u, nullptr, static_cast<uint32_t>(legacyBarriers.size()), legacyBarriers.data());
+    }
+
+    void ResourceContextImpl::releaseTransientResource(const ResourceRecord& record)
+    {
+        if (record.transientGroup == std::numeric_limits<uint32_t>::max())
+        {
+            return;
+        }
+
+        std::lock_guard transientLock(transientMutex);
+        transientBarriers.erase(record.vkHandle);
+
+        auto iter = transientGroups.find(record.transientGroup);
+        if (iter == transientGroups.end())
+        {
+            return;
+        }
+
+        // Records are only destroyed once their last frame retires, so the last one out can free the heaps
+        if (--iter->second.liveResources == 0u)
+        {
+            for (auto& heap : iter->second.heaps)
+            {
+                vmaFreeMemory(vmaAllocatorHandle, heap);
+            }
+            transientGroups.erase(iter);
+        }
+    }
+
+    bool ResourceContextImpl::resumeWhenComplete(std::coroutine_handle<> continuation, const std::atomic<bool>* complete)
+    {
+        if ((std::this_thread::get_id() == workQueueThreadID) && complete->load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        std::lock_guard continuationLock(continuationMutex);
+        pendingContinuations.emplace_back(PendingContinuation{ continuation, complete });
+        return true;
+    }
+
+    void ResourceContextImpl::resumeContinuations()
+    {
+        std::vector<PendingContinuation> waiting;
+        {
+            std::lock_guard continuationLock(continuationMutex);
+            waiting.swap(pendingContinuations);
+        }
+
+        // Anything awaited by a resumed continuation waits for the next update(), so one chain can't keep us here forever
+        std::vector<PendingContinuation> stillWaiting;
+        for (auto& pending : waiting)
+        {
+            if (pending.complete->load(std::memory_order_acquire))
+            {
+                pending.continuation.resume();
+            }
+            else
+            {
+                stillWaiting.emplace_back(pending);
+            }
+        }
+
+        if (!stillWaiting.empty())
+        {
+            std::lock_guard continuationLock(continuationMutex);
+            pendingContinuations.insert(pendingContinuations.end(), stillWaiting.begin(), stillWaiting.end());
+        }
+    }
+
+    void ResourceContextImpl::enqueueEvent(ResourceCreationEvent::CoroutineHandle handle)
+    {
+        eventQueue.push(std::move(handle));
+    }
+
+    bool ResourceContextImpl::copyToFrameArena(ResourceCreationMessage& message)
+    {
+        // Queued before the next ProcessMessages() at the latest, so it's created well before this frame retires
+        std::shared_lock frameLock(frameMutex);
+        std::lock_guard arenaLock(arenaMutex);
+        return CopyCreationMessage(currentFrame().messageArena, message, message.Flags & CreationFlagBits::ResourceCreateCopyInitialData);
     }
 
 }
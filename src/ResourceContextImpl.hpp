@@ -3,28 +3,163 @@
 #define PETRICHOR_RESOURCE_CONTEXT_IMPL_HPP
 #include "ResourceContext.hpp"
 #include "ResourceCreationCoro.hpp"
+#include <array>
 #include <vector>
 #include <unordered_map>
 #include <vulkan/vulkan_core.h>
 #include <queue>
 #include <coroutine>
 #include <thread>
+#include <mutex>
+#include <shared_mutex>
 #include "vk_mem_alloc.h"
 #include "VkDebugUtils.hpp"
 #include "mwsrQueue.hpp"
+#include "SparseResidency.hpp"
+#include "TransientAliasing.hpp"
+#include "ResourceModification.hpp"
+#include "MappedFile.hpp"
+#include "ReadbackPool.hpp"
+#include "ObjectCache.hpp"
+#include "CoroutineFramePool.hpp"
+#include "MemoryStatsSnapshot.hpp"
+#include "DeviceAddressTable.hpp"
+#include "ResourceHandleTable.hpp"
+#include "BindlessHeap.hpp"
+#include "WorkerPool.hpp"
+#include "FormatCapabilities.hpp"
+#include "CreationTrace.hpp"
+#include "UploadScheduler.hpp"
+#include "StagingPool.hpp"
+#include "MessageArena.hpp"
+#include "ImageLayoutTracker.hpp"
+#include <memory>
+#include <string>
 
 namespace petrichor
 {
-    
+
+    // Number of frames of transfer work and deferred destruction we keep in flight
+    constexpr static size_t MaxFramesInFlight = 3u;
+
+    // Handles are a slot index into the resource table in the low 32 bits, and the generation
+    // of that slot in the high 32 bits: so stale handles don't alias whatever reused the slot
+    constexpr inline uint32_t HandleSlot(const GpuResourceHandle handle) noexcept
+    {
+        return static_cast<uint32_t>(handle & 0xFFFFFFFFu);
+    }
+
+    constexpr inline uint32_t HandleGeneration(const GpuResourceHandle handle) noexcept
+    {
+        return static_cast<uint32_t>(handle >> 32u);
+    }
+
+    constexpr inline GpuResourceHandle MakeHandle(const uint32_t slot, const uint32_t generation) noexcept
+    {
+        return (static_cast<uint64_t>(generation) << 32u) | static_cast<uint64_t>(slot);
+    }
+
+    struct ResourceRecord
+    {
+        GpuResourceType type{ GpuResourceType::Invalid };
+        GpuResourceMemoryDomain memoryDomain{ GpuResourceMemoryDomain::Invalid };
+        GpuResourceResidency residency{ GpuResourceResidency::Invalid };
+        GpuResourceCreationFlags flags{ 0u };
+        // Incremented each time the slot is freed, invalidating handles to the previous occupant
+        uint32_t generation{ 0u };
+        // VkBuffer, VkImage or VkSampler depending on type (sparse images are VkImages without an allocation)
+        uint64_t vkHandle{ 0u };
+        VmaAllocation allocation{ VK_NULL_HANDLE };
+        VkDeviceSize size{ 0u };
+        // Copies of the creation info, with pNext and queue family pointers cleared (they wouldn't outlive the message)
+        VkBufferCreateInfo bufferInfo{};
+        VkImageCreateInfo imageInfo{};
+        // What pQueueFamilyIndices pointed to, for concurrently shared resources
+        std::vector<uint32_t> queueFamilies;
+        // Set for transient resources, which are bound into their group's heaps instead of owning an allocation
+        uint32_t transientGroup{ std::numeric_limits<uint32_t>::max() };
+        // Layout and accesses of each of an image's subresources, as of the last barrier recorded by the context or TransitionResources()
+        ImageLayoutTracker layouts;
+        // Set for views: the image or buffer they were made from
+        GpuResourceHandle parentHandle{ INVALID_GPU_RESOURCE_HANDLE };
+        // Views made from this resource, which pin it in place: they'd be left dangling if it were demoted or evicted
+        uint32_t viewCount{ 0u };
+        // Set for buffers created with ResourceCreateDeviceAddress, and mirrored in deviceAddresses
+        VkDeviceAddress deviceAddress{ 0u };
+        // Set for ResourceCreatePersistentlyMapped resources in host visible memory: pins them in place, like views do
+        void* mappedData{ nullptr };
+        bool hostCoherent{ false };
+        // Slot in the bindless array for this type of resource, if it has one
+        uint32_t bindlessIndex{ BindlessIndexInvalid };
+        // Name given with ResourceCreateUserDataAsString, kept so memory stats can be attributed to it
+        std::string debugName;
+        // Set for resources given to importResource(). Unless ownership came with them, destroying one only drops its record
+        bool imported{ false };
+        bool ownsHandle{ true };
+    };
+
     struct ResourceContextImpl
     {
 
-        void construct(vpr::Device* _device, vpr::PhysicalDevice* _physical_device, bool validation_enabled);
+        void construct(vpr::Device* _device, vpr::PhysicalDevice* _physical_device, const EnabledDeviceFeatures& enabled_features, bool validation_enabled);
         void destroy();
+        void update();
 
         ResourceSystemReply createResource(ResourceCreationMessage message);
+        void destroyResource(GpuResourceHandle handle);
+        GpuResourceHandle importResource(const ImportedResourceDesc& desc);
+        void modifyResource(const ResourceModificationMessage& message);
         void ProcessMessages();
 
+        void queryMemoryBudget(uint32_t* num_heaps, GpuMemoryHeapBudget* budgets) const;
+        void setMemoryBudgetPolicy(const MemoryBudgetPolicy& policy);
+        GpuResourceResidency resourceResidency(GpuResourceHandle handle) const;
+        uint64_t deviceAddress(GpuResourceHandle handle) const noexcept;
+        uint64_t vulkanHandle(GpuResourceHandle handle) const noexcept;
+        void* mappedPointer(GpuResourceHandle handle) const;
+        void markMappedRangeDirty(GpuResourceHandle handle, VkDeviceSize offset, VkDeviceSize size);
+        VkDescriptorSetLayout bindlessSetLayout() const noexcept;
+        VkDescriptorSet bindlessSet() const noexcept;
+        uint32_t bindlessIndex(GpuResourceHandle handle) const;
+        // Checked before queueing a creation, so ResourceCreateNeverAllocate requests can fail on the calling thread
+        bool withinNeverAllocateBudget(const ResourceCreationMessage& message) const;
+
+        void requestSparsePages(GpuResourceHandle handle, uint32_t num_requests, const SparseImagePageRequest* requests);
+        SparseResidencyStats sparseResidencyStats(GpuResourceHandle handle) const;
+
+        bool createTransientResources(uint32_t num_resources, const TransientResourceDesc* descs, GpuResourceHandle* handles, TransientMemoryStats* stats);
+        void recordTransientAliasingBarriers(VkCommandBuffer cmd, uint32_t use_point, uint32_t num_handles, const GpuResourceHandle* handles) const;
+        TransientMemoryStats transientMemoryStats() const;
+        void transitionResources(VkCommandBuffer cmd, uint32_t num_transitions, const ImageTransition* transitions);
+
+        ResourceReadbackReply readbackResource(GpuResourceHandle handle, uint64_t offset, uint64_t size);
+        void addTransferWaitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags wait_stages);
+
+        void setUploadBudget(const UploadBudget& budget);
+        UploadSchedulerStats uploadSchedulerStats() const;
+        void setStagingPoolIdleFrames(uint32_t frames);
+        StagingPoolStats stagingPoolStats() const;
+
+        void registerDecompressionCodec(GpuCompressionCodec codec, DecompressionFn fn, void* user_data);
+        DecompressionStats decompressionStats() const;
+
+        SamplerCacheStats samplerCacheStats() const;
+        ViewCacheStats viewCacheStats() const;
+        CoroutineFrameStats coroutineFrameStats() const noexcept;
+
+        void writeMemoryStatsFile(const char* output_file) const;
+        void enableMemoryStatsSnapshots(uint32_t frame_interval, uint32_t capacity);
+        void memoryStatsSnapshots(uint32_t* num_samples, MemoryStatsSample* samples) const;
+        void writeMemoryStatsSnapshots(const char* output_file) const;
+
+        void enableCreationTracing(uint32_t capacity);
+        void creationLatencies(uint32_t* num_latencies, ResourceCreationLatency* latencies) const;
+        void writeCreationLatencyFile(const char* output_file) const;
+
+        // Queues continuation to be resumed by update() once complete is set. Returns false (resume now) instead
+        // if it's already complete and we're on the work queue thread, which is where it'd be resumed anyway
+        bool resumeWhenComplete(std::coroutine_handle<> continuation, const std::atomic<bool>* complete);
+
         /*
         GpuResource* createBuffer(
             const VkBufferCreateInfo* info,
@@ -59,17 +194,346 @@ namespace petrichor
         bool resourceInTransferQueue(GpuResource* rsrc);
         */
     private:
+
+        // File mapping imported as a transfer source: all of it has to outlive the copies reading from it
+        struct ImportedFileUpload
+        {
+            MappedFile file;
+            VkBuffer buffer{ VK_NULL_HANDLE };
+            VkDeviceMemory memory{ VK_NULL_HANDLE };
+        };
+
+        // Everything recorded or released during a frame, retired once that frame's fence signals
+        struct FrameData
+        {
+            VkCommandPool commandPool{ VK_NULL_HANDLE };
+            VkCommandBuffer transferCmd{ VK_NULL_HANDLE };
+            // Uploads let through by the scheduler, submitted ahead of everything else in the frame
+            VkCommandBuffer uploadCmd{ VK_NULL_HANDLE };
+            bool uploadsRecorded{ false };
+            // Set if uploadCmd is bracketed by this frame's pair of timestamp queries
+            bool uploadsTimestamped{ false };
+            VkDeviceSize uploadBytes{ 0u };
+            VkFence fence{ VK_NULL_HANDLE };
+            bool submitted{ false };
+            bool hasCommands{ false };
+            std::vector<ResourceRecord> pendingDestruction;
+            // Staging read by this frame's copies, which goes back in the pool once it retires
+            std::vector<StagingBuffer> releasedStaging;
+            // Signaled by this frame's vkQueueBindSparse, and waited on by its transfer submission
+            VkFence sparseFence{ VK_NULL_HANDLE };
+            VkSemaphore sparseSemaphore{ VK_NULL_HANDLE };
+            bool sparseSubmitted{ false };
+            // Pages unbound this frame, which go back into the pool once the frame retires
+            std::vector<VmaAllocation> releasedPages;
+            std::vector<ImportedFileUpload> importedUploads;
+            // Readbacks copied in this frame's batch: complete as soon as the fence has signaled
+            std::vector<std::unique_ptr<ReadbackState>> readbacks;
+            // Recorded by other threads this frame, and submitted ahead of transferCmd
+            std::vector<VkCommandBuffer> threadCommandBuffers;
+            // Traced creations with copies in this frame's batch, finished once it retires
+            std::vector<CreationTrace> creationTraces;
+            bool tracesGpuComplete{ false };
+            // Copies of messages deferred during this frame. Update() creates them before the frame retires
+            MessageArena messageArena;
+        };
+
+        // Transfer command pools owned by one recording thread: one per frame in flight, all reset in bulk as frames retire
+        struct ThreadCommandPools
+        {
+            std::array<VkCommandPool, MaxFramesInFlight> pools{};
+            std::array<VkCommandBuffer, MaxFramesInFlight> commandBuffers{};
+            // frameCounter each command buffer was last begun for
+            std::array<uint64_t, MaxFramesInFlight> recordingFrame{};
+        };
+
+        // Resources packed together by one createTransientResources() call, and the heaps they share
+        struct TransientGroup
+        {
+            std::vector<VmaAllocation> heaps;
+            uint32_t liveResources{ 0u };
+            VkDeviceSize aliasedBytes{ 0u };
+            VkDeviceSize unaliasedBytes{ 0u };
+            VkDeviceSize peakLiveBytes{ 0u };
+        };
+
+        // Host visible memory that upload data is copied through, coherent unless host cached memory was asked for.
+        // Goes back in the staging pool with the frame it was used in
+        struct StagingAllocation
+        {
+            VkBuffer buffer{ VK_NULL_HANDLE };
+            VmaAllocation allocation{ VK_NULL_HANDLE };
+            VkDeviceSize offset{ 0u };
+            void* mappedData{ nullptr };
+        };
+
+        // Compressed initial contents, already decoded into staging and waiting to be copied out
+        struct DecompressedUpload
+        {
+            StagingAllocation staging;
+            // Of each entry, relative to staging.offset
+            std::vector<VkDeviceSize> offsets;
+            VkDeviceSize totalSize{ 0u };
+        };
+
+        struct DecompressionCodec
+        {
+            DecompressionFn fn{ nullptr };
+            void* userData{ nullptr };
+        };
+
+        // What a transient resource has to wait on at its first use
+        struct TransientAliasBarrier
+        {
+            uint32_t firstUse{ 0u };
+            VkPipelineStageFlags srcStages{ 0u };
+            VkAccessFlags srcAccess{ 0u };
+            VkPipelineStageFlags dstStages{ 0u };
+            VkAccessFlags dstAccess{ 0u };
+            VkImageLayout newLayout{ VK_IMAGE_LAYOUT_UNDEFINED };
+            // Set if something else occupies the memory earlier in the frame, or later in the previous one
+            bool aliased{ false };
+        };
+
         vpr::VkDebugUtilsFunctions vkDebugFns;
         vpr::Device* logicalDevice = nullptr;
-        vpr::PhysicalDevice physicalDevice = nullptr;
+        vpr::PhysicalDevice* physicalDevice = nullptr;
         VmaAllocator vmaAllocatorHandle = VK_NULL_HANDLE;
         friend struct ResourceCreationEvent;
 
-        void enqueueEvent(ResourceCreationEvent&& event);
+        GpuResourceHandle createResourceImmediate(const ResourceCreationMessage& message);
+        GpuResourceHandle createBuffer(const ResourceCreationMessage& message);
+        GpuResourceHandle createImage(const ResourceCreationMessage& message);
+        GpuResourceHandle createSampler(const ResourceCreationMessage& message);
+        GpuResourceHandle createView(const ResourceCreationMessage& message);
+        // Both return false if staging for the upload couldn't be allocated
+        bool uploadBufferData(const ResourceRecord& record, uint32_t num_data, const GpuResourceData* data);
+        bool uploadImageData(const ResourceRecord& record, uint32_t num_data, const GpuImageResourceData* data);
+        // Copies region i of data from offsets[i] in staging
+        void recordStagedImageUpload(const ResourceRecord& record, const StagingAllocation& staging, const VkDeviceSize* offsets, VkDeviceSize total_size,
+            uint32_t num_data, const GpuImageResourceData* data);
+        void recordImageUpload(const ResourceRecord& record, VkCommandBuffer cmd, VkBuffer source, uint32_t num_regions, const VkBufferImageCopy* regions);
+        // Decodes every entry into one staging allocation, across decompressionPool. Returns false if any of them fail
+        bool decompressToStaging(uint32_t num_data, const GpuCompressedResourceData* data, VkDeviceSize min_alignment, DecompressedUpload& upload);
+        bool uploadBufferFromFile(const ResourceRecord& record, MappedFile& file);
+        bool uploadImageFromFile(const ResourceRecord& record, MappedFile& file, uint32_t num_data, const GpuImageResourceData* data);
+        VkBuffer importMappedFile(MappedFile& file);
+        // Host cached staging is much faster to read back from, which decompressors do constantly. It needn't be coherent
+        StagingAllocation acquireStagingMemory(VkDeviceSize size, bool host_cached = false);
+        // Command buffer the calling thread records uploads into for the current frame. Off the work queue
+        // thread, frameMutex has to be held (shared) until recording is done
+        VkCommandBuffer transferCommandBuffer();
+        ThreadCommandPools& callingThreadPools();
+        bool directWriteEligible(GpuResourceMemoryDomain domain) const noexcept;
+        void processModifications();
+        // Puts modifications taken by processModifications back, ahead of any queued since
+        void requeueModifications(std::unordered_map<GpuResourceHandle, BufferModificationBatch>&& buffer_batches,
+            std::unordered_map<GpuResourceHandle, ImageModificationBatch>&& image_batches, std::vector<std::pair<GpuResourceHandle, GpuResourceHandle>>&& copies);
+        void processReadbacks();
+        // Records whatever the upload scheduler lets through this frame
+        void scheduleUploads();
+        // Returns them to the pool once the current frame retires
+        void releaseStaging(std::vector<StagingBuffer>& staging);
+        void completeReadbacks(FrameData& frame);
+        void shareWithTransferQueue(VkSharingMode& sharing_mode, uint32_t& num_families, const uint32_t*& families) const noexcept;
+        GpuResourceHandle createSparseImage(const ResourceCreationMessage& message);
+        GpuResourceHandle createSparseFallbackImage(const ResourceCreationMessage& message);
+        bool sparseImageSupported(const VkImageCreateInfo& info) const;
+        void processSparseBindings();
+        void destroySparseImageState(VkImage image);
+        void releaseTransientResource(const ResourceRecord& record);
+        VmaAllocationCreateInfo allocationCreateInfo(GpuResourceMemoryDomain domain, GpuResourceCreationFlags flags) const noexcept;
+        GpuResourceHandle allocateRecord(ResourceRecord&& record);
+        // For creations that fail after their record is built: destroyed with the frame, like any other record
+        void discardRecord(ResourceRecord&& record);
+        // Both require recordMutex to be held by the caller. Return nullptr for stale/invalid handles
+        ResourceRecord* lookupRecord(GpuResourceHandle handle);
+        const ResourceRecord* lookupRecord(GpuResourceHandle handle) const;
+        void destroyRecord(ResourceRecord& record);
+        void setObjectName(VkObjectType object_type, uint64_t handle, const char* name);
+        VkDeviceAddress bufferDeviceAddress(VkBuffer buffer) const noexcept;
+        // Takes a slot in the bindless array for binding and queues its write: BindlessIndexInvalid if there's no heap, or it's full
+        uint32_t registerBindless(uint32_t binding, uint64_t vk_handle);
+        void flushBindlessWrites();
+        // Fills in the mapping of a ResourceCreatePersistentlyMapped resource
+        void setPersistentMapping(ResourceRecord& record);
+        void flushMappedRanges();
+        // Names the Vulkan object and its allocation, and keeps the name in the record
+        void nameRecord(ResourceRecord& record, VkObjectType object_type, const char* name);
+
+        void beginFrame();
+        void submitFrame();
+        void retireFrame(FrameData& frame);
+        FrameData& currentFrame() noexcept;
+
+        MemoryBudgetPolicy currentBudgetPolicy() const;
+        void enforceMemoryBudget();
+        bool demoteBufferToHost(ResourceRecord& record);
+        void releaseRecord(ResourceRecord& record);
+        void sampleMemoryStats();
+        // Creations with copies to submit wait for their frame, the rest are done
+        void finishCreationTrace(CreationTrace& trace);
+        // Stamps GpuComplete on traces of frames whose fence has signaled since the last update()
+        void pollCreationTraces();
+
+        void enqueueEvent(ResourceCreationEvent::CoroutineHandle handle);
+        void resumeContinuations();
+        // Backs every ResourceCreationEvent frame, so creation doesn't hit the global heap
+        CoroutineFramePool coroutineFramePool;
+
+        // User coroutines awaiting a reply, and the completion flag of the operation they're waiting on
+        struct PendingContinuation
+        {
+            std::coroutine_handle<> continuation;
+            const std::atomic<bool>* complete{ nullptr };
+        };
+
+        std::mutex continuationMutex;
+        std::vector<PendingContinuation> pendingContinuations;
         std::thread::id workQueueThreadID;
-        mwsrQueue<ResourceCreationEvent> eventQueue;
+        mwsrQueue<ResourceCreationEvent::CoroutineHandle> eventQueue;
+        // Copies a ResourceCreateDeferred message into the current frame's arena. False if it has to be created right away
+        bool copyToFrameArena(ResourceCreationMessage& message);
+        // Guards each frame's messageArena. Taken after frameMutex
+        std::mutex arenaMutex;
+
+        mutable std::shared_mutex recordMutex;
+        std::vector<ResourceRecord> resourceRecords;
+        std::vector<uint32_t> freeRecordSlots;
+
+        std::mutex destructionMutex;
+        std::array<FrameData, MaxFramesInFlight> frames;
+        uint64_t frameCounter{ 0u };
+        // Held shared by threads recording into the current frame, and exclusively by update() while it submits and moves on
+        std::shared_mutex frameMutex;
+        // Guards threadPools and each frame's threadCommandBuffers
+        std::mutex threadPoolsMutex;
+        std::unordered_map<std::thread::id, std::unique_ptr<ThreadCommandPools>> threadPools;
+        // Tells the thread local pool cache which context it belongs to
+        uint64_t instanceID{ 0u };
+        VkCommandPoolCreateInfo commandPoolInfo{};
+
+        VkPhysicalDeviceMemoryProperties memoryProperties{};
+        // Memory types that aren't DEVICE_LOCAL, used as the target for demoted resources
+        uint32_t hostOnlyMemoryTypeBits{ 0u };
+        // Memory types that are both DEVICE_LOCAL and HOST_VISIBLE
+        uint32_t directWriteMemoryTypeBits{ 0u };
+        // Set on UMA and ReBAR devices, where device memory can be written directly instead of through staging
+        bool directDeviceWrites{ false };
+        // Transfer and graphics families: just one entry if they're the same family
+        std::array<uint32_t, 2> uploadQueueFamilies{};
+        uint32_t uploadQueueFamilyCount{ 1u };
+        // vkCmdClearColorImage needs graphics or compute, and vkCmdClearDepthStencilImage needs graphics
+        VkQueueFlags transferQueueFlags{ 0u };
+
+        // VK_EXT_external_memory_host: lets file mappings be used as transfer sources without staging
+        bool hostMemoryImportSupported{ false };
+        VkDeviceSize minImportedHostPointerAlignment{ 0u };
+        PFN_vkGetMemoryHostPointerPropertiesEXT vkGetMemoryHostPointerPropertiesEXT{ nullptr };
+
+        // Core in 1.2, or VK_KHR_buffer_device_address, and enabled on the device
+        bool bufferDeviceAddressSupported{ false };
+        PFN_vkGetBufferDeviceAddress vkGetBufferDeviceAddressFn{ nullptr };
+        // Core in 1.3, or VK_KHR_synchronization2. nullptr unless the device enabled the feature, and we fall back to vkCmdPipelineBarrier
+        PFN_vkCmdPipelineBarrier2 vkCmdPipelineBarrier2Fn{ nullptr };
+        // Only written with recordMutex held exclusively, but read with no lock at all
+        DeviceAddressTable deviceAddresses;
+        // Same, for the Vulkan handle of every record
+        ResourceHandleTable vulkanHandles;
+
+        // Written through a persistent mapping this frame
+        struct DirtyMappedRange
+        {
+            GpuResourceHandle handle{ INVALID_GPU_RESOURCE_HANDLE };
+            VmaAllocation allocation{ VK_NULL_HANDLE };
+            VkDeviceSize offset{ 0u };
+            VkDeviceSize size{ 0u };
+        };
+
+        std::mutex dirtyRangeMutex;
+        std::vector<DirtyMappedRange> dirtyRanges;
+        // Only touched by flushMappedRanges(): kept so flushing doesn't allocate every frame
+        std::vector<DirtyMappedRange> flushingRanges;
+        std::vector<VmaAllocation> flushAllocations;
+        std::vector<VkDeviceSize> flushOffsets;
+        std::vector<VkDeviceSize> flushSizes;
+
+        // Only created if descriptor indexing is available. Always taken last: creations register under samplerMutex or
+        // viewMutex, demotion under recordMutex and retirement under frameMutex, but nothing is taken while holding it
+        std::mutex bindlessMutex;
+        BindlessDescriptorHeap bindlessHeap;
+
+        std::mutex modificationMutex;
+        std::unordered_map<GpuResourceHandle, BufferModificationBatch> pendingBufferModifications;
+        std::unordered_map<GpuResourceHandle, ImageModificationBatch> pendingImageModifications;
+        // Source and destination of each queued CreateCopy
+        std::vector<std::pair<GpuResourceHandle, GpuResourceHandle>> pendingCopies;
+        bool memoryBudgetExtEnabled{ false };
+        mutable std::mutex budgetPolicyMutex;
+        MemoryBudgetPolicy budgetPolicy;
+
+        VkPhysicalDeviceFeatures deviceFeatures{};
+        FormatCapabilityTable formatCapabilities;
+        // Transfer queue if its family supports sparse binding, graphics queue otherwise
+        VkQueue sparseBindingQueue{ VK_NULL_HANDLE };
+        bool sparseResidencySupported{ false };
+        mutable std::mutex sparseMutex;
+        // Keyed by VkImage, so that retired records (which no longer have a handle) can find their state
+        std::unordered_map<uint64_t, SparseImageState> sparseImages;
+        SparsePagePool sparsePagePool;
+        std::vector<std::pair<GpuResourceHandle, SparseImagePageRequest>> pendingPageRequests;
+        std::vector<std::pair<VkImage, VkSparseMemoryBind>> pendingMipTailBinds;
+
+        mutable std::mutex transientMutex;
+        std::unordered_map<uint32_t, TransientGroup> transientGroups;
+        uint32_t nextTransientGroupID{ 0u };
+        // Keyed by Vulkan handle, like sparseImages
+        std::unordered_map<uint64_t, TransientAliasBarrier> transientBarriers;
+
+        std::mutex readbackMutex;
+        std::vector<std::unique_ptr<ReadbackState>> pendingReadbacks;
+        std::vector<std::pair<VkSemaphore, VkPipelineStageFlags>> pendingTransferWaits;
+        // Only touched from the work thread
+        ReadbackBufferPool readbackPool;
+        // Completed, and waiting for their reply to be destroyed before the buffer goes back in the pool
+        std::vector<std::unique_ptr<ReadbackState>> completedReadbacks;
+
+        StagingBufferPool stagingPool;
+
+        UploadScheduler uploadScheduler;
+        // Two timestamps per frame in flight, around its scheduled uploads. VK_NULL_HANDLE if the transfer queue can't write them
+        VkQueryPool uploadQueryPool{ VK_NULL_HANDLE };
+        uint64_t timestampMask{ 0u };
+        float timestampPeriod{ 0.0f };
+
+        mutable std::shared_mutex codecMutex;
+        std::unordered_map<GpuCompressionCodec, DecompressionCodec> decompressionCodecs;
+        // Also what ProcessMessages() resumes queued creations across
+        WorkerPool decompressionPool;
+        std::atomic<uint64_t> decompressedBytes{ 0u };
+        std::atomic<uint64_t> decompressionInputBytes{ 0u };
+        std::atomic<uint64_t> decompressedEntries{ 0u };
+        std::atomic<uint64_t> decompressionFailures{ 0u };
+        std::atomic<uint64_t> decompressionNanoseconds{ 0u };
+
+        // Taken before viewMutex and recordMutex, when they're needed together
+        mutable std::mutex samplerMutex;
+        SamplerCache samplerCache;
+        // Taken before recordMutex
+        mutable std::mutex viewMutex;
+        ViewCache viewCache;
+
+        // Never held along with any other lock
+        mutable std::mutex snapshotMutex;
+        MemoryStatsSnapshotRing snapshotRing;
+
+        // nullptr unless tracing is enabled. Buffers that tracing was enabled with before are kept until we're destroyed,
+        // since a creation may still be pushing into one: swapping the pointer is all enabling takes
+        std::atomic<CreationTraceBuffer*> creationTraceBuffer{ nullptr };
+        std::mutex traceBuffersMutex;
+        std::vector<std::unique_ptr<CreationTraceBuffer>> creationTraceBuffers;
     };
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -1,15 +1,57 @@
 #include "ResourceCreationCoro.hpp"
+#include "ResourceContextImpl.hpp"
+#include <chrono>
 #include <thread>
 
 namespace petrichor
 {
 
+    ResourceCreationEvent::Promise::Promise(ResourceContextImpl& parent, ResourceCreationMessage& msg) noexcept :
+        parentImpl(&parent), message(&msg)
+    {
+        if (parent.creationTraceBuffer.load(std::memory_order_acquire) != nullptr)
+        {
+            queuedTimestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+    }
+
+    void* ResourceCreationEvent::Promise::operator new(size_t size, ResourceContextImpl& parent, const ResourceCreationMessage&)
+    {
+        return parent.coroutineFramePool.allocate(size);
+    }
+
+    void ResourceCreationEvent::Promise::operator delete(void* frame, size_t size) noexcept
+    {
+        CoroutineFramePool::deallocate(frame, size);
+    }
+
+    void ResourceCreationEvent::Promise::unhandled_exception() noexcept
+    {
+        // Nothing to rethrow into: caller sees a completed operation with an invalid handle
+        resourceHandle = INVALID_GPU_RESOURCE_HANDLE;
+    }
+
     ResourceSystemReply ResourceCreationEvent::Promise::get_return_object()
     {
         std::coroutine_handle<Promise> handle = std::coroutine_handle<Promise>::from_promise(*this);
-        return ResourceCreationEvent::constructReply(handle);
+        return ResourceCreationEvent::constructReply(handle, parentImpl);
+    }
+
+    ResourceCreationEvent::InitialSuspendAwaitable ResourceCreationEvent::Promise::initial_suspend() noexcept
+    {
+        return InitialSuspendAwaitable{};
     }
 
+    ResourceCreationEvent::FinalSuspendAwaitable ResourceCreationEvent::Promise::final_suspend() noexcept
+    {
+        return FinalSuspendAwaitable{};
+    }
+
+    void ResourceCreationEvent::Promise::return_value(GpuResourceHandle handle) noexcept
+    {
+        resourceHandle = handle;
+    }
 
     bool ResourceCreationEvent::InitialSuspendAwaitable::await_ready() const noexcept
     {
@@ -19,8 +61,45 @@ namespace petrichor
     bool ResourceCreationEvent::InitialSuspendAwaitable::await_suspend(CoroutineHandle handle)
     {
         auto thisThreadID = std::this_thread::get_id();
+        Promise& promise = handle.promise();
+        ResourceContextImpl* impl = promise.parentImpl;
+
+        // Requests that can't fit in the budget fail right here on the calling thread, instead of
+        // waiting a frame just to be told no by the work queue
+        if (!impl->withinNeverAllocateBudget(*promise.message))
+        {
+            return false;
+        }
 
+        if (promise.message->Flags & CreationFlagBits::ResourceCreateDeferred)
+        {
+            // Left for the next Update() even on the work queue thread. A message we can't copy is created
+            // now instead, as the caller is free to release what it points to once we return
+            if (!impl->copyToFrameArena(*promise.message))
+            {
+                return false;
+            }
+        }
+        else if (thisThreadID == impl->workQueueThreadID)
+        {
+            return false;
+        }
+
+        impl->enqueueEvent(handle);
+        return true;
+    }
+
+    bool ResourceCreationEvent::FinalSuspendAwaitable::await_ready() const noexcept
+    {
         return false;
     }
 
+    bool ResourceCreationEvent::FinalSuspendAwaitable::await_suspend(CoroutineHandle handle) noexcept
+    {
+        Promise& promise = handle.promise();
+        promise.complete.store(true, std::memory_order_release);
+        // If the reply already let go of us, nobody else will destroy this frame
+        return !promise.released.exchange(true, std::memory_order_acq_rel);
+    }
+
 }
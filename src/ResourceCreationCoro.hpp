@@ -2,17 +2,37 @@
 #ifndef PETRICHOR_RESOURCE_CREATION_COROUTINE_HPP
 #define PETRICHOR_RESOURCE_CREATION_COROUTINE_HPP
 #include "PetrichorResourceTypes.hpp"
+#include <atomic>
 #include <coroutine>
 
 namespace petrichor
 {
-    
+
+    struct ResourceContextImpl;
+
     struct ResourceCreationEvent
     {
-        // Debug enum used to track state as we proceed through the process
-        enum class State
+        // States a creation passes through, timestamped when tracing is enabled. Only creations that record
+        // copies go on past Recorded: the rest are done once the resource exists
+        enum class State : uint8_t
         {
-
+            // CreateResource() was called
+            Queued = 0,
+            // Creation started: resumed by the work queue thread's ProcessMessages(), or right away on it
+            Dequeued,
+            // The Vulkan object (and its memory) exists
+            Allocated,
+            // Initial contents are in staging memory, or were written straight into the resource
+            Staged,
+            // Upload copies are recorded into a transfer command buffer
+            Recorded,
+            // The transfer batch holding them was submitted
+            Submitted,
+            // The batch's fence was seen signaled
+            GpuComplete,
+            // The frame was recycled, freeing its staging memory
+            Retired,
+            Count
         };
 
         ResourceCreationEvent(const ResourceCreationEvent&) = delete;
@@ -27,12 +47,12 @@ namespace petrichor
         struct Awaiter;
         Awaiter operator co_await() noexcept;
 
-        static ResourceSystemReply constructReply(CoroutineHandle handle)
+        static ResourceSystemReply constructReply(CoroutineHandle handle, ResourceContextImpl* parent)
         {
-            return ResourceSystemReply(handle.address());
+            return ResourceSystemReply(parent, handle.address());
         }
 
-        
+
         struct Awaiter
         {
             // If it returns true, this indicates the value can be immediately returned
@@ -43,25 +63,68 @@ namespace petrichor
         };
 
         struct InitialSuspendAwaitable;
+        struct FinalSuspendAwaitable;
 
         struct Promise
         {
+            // Coroutine parameters are forwarded here: the context is the implicit object parameter
+            // of ResourceContextImpl::createResource, followed by the message it was given
+            Promise(ResourceContextImpl& parent, ResourceCreationMessage& msg) noexcept;
+
+            // Frames come from the context's pool: the parameters are the coroutine's, like the constructor's
+            static void* operator new(size_t size, ResourceContextImpl& parent, const ResourceCreationMessage& msg);
+            static void operator delete(void* frame, size_t size) noexcept;
+
             // Exception in coroutine. Handle it as best as we can.
             void unhandled_exception() noexcept;
-            
+
             ResourceSystemReply get_return_object();
             InitialSuspendAwaitable initial_suspend() noexcept;
-            
-
+            FinalSuspendAwaitable final_suspend() noexcept;
+            void return_value(GpuResourceHandle handle) noexcept;
+
+            ResourceContextImpl* parentImpl = nullptr;
+            // Points at the coroutine frame's copy of the message, so it lives as long as we do. Deferred
+            // creations repoint its members into the frame arena before being queued
+            ResourceCreationMessage* message = nullptr;
+            // When CreateResource() was called, if tracing was enabled then. Queued creations start later
+            uint64_t queuedTimestamp = 0u;
+            GpuResourceHandle resourceHandle = INVALID_GPU_RESOURCE_HANDLE;
+            // Set once the coroutine reaches its final suspend point, read by ResourceOperationComplete
+            std::atomic<bool> complete{ false };
+            // Whichever of the reply and the coroutine finishes second destroys the coroutine frame
+            std::atomic<bool> released{ false };
         };
 
         struct InitialSuspendAwaitable
         {
-            // We always suspend, because we use that to schedule the resource operation
+            // Goes through await_suspend, which is where the resource operation gets scheduled
             bool await_ready() const noexcept;
+            // Returns false, resuming immediately, on the work queue thread or if the creation is bound to fail.
+            // Otherwise queues the creation for ProcessMessages(). Deferred creations are always queued
             bool await_suspend(CoroutineHandle handle);
+            void await_resume() const noexcept {}
+        };
 
+        // Hands the coroutine body its own promise, without suspending
+        struct PromiseAwaitable
+        {
+            Promise* promise = nullptr;
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(CoroutineHandle handle) noexcept
+            {
+                promise = &handle.promise();
+                return false;
+            }
+            Promise& await_resume() const noexcept { return *promise; }
+        };
 
+        struct FinalSuspendAwaitable
+        {
+            bool await_ready() const noexcept;
+            // Returns false, letting the frame be destroyed, if the reply was dropped before we completed
+            bool await_suspend(CoroutineHandle handle) noexcept;
+            void await_resume() const noexcept {}
         };
 
         void* devicePtr = nullptr;
@@ -71,4 +134,12 @@ namespace petrichor
 
 }
 
+// Lets ResourceSystemReply be the return type of our coroutines, without having to expose
+// the promise type (and <coroutine>) in the public headers
+template<typename... Args>
+struct std::coroutine_traits<petrichor::ResourceSystemReply, Args...>
+{
+    using promise_type = petrichor::ResourceCreationEvent::Promise;
+};
+
 #endif //!PETRICHOR_RESOURCE_CREATION_COROUTINE_HPP
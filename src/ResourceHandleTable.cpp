@@ -0,0 +1,253 @@
+#include "ResourceHandleTable.hpp"
+#include <algorithm>
+
+namespace petrichor
+{
+
+    namespace
+    {
+
+        // Holding on to the table's records is what makes handing this one back safe, whether or not the table's still alive
+        struct CachedReader
+        {
+            std::shared_ptr<HandleTableReaders> readers;
+            HandleTableReader* reader{ nullptr };
+        };
+
+        void ReleaseReader(CachedReader& cached) noexcept
+        {
+            if (cached.reader != nullptr)
+            {
+                cached.reader->claimed.store(false, std::memory_order_release);
+            }
+            cached = CachedReader{};
+        }
+
+        // Records of the tables this thread reads. There's usually one context, so a handful covers it: past that the
+        // oldest is handed back, and taken again if its table is read later
+        struct ThreadReaders
+        {
+            ~ThreadReaders()
+            {
+                for (auto& entry : cached)
+                {
+                    ReleaseReader(entry);
+                }
+            }
+
+            std::array<CachedReader, 4u> cached{};
+            size_t nextEvicted{ 0u };
+        };
+
+        thread_local ThreadReaders threadReaders;
+
+    }
+
+    ResourceHandleTable::Directory::Directory(uint32_t _capacity) : chunks(new std::atomic<Entry*>[_capacity]), capacity(_capacity)
+    {}
+
+    ResourceHandleTable::ResourceHandleTable() : directory(new Directory(InitialChunks)), readers(std::make_shared<HandleTableReaders>())
+    {}
+
+    ResourceHandleTable::~ResourceHandleTable()
+    {
+        clear();
+        delete directory.load(std::memory_order_acquire);
+    }
+
+    void ResourceHandleTable::publish(GpuResourceHandle handle, uint64_t vk_handle)
+    {
+        const uint32_t slot = static_cast<uint32_t>(handle & 0xFFFFFFFFu);
+        const uint32_t chunkIdx = slot / ChunkSize;
+
+        Directory* dir = directory.load(std::memory_order_relaxed);
+        if (chunkIdx >= dir->capacity)
+        {
+            Directory* grown = new Directory(std::max(dir->capacity * 2u, chunkIdx + 1u));
+            for (uint32_t i = 0u; i < dir->capacity; ++i)
+            {
+                grown->chunks[i].store(dir->chunks[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+
+            // Readers that announced this epoch or an earlier one may still be using the old directory. Anyone entering
+            // after the increment sees the new one, since it's swapped in first
+            directory.store(grown, std::memory_order_seq_cst);
+            std::lock_guard lock(reclaimMutex);
+            retired.emplace_back(RetiredDirectory{ dir, globalEpoch.fetch_add(1u, std::memory_order_seq_cst) });
+            reclaimRetired();
+            dir = grown;
+        }
+
+        Entry* chunk = dir->chunks[chunkIdx].load(std::memory_order_relaxed);
+        if (chunk == nullptr)
+        {
+            chunk = new Entry[ChunkSize];
+            chunks.emplace_back(chunk);
+            dir->chunks[chunkIdx].store(chunk, std::memory_order_release);
+        }
+
+        Entry& dest = chunk[slot % ChunkSize];
+        dest.handle.store(INVALID_GPU_RESOURCE_HANDLE, std::memory_order_release);
+        dest.vkHandle.store(vk_handle, std::memory_order_release);
+        dest.handle.store(handle, std::memory_order_release);
+    }
+
+    void ResourceHandleTable::retract(GpuResourceHandle handle) noexcept
+    {
+        // Only writers swap the directory, so it can't be freed under us
+        Entry* found = const_cast<Entry*>(entry(directory.load(std::memory_order_relaxed), static_cast<uint32_t>(handle & 0xFFFFFFFFu)));
+        if ((found == nullptr) || (found->handle.load(std::memory_order_acquire) != handle))
+        {
+            return;
+        }
+
+        found->handle.store(INVALID_GPU_RESOURCE_HANDLE, std::memory_order_release);
+        found->vkHandle.store(0u, std::memory_order_release);
+    }
+
+    uint64_t ResourceHandleTable::find(GpuResourceHandle handle) const noexcept
+    {
+        if (handle == INVALID_GPU_RESOURCE_HANDLE)
+        {
+            return 0u;
+        }
+
+        // Announcing before loading the directory is what keeps it alive: a writer scanning readers after retiring it
+        // either sees this epoch (or count), or we load the directory that replaced it
+        HandleTableReader* self = reader();
+        if (self != nullptr)
+        {
+            self->epoch.store(globalEpoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        }
+        else
+        {
+            overflowReaders.fetch_add(1u, std::memory_order_seq_cst);
+        }
+
+        uint64_t result = 0u;
+        const Entry* found = entry(directory.load(std::memory_order_seq_cst), static_cast<uint32_t>(handle & 0xFFFFFFFFu));
+        if ((found != nullptr) && (found->handle.load(std::memory_order_acquire) == handle))
+        {
+            const uint64_t vkHandle = found->vkHandle.load(std::memory_order_acquire);
+            // Changed while we were reading it: the Vulkan handle may belong to whatever replaced it
+            result = found->handle.load(std::memory_order_acquire) == handle ? vkHandle : 0u;
+        }
+
+        if (self != nullptr)
+        {
+            self->epoch.store(HandleTableReader::Idle, std::memory_order_release);
+        }
+        else
+        {
+            overflowReaders.fetch_sub(1u, std::memory_order_release);
+        }
+        return result;
+    }
+
+    void ResourceHandleTable::reclaim()
+    {
+        std::lock_guard lock(reclaimMutex);
+        reclaimRetired();
+    }
+
+    void ResourceHandleTable::clear() noexcept
+    {
+        Directory* dir = directory.load(std::memory_order_relaxed);
+        for (uint32_t i = 0u; i < dir->capacity; ++i)
+        {
+            dir->chunks[i].store(nullptr, std::memory_order_relaxed);
+        }
+        for (Entry* chunk : chunks)
+        {
+            delete[] chunk;
+        }
+        chunks.clear();
+
+        std::lock_guard lock(reclaimMutex);
+        for (const auto& entry : retired)
+        {
+            delete entry.directory;
+        }
+        retired.clear();
+    }
+
+    const ResourceHandleTable::Entry* ResourceHandleTable::entry(const Directory* dir, uint32_t slot) const noexcept
+    {
+        const uint32_t chunkIdx = slot / ChunkSize;
+        if (chunkIdx >= dir->capacity)
+        {
+            return nullptr;
+        }
+
+        const Entry* chunk = dir->chunks[chunkIdx].load(std::memory_order_acquire);
+        return chunk != nullptr ? &chunk[slot % ChunkSize] : nullptr;
+    }
+
+    HandleTableReader* ResourceHandleTable::reader() const noexcept
+    {
+        for (const auto& cached : threadReaders.cached)
+        {
+            if (cached.readers == readers)
+            {
+                return cached.reader;
+            }
+        }
+
+        // First read of this table on this thread: take whichever record is free. Every record is scanned by writers,
+        // claimed or not, so there's nothing to order against them here
+        HandleTableReader* result = nullptr;
+        for (auto& record : readers->records)
+        {
+            bool expected = false;
+            if (!record.claimed.load(std::memory_order_relaxed) && record.claimed.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+            {
+                result = &record;
+                break;
+            }
+        }
+
+        if (result == nullptr)
+        {
+            // Not cached, so we try again next time in case a thread has exited since
+            return nullptr;
+        }
+
+        auto empty = std::find_if(threadReaders.cached.begin(), threadReaders.cached.end(), [](const CachedReader& cached) { return cached.reader == nullptr; });
+        CachedReader& cached = empty != threadReaders.cached.end() ? *empty : threadReaders.cached[threadReaders.nextEvicted++ % threadReaders.cached.size()];
+        ReleaseReader(cached);
+        cached = CachedReader{ readers, result };
+        return result;
+    }
+
+    void ResourceHandleTable::reclaimRetired()
+    {
+        if (retired.empty())
+        {
+            return;
+        }
+
+        // Uncounted readers could be in any epoch
+        if (overflowReaders.load(std::memory_order_seq_cst) != 0u)
+        {
+            return;
+        }
+
+        uint64_t oldest = HandleTableReader::Idle;
+        for (const auto& record : readers->records)
+        {
+            oldest = std::min(oldest, record.epoch.load(std::memory_order_seq_cst));
+        }
+
+        auto reclaimed = std::remove_if(retired.begin(), retired.end(), [oldest](const RetiredDirectory& entry)
+        {
+            if (entry.epoch < oldest)
+            {
+                delete entry.directory;
+                return true;
+            }
+            return false;
+        });
+        retired.erase(reclaimed, retired.end());
+    }
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+#ifndef PETRICHOR_RESOURCE_HANDLE_TABLE_HPP
+#define PETRICHOR_RESOURCE_HANDLE_TABLE_HPP
+#include "PetrichorResourceTypes.hpp"
+#include <array>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace petrichor
+{
+
+    // Epoch a reader thread is reading the table in. One per thread per table, padded so readers never share a line
+    struct alignas(64) HandleTableReader
+    {
+        constexpr static uint64_t Idle = std::numeric_limits<uint64_t>::max();
+
+        std::atomic<uint64_t> epoch{ Idle };
+        // Cleared when the thread holding it exits or stops caching it, so another can take it over
+        std::atomic<bool> claimed{ false };
+    };
+
+    // Allocated with the table, so a thread never allocates or locks to start reading it. Thread local caches hold on
+    // to it too, so a thread can still hand its record back after the table is gone
+    struct HandleTableReaders
+    {
+        constexpr static size_t MaxReaders = 64u;
+        std::array<HandleTableReader, MaxReaders> records;
+    };
+
+    // Vulkan handles of resources, indexed by handle slot. Reads are wait-free: no locks, no retries, no allocation.
+    // Entries live in chunks that never move, found through a directory that's reallocated at twice the size as the table
+    // grows. Readers announce the epoch they entered in, and a replaced directory is only freed once every reader has
+    // moved past the epoch it was retired in. Past MaxReaders threads, the rest are counted instead, and nothing is freed
+    // while any of them are reading. Writers have to be serialized by the caller (we hold recordMutex exclusively)
+    class ResourceHandleTable
+    {
+    public:
+        ResourceHandleTable();
+        ~ResourceHandleTable();
+        ResourceHandleTable(const ResourceHandleTable&) = delete;
+        ResourceHandleTable& operator=(const ResourceHandleTable&) = delete;
+
+        // Replaces whatever the slot held, including an earlier Vulkan handle for the same handle
+        void publish(GpuResourceHandle handle, uint64_t vk_handle);
+        void retract(GpuResourceHandle handle) noexcept;
+        // Zero for stale handles and released resources
+        uint64_t find(GpuResourceHandle handle) const noexcept;
+        // Frees directories no reader can still be using. Safe from any thread
+        void reclaim();
+        // Not safe against concurrent readers: only for when the context is destroyed
+        void clear() noexcept;
+
+    private:
+        // The handle doubles as a sequence number, as in DeviceAddressTable: a reader seeing the same handle on both sides
+        // of its load knows the Vulkan handle belongs to it
+        struct Entry
+        {
+            std::atomic<GpuResourceHandle> handle{ INVALID_GPU_RESOURCE_HANDLE };
+            std::atomic<uint64_t> vkHandle{ 0u };
+        };
+
+        struct Directory
+        {
+            explicit Directory(uint32_t capacity);
+            std::unique_ptr<std::atomic<Entry*>[]> chunks;
+            uint32_t capacity;
+        };
+
+        struct RetiredDirectory
+        {
+            Directory* directory;
+            uint64_t epoch;
+        };
+
+        constexpr static uint32_t ChunkSize = 1024u;
+        constexpr static uint32_t InitialChunks = 16u;
+
+        const Entry* entry(const Directory* dir, uint32_t slot) const noexcept;
+        // Reader record of the calling thread, claiming one the first time it reads this table. nullptr if all are taken
+        HandleTableReader* reader() const noexcept;
+        // Requires reclaimMutex
+        void reclaimRetired();
+
+        std::atomic<Directory*> directory;
+        std::atomic<uint64_t> globalEpoch{ 0u };
+        const std::shared_ptr<HandleTableReaders> readers;
+        // Readers that found every record taken
+        mutable std::atomic<uint32_t> overflowReaders{ 0u };
+        // Every chunk ever allocated, as retired directories share them with the current one
+        std::vector<Entry*> chunks;
+        std::mutex reclaimMutex;
+        std::vector<RetiredDirectory> retired;
+    };
+
+}
+
+#endif //!PETRICHOR_RESOURCE_HANDLE_TABLE_HPP
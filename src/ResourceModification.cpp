@@ -0,0 +1,224 @@
+#include "ResourceModification.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+
+    uint16_t floatToHalf(const float value) noexcept
+    {
+        uint32_t bits = 0u;
+        memcpy(&bits, &value, sizeof(float));
+        const uint32_t sign = (bits >> 16u) & 0x8000u;
+        const int32_t exponent = static_cast<int32_t>((bits >> 23u) & 0xFFu) - 127 + 15;
+        const uint32_t mantissa = bits & 0x007FFFFFu;
+
+        if (exponent <= 0)
+        {
+            // Clear values are colors: flushing denormals to zero is fine
+            return static_cast<uint16_t>(sign);
+        }
+        else if (exponent >= 31)
+        {
+            const uint32_t nanBit = (((bits >> 23u) & 0xFFu) == 0xFFu) && (mantissa != 0u) ? 0x0200u : 0u;
+            return static_cast<uint16_t>(sign | 0x7C00u | nanBit);
+        }
+
+        return static_cast<uint16_t>(sign | (static_cast<uint32_t>(exponent) << 10u) | (mantissa >> 13u));
+    }
+
+    uint8_t floatToUnorm8(const float value) noexcept
+    {
+        return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+    }
+
+    float linearToSrgb(const float value) noexcept
+    {
+        const float clamped = std::clamp(value, 0.0f, 1.0f);
+        return clamped <= 0.0031308f ? clamped * 12.92f : 1.055f * std::pow(clamped, 1.0f / 2.4f) - 0.055f;
+    }
+
+}
+
+namespace petrichor
+{
+
+    void BufferModificationBatch::write(VkDeviceSize offset, const void* data, VkDeviceSize size)
+    {
+        PendingBufferWrite pendingWrite;
+        pendingWrite.offset = offset;
+        pendingWrite.data.resize(static_cast<size_t>(size));
+        memcpy(pendingWrite.data.data(), data, static_cast<size_t>(size));
+        writes.emplace_back(std::move(pendingWrite));
+    }
+
+    void BufferModificationBatch::fill(VkDeviceSize offset, VkDeviceSize size, uint32_t value)
+    {
+        fills.emplace_back(PendingBufferFill{ offset, size, value });
+
+        // vkCmdFillBuffer writes value as whole words starting at offset, so match that byte pattern
+        std::byte pattern[sizeof(uint32_t)];
+        memcpy(pattern, &value, sizeof(uint32_t));
+        const VkDeviceSize fillEnd = offset + size;
+        for (auto& pendingWrite : writes)
+        {
+            const VkDeviceSize writeEnd = pendingWrite.offset + pendingWrite.data.size();
+            const VkDeviceSize begin = std::max(offset, pendingWrite.offset);
+            const VkDeviceSize end = std::min(fillEnd, writeEnd);
+            for (VkDeviceSize i = begin; i < end; ++i)
+            {
+                pendingWrite.data[static_cast<size_t>(i - pendingWrite.offset)] = pattern[(i - offset) % sizeof(uint32_t)];
+            }
+        }
+    }
+
+    std::vector<VkBufferCopy> BufferModificationBatch::mergedRanges() const
+    {
+        std::vector<VkBufferCopy> ranges;
+        ranges.reserve(writes.size());
+        for (const auto& pendingWrite : writes)
+        {
+            ranges.emplace_back(VkBufferCopy{ 0u, pendingWrite.offset, pendingWrite.data.size() });
+        }
+
+        std::sort(ranges.begin(), ranges.end(), [](const VkBufferCopy& lhs, const VkBufferCopy& rhs)
+        {
+            return lhs.dstOffset < rhs.dstOffset;
+        });
+
+        std::vector<VkBufferCopy> result;
+        for (const auto& range : ranges)
+        {
+            if (!result.empty() && (range.dstOffset <= result.back().dstOffset + result.back().size))
+            {
+                VkBufferCopy& merged = result.back();
+                merged.size = std::max(merged.dstOffset + merged.size, range.dstOffset + range.size) - merged.dstOffset;
+            }
+            else
+            {
+                result.emplace_back(range);
+            }
+        }
+
+        return result;
+    }
+
+    void BufferModificationBatch::stage(std::vector<VkBufferCopy>& ranges, std::byte* staging, VkDeviceSize staging_offset) const
+    {
+        VkDeviceSize offset = staging_offset;
+        for (auto& range : ranges)
+        {
+            range.srcOffset = offset;
+            offset += range.size;
+        }
+
+        // Submission order, so that later writes overwrite earlier ones
+        for (const auto& pendingWrite : writes)
+        {
+            auto iter = std::upper_bound(ranges.begin(), ranges.end(), pendingWrite.offset, [](const VkDeviceSize value, const VkBufferCopy& range)
+            {
+                return value < range.dstOffset;
+            });
+            const VkBufferCopy& range = *(iter - 1);
+            memcpy(staging + (range.srcOffset - staging_offset) + (pendingWrite.offset - range.dstOffset), pendingWrite.data.data(), pendingWrite.data.size());
+        }
+    }
+
+    void ImageModificationBatch::write(const GpuImageResourceData& region)
+    {
+        writes.erase(std::remove_if(writes.begin(), writes.end(), [&region](const PendingImageWrite& pendingWrite)
+        {
+            return (pendingWrite.region.MipLevel == region.MipLevel) && (pendingWrite.region.ArrayLayer == region.ArrayLayer) &&
+                (pendingWrite.region.ArrayLayerCount == region.ArrayLayerCount) && (pendingWrite.region.Width == region.Width) &&
+                (pendingWrite.region.Height == region.Height);
+        }), writes.end());
+
+        PendingImageWrite pendingWrite;
+        pendingWrite.data.resize(region.Size);
+        memcpy(pendingWrite.data.data(), region.Data, region.Size);
+        pendingWrite.region = region;
+        pendingWrite.region.Data = pendingWrite.data.data();
+        writes.emplace_back(std::move(pendingWrite));
+    }
+
+    void ImageModificationBatch::clear(const float color[4])
+    {
+        writes.clear();
+        hasClear = true;
+        std::copy(color, color + 4, clearColor);
+    }
+
+    size_t EncodeClearTexel(VkFormat format, const float color[4], std::byte* texel) noexcept
+    {
+        uint8_t unorm8[4];
+        uint16_t half[4];
+
+        switch (format)
+        {
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        {
+            const size_t numComponents = format == VK_FORMAT_R8_UNORM ? 1u : (format == VK_FORMAT_R8G8_UNORM ? 2u : 4u);
+            for (size_t i = 0u; i < numComponents; ++i)
+            {
+                unorm8[i] = floatToUnorm8(color[i]);
+            }
+            memcpy(texel, unorm8, numComponents);
+            return numComponents;
+        }
+        case VK_FORMAT_R8G8B8A8_SRGB:
+            unorm8[0] = floatToUnorm8(linearToSrgb(color[0]));
+            unorm8[1] = floatToUnorm8(linearToSrgb(color[1]));
+            unorm8[2] = floatToUnorm8(linearToSrgb(color[2]));
+            unorm8[3] = floatToUnorm8(color[3]);
+            memcpy(texel, unorm8, 4u);
+            return 4u;
+        case VK_FORMAT_B8G8R8A8_UNORM:
+            unorm8[0] = floatToUnorm8(color[2]);
+            unorm8[1] = floatToUnorm8(color[1]);
+            unorm8[2] = floatToUnorm8(color[0]);
+            unorm8[3] = floatToUnorm8(color[3]);
+            memcpy(texel, unorm8, 4u);
+            return 4u;
+        case VK_FORMAT_B8G8R8A8_SRGB:
+            unorm8[0] = floatToUnorm8(linearToSrgb(color[2]));
+            unorm8[1] = floatToUnorm8(linearToSrgb(color[1]));
+            unorm8[2] = floatToUnorm8(linearToSrgb(color[0]));
+            unorm8[3] = floatToUnorm8(color[3]);
+            memcpy(texel, unorm8, 4u);
+            return 4u;
+        case VK_FORMAT_R16_SFLOAT:
+        case VK_FORMAT_R16G16_SFLOAT:
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+        {
+            const size_t numComponents = format == VK_FORMAT_R16_SFLOAT ? 1u : (format == VK_FORMAT_R16G16_SFLOAT ? 2u : 4u);
+            for (size_t i = 0u; i < numComponents; ++i)
+            {
+                half[i] = floatToHalf(color[i]);
+            }
+            memcpy(texel, half, numComponents * sizeof(uint16_t));
+            return numComponents * sizeof(uint16_t);
+        }
+        case VK_FORMAT_R32_SFLOAT:
+            memcpy(texel, color, sizeof(float));
+            return sizeof(float);
+        case VK_FORMAT_R32G32_SFLOAT:
+            memcpy(texel, color, 2u * sizeof(float));
+            return 2u * sizeof(float);
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            memcpy(texel, color, 4u * sizeof(float));
+            return 4u * sizeof(float);
+        case VK_FORMAT_R32_UINT:
+        {
+            const uint32_t value = static_cast<uint32_t>(std::max(color[0], 0.0f));
+            memcpy(texel, &value, sizeof(uint32_t));
+            return sizeof(uint32_t);
+        }
+        default:
+            return 0u;
+        }
+    }
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+#ifndef PETRICHOR_RESOURCE_MODIFICATION_HPP
+#define PETRICHOR_RESOURCE_MODIFICATION_HPP
+#include "PetrichorResourceTypes.hpp"
+#include <cstddef>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace petrichor
+{
+
+    struct PendingBufferWrite
+    {
+        VkDeviceSize offset{ 0u };
+        std::vector<std::byte> data;
+    };
+
+    struct PendingBufferFill
+    {
+        VkDeviceSize offset{ 0u };
+        VkDeviceSize size{ 0u };
+        uint32_t value{ 0u };
+    };
+
+    // Every SetContents/ClearContents queued against a single buffer during a frame. Fills are
+    // recorded before the writes, so a fill queued after a write is painted into that write instead
+    struct BufferModificationBatch
+    {
+        void write(VkDeviceSize offset, const void* data, VkDeviceSize size);
+        void fill(VkDeviceSize offset, VkDeviceSize size, uint32_t value);
+        // Union of all written ranges, with overlapping and adjacent writes merged together
+        std::vector<VkBufferCopy> mergedRanges() const;
+        // Writes the merged ranges (from mergedRanges()) into staging memory back to back, later writes winning
+        // where they overlap. Sets each range's srcOffset to where it was placed, starting at staging_offset
+        void stage(std::vector<VkBufferCopy>& ranges, std::byte* staging, VkDeviceSize staging_offset) const;
+
+        std::vector<PendingBufferFill> fills;
+        std::vector<PendingBufferWrite> writes;
+    };
+
+    struct PendingImageWrite
+    {
+        // Data points into the owned copy, not the caller's memory
+        GpuImageResourceData region;
+        std::vector<std::byte> data;
+    };
+
+    // Images only support whole-subresource writes, so coalescing is just dropping writes that get overwritten
+    struct ImageModificationBatch
+    {
+        // Replaces any earlier write to the same mip level and layers
+        void write(const GpuImageResourceData& region);
+        // Clears cover the whole image, so every earlier write is dropped
+        void clear(const float color[4]);
+
+        bool hasClear{ false };
+        float clearColor[4]{ 0.0f, 0.0f, 0.0f, 0.0f };
+        std::vector<PendingImageWrite> writes;
+    };
+
+    // Encodes color as a single texel of a color format, for devices that can't clear images on the transfer queue.
+    // Returns the size of the texel written to texel, or zero if we don't know how to encode the format
+    size_t EncodeClearTexel(VkFormat format, const float color[4], std::byte* texel) noexcept;
+
+}
+
+#endif //!PETRICHOR_RESOURCE_MODIFICATION_HPP
@@ -0,0 +1,191 @@
+#include "SparseResidency.hpp"
+#include <algorithm>
+
+namespace petrichor
+{
+
+    VmaAllocation SparsePagePool::acquire(VmaAllocator allocator, const VkMemoryRequirements& page_requirements)
+    {
+        const uint32_t memoryTypeIdx = pageMemoryType(allocator, page_requirements);
+        if (memoryTypeIdx == std::numeric_limits<uint32_t>::max())
+        {
+            return VK_NULL_HANDLE;
+        }
+
+        auto& pages = freePages[poolKey(page_requirements.size, memoryTypeIdx)];
+        if (!pages.empty())
+        {
+            VmaAllocation result = pages.back();
+            pages.pop_back();
+            return result;
+        }
+
+        VkMemoryRequirements requirements = page_requirements;
+        requirements.memoryTypeBits = 1u << memoryTypeIdx;
+        VmaAllocationCreateInfo allocCreateInfo{};
+        allocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+        VmaAllocation result{ VK_NULL_HANDLE };
+        if (vmaAllocateMemory(allocator, &requirements, &allocCreateInfo, &result, nullptr) != VK_SUCCESS)
+        {
+            return VK_NULL_HANDLE;
+        }
+
+        return result;
+    }
+
+    void SparsePagePool::release(VmaAllocator allocator, VmaAllocation page)
+    {
+        VmaAllocationInfo allocInfo{};
+        vmaGetAllocationInfo(allocator, page, &allocInfo);
+        freePages[poolKey(allocInfo.size, allocInfo.memoryType)].emplace_back(page);
+    }
+
+    void SparsePagePool::destroy(VmaAllocator allocator)
+    {
+        for (auto& [key, pages] : freePages)
+        {
+            for (auto& page : pages)
+            {
+                vmaFreeMemory(allocator, page);
+            }
+        }
+        freePages.clear();
+    }
+
+    size_t SparsePagePool::pooledPageCount(VmaAllocator allocator, const VkMemoryRequirements& page_requirements) const
+    {
+        auto iter = freePages.find(poolKey(page_requirements.size, pageMemoryType(allocator, page_requirements)));
+        return iter != freePages.cend() ? iter->second.size() : 0u;
+    }
+
+    uint64_t SparsePagePool::poolKey(VkDeviceSize page_size, uint32_t memory_type_idx) noexcept
+    {
+        return (static_cast<uint64_t>(page_size) * VK_MAX_MEMORY_TYPES) + memory_type_idx;
+    }
+
+    uint32_t SparsePagePool::pageMemoryType(VmaAllocator allocator, const VkMemoryRequirements& page_requirements)
+    {
+        VmaAllocationCreateInfo allocCreateInfo{};
+        allocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+        uint32_t result = std::numeric_limits<uint32_t>::max();
+        vmaFindMemoryTypeIndex(allocator, page_requirements.memoryTypeBits, &allocCreateInfo, &result);
+        return result;
+    }
+
+    bool SparseImageState::initialize(VkDevice device, VkImage _image, const VkImageCreateInfo& create_info)
+    {
+        image = _image;
+        extent = create_info.extent;
+        mipLevels = create_info.mipLevels;
+        arrayLayers = create_info.arrayLayers;
+
+        // For sparse resources, the alignment is the size of a single sparse block: which is our page
+        vkGetImageMemoryRequirements(device, image, &pageRequirements);
+        pageRequirements.size = pageRequirements.alignment;
+
+        uint32_t requirementsCount = 0u;
+        vkGetImageSparseMemoryRequirements(device, image, &requirementsCount, nullptr);
+        if (requirementsCount == 0u)
+        {
+            return false;
+        }
+
+        std::vector<VkSparseImageMemoryRequirements> sparseRequirements(requirementsCount);
+        vkGetImageSparseMemoryRequirements(device, image, &requirementsCount, sparseRequirements.data());
+
+        // Metadata aspects would need their own opaque binds: not worth supporting for the formats we stream
+        for (const auto& requirements : sparseRequirements)
+        {
+            if (requirements.formatProperties.aspectMask & VK_IMAGE_ASPECT_METADATA_BIT)
+            {
+                return false;
+            }
+        }
+
+        const VkSparseImageMemoryRequirements& primary = sparseRequirements.front();
+        aspectMask = primary.formatProperties.aspectMask;
+        granularity = primary.formatProperties.imageGranularity;
+        mipTailFirstLod = primary.imageMipTailFirstLod;
+        mipTailSize = primary.imageMipTailSize;
+        mipTailOffset = primary.imageMipTailOffset;
+        mipTailStride = primary.imageMipTailStride;
+        singleMipTail = (primary.formatProperties.flags & VK_SPARSE_IMAGE_FORMAT_SINGLE_MIPTAIL_BIT) != 0;
+
+        const uint32_t tiledLevels = std::min(mipTailFirstLod, mipLevels);
+        tilesPerLayer = 0u;
+        for (uint32_t mip = 0u; mip < tiledLevels; ++mip)
+        {
+            const uint32_t mipWidth = std::max(extent.width >> mip, 1u);
+            const uint32_t mipHeight = std::max(extent.height >> mip, 1u);
+            const uint32_t mipDepth = std::max(extent.depth >> mip, 1u);
+            const VkExtent3D tileCount
+            {
+                (mipWidth + granularity.width - 1u) / granularity.width,
+                (mipHeight + granularity.height - 1u) / granularity.height,
+                (mipDepth + granularity.depth - 1u) / granularity.depth
+            };
+
+            mipTileOffsets.emplace_back(tilesPerLayer);
+            mipTileCounts.emplace_back(tileCount);
+            tilesPerLayer += static_cast<uint64_t>(tileCount.width) * tileCount.height * tileCount.depth;
+        }
+
+        tilePages.assign(static_cast<size_t>(tilesPerLayer * arrayLayers), VK_NULL_HANDLE);
+        mipTailPages.assign(mipTailCount(), VK_NULL_HANDLE);
+        return true;
+    }
+
+    uint64_t SparseImageState::tileIndex(const SparseImagePageRequest& request) const noexcept
+    {
+        if ((request.MipLevel >= mipTileCounts.size()) || (request.ArrayLayer >= arrayLayers))
+        {
+            return TileIndexInvalid;
+        }
+
+        const VkExtent3D& tileCount = mipTileCounts[request.MipLevel];
+        if ((request.TileX >= tileCount.width) || (request.TileY >= tileCount.height) || (request.TileZ >= tileCount.depth))
+        {
+            return TileIndexInvalid;
+        }
+
+        const uint64_t tileInMip = (static_cast<uint64_t>(request.TileZ) * tileCount.height + request.TileY) * tileCount.width + request.TileX;
+        return (request.ArrayLayer * tilesPerLayer) + mipTileOffsets[request.MipLevel] + tileInMip;
+    }
+
+    VkSparseImageMemoryBind SparseImageState::tileBind(const SparseImagePageRequest& request, VkDeviceMemory memory, VkDeviceSize memory_offset) const noexcept
+    {
+        const uint32_t mipWidth = std::max(extent.width >> request.MipLevel, 1u);
+        const uint32_t mipHeight = std::max(extent.height >> request.MipLevel, 1u);
+        const uint32_t mipDepth = std::max(extent.depth >> request.MipLevel, 1u);
+        const uint32_t x = request.TileX * granularity.width;
+        const uint32_t y = request.TileY * granularity.height;
+        const uint32_t z = request.TileZ * granularity.depth;
+
+        // Edge tiles are clamped to the mip's extent, which the spec allows instead of a granularity multiple
+        return VkSparseImageMemoryBind
+        {
+            VkImageSubresource{ aspectMask, request.MipLevel, request.ArrayLayer },
+            VkOffset3D{ static_cast<int32_t>(x), static_cast<int32_t>(y), static_cast<int32_t>(z) },
+            VkExtent3D{ std::min(granularity.width, mipWidth - x), std::min(granularity.height, mipHeight - y), std::min(granularity.depth, mipDepth - z) },
+            memory,
+            memory_offset,
+            0
+        };
+    }
+
+    uint32_t SparseImageState::mipTailCount() const noexcept
+    {
+        if (mipTailFirstLod >= mipLevels)
+        {
+            return 0u;
+        }
+        return singleMipTail ? 1u : arrayLayers;
+    }
+
+    VkDeviceSize SparseImageState::mipTailResourceOffset(uint32_t tail_idx) const noexcept
+    {
+        return mipTailOffset + (static_cast<VkDeviceSize>(tail_idx) * mipTailStride);
+    }
+
+}
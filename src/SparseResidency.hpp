@@ -0,0 +1,71 @@
+#pragma once
+#ifndef PETRICHOR_SPARSE_RESIDENCY_HPP
+#define PETRICHOR_SPARSE_RESIDENCY_HPP
+#include "PetrichorResourceTypes.hpp"
+#include <vector>
+#include <limits>
+#include <unordered_map>
+#include <vulkan/vulkan_core.h>
+#include "vk_mem_alloc.h"
+
+namespace petrichor
+{
+
+    // Pool of sparse block sized allocations, shared between all sparse images so that tiles
+    // released by one image can be committed to another without going back to the driver
+    struct SparsePagePool
+    {
+        VmaAllocation acquire(VmaAllocator allocator, const VkMemoryRequirements& page_requirements);
+        void release(VmaAllocator allocator, VmaAllocation page);
+        void destroy(VmaAllocator allocator);
+        size_t pooledPageCount(VmaAllocator allocator, const VkMemoryRequirements& page_requirements) const;
+
+    private:
+        // Pages are only interchangeable if both their size and memory type match
+        static uint64_t poolKey(VkDeviceSize page_size, uint32_t memory_type_idx) noexcept;
+        static uint32_t pageMemoryType(VmaAllocator allocator, const VkMemoryRequirements& page_requirements);
+        std::unordered_map<uint64_t, std::vector<VmaAllocation>> freePages;
+    };
+
+    // Tile layout and page table of a single sparse image
+    struct SparseImageState
+    {
+        // Reads the sparse requirements of image: returns false if the image can't be used as a sparse image
+        bool initialize(VkDevice device, VkImage image, const VkImageCreateInfo& create_info);
+        // Linear index of the tile in pages, or TileIndexInvalid if it's out of range or inside the mip tail
+        uint64_t tileIndex(const SparseImagePageRequest& request) const noexcept;
+        VkSparseImageMemoryBind tileBind(const SparseImagePageRequest& request, VkDeviceMemory memory, VkDeviceSize memory_offset) const noexcept;
+        // Number of mip tail regions we need to bind (one per layer, unless the tail is shared)
+        uint32_t mipTailCount() const noexcept;
+        VkDeviceSize mipTailResourceOffset(uint32_t tail_idx) const noexcept;
+
+        constexpr static uint64_t TileIndexInvalid = std::numeric_limits<uint64_t>::max();
+
+        VkImage image{ VK_NULL_HANDLE };
+        VkImageAspectFlags aspectMask{ 0u };
+        VkExtent3D extent{ 0u, 0u, 0u };
+        VkExtent3D granularity{ 0u, 0u, 0u };
+        uint32_t mipLevels{ 1u };
+        uint32_t arrayLayers{ 1u };
+        uint32_t mipTailFirstLod{ 0u };
+        VkDeviceSize mipTailSize{ 0u };
+        VkDeviceSize mipTailOffset{ 0u };
+        VkDeviceSize mipTailStride{ 0u };
+        bool singleMipTail{ false };
+        // Ordinary, fully resident image used because the device can't do sparse residency for it
+        bool isFallback{ false };
+        VkMemoryRequirements pageRequirements{};
+        // Tile counts for each mip level below the mip tail
+        std::vector<VkExtent3D> mipTileCounts;
+        // First tile index of each mip level, within a single array layer
+        std::vector<uint64_t> mipTileOffsets;
+        uint64_t tilesPerLayer{ 0u };
+        // One page per tile: VK_NULL_HANDLE if the tile isn't resident
+        std::vector<VmaAllocation> tilePages;
+        std::vector<VmaAllocation> mipTailPages;
+        uint64_t residentTiles{ 0u };
+    };
+
+}
+
+#endif //!PETRICHOR_SPARSE_RESIDENCY_HPP
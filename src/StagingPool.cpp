@@ -0,0 +1,138 @@
+#include "StagingPool.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace petrichor
+{
+
+    VkResult StagingBufferPool::acquire(VmaAllocator allocator, VkDeviceSize size, bool host_cached, const VmaAllocationCreateInfo& alloc_create_info, StagingBuffer& staging)
+    {
+        const VkDeviceSize capacity = sizeClass(size);
+        {
+            std::lock_guard lock(mutex);
+            auto& buffers = freeBuffers[host_cached ? 1 : 0][capacity];
+            if (!buffers.empty())
+            {
+                staging = buffers.back();
+                buffers.pop_back();
+                ++poolStats.Reuses;
+                --poolStats.PooledBuffers;
+                poolStats.PooledBytes -= capacity;
+                poolStats.InUseBytes += capacity;
+                return VK_SUCCESS;
+            }
+        }
+
+        // Created outside the lock: this is the slow path, and other threads may well hit in the meantime
+        const VkBufferCreateInfo createInfo
+        {
+            VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            nullptr,
+            0,
+            capacity,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_SHARING_MODE_EXCLUSIVE,
+            0u,
+            nullptr
+        };
+
+        StagingBuffer result{};
+        VmaAllocationInfo allocationInfo{};
+        VkResult vkResult = vmaCreateBuffer(allocator, &createInfo, &alloc_create_info, &result.buffer, &result.allocation, &allocationInfo);
+        if (vkResult != VK_SUCCESS)
+        {
+            return vkResult;
+        }
+
+        result.capacity = capacity;
+        result.mappedData = allocationInfo.pMappedData;
+        result.hostCached = host_cached;
+        staging = result;
+
+        std::lock_guard lock(mutex);
+        ++poolStats.Allocations;
+        poolStats.InUseBytes += capacity;
+        return VK_SUCCESS;
+    }
+
+    void StagingBufferPool::release(StagingBuffer buffer, uint64_t frame)
+    {
+        if (buffer.buffer == VK_NULL_HANDLE)
+        {
+            return;
+        }
+
+        buffer.releasedFrame = frame;
+        std::lock_guard lock(mutex);
+        freeBuffers[buffer.hostCached ? 1 : 0][buffer.capacity].emplace_back(buffer);
+        ++poolStats.PooledBuffers;
+        poolStats.PooledBytes += buffer.capacity;
+        poolStats.InUseBytes -= buffer.capacity;
+    }
+
+    void StagingBufferPool::trim(uint64_t frame, std::vector<StagingBuffer>& trimmed)
+    {
+        std::lock_guard lock(mutex);
+        if (idleFrames == 0u)
+        {
+            return;
+        }
+
+        for (auto& classes : freeBuffers)
+        {
+            for (auto& [capacity, buffers] : classes)
+            {
+                // Oldest first, so the idle ones are a prefix
+                auto firstActive = std::find_if(buffers.begin(), buffers.end(), [this, frame](const StagingBuffer& buffer)
+                {
+                    return frame - buffer.releasedFrame < idleFrames;
+                });
+
+                for (auto iter = buffers.begin(); iter != firstActive; ++iter)
+                {
+                    trimmed.emplace_back(*iter);
+                    ++poolStats.TrimmedBuffers;
+                    --poolStats.PooledBuffers;
+                    poolStats.PooledBytes -= capacity;
+                }
+                buffers.erase(buffers.begin(), firstActive);
+            }
+        }
+    }
+
+    void StagingBufferPool::destroy(VmaAllocator allocator)
+    {
+        std::lock_guard lock(mutex);
+        for (auto& classes : freeBuffers)
+        {
+            for (auto& [capacity, buffers] : classes)
+            {
+                for (auto& buffer : buffers)
+                {
+                    vmaDestroyBuffer(allocator, buffer.buffer, buffer.allocation);
+                }
+            }
+            classes.clear();
+        }
+        poolStats.PooledBuffers = 0u;
+        poolStats.PooledBytes = 0u;
+    }
+
+    void StagingBufferPool::setIdleFrames(uint32_t frames)
+    {
+        std::lock_guard lock(mutex);
+        idleFrames = frames;
+    }
+
+    StagingPoolStats StagingBufferPool::stats() const
+    {
+        std::lock_guard lock(mutex);
+        return poolStats;
+    }
+
+    VkDeviceSize StagingBufferPool::sizeClass(VkDeviceSize size) noexcept
+    {
+        return size <= MinSizeClass ? MinSizeClass : std::bit_ceil(size);
+    }
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+#ifndef PETRICHOR_STAGING_POOL_HPP
+#define PETRICHOR_STAGING_POOL_HPP
+#include "PetrichorResourceTypes.hpp"
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <vulkan/vulkan_core.h>
+#include "vk_mem_alloc.h"
+
+namespace petrichor
+{
+
+    // Persistently mapped buffer that uploads are copied through
+    struct StagingBuffer
+    {
+        VkBuffer buffer{ VK_NULL_HANDLE };
+        VmaAllocation allocation{ VK_NULL_HANDLE };
+        VkDeviceSize capacity{ 0u };
+        void* mappedData{ nullptr };
+        bool hostCached{ false };
+        // Frame it was last handed back in, which idle trimming goes by
+        uint64_t releasedFrame{ 0u };
+    };
+
+    // Staging buffers bucketed by power of two size class, separately for coherent and host cached memory. Buffers only come
+    // back once the frame that used them has retired (its fence has signaled), and go back to VMA once they've sat unused
+    // for long enough. Any thread can acquire: release and trim are left to the thread retiring frames
+    struct StagingBufferPool
+    {
+        VkResult acquire(VmaAllocator allocator, VkDeviceSize size, bool host_cached, const VmaAllocationCreateInfo& alloc_create_info, StagingBuffer& staging);
+        void release(StagingBuffer buffer, uint64_t frame);
+        // Takes out buffers that have been idle for idleFrames or more, oldest first in each class, for the caller to free
+        void trim(uint64_t frame, std::vector<StagingBuffer>& trimmed);
+        void destroy(VmaAllocator allocator);
+        // Zero keeps idle buffers forever
+        void setIdleFrames(uint32_t frames);
+        StagingPoolStats stats() const;
+
+        constexpr static VkDeviceSize MinSizeClass = 64u * 1024u;
+        constexpr static uint32_t DefaultIdleFrames = 300u;
+        static VkDeviceSize sizeClass(VkDeviceSize size) noexcept;
+
+    private:
+        mutable std::mutex mutex;
+        // Indexed by hostCached. Used as stacks, so the buffers at the front are the ones idling longest
+        std::unordered_map<VkDeviceSize, std::vector<StagingBuffer>> freeBuffers[2];
+        uint32_t idleFrames{ DefaultIdleFrames };
+        StagingPoolStats poolStats;
+    };
+
+}
+
+#endif //!PETRICHOR_STAGING_POOL_HPP
@@ -0,0 +1,152 @@
+#include "TransientAliasing.hpp"
+#include <algorithm>
+#include <numeric>
+#include <limits>
+
+namespace
+{
+
+    constexpr inline VkDeviceSize alignUp(const VkDeviceSize value, const VkDeviceSize alignment) noexcept
+    {
+        return ((value + alignment - 1u) / alignment) * alignment;
+    }
+
+    constexpr inline bool lifetimesOverlap(const petrichor::TransientAllocationRequest& a, const petrichor::TransientAllocationRequest& b) noexcept
+    {
+        return (a.firstUse <= b.lastUse) && (b.firstUse <= a.lastUse);
+    }
+
+    struct OccupiedRange
+    {
+        VkDeviceSize begin;
+        VkDeviceSize end;
+    };
+
+}
+
+namespace petrichor
+{
+
+    TransientPackResult PackTransientResources(const std::vector<TransientAllocationRequest>& requests)
+    {
+        TransientPackResult result;
+        result.placements.resize(requests.size());
+        result.aliasedPredecessors.resize(requests.size());
+
+        std::vector<uint32_t> order(requests.size());
+        std::iota(order.begin(), order.end(), 0u);
+        // Largest first: small resources then fill the gaps left between big ones
+        std::stable_sort(order.begin(), order.end(), [&requests](const uint32_t lhs, const uint32_t rhs)
+        {
+            return requests[lhs].requirements.size > requests[rhs].requirements.size;
+        });
+
+        std::vector<std::vector<uint32_t>> heapContents;
+        std::vector<OccupiedRange> occupied;
+
+        for (const uint32_t requestIdx : order)
+        {
+            const TransientAllocationRequest& request = requests[requestIdx];
+            const VkDeviceSize alignment = std::max<VkDeviceSize>(request.requirements.alignment, 1u);
+            result.unaliasedBytes += request.requirements.size;
+
+            uint32_t bestHeap = std::numeric_limits<uint32_t>::max();
+            VkDeviceSize bestOffset = 0u;
+            VkDeviceSize bestGrowth = std::numeric_limits<VkDeviceSize>::max();
+
+            for (uint32_t heapIdx = 0u; heapIdx < result.heaps.size(); ++heapIdx)
+            {
+                const TransientHeapLayout& heap = result.heaps[heapIdx];
+                if ((heap.memoryTypeBits & request.requirements.memoryTypeBits) == 0u)
+                {
+                    continue;
+                }
+
+                occupied.clear();
+                for (const uint32_t placedIdx : heapContents[heapIdx])
+                {
+                    if (lifetimesOverlap(request, requests[placedIdx]))
+                    {
+                        const VkDeviceSize begin = result.placements[placedIdx].offset;
+                        occupied.emplace_back(OccupiedRange{ begin, begin + requests[placedIdx].requirements.size });
+                    }
+                }
+
+                std::sort(occupied.begin(), occupied.end(), [](const OccupiedRange& lhs, const OccupiedRange& rhs)
+                {
+                    return lhs.begin < rhs.begin;
+                });
+
+                // First gap large enough, searching upwards from the start of the heap
+                VkDeviceSize candidate = 0u;
+                for (const auto& range : occupied)
+                {
+                    if (candidate + request.requirements.size <= range.begin)
+                    {
+                        break;
+                    }
+                    candidate = std::max(candidate, alignUp(range.end, alignment));
+                }
+
+                const VkDeviceSize end = candidate + request.requirements.size;
+                const VkDeviceSize growth = end > heap.size ? end - heap.size : 0u;
+                if (growth < bestGrowth)
+                {
+                    bestHeap = heapIdx;
+                    bestOffset = candidate;
+                    bestGrowth = growth;
+                }
+            }
+
+            if (bestHeap == std::numeric_limits<uint32_t>::max())
+            {
+                bestHeap = static_cast<uint32_t>(result.heaps.size());
+                bestOffset = 0u;
+                result.heaps.emplace_back(TransientHeapLayout{ 0u, 1u, request.requirements.memoryTypeBits });
+                heapContents.emplace_back();
+            }
+
+            TransientHeapLayout& heap = result.heaps[bestHeap];
+            heap.size = std::max(heap.size, bestOffset + request.requirements.size);
+            heap.alignment = std::max(heap.alignment, alignment);
+            heap.memoryTypeBits &= request.requirements.memoryTypeBits;
+            heapContents[bestHeap].emplace_back(requestIdx);
+            result.placements[requestIdx] = TransientPlacement{ bestHeap, bestOffset };
+        }
+
+        for (const auto& contents : heapContents)
+        {
+            for (const uint32_t idx : contents)
+            {
+                const VkDeviceSize begin = result.placements[idx].offset;
+                const VkDeviceSize end = begin + requests[idx].requirements.size;
+                for (const uint32_t otherIdx : contents)
+                {
+                    const VkDeviceSize otherBegin = result.placements[otherIdx].offset;
+                    const VkDeviceSize otherEnd = otherBegin + requests[otherIdx].requirements.size;
+                    if ((requests[otherIdx].lastUse < requests[idx].firstUse) && (otherBegin < end) && (begin < otherEnd))
+                    {
+                        result.aliasedPredecessors[idx].emplace_back(otherIdx);
+                    }
+                }
+            }
+        }
+
+        // Live bytes only change at a request's first use, so those are the only points worth checking
+        for (const auto& request : requests)
+        {
+            VkDeviceSize liveBytes = 0u;
+            for (const auto& other : requests)
+            {
+                if ((other.firstUse <= request.firstUse) && (request.firstUse <= other.lastUse))
+                {
+                    liveBytes += other.requirements.size;
+                }
+            }
+            result.peakLiveBytes = std::max(result.peakLiveBytes, liveBytes);
+        }
+
+        return result;
+    }
+
+}
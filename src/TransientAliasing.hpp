@@ -0,0 +1,52 @@
+#pragma once
+#ifndef PETRICHOR_TRANSIENT_ALIASING_HPP
+#define PETRICHOR_TRANSIENT_ALIASING_HPP
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace petrichor
+{
+
+    struct TransientAllocationRequest
+    {
+        VkMemoryRequirements requirements{};
+        // Inclusive range of use points the resource is alive for
+        uint32_t firstUse{ 0u };
+        uint32_t lastUse{ 0u };
+    };
+
+    struct TransientPlacement
+    {
+        uint32_t heapIdx{ 0u };
+        VkDeviceSize offset{ 0u };
+    };
+
+    struct TransientHeapLayout
+    {
+        VkDeviceSize size{ 0u };
+        VkDeviceSize alignment{ 1u };
+        uint32_t memoryTypeBits{ 0u };
+    };
+
+    struct TransientPackResult
+    {
+        std::vector<TransientHeapLayout> heaps;
+        // Indexed the same as the requests
+        std::vector<TransientPlacement> placements;
+        // Requests that occupied (part of) the same memory earlier in the frame, which need an aliasing barrier
+        std::vector<std::vector<uint32_t>> aliasedPredecessors;
+        // Sum of every request's size: what we'd allocate without aliasing
+        VkDeviceSize unaliasedBytes{ 0u };
+        // Most bytes alive at any single use point: the lower bound for any packing
+        VkDeviceSize peakLiveBytes{ 0u };
+    };
+
+    // Packs requests into as few, and as small, heaps as possible. Requests only share memory if
+    // their lifetimes don't overlap, and they only share a heap if their memory types are compatible.
+    // Placement is greedy, largest first, at the lowest offset that doesn't collide with a live request.
+    TransientPackResult PackTransientResources(const std::vector<TransientAllocationRequest>& requests);
+
+}
+
+#endif //!PETRICHOR_TRANSIENT_ALIASING_HPP
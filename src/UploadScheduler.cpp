@@ -0,0 +1,156 @@
+#include "UploadScheduler.hpp"
+#include <algorithm>
+
+namespace petrichor
+{
+
+    void UploadScheduler::setBudget(const UploadBudget& new_budget)
+    {
+        std::lock_guard lock(mutex);
+        budget = new_budget;
+        active.store((budget.MaxBytesPerFrame != 0u) || (budget.MaxUploadsPerFrame != 0u) || (budget.TargetMilliseconds > 0.0f), std::memory_order_release);
+    }
+
+    bool UploadScheduler::enabled() const noexcept
+    {
+        return active.load(std::memory_order_acquire);
+    }
+
+    void UploadScheduler::push(uint64_t frame, std::vector<ScheduledUpload>& uploads)
+    {
+        std::lock_guard lock(mutex);
+        for (auto& upload : uploads)
+        {
+            upload.queuedFrame = frame;
+            upload.sequence = nextSequence++;
+            pending.emplace_back(std::move(upload));
+        }
+        lastStats.TotalDeferredUploads += uploads.size();
+        uploads.clear();
+    }
+
+    void UploadScheduler::expedite(std::vector<GpuResourceHandle>& handles)
+    {
+        std::lock_guard lock(mutex);
+        if (pending.empty())
+        {
+            return;
+        }
+
+        std::sort(handles.begin(), handles.end());
+        for (auto& upload : pending)
+        {
+            upload.expedited |= std::binary_search(handles.begin(), handles.end(), upload.handle);
+        }
+    }
+
+    void UploadScheduler::take(uint64_t frame, std::vector<ScheduledUpload>& uploads)
+    {
+        std::lock_guard lock(mutex);
+        lastStats.CurrentByteBudget = byteBudget();
+        lastStats.LastFrameUploads = 0u;
+        lastStats.LastFrameBytes = 0u;
+
+        auto urgent = [frame](const ScheduledUpload& upload) noexcept
+        {
+            return upload.expedited || (upload.deadlineFrame <= frame);
+        };
+
+        std::sort(pending.begin(), pending.end(), [&urgent](const ScheduledUpload& lhs, const ScheduledUpload& rhs)
+        {
+            const bool lhsUrgent = urgent(lhs);
+            const bool rhsUrgent = urgent(rhs);
+            if (lhsUrgent != rhsUrgent)
+            {
+                return lhsUrgent;
+            }
+            if (lhs.priority != rhs.priority)
+            {
+                return lhs.priority > rhs.priority;
+            }
+            if (lhs.deadlineFrame != rhs.deadlineFrame)
+            {
+                return lhs.deadlineFrame < rhs.deadlineFrame;
+            }
+            return lhs.sequence < rhs.sequence;
+        });
+
+        const VkDeviceSize maxBytes = lastStats.CurrentByteBudget != 0u ? lastStats.CurrentByteBudget : std::numeric_limits<VkDeviceSize>::max();
+        const uint32_t maxUploads = budget.MaxUploadsPerFrame != 0u ? budget.MaxUploadsPerFrame : std::numeric_limits<uint32_t>::max();
+
+        // Sorted, so the taken ones are a prefix
+        size_t numTaken = 0u;
+        for (; numTaken < pending.size(); ++numTaken)
+        {
+            const ScheduledUpload& upload = pending[numTaken];
+            const bool fits = (lastStats.LastFrameBytes + upload.bytes <= maxBytes) && (lastStats.LastFrameUploads < maxUploads);
+            if (!urgent(upload) && !fits && (numTaken != 0u))
+            {
+                break;
+            }
+            lastStats.LastFrameBytes += upload.bytes;
+            ++lastStats.LastFrameUploads;
+        }
+
+        uploads.insert(uploads.end(), std::make_move_iterator(pending.begin()), std::make_move_iterator(pending.begin() + numTaken));
+        pending.erase(pending.begin(), pending.begin() + numTaken);
+
+        lastStats.BacklogUploads = static_cast<uint32_t>(pending.size());
+        lastStats.BacklogBytes = 0u;
+        uint64_t oldestFrame = frame;
+        for (const auto& upload : pending)
+        {
+            lastStats.BacklogBytes += upload.bytes;
+            oldestFrame = std::min(oldestFrame, upload.queuedFrame);
+        }
+        lastStats.OldestBacklogFrames = frame - oldestFrame;
+    }
+
+    void UploadScheduler::drain(std::vector<ScheduledUpload>& uploads)
+    {
+        std::lock_guard lock(mutex);
+        uploads.insert(uploads.end(), std::make_move_iterator(pending.begin()), std::make_move_iterator(pending.end()));
+        pending.clear();
+        lastStats.BacklogUploads = 0u;
+        lastStats.BacklogBytes = 0u;
+        lastStats.OldestBacklogFrames = 0u;
+    }
+
+    void UploadScheduler::recordThroughput(VkDeviceSize bytes, uint64_t nanoseconds)
+    {
+        if ((bytes == 0u) || (nanoseconds == 0u))
+        {
+            return;
+        }
+
+        const double sample = static_cast<double>(bytes) * 1.0e9 / static_cast<double>(nanoseconds);
+        std::lock_guard lock(mutex);
+        bytesPerSecond = bytesPerSecond != 0.0 ? bytesPerSecond + ThroughputSmoothing * (sample - bytesPerSecond) : sample;
+    }
+
+    UploadSchedulerStats UploadScheduler::stats() const
+    {
+        std::lock_guard lock(mutex);
+        UploadSchedulerStats result = lastStats;
+        result.MeasuredBytesPerSecond = bytesPerSecond;
+        return result;
+    }
+
+    VkDeviceSize UploadScheduler::byteBudget() const noexcept
+    {
+        if (budget.TargetMilliseconds <= 0.0f)
+        {
+            return budget.MaxBytesPerFrame;
+        }
+
+        if (bytesPerSecond == 0.0)
+        {
+            return budget.MaxBytesPerFrame != 0u ? budget.MaxBytesPerFrame : UnmeasuredBytesPerFrame;
+        }
+
+        // Never down to zero, or nothing but the one forced upload would ever go
+        const VkDeviceSize measured = std::max(static_cast<VkDeviceSize>(bytesPerSecond * static_cast<double>(budget.TargetMilliseconds) / 1000.0), VkDeviceSize{ 1u });
+        return budget.MaxBytesPerFrame != 0u ? std::min(budget.MaxBytesPerFrame, measured) : measured;
+    }
+
+}
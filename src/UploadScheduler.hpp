@@ -0,0 +1,81 @@
+#pragma once
+#ifndef PETRICHOR_UPLOAD_SCHEDULER_HPP
+#define PETRICHOR_UPLOAD_SCHEDULER_HPP
+#include "PetrichorResourceTypes.hpp"
+#include "CreationTrace.hpp"
+#include "StagingPool.hpp"
+#include <vulkan/vulkan_core.h>
+#include "vk_mem_alloc.h"
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace petrichor
+{
+
+    // Staged initial contents of a new resource, waiting for upload budget
+    struct ScheduledUpload
+    {
+        GpuResourceHandle handle{ INVALID_GPU_RESOURCE_HANDLE };
+        // Checked against the record before recording, in case the resource was destroyed while it waited
+        uint64_t vkHandle{ 0u };
+        GpuResourceType type{ GpuResourceType::Invalid };
+        VkBuffer source{ VK_NULL_HANDLE };
+        // Buffers use the first, images the second
+        std::vector<VkBufferCopy> bufferRegions;
+        std::vector<VkBufferImageCopy> imageRegions;
+        // Owned by the upload until it's recorded
+        std::vector<StagingBuffer> staging;
+        VkDeviceSize bytes{ 0u };
+        uint32_t priority{ 0u };
+        // Last frame it may be recorded in, whatever the budget
+        uint64_t deadlineFrame{ std::numeric_limits<uint64_t>::max() };
+        uint64_t queuedFrame{ 0u };
+        uint64_t sequence{ 0u };
+        // Set when something queued against the resource needs its contents this frame
+        bool expedited{ false };
+        bool traced{ false };
+        CreationTrace trace;
+    };
+
+    // Carries staged uploads over from frame to frame, within a per-frame budget. Only the work queue thread
+    // takes uploads out, but any thread can push them
+    struct UploadScheduler
+    {
+        void setBudget(const UploadBudget& budget);
+        // Set if new uploads should be pushed here, rather than recorded straight away
+        bool enabled() const noexcept;
+        void push(uint64_t frame, std::vector<ScheduledUpload>& uploads);
+        // Marks the uploads of these resources to be taken by the next take(), over budget or not. Sorts handles
+        void expedite(std::vector<GpuResourceHandle>& handles);
+        // Moves out what fits in this frame's budget: expedited and overdue uploads first (regardless of budget), then by
+        // priority, deadline and age. Stops at the first that doesn't fit, but always takes at least one
+        void take(uint64_t frame, std::vector<ScheduledUpload>& uploads);
+        // Everything still waiting, when the context is destroyed
+        void drain(std::vector<ScheduledUpload>& uploads);
+        // GPU time taken to copy bytes, from timestamp queries
+        void recordThroughput(VkDeviceSize bytes, uint64_t nanoseconds);
+        UploadSchedulerStats stats() const;
+
+    private:
+        // Used while adapting to throughput we haven't measured yet, if there's no byte limit to start from
+        constexpr static VkDeviceSize UnmeasuredBytesPerFrame = 16u * 1024u * 1024u;
+        // Weight of each new throughput sample: enough to follow clock changes, without chasing every noisy frame
+        constexpr static double ThroughputSmoothing = 0.25;
+
+        // Zero if unlimited. Requires mutex
+        VkDeviceSize byteBudget() const noexcept;
+
+        mutable std::mutex mutex;
+        std::vector<ScheduledUpload> pending;
+        UploadBudget budget;
+        std::atomic<bool> active{ false };
+        uint64_t nextSequence{ 0u };
+        double bytesPerSecond{ 0.0 };
+        UploadSchedulerStats lastStats;
+    };
+
+}
+
+#endif //!PETRICHOR_UPLOAD_SCHEDULER_HPP
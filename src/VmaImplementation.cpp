@@ -0,0 +1,3 @@
+// VMA is header only: this is the one translation unit that carries its implementation
+#define VMA_IMPLEMENTATION
+#include "vk_mem_alloc.h"
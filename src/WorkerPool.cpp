@@ -0,0 +1,122 @@
+#include "WorkerPool.hpp"
+#include <algorithm>
+
+namespace petrichor
+{
+
+    WorkerPool::~WorkerPool()
+    {
+        stop();
+    }
+
+    void WorkerPool::start(uint32_t num_workers)
+    {
+        std::lock_guard lock(mutex);
+        stopping = false;
+        workers.reserve(workers.size() + num_workers);
+        for (uint32_t i = 0u; i < num_workers; ++i)
+        {
+            workers.emplace_back(&WorkerPool::workerLoop, this);
+        }
+    }
+
+    void WorkerPool::stop()
+    {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        workAvailable.notify_all();
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+        workers.clear();
+    }
+
+    uint32_t WorkerPool::workerCount() const noexcept
+    {
+        return static_cast<uint32_t>(workers.size());
+    }
+
+    void WorkerPool::parallelFor(uint32_t count, const std::function<void(uint32_t)>& fn)
+    {
+        Batch batch;
+        batch.fn = &fn;
+        batch.count = count;
+
+        // Nothing to share with a single index (or no workers): don't bother waking anyone
+        const bool shared = (count > 1u) && !workers.empty();
+        if (shared)
+        {
+            {
+                std::lock_guard lock(mutex);
+                batches.emplace_back(&batch);
+            }
+            workAvailable.notify_all();
+        }
+
+        runBatch(batch);
+
+        if (shared)
+        {
+            // Every index is claimed by now, but workers may still be running theirs
+            std::unique_lock lock(mutex);
+            batches.erase(std::find(batches.begin(), batches.end(), &batch));
+            workerFinished.wait(lock, [&batch]() { return batch.activeWorkers == 0u; });
+        }
+    }
+
+    void WorkerPool::runBatch(Batch& batch)
+    {
+        uint32_t index = batch.nextIndex.fetch_add(1u, std::memory_order_relaxed);
+        while (index < batch.count)
+        {
+            (*batch.fn)(index);
+            index = batch.nextIndex.fetch_add(1u, std::memory_order_relaxed);
+        }
+    }
+
+    WorkerPool::Batch* WorkerPool::findWork() const
+    {
+        for (Batch* batch : batches)
+        {
+            if (batch->nextIndex.load(std::memory_order_relaxed) < batch->count)
+            {
+                return batch;
+            }
+        }
+        return nullptr;
+    }
+
+    void WorkerPool::workerLoop()
+    {
+        std::unique_lock lock(mutex);
+        while (true)
+        {
+            Batch* batch = nullptr;
+            workAvailable.wait(lock, [this, &batch]()
+            {
+                batch = findWork();
+                return stopping || (batch != nullptr);
+            });
+
+            if (batch == nullptr)
+            {
+                return;
+            }
+
+            ++batch->activeWorkers;
+            lock.unlock();
+            runBatch(*batch);
+            lock.lock();
+
+            if (--batch->activeWorkers == 0u)
+            {
+                workerFinished.notify_all();
+            }
+        }
+    }
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+#ifndef PETRICHOR_WORKER_POOL_HPP
+#define PETRICHOR_WORKER_POOL_HPP
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace petrichor
+{
+
+    // Threads that CPU heavy parts of creation (decompression) are split across. Callers take part in their own
+    // batches, so a batch always finishes even when every worker is busy with someone else's
+    struct WorkerPool
+    {
+        WorkerPool() = default;
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+        ~WorkerPool();
+
+        void start(uint32_t num_workers);
+        // Waits for the workers to finish what they're running: no batches can be in flight
+        void stop();
+        uint32_t workerCount() const noexcept;
+        // Calls fn(i) once for each i below count, across the workers and the calling thread. Returns once all have returned
+        void parallelFor(uint32_t count, const std::function<void(uint32_t)>& fn);
+
+    private:
+        struct Batch
+        {
+            const std::function<void(uint32_t)>* fn{ nullptr };
+            uint32_t count{ 0u };
+            std::atomic<uint32_t> nextIndex{ 0u };
+            // Workers currently running indices of it. Guarded by mutex, and the batch can't go until it's zero
+            uint32_t activeWorkers{ 0u };
+        };
+
+        // Runs indices until there are none left to claim
+        static void runBatch(Batch& batch);
+        // Oldest batch with indices left to claim, or nullptr. Requires mutex
+        Batch* findWork() const;
+        void workerLoop();
+
+        std::mutex mutex;
+        std::condition_variable workAvailable;
+        std::condition_variable workerFinished;
+        std::deque<Batch*> batches;
+        std::vector<std::thread> workers;
+        bool stopping{ false };
+    };
+
+}
+
+#endif //!PETRICHOR_WORKER_POOL_HPP
@@ -4,7 +4,13 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <mutex>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
 #ifdef _MSC_VER
 #include <intrin.h>
 #endif
@@ -114,7 +120,7 @@ protected:
 
     CasReactorHandle(atomic128& cas_block) : casBlock(&cas_block)
     {
-        lastRead = casBlock->load();
+        lastRead.data = casBlock->load();
     }
 
     template<typename ReturnType, typename Function>
@@ -124,7 +130,7 @@ protected:
         {
             ReactorData new_data = lastRead;
             bool earlyExit = false;
-            out = f(new_data, earlyExit);
+            out = fn(new_data, earlyExit);
             // early exit is used to indicate that we didn't end up mutating state, so no need
             // to do the compare-exchange
             if (earlyExit)
@@ -133,7 +139,7 @@ protected:
             }
 
             // if compare-exchange fails, we retry the reactor function using the update data from whoever succeeded
-            bool cmpxchgOk = casBlock->compare_exchange_weak(lastRead.data, new_data.data));
+            bool cmpxchgOk = casBlock->compare_exchange_weak(lastRead.data, new_data.data);
             
             if (cmpxchgOk)
             {
@@ -150,7 +156,7 @@ protected:
         {
             ReactorData new_data = lastRead;
             bool earlyExit = false;
-            out = f(new_data, param, earlyExit);
+            out = fn(new_data, param, earlyExit);
             if (earlyExit)
             {
                 return;
@@ -173,7 +179,7 @@ protected:
         {
             ReactorData new_data = lastRead;
             bool earlyExit = false;
-            out = f(new_data, p0, p1, earlyExit);
+            out = fn(new_data, p0, p1, earlyExit);
             if (earlyExit)
             {
                 return;
@@ -225,7 +231,6 @@ namespace detail
 
         EntranceReactorData(uint64_t firstToWrite, uint64_t lastToWrite)
         {
-            memset(this, 0, sizeof(EntranceReactorData));
             setIDsToWrite(firstToWrite, lastToWrite);
         }
 
@@ -258,12 +263,11 @@ namespace detail
 
         void setFirstIDToWrite(uint64_t value)
         {
-            const uint32_t lockedCount = getLockedThreadCount();
+            [[maybe_unused]] const uint32_t lockedCount = getLockedThreadCount();
             const uint64_t last = getLastIDToWrite();
             data.low = value;
             const int64_t offset = last - value;
             assert((int32_t)offset == offset);
-            const uint64_t oldHigh = data.high;
             data.high = (data.high & 0xFFFFFFFF00000000LL) | uint32_t(int32_t(offset));
             assert(getFirstIDToWrite() == value);
             assert(getLastIDToWrite() == last);
@@ -272,8 +276,8 @@ namespace detail
 
         void setLastIDToWrite(uint64_t value)
         {
-            uint32_t lockedCount = getLockedThreadCount();
-            uint64_t first = getFirstIDToWrite();
+            [[maybe_unused]] uint32_t lockedCount = getLockedThreadCount();
+            [[maybe_unused]] uint64_t first = getFirstIDToWrite();
             const int64_t offset = value - data.low;
             assert((int32_t)offset == offset);
             data.high = (data.high & 0xFFFFFFFF00000000LL) | uint32_t(int32_t(offset));
@@ -284,7 +288,7 @@ namespace detail
 
         void setIDsToWrite(uint64_t first, uint64_t last)
         {
-            uint32_t lockedCount = getLockedThreadCount();
+            [[maybe_unused]] uint32_t lockedCount = getLockedThreadCount();
             data.low = first;
             const int64_t offset = last - first;
             assert(int32_t(offset) == offset);
@@ -310,14 +314,15 @@ namespace detail
         {
             std::pair<uint64_t, bool> result{ false, 0u };
 
-            auto reactFunction = [](EntranceReactorData& data, bool& earlyExit)->std::pair<uint64_t, bool>
+            auto reactFunction = [](EntranceReactorData& data, bool& /*earlyExit*/)->std::pair<uint64_t, bool>
             {
                 const uint64_t firstToWrite = data.getFirstIDToWrite();
                 uint64_t newIDToWrite = firstToWrite + 1u;
                 data.setFirstIDToWrite(newIDToWrite);
 
                 bool willLock = false;
-                if (newIDToWrite >= data.getLastIDToWrite())
+                // lastIDToWrite is exclusive: we only have to wait if the ID we were given is past it
+                if (firstToWrite >= data.getLastIDToWrite())
                 {
                     willLock = true;
                     const uint32_t lockedCount = data.getLockedThreadCount();
@@ -337,7 +342,7 @@ namespace detail
         {
             int dummyResult{ 0 };
             
-            auto reactFunction = [](EntranceReactorData& data, bool& earlyExit)->int
+            auto reactFunction = [](EntranceReactorData& data, bool& /*earlyExit*/)->int
             {
                 const uint32_t lockedCount = data.getLockedThreadCount();
                 uint32_t newLockedCount = lockedCount - 1u;
@@ -355,16 +360,16 @@ namespace detail
         {
             bool result = false;
 
-            auto reactFunction = [](EntranceReactorData& data, uint64_t newLastID, bool& earlyExit)->bool
+            auto reactFunction = [](EntranceReactorData& data, uint64_t newLastID, bool& /*earlyExit*/)->bool
             {
-                const uint64_t lastIDToWrite = data.getLastIDToWrite();
+                [[maybe_unused]] const uint64_t lastIDToWrite = data.getLastIDToWrite();
                 assert(lastIDToWrite <= newLastID);
                 const uint32_t lockedCount = data.getLockedThreadCount();
                 data.setLastIDToWrite(newLastID);
                 return lockedCount > 0u;
             };
 
-            React(result, reactFunction);
+            React(result, reactFunction, newLastIDToWrite);
 
             return result;
         }
@@ -389,16 +394,14 @@ namespace detail
         constexpr static uint64_t EntranceFirstToWrite = 0u;
         constexpr static uint64_t EntranceLastToWrite = mwsrQueueSize;
 
-        ExitReactorData()
-        {
-            memset(this, 0, sizeof(ExitReactorData));
-        }
+        // cas_data128_t starts zeroed
+        ExitReactorData() {}
 
     private:
 
         uint64_t getFirstIDToRead() const noexcept
         {
-            constexpr static uint64_t mask = 0x7FFFFFFFLL;
+            constexpr static uint64_t mask = 0x7FFFFFFFFFFFFFFFULL;
             return data.high & mask;
         }
 
@@ -409,13 +412,13 @@ namespace detail
 
         bool getReaderIsLocked() const noexcept
         {
-            return (data.high & 0x80000000LL) != 0;
+            return (data.high & 0x8000000000000000ULL) != 0;
         }
 
         void setFirstIDToRead(uint64_t value)
         {
-            assert((value & 0x80000000LL) != 0);
-            data.high = (data.high & 0x80000000LL) | value;
+            assert((value & 0x8000000000000000ULL) == 0);
+            data.high = (data.high & 0x8000000000000000ULL) | value;
         }
 
         void setCompletedWritesMask(uint64_t value) noexcept
@@ -425,12 +428,12 @@ namespace detail
 
         void setReaderIsLocked() noexcept
         {
-            data.high |= 0x80000000LL;
+            data.high |= 0x8000000000000000ULL;
         }
 
         void setReaderIsUnlocked() noexcept
         {
-            data.high &= ~0x80000000LL;
+            data.high &= ~0x8000000000000000ULL;
         }
     };
 
@@ -441,7 +444,7 @@ namespace detail
 
         bool writeCompleted(uint64_t _id)
         {
-            auto reactFunction = [](ExitReactorData& data, uint64_t id, bool& earlyExit)->bool
+            auto reactFunction = [](ExitReactorData& data, uint64_t id, bool& /*earlyExit*/)->bool
             {
                 const uint64_t firstToRead = data.getFirstIDToRead();
                 assert(id >= firstToRead);
@@ -467,7 +470,7 @@ namespace detail
 
             bool result = false;
             /// result is true if we've unlocked the reader (from locked), false if it wasn't even locked in the first place
-            React(result, reactFunction);
+            React(result, reactFunction, _id);
             return result;
         }
 
@@ -508,12 +511,40 @@ namespace detail
             return result;
         }
 
+        // Same as startRead, but never locks the reader: returns zero items read if nothing is ready
+        std::pair<size_t, uint64_t> tryStartRead()
+        {
+            auto reactFunction = [](ExitReactorData& data, bool& earlyExit)->std::pair<size_t, uint64_t>
+            {
+                earlyExit = true;
+                const uint64_t mask = data.getCompletedWritesMask();
+                if (!maskGetBit(mask, 0u))
+                {
+                    return { 0u, 0u };
+                }
+
+                uint64_t n = 1u;
+                for (; n < mwsrQueueSize; ++n)
+                {
+                    if (!maskGetBit(mask, n))
+                    {
+                        break;
+                    }
+                }
+                return std::pair<size_t, uint64_t>{ size_t(n), data.getFirstIDToRead() };
+            };
+
+            std::pair<size_t, uint64_t> result{ 0u, 0u };
+            React(result, reactFunction);
+            return result;
+        }
+
         uint64_t readCompleted(size_t _size, uint64_t _id)
         {
-            auto reactFunction = [](ExitReactorData& data, uint64_t size, uint64_t id, bool& earlyExit)->uint64_t
+            auto reactFunction = [](ExitReactorData& data, uint64_t size, uint64_t /*id*/, bool& /*earlyExit*/)->uint64_t
             {
                 const uint64_t mask = data.getCompletedWritesMask();
-                assert(!maskGetBit(mask, 0));
+                assert(maskGetBit(mask, 0));
 
                 const uint64_t previousFirstIDToRead = data.getFirstIDToRead();
                 // update first ID to read based on how many we say have completed
@@ -522,7 +553,8 @@ namespace detail
                 assert(newFirstIDToRead > previousFirstIDToRead);
                 data.setFirstIDToRead(newFirstIDToRead);
 
-                uint64_t newMask = mask >> size;
+                // shifting by the full width is undefined, and means everything was read anyways
+                uint64_t newMask = size < 64u ? (mask >> size) : 0u;
                 data.setCompletedWritesMask(newMask);
                 uint64_t newLastIDToWrite = newFirstIDToRead + mwsrQueueSize;
                 return newLastIDToWrite;
@@ -643,7 +675,7 @@ namespace detail
             }
             else
             {
-                assert(toInsert = prev->next);
+                assert(toInsert == prev->next);
                 iter->next = toInsert;
                 prev->next = iter;
             }
@@ -694,17 +726,50 @@ private:
         return id % detail::mwsrQueueSize;
     }
 
+    // Moves numRead completed items out of the ring: the first is returned, the rest go into readCache
+    T readItems(detail::ExitReactorHandle& exit, size_t numRead, uint64_t firstId)
+    {
+        size_t queueIndex = getQueueIndex(firstId);
+        T resultItem = std::move(items[queueIndex]);
+        assert(readCacheBegin == readCacheEnd);
+        readCacheBegin = 0u;
+        readCacheEnd = 0u;
+
+        for (size_t i = 1; i < numRead; ++i)
+        {
+            readCache[readCacheEnd++] = std::move(items[getQueueIndex(firstId + i)]);
+        }
+        assert(readCacheEnd <= detail::mwsrQueueSize - 1u);
+
+        const uint64_t newLastWrite = exit.readCompleted(numRead, firstId);
+
+        detail::EntranceReactorHandle entrance(entranceData);
+        const bool shouldUnlock = entrance.moveLastToWrite(newLastWrite);
+        if (shouldUnlock)
+        {
+            lockedWriters.unlockAllUpTo(newLastWrite);
+        }
+
+        return resultItem;
+    }
+
 public:
     static_assert(std::is_default_constructible_v<T>, "QueueItem used in mwsrQueue must be default-constructible!");
     static_assert(std::is_move_assignable_v<T>, "QueueItem must be move-assignable!");
 
-    mwsrQueue() : entranceData({ detail::ExitReactorData::EntranceFirstToWrite, detail::ExitReactorData::EntranceLastToWrite }) {}
+    mwsrQueue() : entranceData(detail::EntranceReactorData(detail::ExitReactorData::EntranceFirstToWrite, detail::ExitReactorData::EntranceLastToWrite).Data()) {}
     mwsrQueue(const mwsrQueue&) = delete;
     mwsrQueue& operator=(const mwsrQueue&) = delete;
 
-    bool empty() const noexcept
+    // Only meaningful from the reader thread: writers may be adding items concurrently
+    bool empty() noexcept
     {
-        return readCacheBegin != readCacheEnd;
+        if (readCacheBegin != readCacheEnd)
+        {
+            return false;
+        }
+        detail::ExitReactorHandle exit(exitData);
+        return exit.tryStartRead().first == 0u;
     }
 
     void push(T&& item)
@@ -750,31 +815,36 @@ public:
                 continue;
             }
 
-            size_t queueIndex = getQueueIndex(firstId);
-            T resultItem = std::move(items[queueIndex]);
-            assert(readCacheBegin == readCacheEnd);
-            readCacheBegin = 0u;
-            readCacheEnd = 0u;
-
-            for (size_t i = 1; i < numRead; ++i)
-            {
-                readCache[readCacheEnd++] = std::move(items[getQueueIndex(firstId + i)]);
-            }
-            assert(readCacheEnd < detail::mwsrQueueSize - 1u);
-
-            const uint64_t newLastWrite = exit.readCompleted(size, firstId);
+            return readItems(exit, numRead, firstId);
+        }
+    }
 
-            detail::EntranceReactorHandle entrance(entranceData);
-            const bool shouldUnlock = entrance.moveLastToWrite(newLastWrite);
-            if (shouldUnlock)
-            {
-                lockedWriters.unlockUpTo(firstId + numRead - 1u + detail::mwsrQueueSize);
-            }
+    // Non-blocking version of pop, for readers that poll once per frame instead of parking a thread
+    bool try_pop(T& out)
+    {
+        if (readCacheBegin < readCacheEnd)
+        {
+            out = std::move(readCache[readCacheBegin++]);
+            return true;
+        }
 
-            return resultItem;
+        detail::ExitReactorHandle exit(exitData);
+        auto[ numRead, firstId ] = exit.tryStartRead();
+        if (!numRead)
+        {
+            return false;
         }
+
+        out = readItems(exit, numRead, firstId);
+        return true;
     }
 
 };
 
+namespace detail
+{
+    template<typename QueueItem>
+    thread_local LockedThreadsListLockItem LockedThreadsList<QueueItem>::lockedThreadsListTLS_data;
+}
+
 #endif //!PETRICHOR_MWSR_QUEUE_HPP
@@ -0,0 +1,125 @@
+#include "RenderingContext.hpp"
+#include "ResourceContext.hpp"
+#include "easylogging++.h"
+INITIALIZE_EASYLOGGINGPP
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace petrichor;
+
+// CreateResource() throughput, with as little besides the coroutine frame as possible: every sampler after the
+// first is a sampler cache hit, so the driver barely shows up. Configure with PETRICHOR_COROUTINE_FRAME_POOL_ENABLED_CONF
+// on and then off to compare the frame pool against the global heap
+#ifdef PETRICHOR_COROUTINE_FRAME_POOL_ENABLED_CONF
+constexpr static const char* FrameAllocator = "frame pool";
+#else
+constexpr static const char* FrameAllocator = "global heap";
+#endif
+
+constexpr static uint32_t CreationsPerThread = 200000u;
+// Creations off the Update() thread are queued for it, so each thread waits on a batch at a time before destroying them
+constexpr static uint32_t CreationsPerBatch = 1000u;
+constexpr static uint32_t ThreadCounts[] = { 1u, 2u, 4u, 8u };
+
+static double CreationsPerSecond(ResourceContext& context, const ResourceCreationMessage& message, uint32_t num_threads)
+{
+    std::atomic<uint32_t> finishedThreads{ 0u };
+    auto createAndDestroy = [&context, &message, &finishedThreads]()
+    {
+        std::vector<ResourceSystemReply> replies;
+        replies.reserve(CreationsPerBatch);
+        for (uint32_t i = 0u; i < CreationsPerThread; i += CreationsPerBatch)
+        {
+            for (uint32_t j = 0u; j < CreationsPerBatch; ++j)
+            {
+                replies.emplace_back(context.CreateResource(message));
+            }
+            for (const auto& reply : replies)
+            {
+                while (!ResourceOperationComplete(reply))
+                {
+                    std::this_thread::yield();
+                }
+                context.DestroyResource(GetHandleFromOperation(reply));
+            }
+            replies.clear();
+        }
+        finishedThreads.fetch_add(1u, std::memory_order_release);
+    };
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0u; i < num_threads; ++i)
+    {
+        threads.emplace_back(createAndDestroy);
+    }
+    // This is the thread that constructed the context, so it's the one that has to run the queued creations
+    while (finishedThreads.load(std::memory_order_acquire) != num_threads)
+    {
+        context.Update();
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    return static_cast<double>(CreationsPerThread * num_threads) / elapsed.count();
+}
+
+int main(int argc, char* argv[])
+{
+    RenderingContext& renderingContext = RenderingContext::Get();
+    renderingContext.Construct("RendererContextCfg.json");
+
+    ResourceContext& resourceContext = ResourceContext::Get(renderingContext.Device(), renderingContext.PhysicalDevice());
+    resourceContext.Construct(renderingContext.Device(), renderingContext.PhysicalDevice());
+
+    const VkSamplerCreateInfo samplerInfo
+    {
+        VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        nullptr,
+        0,
+        VK_FILTER_LINEAR,
+        VK_FILTER_LINEAR,
+        VK_SAMPLER_MIPMAP_MODE_LINEAR,
+        VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        0.0f,
+        VK_FALSE,
+        1.0f,
+        VK_FALSE,
+        VK_COMPARE_OP_NEVER,
+        0.0f,
+        VK_LOD_CLAMP_NONE,
+        VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK,
+        VK_FALSE
+    };
+
+    ResourceCreationMessage message{};
+    message.Type = GpuResourceType::Sampler;
+    message.Info = &samplerInfo;
+
+    // Keeps the sampler alive throughout, so every creation we time is a cache hit
+    ResourceSystemReply anchor = resourceContext.CreateResource(message);
+
+    std::printf("Coroutine frames from the %s\n", FrameAllocator);
+    for (const uint32_t numThreads : ThreadCounts)
+    {
+        const double rate = CreationsPerSecond(resourceContext, message, numThreads);
+        resourceContext.Update();
+
+        const CoroutineFrameStats stats = resourceContext.GetCoroutineFrameStats();
+        std::printf("%u thread(s): %.0f creations/sec (frames outstanding: %llu, total: %llu, heap: %llu, pooled bytes: %llu)\n",
+            numThreads, rate, static_cast<unsigned long long>(stats.OutstandingFrames), static_cast<unsigned long long>(stats.TotalFrames),
+            static_cast<unsigned long long>(stats.HeapFrames), static_cast<unsigned long long>(stats.PooledBytes));
+    }
+
+    resourceContext.DestroyResource(GetHandleFromOperation(anchor));
+    resourceContext.Destroy();
+    return 0;
+}
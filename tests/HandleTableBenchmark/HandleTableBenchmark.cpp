@@ -0,0 +1,149 @@
+#include "RenderingContext.hpp"
+#include "ResourceContext.hpp"
+#include "easylogging++.h"
+INITIALIZE_EASYLOGGINGPP
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace petrichor;
+
+// GetVulkanHandle() throughput from render threads, while the work queue thread destroys and recreates buffers and
+// calls Update(). Each run starts from a new context, and keeps more buffers alive than the handle table starts out
+// with room for, so it grows (and has its old directories reclaimed) under the readers too
+constexpr static uint32_t LiveBuffers = 65536u;
+constexpr static uint32_t ChurnPerUpdate = 256u;
+constexpr static std::chrono::seconds RunDuration{ 2 };
+constexpr static uint32_t ThreadCounts[] = { 1u, 2u, 4u, 8u, 16u, 32u };
+
+struct RunResult
+{
+    double lookupsPerSecond{ 0.0 };
+    double churnPerSecond{ 0.0 };
+    // Lookups that found a buffer, rather than one destroyed between picking the handle and resolving it
+    double hitRate{ 0.0 };
+};
+
+static RunResult LookupsPerSecond(ResourceContext& context, const ResourceCreationMessage& message, uint32_t num_threads)
+{
+    std::unique_ptr<std::atomic<GpuResourceHandle>[]> handles(new std::atomic<GpuResourceHandle>[LiveBuffers]);
+    for (uint32_t i = 0u; i < LiveBuffers; ++i)
+    {
+        handles[i].store(INVALID_GPU_RESOURCE_HANDLE, std::memory_order_relaxed);
+    }
+
+    std::atomic<bool> running{ true };
+    std::atomic<uint64_t> totalLookups{ 0u };
+    std::atomic<uint64_t> totalHits{ 0u };
+    uint64_t churned = 0u;
+
+    auto lookup = [&](uint32_t seed)
+    {
+        uint64_t lookups = 0u;
+        uint64_t hits = 0u;
+        uint32_t state = seed * 2654435761u + 1u;
+        while (running.load(std::memory_order_relaxed))
+        {
+            // Batched, so checking the flag doesn't show up next to the lookups
+            for (uint32_t i = 0u; i < 1024u; ++i)
+            {
+                state ^= state << 13u;
+                state ^= state >> 17u;
+                state ^= state << 5u;
+                const GpuResourceHandle handle = handles[state % LiveBuffers].load(std::memory_order_relaxed);
+                hits += context.GetVulkanHandle(handle) != 0u ? 1u : 0u;
+            }
+            lookups += 1024u;
+        }
+        totalLookups.fetch_add(lookups, std::memory_order_relaxed);
+        totalHits.fetch_add(hits, std::memory_order_relaxed);
+    };
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> readers;
+    for (uint32_t i = 0u; i < num_threads; ++i)
+    {
+        readers.emplace_back(lookup, i);
+    }
+
+    // Churn runs here, as Update() has to be called from the thread that constructed the context
+    for (uint32_t i = 0u; std::chrono::high_resolution_clock::now() - start < RunDuration; i = (i + 1u) % LiveBuffers)
+    {
+        const GpuResourceHandle replaced = handles[i].exchange(GetHandleFromOperation(context.CreateResource(message)), std::memory_order_relaxed);
+        if (replaced != INVALID_GPU_RESOURCE_HANDLE)
+        {
+            context.DestroyResource(replaced);
+        }
+        if ((++churned % ChurnPerUpdate) == 0u)
+        {
+            context.Update();
+        }
+    }
+
+    running.store(false, std::memory_order_relaxed);
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    for (uint32_t i = 0u; i < LiveBuffers; ++i)
+    {
+        const GpuResourceHandle handle = handles[i].load(std::memory_order_relaxed);
+        if (handle != INVALID_GPU_RESOURCE_HANDLE)
+        {
+            context.DestroyResource(handle);
+        }
+    }
+    context.Update();
+
+    const uint64_t lookups = totalLookups.load(std::memory_order_relaxed);
+    return RunResult
+    {
+        static_cast<double>(lookups) / elapsed.count(),
+        static_cast<double>(churned) / elapsed.count(),
+        lookups != 0u ? static_cast<double>(totalHits.load(std::memory_order_relaxed)) / static_cast<double>(lookups) : 0.0
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    RenderingContext& renderingContext = RenderingContext::Get();
+    renderingContext.Construct("RendererContextCfg.json");
+
+    ResourceContext& resourceContext = ResourceContext::Get(renderingContext.Device(), renderingContext.PhysicalDevice());
+
+    const VkBufferCreateInfo bufferInfo
+    {
+        VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        nullptr,
+        0,
+        256u,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_SHARING_MODE_EXCLUSIVE,
+        0u,
+        nullptr
+    };
+
+    ResourceCreationMessage message{};
+    message.Type = GpuResourceType::Buffer;
+    message.MemoryDomain = GpuResourceMemoryDomain::Device;
+    message.Info = &bufferInfo;
+
+    for (const uint32_t numThreads : ThreadCounts)
+    {
+        // Fresh context each run, so the table starts small and grows while it's being read
+        resourceContext.Construct(renderingContext.Device(), renderingContext.PhysicalDevice());
+        const RunResult result = LookupsPerSecond(resourceContext, message, numThreads);
+        resourceContext.Destroy();
+
+        std::printf("%u reader(s): %.0f lookups/sec (%.0f per reader, %.1f%% hits) against %.0f creations + destructions/sec\n",
+            numThreads, result.lookupsPerSecond, result.lookupsPerSecond / static_cast<double>(numThreads), result.hitRate * 100.0,
+            result.churnPerSecond);
+    }
+
+    return 0;
+}
@@ -0,0 +1,244 @@
+#include "ImageLayoutTracker.hpp"
+#include "UnitTestChecks.hpp"
+#include <vector>
+
+using namespace petrichor;
+
+constexpr static SubresourceState Undefined{ VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE };
+constexpr static SubresourceState TransferWrite{ VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT };
+constexpr static SubresourceState FragmentRead{ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT };
+constexpr static SubresourceState ComputeRead{ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT };
+constexpr static SubresourceState StorageWrite{ VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT };
+
+static VkImageSubresourceRange Range(uint32_t base_mip, uint32_t mip_count, uint32_t base_layer, uint32_t layer_count)
+{
+    return VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, base_mip, mip_count, base_layer, layer_count };
+}
+
+static bool Covers(const SubresourceTransition& transition, uint32_t base_mip, uint32_t mip_count, uint32_t base_layer, uint32_t layer_count)
+{
+    return (transition.range.aspectMask == VK_IMAGE_ASPECT_COLOR_BIT) && (transition.range.baseMipLevel == base_mip) &&
+        (transition.range.levelCount == mip_count) && (transition.range.baseArrayLayer == base_layer) && (transition.range.layerCount == layer_count);
+}
+
+// Finds the transition covering exactly this range, as the order they're appended in isn't part of the contract
+static const SubresourceTransition* Find(const std::vector<SubresourceTransition>& transitions, uint32_t base_mip, uint32_t mip_count,
+    uint32_t base_layer, uint32_t layer_count)
+{
+    for (const auto& transition : transitions)
+    {
+        if (Covers(transition, base_mip, mip_count, base_layer, layer_count))
+        {
+            return &transition;
+        }
+    }
+    return nullptr;
+}
+
+static void WholeImageTransition()
+{
+    ImageLayoutTracker tracker;
+    tracker.reset(Undefined);
+
+    std::vector<SubresourceTransition> transitions;
+    tracker.transition(4u, 2u, Range(0u, VK_REMAINING_MIP_LEVELS, 0u, VK_REMAINING_ARRAY_LAYERS), TransferWrite, transitions);
+    PETRICHOR_CHECK(transitions.size() == 1u);
+    PETRICHOR_CHECK(Covers(transitions[0], 0u, 4u, 0u, 2u));
+    PETRICHOR_CHECK(transitions[0].previous.layout == VK_IMAGE_LAYOUT_UNDEFINED);
+}
+
+static void ReadsAccumulateUntilAWrite()
+{
+    ImageLayoutTracker tracker;
+    tracker.reset(TransferWrite);
+
+    std::vector<SubresourceTransition> transitions;
+    tracker.transition(1u, 1u, Range(0u, 1u, 0u, 1u), FragmentRead, transitions);
+    PETRICHOR_CHECK(transitions.size() == 1u);
+    PETRICHOR_CHECK(transitions[0].previous.access == VK_ACCESS_2_TRANSFER_WRITE_BIT);
+
+    // Same layout, reads on both sides: nothing to wait on
+    transitions.clear();
+    tracker.transition(1u, 1u, Range(0u, 1u, 0u, 1u), ComputeRead, transitions);
+    PETRICHOR_CHECK(transitions.empty());
+
+    // The write has to wait on both of the reads before it
+    tracker.transition(1u, 1u, Range(0u, 1u, 0u, 1u), StorageWrite, transitions);
+    PETRICHOR_CHECK(transitions.size() == 1u);
+    PETRICHOR_CHECK(transitions[0].previous.layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    PETRICHOR_CHECK(transitions[0].previous.stages == (VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT));
+    PETRICHOR_CHECK(transitions[0].previous.access == VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+}
+
+static void WritesInTheSameLayoutStillNeedABarrier()
+{
+    ImageLayoutTracker tracker;
+    tracker.reset(StorageWrite);
+
+    std::vector<SubresourceTransition> transitions;
+    tracker.transition(1u, 1u, Range(0u, 1u, 0u, 1u), StorageWrite, transitions);
+    PETRICHOR_CHECK(transitions.size() == 1u);
+    PETRICHOR_CHECK(transitions[0].previous.layout == VK_IMAGE_LAYOUT_GENERAL);
+    PETRICHOR_CHECK(transitions[0].previous.access == VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+}
+
+static void PartialTransitionsSplitTheImage()
+{
+    ImageLayoutTracker tracker;
+    tracker.reset(Undefined);
+
+    // Writing mips one at a time, as when generating them
+    std::vector<SubresourceTransition> transitions;
+    tracker.transition(4u, 1u, Range(0u, 1u, 0u, 1u), TransferWrite, transitions);
+    PETRICHOR_CHECK(transitions.size() == 1u);
+    PETRICHOR_CHECK(Covers(transitions[0], 0u, 1u, 0u, 1u));
+
+    // The rest of the levels were never touched, so they share a barrier
+    transitions.clear();
+    tracker.transition(4u, 1u, Range(0u, VK_REMAINING_MIP_LEVELS, 0u, 1u), FragmentRead, transitions);
+    PETRICHOR_CHECK(transitions.size() == 2u);
+    const SubresourceTransition* written = Find(transitions, 0u, 1u, 0u, 1u);
+    const SubresourceTransition* untouched = Find(transitions, 1u, 3u, 0u, 1u);
+    PETRICHOR_CHECK((written != nullptr) && (written->previous.layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+    PETRICHOR_CHECK((untouched != nullptr) && (untouched->previous.layout == VK_IMAGE_LAYOUT_UNDEFINED));
+
+    // Back to agreeing on a single state, so the whole image moves in one barrier
+    transitions.clear();
+    tracker.transition(4u, 1u, Range(0u, 4u, 0u, 1u), StorageWrite, transitions);
+    PETRICHOR_CHECK(transitions.size() == 1u);
+    PETRICHOR_CHECK(Covers(transitions[0], 0u, 4u, 0u, 1u));
+    PETRICHOR_CHECK(transitions[0].previous.layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+static void LayersMergeByLayout()
+{
+    ImageLayoutTracker tracker;
+    tracker.reset(Undefined);
+
+    std::vector<SubresourceTransition> transitions;
+    tracker.transition(1u, 6u, Range(0u, 1u, 2u, 2u), TransferWrite, transitions);
+    PETRICHOR_CHECK(transitions.size() == 1u);
+    PETRICHOR_CHECK(Covers(transitions[0], 0u, 1u, 2u, 2u));
+
+    // Runs of layers in the same layout share a barrier, so this takes three
+    transitions.clear();
+    tracker.transition(1u, 6u, Range(0u, 1u, 0u, 6u), FragmentRead, transitions);
+    PETRICHOR_CHECK(transitions.size() == 3u);
+    PETRICHOR_CHECK(Find(transitions, 0u, 1u, 0u, 2u) != nullptr);
+    PETRICHOR_CHECK(Find(transitions, 0u, 1u, 2u, 2u) != nullptr);
+    PETRICHOR_CHECK(Find(transitions, 0u, 1u, 4u, 2u) != nullptr);
+}
+
+static void LevelsAndLayersMergeTogether()
+{
+    ImageLayoutTracker tracker;
+    tracker.reset(Undefined);
+
+    // A cube face with every mip: one barrier for the lot
+    std::vector<SubresourceTransition> transitions;
+    tracker.transition(3u, 6u, Range(0u, VK_REMAINING_MIP_LEVELS, 1u, 1u), TransferWrite, transitions);
+    PETRICHOR_CHECK(transitions.size() == 1u);
+    PETRICHOR_CHECK(Covers(transitions[0], 0u, 3u, 1u, 1u));
+
+    // The other five faces: before and after the one that was written
+    transitions.clear();
+    tracker.transition(3u, 6u, Range(0u, 3u, 0u, 6u), FragmentRead, transitions);
+    PETRICHOR_CHECK(transitions.size() == 3u);
+    PETRICHOR_CHECK(Find(transitions, 0u, 3u, 0u, 1u) != nullptr);
+    PETRICHOR_CHECK(Find(transitions, 0u, 3u, 1u, 1u) != nullptr);
+    PETRICHOR_CHECK(Find(transitions, 0u, 3u, 2u, 4u) != nullptr);
+}
+
+static void RangesAreClamped()
+{
+    ImageLayoutTracker tracker;
+    tracker.reset(Undefined);
+
+    std::vector<SubresourceTransition> transitions;
+    tracker.transition(2u, 2u, Range(5u, 1u, 0u, 1u), TransferWrite, transitions);
+    tracker.transition(2u, 2u, Range(0u, 1u, 7u, 1u), TransferWrite, transitions);
+    tracker.transition(2u, 2u, Range(0u, 0u, 0u, 2u), TransferWrite, transitions);
+    PETRICHOR_CHECK(transitions.empty());
+
+    // Running off the end covers what's there
+    tracker.transition(2u, 2u, Range(1u, 8u, 1u, 8u), TransferWrite, transitions);
+    PETRICHOR_CHECK(transitions.size() == 1u);
+    PETRICHOR_CHECK(Covers(transitions[0], 1u, 1u, 1u, 1u));
+}
+
+static void ResetForgetsEverything()
+{
+    ImageLayoutTracker tracker;
+    tracker.reset(Undefined);
+
+    std::vector<SubresourceTransition> transitions;
+    tracker.transition(2u, 1u, Range(0u, 1u, 0u, 1u), TransferWrite, transitions);
+    tracker.reset(FragmentRead);
+
+    transitions.clear();
+    tracker.transition(2u, 1u, Range(0u, 2u, 0u, 1u), ComputeRead, transitions);
+    PETRICHOR_CHECK(transitions.empty());
+}
+
+static void MergeTakesThePlannedStates()
+{
+    ImageLayoutTracker tracker;
+    tracker.reset(FragmentRead);
+
+    // Nothing touched the image while the batch was planned: the batch's states win outright
+    const ImageLayoutTracker base = tracker;
+    ImageLayoutTracker planned = tracker;
+    std::vector<SubresourceTransition> transitions;
+    planned.transition(3u, 2u, Range(0u, 1u, 1u, 1u), TransferWrite, transitions);
+    tracker.merge(3u, 2u, base, planned);
+
+    transitions.clear();
+    tracker.transition(3u, 2u, Range(0u, 3u, 0u, 2u), FragmentRead, transitions);
+    const SubresourceTransition* written = Find(transitions, 0u, 1u, 1u, 1u);
+    PETRICHOR_CHECK((written != nullptr) && (written->previous.layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+    PETRICHOR_CHECK(transitions.size() == 1u);
+}
+
+static void MergeKeepsInterleavedTransitions()
+{
+    ImageLayoutTracker tracker;
+    tracker.reset(FragmentRead);
+
+    // Update() copies the states out and plans its barriers from them...
+    const ImageLayoutTracker base = tracker;
+    ImageLayoutTracker planned = tracker;
+    std::vector<SubresourceTransition> transitions;
+    planned.transition(2u, 2u, Range(0u, 2u, 0u, 1u), TransferWrite, transitions);
+
+    // ...while a render thread moves a layer it isn't touching, and one it is
+    transitions.clear();
+    tracker.transition(2u, 2u, Range(0u, 2u, 1u, 1u), StorageWrite, transitions);
+    tracker.transition(2u, 2u, Range(1u, 1u, 0u, 1u), StorageWrite, transitions);
+    tracker.merge(2u, 2u, base, planned);
+
+    // Whatever the render thread moved keeps its newer state, the rest takes the batch's
+    transitions.clear();
+    tracker.transition(2u, 2u, Range(0u, 2u, 0u, 2u), FragmentRead, transitions);
+    PETRICHOR_CHECK(transitions.size() == 3u);
+    const SubresourceTransition* batch = Find(transitions, 0u, 1u, 0u, 1u);
+    const SubresourceTransition* renderLayer = Find(transitions, 0u, 1u, 1u, 1u);
+    const SubresourceTransition* renderMip = Find(transitions, 1u, 1u, 0u, 2u);
+    PETRICHOR_CHECK((batch != nullptr) && (batch->previous.layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+    PETRICHOR_CHECK((renderLayer != nullptr) && (renderLayer->previous.layout == VK_IMAGE_LAYOUT_GENERAL));
+    PETRICHOR_CHECK((renderMip != nullptr) && (renderMip->previous.layout == VK_IMAGE_LAYOUT_GENERAL));
+}
+
+int main(int argc, char* argv[])
+{
+    WholeImageTransition();
+    ReadsAccumulateUntilAWrite();
+    WritesInTheSameLayoutStillNeedABarrier();
+    PartialTransitionsSplitTheImage();
+    LayersMergeByLayout();
+    LevelsAndLayersMergeTogether();
+    RangesAreClamped();
+    ResetForgetsEverything();
+    MergeTakesThePlannedStates();
+    MergeKeepsInterleavedTransitions();
+    return UnitTestResult();
+}
@@ -0,0 +1,278 @@
+#include "MessageArena.hpp"
+#include "UnitTestChecks.hpp"
+#include <vulkan/vulkan_core.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace petrichor;
+
+static bool Aligned(const void* pointer, size_t alignment)
+{
+    return (reinterpret_cast<uintptr_t>(pointer) % alignment) == 0u;
+}
+
+static void AllocationsAreAlignedAndDisjoint()
+{
+    MessageArena arena;
+    std::vector<std::pair<std::byte*, size_t>> allocations;
+    for (size_t i = 0u; i < 512u; ++i)
+    {
+        const size_t alignment = size_t(1u) << (i % 7u);
+        const size_t size = 1u + (i * 37u) % 500u;
+        auto* allocation = static_cast<std::byte*>(arena.allocate(size, alignment));
+        PETRICHOR_CHECK(Aligned(allocation, alignment));
+        std::memset(allocation, static_cast<int>(i & 0xFFu), size);
+        allocations.emplace_back(allocation, size);
+    }
+
+    // Every allocation still holds what was written to it, so none of them overlapped
+    for (size_t i = 0u; i < allocations.size(); ++i)
+    {
+        for (size_t j = 0u; j < allocations[i].second; ++j)
+        {
+            if (allocations[i].first[j] != static_cast<std::byte>(i & 0xFFu))
+            {
+                PETRICHOR_CHECK(!"allocation was overwritten");
+                break;
+            }
+        }
+    }
+}
+
+static void CopiesAndStrings()
+{
+    MessageArena arena;
+    const uint32_t values[4]{ 1u, 2u, 3u, 4u };
+    const uint32_t* copied = arena.copy(values, 4u);
+    PETRICHOR_CHECK(copied != values);
+    PETRICHOR_CHECK(std::memcmp(copied, values, sizeof(values)) == 0);
+    PETRICHOR_CHECK(arena.copy(values, 0u) == nullptr);
+    PETRICHOR_CHECK(arena.copy<uint32_t>(nullptr, 4u) == nullptr);
+
+    char name[] = "staging ring";
+    const char* copiedName = arena.copyString(name);
+    name[0] = 'X';
+    PETRICHOR_CHECK(std::strcmp(copiedName, "staging ring") == 0);
+    PETRICHOR_CHECK(arena.copyString(nullptr) == nullptr);
+}
+
+static void ResetKeepsRegularBlocks()
+{
+    MessageArena arena;
+    void* first = arena.allocate(64u, 16u);
+    // Past a block, so it gets one of its own
+    void* big = arena.allocate(MessageArena::BlockSize * 2u, 16u);
+    PETRICHOR_CHECK(big != nullptr);
+    PETRICHOR_CHECK(Aligned(big, 16u));
+    std::memset(big, 0xAB, MessageArena::BlockSize * 2u);
+
+    arena.reset();
+    // Starts over from the front of the block that's kept
+    PETRICHOR_CHECK(arena.allocate(64u, 16u) == first);
+}
+
+static void CopiesBufferMessages()
+{
+    MessageArena arena;
+
+    uint32_t queueFamilies[2]{ 0u, 2u };
+    VkBufferOpaqueCaptureAddressCreateInfo captureInfo{ VK_STRUCTURE_TYPE_BUFFER_OPAQUE_CAPTURE_ADDRESS_CREATE_INFO, nullptr, 0x1000u };
+    VkExternalMemoryBufferCreateInfo externalInfo{ VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO, &captureInfo, 0u };
+    VkBufferCreateInfo bufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, &externalInfo, 0, 256u, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_SHARING_MODE_CONCURRENT, 2u, queueFamilies };
+
+    std::byte payload[256]{};
+    std::memset(payload, 0x5A, sizeof(payload));
+    GpuResourceData data{ payload, sizeof(payload), 16u, 0u };
+    char name[] = "vertices";
+
+    ResourceCreationMessage message{};
+    message.Type = GpuResourceType::Buffer;
+    message.MemoryDomain = GpuResourceMemoryDomain::Device;
+    message.Flags = CreationFlagBits::ResourceCreateUserDataAsString;
+    message.ResourceData.bufferData.numData = 1u;
+    message.ResourceData.bufferData.data = &data;
+    message.Info = &bufferInfo;
+    message.UserData = name;
+
+    PETRICHOR_CHECK(CopyCreationMessage(arena, message, true));
+
+    // Clobber everything the original pointed at: the copy shouldn't notice
+    queueFamilies[1] = 7u;
+    captureInfo.opaqueCaptureAddress = 0u;
+    externalInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+    bufferInfo.size = 0u;
+    std::memset(payload, 0, sizeof(payload));
+    data.Size = 0u;
+    name[0] = 'X';
+
+    const auto* copiedInfo = reinterpret_cast<const VkBufferCreateInfo*>(message.Info);
+    PETRICHOR_CHECK(copiedInfo != &bufferInfo);
+    PETRICHOR_CHECK(copiedInfo->size == 256u);
+    PETRICHOR_CHECK(copiedInfo->queueFamilyIndexCount == 2u);
+    PETRICHOR_CHECK(copiedInfo->pQueueFamilyIndices[1] == 2u);
+
+    const auto* copiedExternal = reinterpret_cast<const VkExternalMemoryBufferCreateInfo*>(copiedInfo->pNext);
+    PETRICHOR_CHECK(copiedExternal != &externalInfo);
+    PETRICHOR_CHECK(copiedExternal->sType == VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO);
+    PETRICHOR_CHECK(copiedExternal->handleTypes == 0u);
+    const auto* copiedCapture = reinterpret_cast<const VkBufferOpaqueCaptureAddressCreateInfo*>(copiedExternal->pNext);
+    PETRICHOR_CHECK(copiedCapture != &captureInfo);
+    PETRICHOR_CHECK(copiedCapture->opaqueCaptureAddress == 0x1000u);
+    PETRICHOR_CHECK(copiedCapture->pNext == nullptr);
+
+    const GpuResourceData* copiedData = message.ResourceData.bufferData.data;
+    PETRICHOR_CHECK(copiedData != &data);
+    PETRICHOR_CHECK(copiedData->Size == sizeof(payload));
+    PETRICHOR_CHECK(copiedData->Data != payload);
+    PETRICHOR_CHECK(static_cast<const std::byte*>(copiedData->Data)[255] == std::byte{ 0x5A });
+    PETRICHOR_CHECK(std::strcmp(reinterpret_cast<const char*>(message.UserData), "vertices") == 0);
+    PETRICHOR_CHECK(message.FileSource == nullptr);
+}
+
+static void LeavesPayloadsUnlessAsked()
+{
+    MessageArena arena;
+    const VkBufferCreateInfo bufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, nullptr, 0, 64u, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_SHARING_MODE_EXCLUSIVE, 0u, nullptr };
+    const std::byte payload[64]{};
+    const GpuResourceData data{ payload, sizeof(payload), 0u, 0u };
+    const GpuCompressedResourceData compressed{ payload, sizeof(payload), 128u, 0u, CompressionCodecs::Uncompressed };
+    int userValue = 0;
+
+    ResourceCreationMessage message{};
+    message.Type = GpuResourceType::Buffer;
+    message.MemoryDomain = GpuResourceMemoryDomain::Device;
+    message.Flags = 0u;
+    message.ResourceData.bufferData.numData = 1u;
+    message.ResourceData.bufferData.data = &data;
+    message.NumCompressedData = 1u;
+    message.CompressedData = &compressed;
+    message.Info = &bufferInfo;
+    message.UserData = &userValue;
+
+    PETRICHOR_CHECK(CopyCreationMessage(arena, message, false));
+    PETRICHOR_CHECK(message.ResourceData.bufferData.data != &data);
+    PETRICHOR_CHECK(message.ResourceData.bufferData.data->Data == payload);
+    PETRICHOR_CHECK(message.CompressedData != &compressed);
+    PETRICHOR_CHECK(message.CompressedData->Data == payload);
+    PETRICHOR_CHECK(message.CompressedData->DecompressedSize == 128u);
+    PETRICHOR_CHECK(reinterpret_cast<const VkBufferCreateInfo*>(message.Info)->pQueueFamilyIndices == nullptr);
+    // Not a string, so it's the caller's own value
+    PETRICHOR_CHECK(message.UserData == &userValue);
+}
+
+static void CopiesImageMessages()
+{
+    MessageArena arena;
+    VkFormat viewFormats[2]{ VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R8G8B8A8_SRGB };
+    const VkImageFormatListCreateInfo formatList{ VK_STRUCTURE_TYPE_IMAGE_FORMAT_LIST_CREATE_INFO, nullptr, 2u, viewFormats };
+    const VkImageCreateInfo imageInfo{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO, &formatList, VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT,
+        VK_IMAGE_TYPE_2D, VK_FORMAT_R8G8B8A8_UNORM, VkExtent3D{ 64u, 64u, 1u }, 1u, 1u, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_SAMPLED_BIT, VK_SHARING_MODE_EXCLUSIVE, 0u, nullptr, VK_IMAGE_LAYOUT_UNDEFINED };
+    char path[] = "textures/albedo.bin";
+    const GpuResourceFileSource fileSource{ path, 128u, 0u };
+    GpuImageResourceData region{};
+    region.Size = 64u * 64u * 4u;
+    region.Width = 64u;
+    region.Height = 64u;
+    region.ArrayLayerCount = 1u;
+    region.MipLevelCount = 1u;
+
+    ResourceCreationMessage message{};
+    message.Type = GpuResourceType::Image;
+    message.MemoryDomain = GpuResourceMemoryDomain::Device;
+    message.Flags = 0u;
+    message.ResourceData.imageData.numData = 1u;
+    message.ResourceData.imageData.data = &region;
+    message.Info = &imageInfo;
+    message.FileSource = &fileSource;
+
+    PETRICHOR_CHECK(CopyCreationMessage(arena, message, true));
+    viewFormats[1] = VK_FORMAT_UNDEFINED;
+    path[0] = 'X';
+
+    const auto* copiedInfo = reinterpret_cast<const VkImageCreateInfo*>(message.Info);
+    PETRICHOR_CHECK(copiedInfo != &imageInfo);
+    PETRICHOR_CHECK(copiedInfo->extent.width == 64u);
+    const auto* copiedList = reinterpret_cast<const VkImageFormatListCreateInfo*>(copiedInfo->pNext);
+    PETRICHOR_CHECK(copiedList != &formatList);
+    PETRICHOR_CHECK(copiedList->pViewFormats != viewFormats);
+    PETRICHOR_CHECK(copiedList->pViewFormats[1] == VK_FORMAT_R8G8B8A8_SRGB);
+    PETRICHOR_CHECK(message.ResourceData.imageData.data != &region);
+    PETRICHOR_CHECK(message.ResourceData.imageData.data->Width == 64u);
+    // No Data to copy, as it comes from the file
+    PETRICHOR_CHECK(message.ResourceData.imageData.data->Data == nullptr);
+    PETRICHOR_CHECK(message.FileSource != &fileSource);
+    PETRICHOR_CHECK(message.FileSource->Offset == 128u);
+    PETRICHOR_CHECK(std::strcmp(message.FileSource->Path, "textures/albedo.bin") == 0);
+}
+
+static void CopiesSamplersAndViews()
+{
+    MessageArena arena;
+    const VkSamplerReductionModeCreateInfo reduction{ VK_STRUCTURE_TYPE_SAMPLER_REDUCTION_MODE_CREATE_INFO, nullptr, VK_SAMPLER_REDUCTION_MODE_MIN };
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.pNext = &reduction;
+    samplerInfo.maxLod = 8.0f;
+
+    ResourceCreationMessage sampler{};
+    sampler.Type = GpuResourceType::Sampler;
+    sampler.Info = &samplerInfo;
+    PETRICHOR_CHECK(CopyCreationMessage(arena, sampler, false));
+    PETRICHOR_CHECK(sampler.Info != &samplerInfo);
+    const auto* copiedSampler = reinterpret_cast<const VkSamplerCreateInfo*>(sampler.Info);
+    PETRICHOR_CHECK(copiedSampler->maxLod == 8.0f);
+    PETRICHOR_CHECK(copiedSampler->pNext != &reduction);
+    PETRICHOR_CHECK(reinterpret_cast<const VkSamplerReductionModeCreateInfo*>(copiedSampler->pNext)->reductionMode == VK_SAMPLER_REDUCTION_MODE_MIN);
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+
+    ResourceCreationMessage view{};
+    view.Type = GpuResourceType::ImageView;
+    view.ViewInfo = &viewInfo;
+    view.ParentHandle = 42u;
+    PETRICHOR_CHECK(CopyCreationMessage(arena, view, false));
+    PETRICHOR_CHECK(view.ViewInfo != &viewInfo);
+    PETRICHOR_CHECK(reinterpret_cast<const VkImageViewCreateInfo*>(view.ViewInfo)->format == VK_FORMAT_R8G8B8A8_SRGB);
+    PETRICHOR_CHECK(view.ParentHandle == 42u);
+}
+
+static void RefusesUnknownChains()
+{
+    MessageArena arena;
+    // Could hold pointers of its own, which we'd have no way to know about
+    const VkPhysicalDeviceFeatures2 unknown{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, nullptr, VkPhysicalDeviceFeatures{} };
+    const VkExternalMemoryBufferCreateInfo known{ VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO, &unknown, 0u };
+    const VkBufferCreateInfo bufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, &known, 0, 64u, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_SHARING_MODE_EXCLUSIVE, 0u, nullptr };
+    const char* name = "refused";
+
+    ResourceCreationMessage message{};
+    message.Type = GpuResourceType::Buffer;
+    message.Flags = CreationFlagBits::ResourceCreateUserDataAsString;
+    message.Info = &bufferInfo;
+    message.UserData = name;
+
+    PETRICHOR_CHECK(!CopyCreationMessage(arena, message, true));
+    // Left as it was
+    PETRICHOR_CHECK(message.Info == &bufferInfo);
+    PETRICHOR_CHECK(message.UserData == name);
+}
+
+int main(int argc, char* argv[])
+{
+    AllocationsAreAlignedAndDisjoint();
+    CopiesAndStrings();
+    ResetKeepsRegularBlocks();
+    CopiesBufferMessages();
+    LeavesPayloadsUnlessAsked();
+    CopiesImageMessages();
+    CopiesSamplersAndViews();
+    RefusesUnknownChains();
+    return UnitTestResult();
+}
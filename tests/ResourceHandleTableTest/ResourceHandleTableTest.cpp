@@ -0,0 +1,235 @@
+#include "ResourceHandleTable.hpp"
+#include "UnitTestChecks.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace petrichor;
+
+// Same layout as the context's handles: generation in the high half, slot in the low
+static GpuResourceHandle Handle(uint32_t slot, uint32_t generation)
+{
+    return (static_cast<uint64_t>(generation) << 32u) | static_cast<uint64_t>(slot);
+}
+
+static void PublishFindRetract()
+{
+    ResourceHandleTable table;
+    PETRICHOR_CHECK(table.find(Handle(3u, 0u)) == 0u);
+
+    table.publish(Handle(3u, 0u), 0x30u);
+    table.publish(Handle(4u, 0u), 0x40u);
+    PETRICHOR_CHECK(table.find(Handle(3u, 0u)) == 0x30u);
+    PETRICHOR_CHECK(table.find(Handle(4u, 0u)) == 0x40u);
+
+    table.retract(Handle(3u, 0u));
+    PETRICHOR_CHECK(table.find(Handle(3u, 0u)) == 0u);
+    PETRICHOR_CHECK(table.find(Handle(4u, 0u)) == 0x40u);
+
+    // Publishing over a live handle replaces the Vulkan handle, as when a resource is demoted or moved
+    table.publish(Handle(4u, 0u), 0x41u);
+    PETRICHOR_CHECK(table.find(Handle(4u, 0u)) == 0x41u);
+}
+
+static void StaleHandlesFindNothing()
+{
+    ResourceHandleTable table;
+    table.publish(Handle(7u, 0u), 0x70u);
+    table.retract(Handle(7u, 0u));
+    table.publish(Handle(7u, 1u), 0x71u);
+    PETRICHOR_CHECK(table.find(Handle(7u, 0u)) == 0u);
+    PETRICHOR_CHECK(table.find(Handle(7u, 1u)) == 0x71u);
+
+    // Retracting with the old handle leaves the slot's new occupant alone
+    table.retract(Handle(7u, 0u));
+    PETRICHOR_CHECK(table.find(Handle(7u, 1u)) == 0x71u);
+}
+
+static void InvalidHandlesFindNothing()
+{
+    ResourceHandleTable table;
+    table.publish(Handle(0u, 0u), 0x10u);
+    PETRICHOR_CHECK(table.find(INVALID_GPU_RESOURCE_HANDLE) == 0u);
+    // Past anything the table has room for yet
+    PETRICHOR_CHECK(table.find(Handle(1000000u, 0u)) == 0u);
+    table.retract(Handle(1000000u, 0u));
+    table.retract(INVALID_GPU_RESOURCE_HANDLE);
+    PETRICHOR_CHECK(table.find(Handle(0u, 0u)) == 0x10u);
+}
+
+static void GrowingKeepsEarlierEntries()
+{
+    ResourceHandleTable table;
+    // Sixteen chunks of 1024 to start with, so this grows the directory a few times over
+    constexpr uint32_t SlotCount = 100000u;
+    for (uint32_t slot = 0u; slot < SlotCount; slot += 7u)
+    {
+        table.publish(Handle(slot, 2u), 0x1000u + slot);
+    }
+
+    bool allFound = true;
+    for (uint32_t slot = 0u; slot < SlotCount; slot += 7u)
+    {
+        allFound = allFound && (table.find(Handle(slot, 2u)) == 0x1000u + slot);
+    }
+    PETRICHOR_CHECK(allFound);
+    PETRICHOR_CHECK(table.find(Handle(1u, 2u)) == 0u);
+
+    // Nothing is reading, so every retired directory can go
+    table.reclaim();
+    const uint32_t lastSlot = (SlotCount - 1u) / 7u * 7u;
+    PETRICHOR_CHECK(table.find(Handle(lastSlot, 2u)) == 0x1000u + lastSlot);
+}
+
+static void ClearEmptiesTheTable()
+{
+    ResourceHandleTable table;
+    table.publish(Handle(1u, 0u), 0x10u);
+    table.publish(Handle(50000u, 0u), 0x20u);
+    table.clear();
+    PETRICHOR_CHECK(table.find(Handle(1u, 0u)) == 0u);
+    PETRICHOR_CHECK(table.find(Handle(50000u, 0u)) == 0u);
+}
+
+static void ManyTablesOnOneThread()
+{
+    // More tables than a thread caches reader records for, some destroyed while still cached
+    std::vector<std::unique_ptr<ResourceHandleTable>> tables;
+    for (uint32_t i = 0u; i < 12u; ++i)
+    {
+        tables.emplace_back(std::make_unique<ResourceHandleTable>());
+        tables.back()->publish(Handle(i, 0u), 0x100u + i);
+        if (i % 3u == 0u)
+        {
+            tables.front().reset();
+            tables.erase(tables.begin());
+        }
+    }
+
+    bool allFound = true;
+    for (const auto& table : tables)
+    {
+        bool foundOne = false;
+        for (uint32_t i = 0u; i < 12u; ++i)
+        {
+            foundOne = foundOne || (table->find(Handle(i, 0u)) == 0x100u + i);
+        }
+        allFound = allFound && foundOne;
+    }
+    PETRICHOR_CHECK(allFound);
+}
+
+static void ReadersDuringGrowth()
+{
+    ResourceHandleTable table;
+    constexpr uint32_t EarlySlots = 256u;
+    for (uint32_t slot = 0u; slot < EarlySlots; ++slot)
+    {
+        table.publish(Handle(slot, 0u), 0x1000u + slot);
+    }
+
+    // Readers never see a wrong Vulkan handle for the early slots, nor one of them go missing, while the directory
+    // they're reading through is replaced and freed under them
+    std::atomic<bool> done{ false };
+    std::atomic<uint32_t> wrongReads{ 0u };
+    std::vector<std::thread> readers;
+    for (uint32_t i = 0u; i < 4u; ++i)
+    {
+        readers.emplace_back([&table, &done, &wrongReads, i]()
+        {
+            uint32_t slot = i;
+            while (!done.load(std::memory_order_acquire))
+            {
+                if (table.find(Handle(slot, 0u)) != 0x1000u + slot)
+                {
+                    wrongReads.fetch_add(1u, std::memory_order_relaxed);
+                }
+                slot = (slot + 1u) % EarlySlots;
+                if (slot == 0u)
+                {
+                    table.reclaim();
+                }
+            }
+        });
+    }
+
+    for (uint32_t slot = EarlySlots; slot < 200000u; slot += 1024u)
+    {
+        table.publish(Handle(slot, 0u), 0x1000u + slot);
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+
+    PETRICHOR_CHECK(wrongReads.load() == 0u);
+    table.reclaim();
+}
+
+static void MoreReadersThanRecords()
+{
+    ResourceHandleTable table;
+    table.publish(Handle(5u, 0u), 0x50u);
+
+    // Every thread reads before any exits, so the last few find all the records taken and are only counted
+    constexpr uint32_t ReaderCount = static_cast<uint32_t>(HandleTableReaders::MaxReaders) + 4u;
+    std::atomic<uint32_t> arrived{ 0u };
+    std::atomic<bool> release{ false };
+    std::atomic<uint32_t> wrongReads{ 0u };
+    std::vector<std::thread> readers;
+    for (uint32_t i = 0u; i < ReaderCount; ++i)
+    {
+        readers.emplace_back([&]()
+        {
+            if (table.find(Handle(5u, 0u)) != 0x50u)
+            {
+                wrongReads.fetch_add(1u, std::memory_order_relaxed);
+            }
+            arrived.fetch_add(1u, std::memory_order_acq_rel);
+            while (!release.load(std::memory_order_acquire))
+            {
+                if (table.find(Handle(5u, 0u)) != 0x50u)
+                {
+                    wrongReads.fetch_add(1u, std::memory_order_relaxed);
+                }
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    while (arrived.load(std::memory_order_acquire) != ReaderCount)
+    {
+        std::this_thread::yield();
+    }
+
+    // Grows and reclaims under all of them
+    for (uint32_t slot = 1024u; slot < 100000u; slot += 1024u)
+    {
+        table.publish(Handle(slot, 0u), 0x1000u + slot);
+        table.reclaim();
+    }
+    release.store(true, std::memory_order_release);
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+
+    PETRICHOR_CHECK(wrongReads.load() == 0u);
+    PETRICHOR_CHECK(table.find(Handle(5u, 0u)) == 0x50u);
+    table.reclaim();
+}
+
+int main(int argc, char* argv[])
+{
+    PublishFindRetract();
+    StaleHandlesFindNothing();
+    InvalidHandlesFindNothing();
+    GrowingKeepsEarlierEntries();
+    ClearEmptiesTheTable();
+    ManyTablesOnOneThread();
+    ReadersDuringGrowth();
+    MoreReadersThanRecords();
+    return UnitTestResult();
+}
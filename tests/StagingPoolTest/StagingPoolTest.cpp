@@ -0,0 +1,156 @@
+#include "StagingPool.hpp"
+#include "UnitTestChecks.hpp"
+#include <cstdint>
+#include <vector>
+
+using namespace petrichor;
+
+// Only ever handed back and forth: the pool never touches a buffer it doesn't have to create, and trimmed ones are left to
+// the caller to free, so these never reach Vulkan. Neither does the null allocator, as long as every acquire is a hit
+static StagingBuffer FakeBuffer(uint64_t id, VkDeviceSize capacity, bool host_cached)
+{
+    StagingBuffer buffer;
+    buffer.buffer = (VkBuffer)id;
+    buffer.capacity = capacity;
+    buffer.hostCached = host_cached;
+    return buffer;
+}
+
+static VkBuffer Acquire(StagingBufferPool& pool, VkDeviceSize size, bool host_cached)
+{
+    StagingBuffer staging;
+    const VkResult result = pool.acquire(VK_NULL_HANDLE, size, host_cached, VmaAllocationCreateInfo{}, staging);
+    PETRICHOR_CHECK(result == VK_SUCCESS);
+    PETRICHOR_CHECK(staging.capacity == StagingBufferPool::sizeClass(size));
+    PETRICHOR_CHECK(staging.hostCached == host_cached);
+    return staging.buffer;
+}
+
+static void SizeClasses()
+{
+    constexpr VkDeviceSize MinSizeClass = StagingBufferPool::MinSizeClass;
+    PETRICHOR_CHECK(StagingBufferPool::sizeClass(0u) == MinSizeClass);
+    PETRICHOR_CHECK(StagingBufferPool::sizeClass(1u) == MinSizeClass);
+    PETRICHOR_CHECK(StagingBufferPool::sizeClass(MinSizeClass) == MinSizeClass);
+    PETRICHOR_CHECK(StagingBufferPool::sizeClass(MinSizeClass + 1u) == 2u * MinSizeClass);
+    PETRICHOR_CHECK(StagingBufferPool::sizeClass(1024u * 1024u) == 1024u * 1024u);
+    PETRICHOR_CHECK(StagingBufferPool::sizeClass(1024u * 1024u + 1u) == 2u * 1024u * 1024u);
+    PETRICHOR_CHECK(StagingBufferPool::sizeClass(VkDeviceSize(3u) << 30u) == VkDeviceSize(4u) << 30u);
+}
+
+static void ReusesBuffersOfTheSameClass()
+{
+    StagingBufferPool pool;
+    pool.release(FakeBuffer(0x10u, 128u * 1024u, false), 1u);
+    StagingPoolStats stats = pool.stats();
+    PETRICHOR_CHECK(stats.PooledBuffers == 1u);
+    PETRICHOR_CHECK(stats.PooledBytes == 128u * 1024u);
+
+    // Anything over 64KiB up to 128KiB comes out of the 128KiB class
+    PETRICHOR_CHECK(Acquire(pool, 100u * 1024u, false) == (VkBuffer)uint64_t(0x10u));
+    stats = pool.stats();
+    PETRICHOR_CHECK(stats.Reuses == 1u);
+    PETRICHOR_CHECK(stats.Allocations == 0u);
+    PETRICHOR_CHECK(stats.PooledBuffers == 0u);
+    PETRICHOR_CHECK(stats.PooledBytes == 0u);
+}
+
+static void ClassesDontMix()
+{
+    StagingBufferPool pool;
+    pool.release(FakeBuffer(0x10u, 64u * 1024u, false), 1u);
+    pool.release(FakeBuffer(0x20u, 256u * 1024u, false), 1u);
+    pool.release(FakeBuffer(0x30u, 256u * 1024u, true), 1u);
+
+    PETRICHOR_CHECK(Acquire(pool, 200u * 1024u, true) == (VkBuffer)uint64_t(0x30u));
+    PETRICHOR_CHECK(Acquire(pool, 200u * 1024u, false) == (VkBuffer)uint64_t(0x20u));
+    PETRICHOR_CHECK(Acquire(pool, 1u, false) == (VkBuffer)uint64_t(0x10u));
+    PETRICHOR_CHECK(pool.stats().PooledBuffers == 0u);
+}
+
+static void MostRecentlyReleasedFirst()
+{
+    // So the ones left at the bottom are the ones idling longest, and trimmed first
+    StagingBufferPool pool;
+    pool.release(FakeBuffer(0x10u, 64u * 1024u, false), 1u);
+    pool.release(FakeBuffer(0x20u, 64u * 1024u, false), 2u);
+    PETRICHOR_CHECK(Acquire(pool, 1u, false) == (VkBuffer)uint64_t(0x20u));
+    PETRICHOR_CHECK(Acquire(pool, 1u, false) == (VkBuffer)uint64_t(0x10u));
+}
+
+static void TrimLeavesRecentBuffers()
+{
+    StagingBufferPool pool;
+    pool.setIdleFrames(10u);
+    pool.release(FakeBuffer(0x10u, 64u * 1024u, false), 5u);
+    pool.release(FakeBuffer(0x20u, 128u * 1024u, true), 8u);
+    std::vector<StagingBuffer> trimmed;
+    pool.trim(14u, trimmed);
+    StagingPoolStats stats = pool.stats();
+    PETRICHOR_CHECK(trimmed.empty());
+    PETRICHOR_CHECK(stats.TrimmedBuffers == 0u);
+    PETRICHOR_CHECK(stats.PooledBuffers == 2u);
+
+    // Zero keeps them forever
+    pool.setIdleFrames(0u);
+    pool.trim(1000u, trimmed);
+    stats = pool.stats();
+    PETRICHOR_CHECK(trimmed.empty());
+    PETRICHOR_CHECK(stats.TrimmedBuffers == 0u);
+    PETRICHOR_CHECK(stats.PooledBuffers == 2u);
+}
+
+static void TrimTakesIdleBuffersOldestFirst()
+{
+    StagingBufferPool pool;
+    pool.setIdleFrames(10u);
+    pool.release(FakeBuffer(0x10u, 64u * 1024u, false), 2u);
+    pool.release(FakeBuffer(0x20u, 64u * 1024u, false), 4u);
+    pool.release(FakeBuffer(0x30u, 64u * 1024u, false), 9u);
+    pool.release(FakeBuffer(0x40u, 256u * 1024u, true), 3u);
+
+    // Frame 14: the first two and the host cached one have idled for ten frames or more, the third for only five
+    std::vector<StagingBuffer> trimmed;
+    pool.trim(14u, trimmed);
+    PETRICHOR_CHECK(trimmed.size() == 3u);
+    StagingPoolStats stats = pool.stats();
+    PETRICHOR_CHECK(stats.TrimmedBuffers == 3u);
+    PETRICHOR_CHECK(stats.PooledBuffers == 1u);
+    PETRICHOR_CHECK(stats.PooledBytes == 64u * 1024u);
+
+    bool oldestFirst = false;
+    bool hostCachedTrimmed = false;
+    for (size_t i = 0u; i < trimmed.size(); ++i)
+    {
+        oldestFirst = oldestFirst || ((trimmed[i].buffer == (VkBuffer)uint64_t(0x10u)) && (i + 1u < trimmed.size()) &&
+            (trimmed[i + 1u].buffer == (VkBuffer)uint64_t(0x20u)));
+        hostCachedTrimmed = hostCachedTrimmed || (trimmed[i].buffer == (VkBuffer)uint64_t(0x40u));
+    }
+    PETRICHOR_CHECK(oldestFirst);
+    PETRICHOR_CHECK(hostCachedTrimmed);
+
+    // The one left is still handed out
+    PETRICHOR_CHECK(Acquire(pool, 1u, false) == (VkBuffer)uint64_t(0x30u));
+    PETRICHOR_CHECK(pool.stats().PooledBytes == 0u);
+}
+
+static void NullBuffersAreIgnored()
+{
+    StagingBufferPool pool;
+    pool.release(StagingBuffer{}, 1u);
+    const StagingPoolStats stats = pool.stats();
+    PETRICHOR_CHECK(stats.PooledBuffers == 0u);
+    PETRICHOR_CHECK(stats.PooledBytes == 0u);
+}
+
+int main(int argc, char* argv[])
+{
+    SizeClasses();
+    ReusesBuffersOfTheSameClass();
+    ClassesDontMix();
+    MostRecentlyReleasedFirst();
+    TrimLeavesRecentBuffers();
+    TrimTakesIdleBuffersOldestFirst();
+    NullBuffersAreIgnored();
+    return UnitTestResult();
+}
@@ -0,0 +1,187 @@
+#include "TransientAliasing.hpp"
+#include "UnitTestChecks.hpp"
+#include <algorithm>
+#include <vector>
+
+using namespace petrichor;
+
+static TransientAllocationRequest MakeRequest(VkDeviceSize size, VkDeviceSize alignment, uint32_t memory_type_bits, uint32_t first_use, uint32_t last_use)
+{
+    return TransientAllocationRequest{ VkMemoryRequirements{ size, alignment, memory_type_bits }, first_use, last_use };
+}
+
+// What has to hold for any packing: requests alive at the same time never share bytes, everything fits (aligned) in a
+// heap it can be bound to, and every earlier occupant of a request's bytes is listed as a predecessor
+static void CheckPacking(const std::vector<TransientAllocationRequest>& requests, const TransientPackResult& result)
+{
+    PETRICHOR_CHECK(result.placements.size() == requests.size());
+    PETRICHOR_CHECK(result.aliasedPredecessors.size() == requests.size());
+
+    VkDeviceSize unaliasedBytes = 0u;
+    for (size_t i = 0u; i < requests.size(); ++i)
+    {
+        const TransientAllocationRequest& request = requests[i];
+        const TransientPlacement& placement = result.placements[i];
+        unaliasedBytes += request.requirements.size;
+
+        PETRICHOR_CHECK(placement.heapIdx < result.heaps.size());
+        if (placement.heapIdx >= result.heaps.size())
+        {
+            continue;
+        }
+
+        const TransientHeapLayout& heap = result.heaps[placement.heapIdx];
+        PETRICHOR_CHECK(placement.offset % std::max<VkDeviceSize>(request.requirements.alignment, 1u) == 0u);
+        PETRICHOR_CHECK(placement.offset + request.requirements.size <= heap.size);
+        PETRICHOR_CHECK(heap.alignment >= request.requirements.alignment);
+        PETRICHOR_CHECK(heap.memoryTypeBits != 0u);
+        PETRICHOR_CHECK((heap.memoryTypeBits & ~request.requirements.memoryTypeBits) == 0u);
+
+        for (size_t j = 0u; j < requests.size(); ++j)
+        {
+            const TransientAllocationRequest& other = requests[j];
+            const TransientPlacement& otherPlacement = result.placements[j];
+            const bool sharesBytes = (i != j) && (otherPlacement.heapIdx == placement.heapIdx) &&
+                (otherPlacement.offset < placement.offset + request.requirements.size) &&
+                (placement.offset < otherPlacement.offset + other.requirements.size);
+            const bool livesOverlap = (request.firstUse <= other.lastUse) && (other.firstUse <= request.lastUse);
+            PETRICHOR_CHECK(!(sharesBytes && livesOverlap));
+
+            const auto& predecessors = result.aliasedPredecessors[i];
+            const bool listed = std::find(predecessors.begin(), predecessors.end(), static_cast<uint32_t>(j)) != predecessors.end();
+            PETRICHOR_CHECK(listed == (sharesBytes && (other.lastUse < request.firstUse)));
+        }
+    }
+
+    PETRICHOR_CHECK(result.unaliasedBytes == unaliasedBytes);
+}
+
+static void DisjointLifetimesShareMemory()
+{
+    const std::vector<TransientAllocationRequest> requests
+    {
+        MakeRequest(4096u, 256u, 0x1u, 0u, 1u),
+        MakeRequest(4096u, 256u, 0x1u, 2u, 3u),
+        MakeRequest(4096u, 256u, 0x1u, 4u, 5u)
+    };
+
+    const TransientPackResult result = PackTransientResources(requests);
+    CheckPacking(requests, result);
+    PETRICHOR_CHECK(result.heaps.size() == 1u);
+    PETRICHOR_CHECK(result.heaps[0].size == 4096u);
+    PETRICHOR_CHECK(result.unaliasedBytes == 3u * 4096u);
+    PETRICHOR_CHECK(result.peakLiveBytes == 4096u);
+    // Each one takes over the memory of everything before it
+    PETRICHOR_CHECK(result.aliasedPredecessors[0].empty());
+    PETRICHOR_CHECK(result.aliasedPredecessors[1].size() == 1u);
+    PETRICHOR_CHECK(result.aliasedPredecessors[2].size() == 2u);
+}
+
+static void OverlappingLifetimesDontShareMemory()
+{
+    const std::vector<TransientAllocationRequest> requests
+    {
+        MakeRequest(4096u, 256u, 0x1u, 0u, 2u),
+        MakeRequest(2048u, 256u, 0x1u, 1u, 3u),
+        MakeRequest(1024u, 256u, 0x1u, 2u, 2u)
+    };
+
+    const TransientPackResult result = PackTransientResources(requests);
+    CheckPacking(requests, result);
+    PETRICHOR_CHECK(result.heaps.size() == 1u);
+    PETRICHOR_CHECK(result.heaps[0].size == 4096u + 2048u + 1024u);
+    PETRICHOR_CHECK(result.peakLiveBytes == 4096u + 2048u + 1024u);
+}
+
+static void SmallRequestsFillGaps()
+{
+    // The two small ones are only alive while the big ones aren't, so they go at the bottom of the heap
+    const std::vector<TransientAllocationRequest> requests
+    {
+        MakeRequest(8192u, 256u, 0x1u, 0u, 1u),
+        MakeRequest(8192u, 256u, 0x1u, 4u, 5u),
+        MakeRequest(2048u, 256u, 0x1u, 2u, 3u),
+        MakeRequest(2048u, 256u, 0x1u, 2u, 3u)
+    };
+
+    const TransientPackResult result = PackTransientResources(requests);
+    CheckPacking(requests, result);
+    PETRICHOR_CHECK(result.heaps.size() == 1u);
+    PETRICHOR_CHECK(result.heaps[0].size == 8192u);
+    PETRICHOR_CHECK(result.peakLiveBytes == 8192u);
+}
+
+static void IncompatibleMemoryTypesGetTheirOwnHeaps()
+{
+    const std::vector<TransientAllocationRequest> requests
+    {
+        MakeRequest(4096u, 256u, 0x1u, 0u, 1u),
+        MakeRequest(4096u, 256u, 0x2u, 2u, 3u),
+        MakeRequest(4096u, 256u, 0x3u, 4u, 5u)
+    };
+
+    const TransientPackResult result = PackTransientResources(requests);
+    CheckPacking(requests, result);
+    PETRICHOR_CHECK(result.heaps.size() == 2u);
+    PETRICHOR_CHECK(result.placements[0].heapIdx != result.placements[1].heapIdx);
+}
+
+static void OffsetsRespectAlignment()
+{
+    const std::vector<TransientAllocationRequest> requests
+    {
+        MakeRequest(1000u, 16u, 0x1u, 0u, 3u),
+        MakeRequest(500u, 4096u, 0x1u, 0u, 3u),
+        MakeRequest(100u, 1024u, 0x1u, 1u, 2u)
+    };
+
+    const TransientPackResult result = PackTransientResources(requests);
+    CheckPacking(requests, result);
+    PETRICHOR_CHECK(result.heaps.size() == 1u);
+    PETRICHOR_CHECK(result.heaps[0].alignment == 4096u);
+}
+
+static void NoRequests()
+{
+    const TransientPackResult result = PackTransientResources({});
+    PETRICHOR_CHECK(result.heaps.empty());
+    PETRICHOR_CHECK(result.placements.empty());
+    PETRICHOR_CHECK(result.unaliasedBytes == 0u);
+    PETRICHOR_CHECK(result.peakLiveBytes == 0u);
+}
+
+static void ManyRequests()
+{
+    // Deterministic, so a failure can be reproduced
+    std::vector<TransientAllocationRequest> requests;
+    uint32_t state = 0x9E3779B9u;
+    auto next = [&state]()
+    {
+        state ^= state << 13u;
+        state ^= state >> 17u;
+        state ^= state << 5u;
+        return state;
+    };
+
+    for (uint32_t i = 0u; i < 200u; ++i)
+    {
+        const uint32_t firstUse = next() % 32u;
+        const VkDeviceSize alignment = VkDeviceSize(1u) << (next() % 13u);
+        requests.emplace_back(MakeRequest(1u + next() % 65536u, alignment, (next() % 3u) + 1u, firstUse, firstUse + next() % 8u));
+    }
+
+    const TransientPackResult result = PackTransientResources(requests);
+    CheckPacking(requests, result);
+}
+
+int main(int argc, char* argv[])
+{
+    DisjointLifetimesShareMemory();
+    OverlappingLifetimesDontShareMemory();
+    SmallRequestsFillGaps();
+    IncompatibleMemoryTypesGetTheirOwnHeaps();
+    OffsetsRespectAlignment();
+    NoRequests();
+    ManyRequests();
+    return UnitTestResult();
+}
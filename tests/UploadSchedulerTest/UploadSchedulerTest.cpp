@@ -0,0 +1,207 @@
+#include "UploadScheduler.hpp"
+#include "UnitTestChecks.hpp"
+#include <vector>
+
+using namespace petrichor;
+
+static ScheduledUpload MakeUpload(GpuResourceHandle handle, VkDeviceSize bytes, uint32_t priority = 0u,
+    uint64_t deadline_frame = std::numeric_limits<uint64_t>::max())
+{
+    ScheduledUpload upload;
+    upload.handle = handle;
+    upload.bytes = bytes;
+    upload.priority = priority;
+    upload.deadlineFrame = deadline_frame;
+    return upload;
+}
+
+static void Push(UploadScheduler& scheduler, uint64_t frame, std::vector<ScheduledUpload> uploads)
+{
+    scheduler.push(frame, uploads);
+    PETRICHOR_CHECK(uploads.empty());
+}
+
+static std::vector<GpuResourceHandle> Take(UploadScheduler& scheduler, uint64_t frame)
+{
+    std::vector<ScheduledUpload> taken;
+    scheduler.take(frame, taken);
+    std::vector<GpuResourceHandle> handles;
+    for (const auto& upload : taken)
+    {
+        handles.emplace_back(upload.handle);
+    }
+    return handles;
+}
+
+static void EnabledOnlyWithABudget()
+{
+    UploadScheduler scheduler;
+    PETRICHOR_CHECK(!scheduler.enabled());
+    scheduler.setBudget(UploadBudget{ 1024u, 0u, 0.0f });
+    PETRICHOR_CHECK(scheduler.enabled());
+    scheduler.setBudget(UploadBudget{ 0u, 4u, 0.0f });
+    PETRICHOR_CHECK(scheduler.enabled());
+    scheduler.setBudget(UploadBudget{ 0u, 0u, 2.0f });
+    PETRICHOR_CHECK(scheduler.enabled());
+    scheduler.setBudget(UploadBudget{});
+    PETRICHOR_CHECK(!scheduler.enabled());
+}
+
+static void ByteBudgetCarriesUploadsOver()
+{
+    UploadScheduler scheduler;
+    scheduler.setBudget(UploadBudget{ 100u, 0u, 0.0f });
+    Push(scheduler, 0u, { MakeUpload(1u, 40u), MakeUpload(2u, 40u), MakeUpload(3u, 40u) });
+
+    PETRICHOR_CHECK((Take(scheduler, 0u) == std::vector<GpuResourceHandle>{ 1u, 2u }));
+    UploadSchedulerStats stats = scheduler.stats();
+    PETRICHOR_CHECK(stats.LastFrameUploads == 2u);
+    PETRICHOR_CHECK(stats.LastFrameBytes == 80u);
+    PETRICHOR_CHECK(stats.CurrentByteBudget == 100u);
+    PETRICHOR_CHECK(stats.BacklogUploads == 1u);
+    PETRICHOR_CHECK(stats.BacklogBytes == 40u);
+    PETRICHOR_CHECK(stats.TotalDeferredUploads == 3u);
+
+    PETRICHOR_CHECK((Take(scheduler, 3u) == std::vector<GpuResourceHandle>{ 3u }));
+    stats = scheduler.stats();
+    PETRICHOR_CHECK(stats.BacklogUploads == 0u);
+    PETRICHOR_CHECK(stats.BacklogBytes == 0u);
+    PETRICHOR_CHECK(Take(scheduler, 4u).empty());
+}
+
+static void OversizedUploadGoesOnItsOwn()
+{
+    UploadScheduler scheduler;
+    scheduler.setBudget(UploadBudget{ 100u, 0u, 0.0f });
+    Push(scheduler, 0u, { MakeUpload(1u, 500u), MakeUpload(2u, 10u) });
+
+    PETRICHOR_CHECK((Take(scheduler, 0u) == std::vector<GpuResourceHandle>{ 1u }));
+    PETRICHOR_CHECK((Take(scheduler, 1u) == std::vector<GpuResourceHandle>{ 2u }));
+}
+
+static void UploadCountBudget()
+{
+    UploadScheduler scheduler;
+    scheduler.setBudget(UploadBudget{ 0u, 2u, 0.0f });
+    Push(scheduler, 0u, { MakeUpload(1u, 1u), MakeUpload(2u, 1u), MakeUpload(3u, 1u), MakeUpload(4u, 1u), MakeUpload(5u, 1u) });
+
+    PETRICHOR_CHECK(Take(scheduler, 0u).size() == 2u);
+    PETRICHOR_CHECK(Take(scheduler, 1u).size() == 2u);
+    PETRICHOR_CHECK(Take(scheduler, 2u).size() == 1u);
+}
+
+static void OrderedByPriorityDeadlineAndAge()
+{
+    UploadScheduler scheduler;
+    scheduler.setBudget(UploadBudget{ 0u, 1u, 0.0f });
+    Push(scheduler, 0u,
+    {
+        MakeUpload(1u, 1u, 0u),
+        MakeUpload(2u, 1u, 5u, 100u),
+        MakeUpload(3u, 1u, 5u, 50u),
+        MakeUpload(4u, 1u, 0u)
+    });
+
+    // Same priority goes by deadline, then whichever was pushed first
+    PETRICHOR_CHECK((Take(scheduler, 1u) == std::vector<GpuResourceHandle>{ 3u }));
+    PETRICHOR_CHECK((Take(scheduler, 2u) == std::vector<GpuResourceHandle>{ 2u }));
+    PETRICHOR_CHECK((Take(scheduler, 3u) == std::vector<GpuResourceHandle>{ 1u }));
+    PETRICHOR_CHECK((Take(scheduler, 4u) == std::vector<GpuResourceHandle>{ 4u }));
+}
+
+static void OverdueUploadsIgnoreTheBudget()
+{
+    UploadScheduler scheduler;
+    scheduler.setBudget(UploadBudget{ 100u, 1u, 0.0f });
+    Push(scheduler, 0u, { MakeUpload(1u, 10u, 10u), MakeUpload(2u, 400u, 0u, 2u), MakeUpload(3u, 400u, 0u, 2u) });
+
+    // Nothing is due yet, so priority wins
+    PETRICHOR_CHECK((Take(scheduler, 1u) == std::vector<GpuResourceHandle>{ 1u }));
+    // Both are due now, over budget or not
+    PETRICHOR_CHECK((Take(scheduler, 2u) == std::vector<GpuResourceHandle>{ 2u, 3u }));
+    PETRICHOR_CHECK(scheduler.stats().LastFrameBytes == 800u);
+}
+
+static void ExpeditedUploadsGoNext()
+{
+    UploadScheduler scheduler;
+    scheduler.setBudget(UploadBudget{ 0u, 1u, 0.0f });
+    Push(scheduler, 0u, { MakeUpload(1u, 1u, 10u), MakeUpload(2u, 1u), MakeUpload(3u, 1u), MakeUpload(4u, 1u) });
+
+    std::vector<GpuResourceHandle> needed{ 4u, 3u, 99u };
+    scheduler.expedite(needed);
+    PETRICHOR_CHECK((Take(scheduler, 0u) == std::vector<GpuResourceHandle>{ 3u, 4u }));
+    PETRICHOR_CHECK((Take(scheduler, 1u) == std::vector<GpuResourceHandle>{ 1u }));
+}
+
+static void BacklogAge()
+{
+    UploadScheduler scheduler;
+    scheduler.setBudget(UploadBudget{ 0u, 1u, 0.0f });
+    Push(scheduler, 2u, { MakeUpload(1u, 1u), MakeUpload(2u, 1u) });
+    Push(scheduler, 5u, { MakeUpload(3u, 1u) });
+
+    Take(scheduler, 6u);
+    PETRICHOR_CHECK(scheduler.stats().OldestBacklogFrames == 4u);
+    Take(scheduler, 7u);
+    PETRICHOR_CHECK(scheduler.stats().OldestBacklogFrames == 2u);
+    Take(scheduler, 8u);
+    PETRICHOR_CHECK(scheduler.stats().OldestBacklogFrames == 0u);
+}
+
+static void ByteBudgetFollowsMeasuredThroughput()
+{
+    UploadScheduler scheduler;
+    scheduler.setBudget(UploadBudget{ 0u, 0u, 1.0f });
+    // Nothing measured yet, and no byte limit to start from
+    Take(scheduler, 0u);
+    PETRICHOR_CHECK(scheduler.stats().CurrentByteBudget == 16u * 1024u * 1024u);
+
+    // 1 GB/s, so a millisecond is worth a megabyte
+    scheduler.recordThroughput(1000000u, 1000000u);
+    PETRICHOR_CHECK(scheduler.stats().MeasuredBytesPerSecond == 1.0e9);
+    Take(scheduler, 1u);
+    PETRICHOR_CHECK(scheduler.stats().CurrentByteBudget == 1000000u);
+
+    // Later samples are smoothed in, rather than replacing the estimate
+    scheduler.recordThroughput(3000000u, 1000000u);
+    PETRICHOR_CHECK(scheduler.stats().MeasuredBytesPerSecond == 1.5e9);
+
+    // A byte limit still caps it
+    scheduler.setBudget(UploadBudget{ 1000u, 0u, 1.0f });
+    Take(scheduler, 2u);
+    PETRICHOR_CHECK(scheduler.stats().CurrentByteBudget == 1000u);
+
+    // Empty samples are ignored
+    scheduler.recordThroughput(0u, 1000000u);
+    scheduler.recordThroughput(1000000u, 0u);
+    PETRICHOR_CHECK(scheduler.stats().MeasuredBytesPerSecond == 1.5e9);
+}
+
+static void DrainTakesEverything()
+{
+    UploadScheduler scheduler;
+    scheduler.setBudget(UploadBudget{ 0u, 1u, 0.0f });
+    Push(scheduler, 0u, { MakeUpload(1u, 1u), MakeUpload(2u, 1u), MakeUpload(3u, 1u) });
+
+    std::vector<ScheduledUpload> drained;
+    scheduler.drain(drained);
+    PETRICHOR_CHECK(drained.size() == 3u);
+    PETRICHOR_CHECK(scheduler.stats().BacklogUploads == 0u);
+    PETRICHOR_CHECK(Take(scheduler, 1u).empty());
+}
+
+int main(int argc, char* argv[])
+{
+    EnabledOnlyWithABudget();
+    ByteBudgetCarriesUploadsOver();
+    OversizedUploadGoesOnItsOwn();
+    UploadCountBudget();
+    OrderedByPriorityDeadlineAndAge();
+    OverdueUploadsIgnoreTheBudget();
+    ExpeditedUploadsGoNext();
+    BacklogAge();
+    ByteBudgetFollowsMeasuredThroughput();
+    DrainTakesEverything();
+    return UnitTestResult();
+}
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef PETRICHOR_TEST_FIXTURES_UNIT_TEST_CHECKS_HPP
+#define PETRICHOR_TEST_FIXTURES_UNIT_TEST_CHECKS_HPP
+#include <cstdio>
+#include <cstdlib>
+
+// Checks for the headless unit tests. Failures are printed and counted rather than aborting, so one run reports
+// everything that's broken, and main() returns UnitTestResult() so CTest sees them
+namespace petrichor
+{
+
+    inline int UnitTestFailures = 0;
+
+    inline void UnitTestCheck(const bool passed, const char* expression, const char* file, const int line)
+    {
+        if (!passed)
+        {
+            std::fprintf(stderr, "%s(%d): check failed: %s\n", file, line, expression);
+            ++UnitTestFailures;
+        }
+    }
+
+    inline int UnitTestResult()
+    {
+        if (UnitTestFailures != 0)
+        {
+            std::fprintf(stderr, "%d check(s) failed\n", UnitTestFailures);
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+}
+
+#define PETRICHOR_CHECK(expression) ::petrichor::UnitTestCheck(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
+
+#endif //!PETRICHOR_TEST_FIXTURES_UNIT_TEST_CHECKS_HPP
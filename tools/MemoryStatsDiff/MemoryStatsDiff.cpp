@@ -0,0 +1,125 @@
+#include "PetrichorResourceTypes.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+using namespace petrichor;
+
+// Compares memory stats snapshots written by ResourceContext::WriteMemoryStatsSnapshots():
+//   MemoryStatsDiff <snapshots>           oldest sample in the file against the newest
+//   MemoryStatsDiff <before> <after>      newest sample of each file
+
+static bool ReadSnapshots(const char* path, std::vector<MemoryStatsSample>& samples)
+{
+    std::ifstream input(path, std::ios::binary);
+    if (!input.is_open())
+    {
+        std::fprintf(stderr, "Couldn't open %s\n", path);
+        return false;
+    }
+
+    MemoryStatsSnapshotFileHeader header;
+    input.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!input.good() || (header.Magic != MemoryStatsSnapshotMagic))
+    {
+        std::fprintf(stderr, "%s isn't a memory stats snapshot file\n", path);
+        return false;
+    }
+
+    if ((header.Version != MemoryStatsSnapshotVersion) || (header.SampleSize != sizeof(MemoryStatsSample)))
+    {
+        std::fprintf(stderr, "%s was written by an incompatible version (version %u, sample size %u)\n", path, header.Version, header.SampleSize);
+        return false;
+    }
+
+    samples.resize(header.SampleCount);
+    input.read(reinterpret_cast<char*>(samples.data()), sizeof(MemoryStatsSample) * samples.size());
+    if (!input.good())
+    {
+        std::fprintf(stderr, "%s is truncated\n", path);
+        return false;
+    }
+
+    if (samples.empty())
+    {
+        std::fprintf(stderr, "%s contains no samples\n", path);
+        return false;
+    }
+
+    return true;
+}
+
+static void PrintRow(const char* label, uint64_t before, uint64_t after)
+{
+    const long long delta = static_cast<long long>(after) - static_cast<long long>(before);
+    std::printf("    %-22s %16llu %16llu %+17lld\n", label, static_cast<unsigned long long>(before), static_cast<unsigned long long>(after), delta);
+}
+
+static void PrintDiff(const MemoryStatsSample& before, const MemoryStatsSample& after)
+{
+    const double elapsedMs = static_cast<double>(static_cast<long long>(after.Timestamp - before.Timestamp)) / 1.0e6;
+    std::printf("Frame %llu -> frame %llu (%.1f ms)\n", static_cast<unsigned long long>(before.FrameIndex),
+        static_cast<unsigned long long>(after.FrameIndex), elapsedMs);
+    std::printf("    %-22s %16s %16s %17s\n", "", "before", "after", "delta");
+
+    PrintRow("Live resources", before.LiveResources, after.LiveResources);
+    PrintRow("Evicted resources", before.EvictedResources, after.EvictedResources);
+
+    const uint32_t heapCount = std::min(std::max(before.HeapCount, after.HeapCount), MemoryStatsMaxHeaps);
+    for (uint32_t i = 0u; i < heapCount; ++i)
+    {
+        std::printf("  Heap %u\n", i);
+        PrintRow("Block bytes", before.HeapBlockBytes[i], after.HeapBlockBytes[i]);
+        PrintRow("Allocation bytes", before.HeapAllocationBytes[i], after.HeapAllocationBytes[i]);
+        // Allocated from the driver, but not occupied by anything
+        PrintRow("Unused block bytes", before.HeapBlockBytes[i] - before.HeapAllocationBytes[i], after.HeapBlockBytes[i] - after.HeapAllocationBytes[i]);
+        PrintRow("Allocations", before.HeapAllocationCount[i], after.HeapAllocationCount[i]);
+        PrintRow("Usage", before.HeapUsage[i], after.HeapUsage[i]);
+        PrintRow("Budget", before.HeapBudget[i], after.HeapBudget[i]);
+    }
+
+    // Indexed by GpuResourceMemoryDomain: zero is Invalid, which nothing is allocated in
+    constexpr static const char* DomainNames[MemoryStatsDomainCount] = { "Invalid", "Device", "Host", "HostCached", "LinkedDeviceHost" };
+    for (uint32_t i = 1u; i < MemoryStatsDomainCount; ++i)
+    {
+        if ((before.DomainResources[i] == 0u) && (after.DomainResources[i] == 0u))
+        {
+            continue;
+        }
+
+        std::printf("  Domain %s\n", DomainNames[i]);
+        PrintRow("Resources", before.DomainResources[i], after.DomainResources[i]);
+        PrintRow("Bytes", before.DomainBytes[i], after.DomainBytes[i]);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if ((argc != 2) && (argc != 3))
+    {
+        std::fprintf(stderr, "Usage: %s <snapshots> | <before snapshots> <after snapshots>\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<MemoryStatsSample> beforeSamples;
+    if (!ReadSnapshots(argv[1], beforeSamples))
+    {
+        return 1;
+    }
+
+    if (argc == 2)
+    {
+        PrintDiff(beforeSamples.front(), beforeSamples.back());
+        return 0;
+    }
+
+    std::vector<MemoryStatsSample> afterSamples;
+    if (!ReadSnapshots(argv[2], afterSamples))
+    {
+        return 1;
+    }
+
+    PrintDiff(beforeSamples.back(), afterSamples.back());
+    return 0;
+}